@@ -0,0 +1,165 @@
+#include "admission_controller.h"
+#include <algorithm>
+
+namespace {
+
+// 线程级状态：最近一次准入结果与作用域截止时间
+thread_local AdmissionStatus last_status = AdmissionStatus::ADMITTED;
+thread_local bool has_scoped_deadline = false;
+thread_local AdmissionController::Clock::time_point scoped_deadline;
+
+}  // namespace
+
+AdmissionController::AdmissionController(std::size_t max_queued, std::chrono::milliseconds default_deadline)
+    : max_queued_(max_queued), default_deadline_(default_deadline),
+      next_waiter_(0), owner_depth_(0) {
+    metrics_ = AdmissionMetrics();
+}
+
+AdmissionController::Ticket::Ticket(AdmissionController& controller)
+    : controller_(controller),
+      status_(controller.acquire(controller.defaultDeadline(), AdmissionPriority::INTERACTIVE)) {}
+      
+AdmissionController::Ticket::Ticket(AdmissionController& controller, Clock::time_point deadline)
+    : controller_(controller), status_(controller.acquire(deadline, AdmissionPriority::INTERACTIVE)) {}
+    
+AdmissionController::Ticket::Ticket(AdmissionController& controller, AdmissionPriority priority)
+    : controller_(controller),
+      status_(controller.acquire(priority == AdmissionPriority::BATCH && !has_scoped_deadline
+                                     ? Clock::time_point::max()
+                                     : controller.defaultDeadline(),
+                                 priority)) {}
+                                 
+AdmissionController::Ticket::~Ticket() {
+    if (admitted()) {
+        controller_.release();
+    }
+}
+
+AdmissionController::WriteGuard::WriteGuard(AdmissionController& controller, std::recursive_mutex& mutex,
+                                            AdmissionPriority priority)
+    : ticket_(controller, priority), lock_(mutex, std::defer_lock) {
+    if (ticket_.admitted()) {
+        lock_.lock();
+    }
+}
+
+AdmissionController::ScopedDeadline::ScopedDeadline(std::chrono::milliseconds timeout)
+    : had_previous_(has_scoped_deadline), previous_(scoped_deadline) {
+    Clock::time_point deadline = Clock::now() + timeout;
+    // 嵌套作用域只能收紧截止时间
+    scoped_deadline = had_previous_ ? std::min(previous_, deadline) : deadline;
+    has_scoped_deadline = true;
+}
+
+AdmissionController::ScopedDeadline::~ScopedDeadline() {
+    has_scoped_deadline = had_previous_;
+    scoped_deadline = previous_;
+}
+
+AdmissionStatus AdmissionController::lastStatus() {
+    return last_status;
+}
+
+AdmissionController::Clock::time_point AdmissionController::defaultDeadline() const {
+    return has_scoped_deadline ? scoped_deadline : Clock::now() + default_deadline_;
+}
+
+bool AdmissionController::isNext(std::uint64_t waiter, AdmissionPriority priority) const {
+    if (owner_depth_ != 0) {
+        return false;
+    }
+    if (priority == AdmissionPriority::INTERACTIVE) {
+        return interactive_waiters_.front() == waiter;
+    }
+    return interactive_waiters_.empty() && batch_waiters_.front() == waiter;
+}
+
+AdmissionStatus AdmissionController::acquire(Clock::time_point deadline, AdmissionPriority priority) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::thread::id self = std::this_thread::get_id();
+    
+    // 重入：当前线程已持有准入
+    if (owner_depth_ > 0 && owner_ == self) {
+        ++owner_depth_;
+        last_status = AdmissionStatus::ADMITTED;
+        return last_status;
+    }
+    
+    std::deque<std::uint64_t>& queue = priority == AdmissionPriority::INTERACTIVE ? interactive_waiters_ : batch_waiters_;
+    
+    // 空闲且本通道及更高优先级通道均无人排队时直接准入
+    bool idle = owner_depth_ == 0 && interactive_waiters_.empty() &&
+                (priority == AdmissionPriority::INTERACTIVE || batch_waiters_.empty());
+    if (!idle) {
+        if (interactive_waiters_.size() + batch_waiters_.size() >= max_queued_) {
+            ++metrics_.rejected;
+            last_status = AdmissionStatus::REJECTED;
+            return last_status;
+        }
+        
+        std::uint64_t waiter = next_waiter_++;
+        queue.push_back(waiter);
+        metrics_.peak_queue_depth = std::max(metrics_.peak_queue_depth,
+                                             interactive_waiters_.size() + batch_waiters_.size());
+        Clock::time_point enqueued = Clock::now();
+        
+        auto my_turn = [this, waiter, priority]() {
+            return isNext(waiter, priority);
+        };
+        bool turn = true;
+        if (deadline == Clock::time_point::max()) {
+            turn_cv_.wait(lock, my_turn);
+        } else {
+            turn = turn_cv_.wait_until(lock, deadline, my_turn);
+        }
+        
+        if (!turn) {
+            queue.erase(std::find(queue.begin(), queue.end(), waiter));
+            ++metrics_.deadline_exceeded;
+            // 队首离开后下一个等待者可能已可以准入
+            turn_cv_.notify_all();
+            last_status = AdmissionStatus::DEADLINE_EXCEEDED;
+            return last_status;
+        }
+        
+        queue.pop_front();
+        if (priority == AdmissionPriority::INTERACTIVE && !batch_waiters_.empty() &&
+            batch_waiters_.front() < waiter) {
+            ++metrics_.preemptions;
+        }
+        metrics_.total_wait_us += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - enqueued).count());
+    } else if (priority == AdmissionPriority::INTERACTIVE && !batch_waiters_.empty()) {
+        ++metrics_.preemptions;
+    }
+    
+    owner_ = self;
+    owner_depth_ = 1;
+    ++metrics_.admitted;
+    if (priority == AdmissionPriority::BATCH) {
+        ++metrics_.batch_admitted;
+    }
+    last_status = AdmissionStatus::ADMITTED;
+    return last_status;
+}
+
+void AdmissionController::release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--owner_depth_ == 0) {
+        owner_ = std::thread::id();
+        turn_cv_.notify_all();
+    }
+}
+
+AdmissionMetrics AdmissionController::metrics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AdmissionMetrics snapshot = metrics_;
+    snapshot.queue_depth = interactive_waiters_.size() + batch_waiters_.size();
+    return snapshot;
+}
+
+bool AdmissionController::interactiveWaiting() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !interactive_waiters_.empty();
+}
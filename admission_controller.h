@@ -0,0 +1,158 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// 准入结果
+enum class AdmissionStatus {
+    ADMITTED,
+    REJECTED,           // 等待队列已满，立即拒绝
+    DEADLINE_EXCEEDED   // 在截止时间前未轮到执行
+};
+
+// 优先级：交互式写入优先于批量写入准入
+enum class AdmissionPriority {
+    INTERACTIVE,
+    BATCH
+};
+
+// 准入控制指标快照
+struct AdmissionMetrics {
+    std::uint64_t admitted;
+    std::uint64_t rejected;
+    std::uint64_t deadline_exceeded;
+    std::size_t queue_depth;       // 当前等待的写入者数量
+    std::size_t peak_queue_depth;  // 历史最大等待数量
+    std::uint64_t total_wait_us;   // 已准入写入者的累计排队时间
+    std::uint64_t batch_admitted;  // 其中批量写入的准入次数
+    std::uint64_t preemptions;     // 交互式写入越过排队中批量写入的次数
+};
+
+// 写入准入控制器
+//
+// 位于每个数据库连接的写入路径之前：同一时刻只准入一个写入者，其余写入者
+// 按到达顺序排队。队列长度有上限，超过上限的请求立即被拒绝；排队超过截止
+// 时间的请求放弃执行。过载时调用方得到明确的拒绝结果，而不是无限期地阻塞在
+// 连接互斥量或SQLite的忙等待上。
+//
+// 准入可重入：已持有准入的线程再次申请时直接通过，使批量操作、分布式事务
+// 内部的单条写入不会自我阻塞。
+//
+// 等待者分为交互式与批量两条通道：每次归还准入时优先准入交互式队首，
+// 批量通道只在没有交互式等待者时前进。批量写入默认不设截止时间（可由
+// ScopedDeadline限定），应拆分为有界的分块事务，使交互式写入能在块间插队。
+class AdmissionController {
+public:
+    typedef std::chrono::steady_clock Clock;
+    
+    AdmissionController(std::size_t max_queued, std::chrono::milliseconds default_deadline);
+    
+    // 准入凭证：构造时申请，析构时归还
+    class Ticket {
+    public:
+        explicit Ticket(AdmissionController& controller);
+        Ticket(AdmissionController& controller, Clock::time_point deadline);
+        Ticket(AdmissionController& controller, AdmissionPriority priority);
+        ~Ticket();
+        
+        bool admitted() const {
+            return status_ == AdmissionStatus::ADMITTED;
+        }
+        
+        AdmissionStatus status() const {
+            return status_;
+        }
+        
+    private:
+        Ticket(const Ticket&) = delete;
+        Ticket& operator=(const Ticket&) = delete;
+        
+        AdmissionController& controller_;
+        AdmissionStatus status_;
+    };
+    
+    // 管理器写入方法的入口：先获得准入，再锁定连接互斥量。过载时写入者在准入队列中
+    // 排队或被拒绝，而不是无限期地阻塞在连接互斥量上；admitted()为false时未加锁，
+    // 调用方应立即返回失败（原因见lastStatus()）
+    class WriteGuard {
+    public:
+        WriteGuard(AdmissionController& controller, std::recursive_mutex& mutex,
+                   AdmissionPriority priority = AdmissionPriority::INTERACTIVE);
+        
+        bool admitted() const {
+            return ticket_.admitted();
+        }
+        
+    private:
+        WriteGuard(const WriteGuard&) = delete;
+        WriteGuard& operator=(const WriteGuard&) = delete;
+        
+        Ticket ticket_;
+        std::unique_lock<std::recursive_mutex> lock_;  // 先于ticket_析构，解锁后才归还准入
+    };
+    
+    // 为当前线程在作用域内的写入设置截止时间，覆盖控制器的默认值
+    class ScopedDeadline {
+    public:
+        explicit ScopedDeadline(std::chrono::milliseconds timeout);
+        ~ScopedDeadline();
+        
+    private:
+        ScopedDeadline(const ScopedDeadline&) = delete;
+        ScopedDeadline& operator=(const ScopedDeadline&) = delete;
+        
+        bool had_previous_;
+        Clock::time_point previous_;
+    };
+    
+    // 当前线程最近一次准入申请的结果，写入方法返回false时用于区分过载与其他错误
+    static AdmissionStatus lastStatus();
+    
+    AdmissionMetrics metrics() const;
+    
+    // 是否有交互式写入在等待，批量操作可据此提前结束当前分块
+    bool interactiveWaiting() const;
+    
+private:
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+    
+    AdmissionStatus acquire(Clock::time_point deadline, AdmissionPriority priority);
+    void release();
+    Clock::time_point defaultDeadline() const;
+    bool isNext(std::uint64_t waiter, AdmissionPriority priority) const;
+    
+    const std::size_t max_queued_;
+    const std::chrono::milliseconds default_deadline_;
+    
+    mutable std::mutex mutex_;
+    std::condition_variable turn_cv_;
+    std::deque<std::uint64_t> interactive_waiters_;  // 排队者编号，按到达顺序
+    std::deque<std::uint64_t> batch_waiters_;
+    std::uint64_t next_waiter_;
+    std::thread::id owner_;
+    std::size_t owner_depth_;            // 重入深度，0表示空闲
+    
+    AdmissionMetrics metrics_;
+};
+
+// 需要一次性获得多个准入的操作（如分布式事务）被拒绝时抛出
+class AdmissionRejected : public std::runtime_error {
+public:
+    AdmissionRejected(const std::string& message, AdmissionStatus status)
+        : std::runtime_error(message), status_(status) {}
+        
+    AdmissionStatus status() const {
+        return status_;
+    }
+    
+private:
+    AdmissionStatus status_;
+};
@@ -0,0 +1,76 @@
+#include "bloom_filter.h"
+#include <cstdint>
+
+namespace {
+
+// 每个字内位位置的乘数，取自Parquet的分块布隆过滤器
+const std::uint32_t kSalts[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+const std::size_t kBitsPerItem = 16;
+const std::size_t kBlockBits = 512;
+
+}  // namespace
+
+BlockedBloomFilter::BlockedBloomFilter(std::size_t expected_items)
+    : capacity_(expected_items > 0 ? expected_items : 1), block_mask_(0), words_(nullptr) {
+    // 块数取2的幂，便于以掩码选块
+    std::size_t blocks = 1;
+    while (blocks * kBlockBits < capacity_ * kBitsPerItem) {
+        blocks <<= 1;
+    }
+    block_mask_ = blocks - 1;
+    
+    std::size_t words = blocks * kBlockWords;
+    storage_.reset(new std::atomic<std::uint64_t>[words + kBlockWords]);
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(storage_.get());
+    std::uintptr_t aligned = (address + 63) & ~static_cast<std::uintptr_t>(63);
+    words_ = reinterpret_cast<std::atomic<std::uint64_t>*>(aligned);
+    for (std::size_t i = 0; i < words; ++i) {
+        words_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+std::uint64_t BlockedBloomFilter::hash(const std::string& key, std::uint64_t seed) {
+    // FNV-1a后接splitmix64终结函数，使高低位都充分混合
+    std::uint64_t h = 0xcbf29ce484222325ULL ^ (seed * 0x9e3779b97f4a7c15ULL);
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+std::atomic<std::uint64_t>* BlockedBloomFilter::block(std::uint64_t hash) const {
+    return words_ + ((hash >> 32) & block_mask_) * kBlockWords;
+}
+
+void BlockedBloomFilter::insert(const std::string& key, std::uint64_t seed) {
+    std::uint64_t h = hash(key, seed);
+    std::atomic<std::uint64_t>* words = block(h);
+    std::uint32_t low = static_cast<std::uint32_t>(h);
+    for (std::size_t i = 0; i < kBlockWords; ++i) {
+        std::uint32_t bit = (low * kSalts[i]) >> 26;
+        words[i].fetch_or(std::uint64_t(1) << bit, std::memory_order_release);
+    }
+}
+
+bool BlockedBloomFilter::mayContain(const std::string& key, std::uint64_t seed) const {
+    std::uint64_t h = hash(key, seed);
+    const std::atomic<std::uint64_t>* words = block(h);
+    std::uint32_t low = static_cast<std::uint32_t>(h);
+    for (std::size_t i = 0; i < kBlockWords; ++i) {
+        std::uint32_t bit = (low * kSalts[i]) >> 26;
+        if (!(words[i].load(std::memory_order_acquire) & (std::uint64_t(1) << bit))) {
+            return false;
+        }
+    }
+    return true;
+}
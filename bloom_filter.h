@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// 分块布隆过滤器
+//
+// 位数组划分为64字节的块（恰为一个缓存行），每个键只落在一个块内，在块的
+// 8个字中各置一位，因此一次查询只访问一个缓存行。按每键16位设计容量时
+// 假阳性率约为0.5%。不支持删除：被删除的键只会造成假阳性，由使用方按需重建。
+// 位数组为原子字，插入与查询可并发进行，查询不加锁。
+class BlockedBloomFilter {
+public:
+    // expected_items为设计容量，超过后假阳性率上升
+    explicit BlockedBloomFilter(std::size_t expected_items);
+    
+    // seed区分不同的键空间（如用户名与邮箱），同一字符串在不同seed下互不干扰
+    void insert(const std::string& key, std::uint64_t seed = 0);
+    // 返回false时键一定不存在；返回true时键可能存在
+    bool mayContain(const std::string& key, std::uint64_t seed = 0) const;
+    
+    std::size_t capacity() const {
+        return capacity_;
+    }
+    
+    std::size_t memoryBytes() const {
+        return (block_mask_ + 1) * kBlockWords * sizeof(std::uint64_t);
+    }
+    
+private:
+    BlockedBloomFilter(const BlockedBloomFilter&) = delete;
+    BlockedBloomFilter& operator=(const BlockedBloomFilter&) = delete;
+    
+    static const std::size_t kBlockWords = 8;
+    
+    static std::uint64_t hash(const std::string& key, std::uint64_t seed);
+    std::atomic<std::uint64_t>* block(std::uint64_t hash) const;
+    
+    std::size_t capacity_;
+    std::size_t block_mask_;
+    // 多分配一块，使words_按64字节对齐
+    std::unique_ptr<std::atomic<std::uint64_t>[]> storage_;
+    std::atomic<std::uint64_t>* words_;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "admission_controller.h"
+#include "transaction_scope.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// 分块批量写入
+//
+// 将大批量写入拆分为多个有界事务，每块在批量通道上单独获得准入、单独提交，
+// 块间归还准入与连接互斥量，使排队的交互式写入得以插队。交互式写入等待时
+// 当前块提前结束（至少写入一行），以缩短其排队时间。
+// 整批不再是原子的：返回值为已提交的行数，失败时之后的行不会写入。
+// 连接已处于外层事务中时无法分块，整批在外层事务内以一个保存点执行。
+template <typename Row, typename WriteRow>
+std::size_t writeInChunks(AdmissionController& admission, std::recursive_mutex& mutex, sqlite3* db,
+                          const std::vector<Row>& rows, std::size_t chunk_rows, WriteRow write_row) {
+    std::size_t committed = 0;
+    if (chunk_rows == 0) {
+        chunk_rows = 1;
+    }
+    
+    while (committed < rows.size()) {
+        AdmissionController::Ticket ticket(admission, AdmissionPriority::BATCH);
+        if (!ticket.admitted()) {
+            return committed;
+        }
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        
+        bool nested = !sqlite3_get_autocommit(db);
+        TransactionScope transaction(db);
+        if (!transaction.active()) {
+            return committed;
+        }
+        
+        std::size_t end = nested ? rows.size() : std::min(rows.size(), committed + chunk_rows);
+        std::size_t next = committed;
+        while (next < end) {
+            if (!write_row(rows[next])) {
+                return committed; // 作用域析构时回滚当前块
+            }
+            ++next;
+            if (!nested && admission.interactiveWaiting()) {
+                break;
+            }
+        }
+        
+        if (!transaction.commit()) {
+            return committed;
+        }
+        committed = next;
+    }
+    
+    return committed;
+}
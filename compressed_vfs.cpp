@@ -0,0 +1,886 @@
+#include "compressed_vfs.h"
+#include "io_stats_vfs.h"
+#include <zlib.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+const std::uint32_t kSuperMagic = 0x5A50434D;  // "MCPZ"
+const std::uint32_t kMapMagic = 0x504D434D;    // "MCMP"
+const std::uint32_t kFormatVersion = 1;
+const std::uint64_t kUnit = 512;               // 物理分配单位
+const std::uint64_t kGroupSize = 64 * 1024;    // 逻辑页组大小
+const std::uint64_t kDataStartUnit = 2;        // 单位0、1为超级块槽位
+const std::size_t kSuperSize = 40;
+const std::size_t kMapHeaderSize = 32;
+const std::size_t kMapEntrySize = 24;
+const std::size_t kCacheGroups = 32;           // 每个文件缓存的解压页组数量
+const std::uint32_t kStoredRaw = 1;            // 压缩无收益时原样存储
+
+void putU32(unsigned char* out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+void putU64(unsigned char* out, std::uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+std::uint32_t getU32(const unsigned char* in) {
+    std::uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+std::uint64_t getU64(const unsigned char* in) {
+    std::uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+std::uint32_t checksum(const unsigned char* data, std::size_t size) {
+    return static_cast<std::uint32_t>(crc32(0L, data, static_cast<uInt>(size)));
+}
+
+std::uint64_t unitsFor(std::uint64_t bytes) {
+    return (bytes + kUnit - 1) / kUnit;
+}
+
+// 物理区间，以分配单位计
+struct Extent {
+    std::uint64_t unit;
+    std::uint64_t units;
+};
+
+// 映射条目：页组在物理文件中的位置
+struct GroupEntry {
+    Extent extent;
+    std::uint32_t stored_len;
+    std::uint32_t flags;
+    std::uint32_t crc;
+};
+
+struct CachedGroup {
+    std::vector<unsigned char> data;
+    bool dirty;
+    std::list<std::uint32_t>::iterator lru;
+};
+
+// 同一路径的共享状态，由该文件的所有连接共用
+struct Store {
+    std::mutex mutex;
+    std::string path;
+    int refs;
+    sqlite3_file* data;  // 读写页组的独立句柄，从不加锁
+    
+    std::uint64_t logical_size;
+    std::uint64_t generation;      // 最近一次持久化映射的代数
+    int active_slot;               // 最近写入的超级块槽位
+    Extent map_extent;             // 当前持久映射的位置，units为0表示尚无
+    bool map_dirty;                // 内存映射或逻辑大小与磁盘不一致
+    
+    std::map<std::uint32_t, GroupEntry> groups;
+    std::map<std::uint64_t, std::uint64_t> free_extents;  // 起始单位 -> 单位数
+    std::vector<Extent> pending_free;  // 持久映射仍引用，下次提交后释放
+    std::uint64_t end_unit;
+    
+    std::unordered_map<std::uint32_t, CachedGroup> cache;
+    std::list<std::uint32_t> lru;  // 最近使用在前
+};
+
+// 包装文件：每个连接自己的底层句柄（用于加锁与共享内存）紧随其后
+struct CompressedFile {
+    sqlite3_file base;
+    Store* store;
+    sqlite3_file* real;
+};
+
+sqlite3_vfs compressed_vfs;
+sqlite3_vfs* root_vfs = nullptr;
+std::once_flag install_once;
+
+// 打开的文件表有意不析构，理由同I/O统计VFS
+struct Registry {
+    std::mutex mutex;
+    std::map<std::string, Store*> stores;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+// ---- 物理空间 ----
+
+int readRaw(Store& store, void* buffer, std::uint64_t size, std::uint64_t offset) {
+    return store.data->pMethods->xRead(store.data, buffer, static_cast<int>(size),
+                                       static_cast<sqlite3_int64>(offset));
+}
+
+int writeRaw(Store& store, const void* buffer, std::uint64_t size, std::uint64_t offset) {
+    return store.data->pMethods->xWrite(store.data, buffer, static_cast<int>(size),
+                                        static_cast<sqlite3_int64>(offset));
+}
+
+void releaseExtent(Store& store, Extent extent) {
+    if (extent.units == 0) {
+        return;
+    }
+    auto next = store.free_extents.lower_bound(extent.unit);
+    // 与前后空闲区间合并
+    if (next != store.free_extents.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == extent.unit) {
+            extent.unit = prev->first;
+            extent.units += prev->second;
+            store.free_extents.erase(prev);
+        }
+    }
+    if (next != store.free_extents.end() && extent.unit + extent.units == next->first) {
+        extent.units += next->second;
+        store.free_extents.erase(next);
+    }
+    store.free_extents[extent.unit] = extent.units;
+}
+
+Extent allocateExtent(Store& store, std::uint64_t units) {
+    for (auto it = store.free_extents.begin(); it != store.free_extents.end(); ++it) {
+        if (it->second >= units) {
+            Extent extent = {it->first, units};
+            std::uint64_t remaining = it->second - units;
+            store.free_extents.erase(it);
+            if (remaining > 0) {
+                store.free_extents[extent.unit + units] = remaining;
+            }
+            return extent;
+        }
+    }
+    Extent extent = {store.end_unit, units};
+    store.end_unit += units;
+    return extent;
+}
+
+// ---- 页组 ----
+
+int writeGroup(Store& store, std::uint32_t index, CachedGroup& cached) {
+    uLongf stored_len = compressBound(kGroupSize);
+    std::vector<unsigned char> stored(stored_len);
+    std::uint32_t flags = 0;
+    if (compress2(stored.data(), &stored_len, cached.data.data(), kGroupSize, Z_BEST_SPEED) != Z_OK ||
+        unitsFor(stored_len) >= unitsFor(kGroupSize)) {
+        std::memcpy(stored.data(), cached.data.data(), kGroupSize);
+        stored_len = kGroupSize;
+        flags = kStoredRaw;
+    }
+    
+    GroupEntry entry;
+    entry.extent = allocateExtent(store, unitsFor(stored_len));
+    entry.stored_len = static_cast<std::uint32_t>(stored_len);
+    entry.flags = flags;
+    entry.crc = checksum(stored.data(), stored_len);
+    
+    int result = writeRaw(store, stored.data(), stored_len, entry.extent.unit * kUnit);
+    if (result != SQLITE_OK) {
+        releaseExtent(store, entry.extent);
+        return result;
+    }
+    
+    auto existing = store.groups.find(index);
+    if (existing != store.groups.end()) {
+        store.pending_free.push_back(existing->second.extent);
+    }
+    store.groups[index] = entry;
+    store.map_dirty = true;
+    cached.dirty = false;
+    return SQLITE_OK;
+}
+
+int readGroup(Store& store, std::uint32_t index, std::vector<unsigned char>& out) {
+    auto it = store.groups.find(index);
+    if (it == store.groups.end()) {
+        return SQLITE_OK;  // 从未写入的页组读作全零
+    }
+    const GroupEntry& entry = it->second;
+    std::vector<unsigned char> stored(entry.stored_len);
+    int result = readRaw(store, stored.data(), entry.stored_len, entry.extent.unit * kUnit);
+    if (result != SQLITE_OK) {
+        return result;
+    }
+    if (checksum(stored.data(), entry.stored_len) != entry.crc) {
+        return SQLITE_IOERR_READ;
+    }
+    if (entry.flags & kStoredRaw) {
+        std::memcpy(out.data(), stored.data(), kGroupSize);
+        return SQLITE_OK;
+    }
+    uLongf raw_len = kGroupSize;
+    if (uncompress(out.data(), &raw_len, stored.data(), entry.stored_len) != Z_OK || raw_len != kGroupSize) {
+        return SQLITE_IOERR_READ;
+    }
+    return SQLITE_OK;
+}
+
+// 取得缓存中的页组；load为false时调用方将覆盖整个页组，无需读盘
+int cachedGroup(Store& store, std::uint32_t index, bool load, CachedGroup** out) {
+    auto it = store.cache.find(index);
+    if (it != store.cache.end()) {
+        store.lru.splice(store.lru.begin(), store.lru, it->second.lru);
+        *out = &it->second;
+        return SQLITE_OK;
+    }
+    
+    // 淘汰最久未用的页组，脏页组先写出（不同步，旧位置仍由持久映射保留）
+    if (store.cache.size() >= kCacheGroups) {
+        std::uint32_t victim = store.lru.back();
+        CachedGroup& evicted = store.cache[victim];
+        if (evicted.dirty) {
+            int result = writeGroup(store, victim, evicted);
+            if (result != SQLITE_OK) {
+                return result;
+            }
+        }
+        store.lru.pop_back();
+        store.cache.erase(victim);
+    }
+    
+    CachedGroup fresh;
+    fresh.data.assign(kGroupSize, 0);
+    fresh.dirty = false;
+    if (load) {
+        int result = readGroup(store, index, fresh.data);
+        if (result != SQLITE_OK) {
+            return result;
+        }
+    }
+    store.lru.push_front(index);
+    fresh.lru = store.lru.begin();
+    CachedGroup& inserted = store.cache[index];
+    inserted = std::move(fresh);
+    *out = &inserted;
+    return SQLITE_OK;
+}
+
+void dropCachedGroup(Store& store, std::uint32_t index) {
+    auto it = store.cache.find(index);
+    if (it != store.cache.end()) {
+        store.lru.erase(it->second.lru);
+        store.cache.erase(it);
+    }
+}
+
+// ---- 映射持久化 ----
+
+// 碎片整理：空闲空间超过有效数据的四分之一时，从文件尾部起把页组记录原样
+// 复制到更靠前的空洞中，返回是否有记录被移动
+bool relocateTail(Store& store) {
+    std::uint64_t free_units = 0;
+    for (const auto& item : store.free_extents) {
+        free_units += item.second;
+    }
+    std::uint64_t live_units = store.end_unit - kDataStartUnit - free_units;
+    if (free_units < 256 || free_units * 4 < live_units) {
+        return false;
+    }
+    
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> by_position;
+    for (const auto& item : store.groups) {
+        by_position.push_back(std::make_pair(item.second.extent.unit, item.first));
+    }
+    std::sort(by_position.rbegin(), by_position.rend());
+    
+    bool moved = false;
+    std::vector<unsigned char> buffer;
+    for (const auto& item : by_position) {
+        GroupEntry& entry = store.groups[item.second];
+        if (store.free_extents.empty() || store.free_extents.begin()->first > entry.extent.unit) {
+            break;  // 前面已没有空洞
+        }
+        Extent target = allocateExtent(store, entry.extent.units);
+        if (target.unit > entry.extent.unit) {
+            releaseExtent(store, target);
+            continue;
+        }
+        buffer.resize(entry.stored_len);
+        if (readRaw(store, buffer.data(), entry.stored_len, entry.extent.unit * kUnit) != SQLITE_OK ||
+            writeRaw(store, buffer.data(), entry.stored_len, target.unit * kUnit) != SQLITE_OK) {
+            releaseExtent(store, target);
+            break;
+        }
+        store.pending_free.push_back(entry.extent);
+        entry.extent = target;
+        moved = true;
+    }
+    if (moved) {
+        store.map_dirty = true;
+    }
+    return moved;
+}
+
+// 写出脏页组与映射，同步后切换超级块，再释放被替换的旧位置
+int commitStore(Store& store, int sync_flags, bool compact = true) {
+    for (auto& item : store.cache) {
+        if (item.second.dirty) {
+            int result = writeGroup(store, item.first, item.second);
+            if (result != SQLITE_OK) {
+                return result;
+            }
+        }
+    }
+    if (!store.map_dirty) {
+        return SQLITE_OK;
+    }
+    
+    std::uint64_t generation = store.generation + 1;
+    std::vector<unsigned char> map(kMapHeaderSize + store.groups.size() * kMapEntrySize, 0);
+    putU32(&map[0], kMapMagic);
+    putU32(&map[4], static_cast<std::uint32_t>(store.groups.size()));
+    putU64(&map[8], generation);
+    putU64(&map[16], store.logical_size);
+    unsigned char* entry_out = &map[kMapHeaderSize];
+    for (const auto& item : store.groups) {
+        putU32(entry_out, item.first);
+        putU32(entry_out + 4, item.second.stored_len);
+        putU32(entry_out + 8, item.second.flags);
+        putU32(entry_out + 12, item.second.crc);
+        putU64(entry_out + 16, item.second.extent.unit);
+        entry_out += kMapEntrySize;
+    }
+    putU32(&map[24], checksum(&map[kMapHeaderSize], map.size() - kMapHeaderSize));
+    putU32(&map[28], checksum(&map[0], 28));
+    
+    Extent map_extent = allocateExtent(store, unitsFor(map.size()));
+    int result = writeRaw(store, map.data(), map.size(), map_extent.unit * kUnit);
+    if (result == SQLITE_OK) {
+        result = store.data->pMethods->xSync(store.data, sync_flags);
+    }
+    if (result != SQLITE_OK) {
+        releaseExtent(store, map_extent);
+        return result;
+    }
+    
+    // 页组与映射已落盘，写入另一个超级块槽位使其生效
+    unsigned char super[kSuperSize] = {0};
+    putU32(&super[0], kSuperMagic);
+    putU32(&super[4], kFormatVersion);
+    putU32(&super[8], static_cast<std::uint32_t>(kGroupSize));
+    putU32(&super[12], static_cast<std::uint32_t>(map.size()));
+    putU64(&super[16], generation);
+    putU64(&super[24], map_extent.unit);
+    putU32(&super[32], checksum(super, 32));
+    int slot = 1 - store.active_slot;
+    result = writeRaw(store, super, kSuperSize, slot * kUnit);
+    if (result == SQLITE_OK) {
+        result = store.data->pMethods->xSync(store.data, sync_flags);
+    }
+    if (result != SQLITE_OK) {
+        releaseExtent(store, map_extent);
+        return result;
+    }
+    
+    store.active_slot = slot;
+    store.generation = generation;
+    releaseExtent(store, store.map_extent);
+    store.map_extent = map_extent;
+    for (const auto& extent : store.pending_free) {
+        releaseExtent(store, extent);
+    }
+    store.pending_free.clear();
+    store.map_dirty = false;
+    
+    // 文件末尾的空闲空间归还给文件系统
+    if (!store.free_extents.empty()) {
+        auto last = std::prev(store.free_extents.end());
+        if (last->first + last->second == store.end_unit) {
+            store.end_unit = last->first;
+            store.free_extents.erase(last);
+            store.data->pMethods->xTruncate(store.data, static_cast<sqlite3_int64>(store.end_unit * kUnit));
+        }
+    }
+    
+    // 写时复制在文件中部留下空洞，碎片过多时把尾部记录搬入空洞后再提交一次
+    if (compact && relocateTail(store)) {
+        return commitStore(store, sync_flags, false);
+    }
+    return SQLITE_OK;
+}
+
+// 读取超级块与映射，重建页组表与空闲空间
+int loadStore(Store& store) {
+    sqlite3_int64 physical_size = 0;
+    int result = store.data->pMethods->xFileSize(store.data, &physical_size);
+    if (result != SQLITE_OK) {
+        return result;
+    }
+    
+    store.logical_size = 0;
+    store.generation = 0;
+    store.active_slot = 1;
+    store.map_extent.unit = 0;
+    store.map_extent.units = 0;
+    store.map_dirty = false;
+    store.end_unit = kDataStartUnit;
+    if (physical_size == 0) {
+        return SQLITE_OK;
+    }
+    
+    // 未压缩的数据库文件或其他格式在此被拒绝
+    if (static_cast<std::uint64_t>(physical_size) < kDataStartUnit * kUnit) {
+        return SQLITE_NOTADB;
+    }
+    unsigned char supers[2][kSuperSize];
+    for (int slot = 0; slot < 2; ++slot) {
+        result = readRaw(store, supers[slot], kSuperSize, slot * kUnit);
+        if (result != SQLITE_OK) {
+            return result;
+        }
+    }
+    int chosen = -1;
+    for (int slot = 0; slot < 2; ++slot) {
+        const unsigned char* super = supers[slot];
+        bool valid = getU32(super) == kSuperMagic && getU32(super + 4) == kFormatVersion &&
+                     getU32(super + 8) == kGroupSize && getU32(super + 32) == checksum(super, 32);
+        if (valid && (chosen < 0 || getU64(super + 16) > getU64(supers[chosen] + 16))) {
+            chosen = slot;
+        }
+    }
+    if (chosen < 0) {
+        return SQLITE_NOTADB;
+    }
+    
+    std::uint32_t map_size = getU32(supers[chosen] + 12);
+    std::uint64_t map_unit = getU64(supers[chosen] + 24);
+    if (map_size < kMapHeaderSize) {
+        return SQLITE_CORRUPT;
+    }
+    std::vector<unsigned char> map(map_size);
+    result = readRaw(store, map.data(), map_size, map_unit * kUnit);
+    if (result != SQLITE_OK) {
+        return result;
+    }
+    std::uint32_t count = getU32(&map[4]);
+    if (getU32(&map[0]) != kMapMagic || getU32(&map[28]) != checksum(&map[0], 28) ||
+        map_size != kMapHeaderSize + count * kMapEntrySize ||
+        getU32(&map[24]) != checksum(&map[kMapHeaderSize], map_size - kMapHeaderSize)) {
+        return SQLITE_CORRUPT;
+    }
+    
+    store.generation = getU64(supers[chosen] + 16);
+    store.active_slot = chosen;
+    store.logical_size = getU64(&map[16]);
+    store.map_extent.unit = map_unit;
+    store.map_extent.units = unitsFor(map_size);
+    
+    std::vector<Extent> used;
+    used.push_back(store.map_extent);
+    const unsigned char* entry_in = &map[kMapHeaderSize];
+    for (std::uint32_t i = 0; i < count; ++i, entry_in += kMapEntrySize) {
+        GroupEntry entry;
+        entry.stored_len = getU32(entry_in + 4);
+        entry.flags = getU32(entry_in + 8);
+        entry.crc = getU32(entry_in + 12);
+        entry.extent.unit = getU64(entry_in + 16);
+        entry.extent.units = unitsFor(entry.stored_len);
+        store.groups[getU32(entry_in)] = entry;
+        used.push_back(entry.extent);
+    }
+    
+    // 未被映射引用的空间均可复用
+    std::sort(used.begin(), used.end(), [](const Extent& a, const Extent& b) {
+        return a.unit < b.unit;
+    });
+    std::uint64_t cursor = kDataStartUnit;
+    for (const auto& extent : used) {
+        if (extent.unit > cursor) {
+            releaseExtent(store, {cursor, extent.unit - cursor});
+        }
+        cursor = std::max(cursor, extent.unit + extent.units);
+    }
+    store.end_unit = std::max(cursor, unitsFor(static_cast<std::uint64_t>(physical_size)));
+    if (store.end_unit > cursor) {
+        releaseExtent(store, {cursor, store.end_unit - cursor});
+    }
+    return SQLITE_OK;
+}
+
+int acquireStore(const char* name, int flags, Store** out) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto it = reg.stores.find(name);
+    if (it != reg.stores.end()) {
+        ++it->second->refs;
+        *out = it->second;
+        return SQLITE_OK;
+    }
+    
+    std::unique_ptr<Store> store(new Store());
+    store->path = name;
+    store->refs = 1;
+    store->data = static_cast<sqlite3_file*>(std::calloc(1, root_vfs->szOsFile));
+    if (!store->data) {
+        return SQLITE_NOMEM;
+    }
+    int data_flags = (flags & (SQLITE_OPEN_READONLY | SQLITE_OPEN_READWRITE)) | SQLITE_OPEN_MAIN_DB;
+    int result = root_vfs->xOpen(root_vfs, store->path.c_str(), store->data, data_flags, nullptr);
+    if (result == SQLITE_OK) {
+        result = loadStore(*store);
+    }
+    if (result != SQLITE_OK) {
+        if (store->data->pMethods) {
+            store->data->pMethods->xClose(store->data);
+        }
+        std::free(store->data);
+        return result;
+    }
+    
+    *out = store.get();
+    reg.stores[store->path] = store.release();
+    return SQLITE_OK;
+}
+
+int releaseStore(Store* store) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    if (--store->refs > 0) {
+        return SQLITE_OK;
+    }
+    int result;
+    {
+        std::lock_guard<std::mutex> store_lock(store->mutex);
+        result = commitStore(*store, SQLITE_SYNC_NORMAL);
+    }
+    store->data->pMethods->xClose(store->data);
+    std::free(store->data);
+    reg.stores.erase(store->path);
+    delete store;
+    return result;
+}
+
+// ---- 文件方法 ----
+
+Store& storeOf(sqlite3_file* file) {
+    return *reinterpret_cast<CompressedFile*>(file)->store;
+}
+
+sqlite3_file* realFile(sqlite3_file* file) {
+    return reinterpret_cast<CompressedFile*>(file)->real;
+}
+
+int compressedClose(sqlite3_file* file) {
+    int result = releaseStore(reinterpret_cast<CompressedFile*>(file)->store);
+    sqlite3_file* real = realFile(file);
+    int close_result = real->pMethods->xClose(real);
+    file->pMethods = nullptr;
+    return result != SQLITE_OK ? result : close_result;
+}
+
+int compressedRead(sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset) {
+    Store& store = storeOf(file);
+    std::lock_guard<std::mutex> lock(store.mutex);
+    unsigned char* out = static_cast<unsigned char*>(buffer);
+    std::uint64_t position = static_cast<std::uint64_t>(offset);
+    std::uint64_t available = store.logical_size > position
+                                  ? std::min<std::uint64_t>(amount, store.logical_size - position) : 0;
+                                  
+    std::uint64_t done = 0;
+    while (done < available) {
+        std::uint32_t index = static_cast<std::uint32_t>((position + done) / kGroupSize);
+        std::uint64_t within = (position + done) % kGroupSize;
+        std::uint64_t chunk = std::min(kGroupSize - within, available - done);
+        CachedGroup* group = nullptr;
+        int result = cachedGroup(store, index, true, &group);
+        if (result != SQLITE_OK) {
+            return result;
+        }
+        std::memcpy(out + done, group->data.data() + within, chunk);
+        done += chunk;
+    }
+    
+    // 读取超出逻辑大小时按SQLite约定补零并报告短读
+    if (available < static_cast<std::uint64_t>(amount)) {
+        std::memset(out + available, 0, amount - available);
+        return SQLITE_IOERR_SHORT_READ;
+    }
+    return SQLITE_OK;
+}
+
+int compressedWrite(sqlite3_file* file, const void* buffer, int amount, sqlite3_int64 offset) {
+    Store& store = storeOf(file);
+    std::lock_guard<std::mutex> lock(store.mutex);
+    const unsigned char* in = static_cast<const unsigned char*>(buffer);
+    std::uint64_t position = static_cast<std::uint64_t>(offset);
+    
+    std::uint64_t done = 0;
+    while (done < static_cast<std::uint64_t>(amount)) {
+        std::uint32_t index = static_cast<std::uint32_t>((position + done) / kGroupSize);
+        std::uint64_t within = (position + done) % kGroupSize;
+        std::uint64_t chunk = std::min<std::uint64_t>(kGroupSize - within, amount - done);
+        CachedGroup* group = nullptr;
+        int result = cachedGroup(store, index, chunk != kGroupSize, &group);
+        if (result != SQLITE_OK) {
+            return SQLITE_IOERR_WRITE;
+        }
+        std::memcpy(group->data.data() + within, in + done, chunk);
+        group->dirty = true;
+        done += chunk;
+    }
+    
+    store.logical_size = std::max(store.logical_size, position + amount);
+    store.map_dirty = true;
+    return SQLITE_OK;
+}
+
+int compressedTruncate(sqlite3_file* file, sqlite3_int64 size) {
+    Store& store = storeOf(file);
+    std::lock_guard<std::mutex> lock(store.mutex);
+    std::uint64_t new_size = static_cast<std::uint64_t>(size);
+    std::uint32_t first_dropped = static_cast<std::uint32_t>((new_size + kGroupSize - 1) / kGroupSize);
+    
+    for (auto it = store.groups.lower_bound(first_dropped); it != store.groups.end();) {
+        store.pending_free.push_back(it->second.extent);
+        it = store.groups.erase(it);
+    }
+    std::vector<std::uint32_t> dropped;
+    for (const auto& item : store.cache) {
+        if (item.first >= first_dropped) {
+            dropped.push_back(item.first);
+        }
+    }
+    for (std::uint32_t index : dropped) {
+        dropCachedGroup(store, index);
+    }
+    
+    // 截断点落在页组中间时清零其后部，重新增长时读到的是零
+    if (new_size % kGroupSize != 0 && new_size < store.logical_size) {
+        CachedGroup* group = nullptr;
+        int result = cachedGroup(store, static_cast<std::uint32_t>(new_size / kGroupSize), true, &group);
+        if (result != SQLITE_OK) {
+            return SQLITE_IOERR_TRUNCATE;
+        }
+        std::fill(group->data.begin() + new_size % kGroupSize, group->data.end(), 0);
+        group->dirty = true;
+    }
+    
+    store.logical_size = new_size;
+    store.map_dirty = true;
+    return SQLITE_OK;
+}
+
+int compressedSync(sqlite3_file* file, int flags) {
+    Store& store = storeOf(file);
+    std::lock_guard<std::mutex> lock(store.mutex);
+    return commitStore(store, flags) == SQLITE_OK ? SQLITE_OK : SQLITE_IOERR_FSYNC;
+}
+
+int compressedFileSize(sqlite3_file* file, sqlite3_int64* size) {
+    Store& store = storeOf(file);
+    std::lock_guard<std::mutex> lock(store.mutex);
+    *size = static_cast<sqlite3_int64>(store.logical_size);
+    return SQLITE_OK;
+}
+
+int compressedLock(sqlite3_file* file, int lock) {
+    return realFile(file)->pMethods->xLock(realFile(file), lock);
+}
+
+int compressedUnlock(sqlite3_file* file, int lock) {
+    return realFile(file)->pMethods->xUnlock(realFile(file), lock);
+}
+
+int compressedCheckReservedLock(sqlite3_file* file, int* result) {
+    return realFile(file)->pMethods->xCheckReservedLock(realFile(file), result);
+}
+
+int compressedFileControl(sqlite3_file* file, int op, void* arg) {
+    // 物理布局由本层管理，预分配提示对压缩文件无意义
+    if (op == SQLITE_FCNTL_SIZE_HINT || op == SQLITE_FCNTL_CHUNK_SIZE) {
+        return SQLITE_OK;
+    }
+    return realFile(file)->pMethods->xFileControl(realFile(file), op, arg);
+}
+
+int compressedSectorSize(sqlite3_file* file) {
+    return realFile(file)->pMethods->xSectorSize(realFile(file));
+}
+
+int compressedDeviceCharacteristics(sqlite3_file* file) {
+    // 页组整体重写，不能承诺任何粒度的原子写
+    int atomic_bits = SQLITE_IOCAP_ATOMIC | SQLITE_IOCAP_ATOMIC512 | SQLITE_IOCAP_ATOMIC1K | SQLITE_IOCAP_ATOMIC2K |
+                      SQLITE_IOCAP_ATOMIC4K | SQLITE_IOCAP_ATOMIC8K | SQLITE_IOCAP_ATOMIC16K |
+                      SQLITE_IOCAP_ATOMIC32K | SQLITE_IOCAP_ATOMIC64K | SQLITE_IOCAP_BATCH_ATOMIC;
+    return realFile(file)->pMethods->xDeviceCharacteristics(realFile(file)) & ~atomic_bits;
+}
+
+int compressedShmMap(sqlite3_file* file, int region, int size, int extend, void volatile** pages) {
+    return realFile(file)->pMethods->xShmMap(realFile(file), region, size, extend, pages);
+}
+
+int compressedShmLock(sqlite3_file* file, int offset, int n, int flags) {
+    return realFile(file)->pMethods->xShmLock(realFile(file), offset, n, flags);
+}
+
+void compressedShmBarrier(sqlite3_file* file) {
+    realFile(file)->pMethods->xShmBarrier(realFile(file));
+}
+
+int compressedShmUnmap(sqlite3_file* file, int delete_flag) {
+    return realFile(file)->pMethods->xShmUnmap(realFile(file), delete_flag);
+}
+
+// 版本2：支持WAL所需的共享内存，不提供xFetch，使SQLite不对压缩文件使用mmap
+const sqlite3_io_methods kMethods = {
+    2, compressedClose, compressedRead, compressedWrite, compressedTruncate, compressedSync,
+    compressedFileSize, compressedLock, compressedUnlock, compressedCheckReservedLock,
+    compressedFileControl, compressedSectorSize, compressedDeviceCharacteristics,
+    compressedShmMap, compressedShmLock, compressedShmBarrier, compressedShmUnmap, nullptr, nullptr
+};
+
+// ---- VFS方法 ----
+
+int compressedOpen(sqlite3_vfs*, sqlite3_filename name, sqlite3_file* file, int flags, int* out_flags) {
+    // 只压缩有名称的主数据库文件，其余文件直接由底层VFS在同一结构上打开
+    if (!(flags & SQLITE_OPEN_MAIN_DB) || !name) {
+        return root_vfs->xOpen(root_vfs, name, file, flags, out_flags);
+    }
+    
+    CompressedFile* wrapper = reinterpret_cast<CompressedFile*>(file);
+    wrapper->base.pMethods = nullptr;
+    wrapper->store = nullptr;
+    wrapper->real = reinterpret_cast<sqlite3_file*>(wrapper + 1);
+    
+    int result = root_vfs->xOpen(root_vfs, name, wrapper->real, flags, out_flags);
+    if (result == SQLITE_OK) {
+        result = acquireStore(name, flags, &wrapper->store);
+    }
+    if (result != SQLITE_OK) {
+        if (wrapper->real->pMethods) {
+            wrapper->real->pMethods->xClose(wrapper->real);
+        }
+        return result;
+    }
+    
+    wrapper->base.pMethods = &kMethods;
+    return SQLITE_OK;
+}
+
+int compressedDelete(sqlite3_vfs*, const char* name, int sync_dir) {
+    return root_vfs->xDelete(root_vfs, name, sync_dir);
+}
+
+int compressedAccess(sqlite3_vfs*, const char* name, int flags, int* result) {
+    return root_vfs->xAccess(root_vfs, name, flags, result);
+}
+
+int compressedFullPathname(sqlite3_vfs*, const char* name, int size, char* out) {
+    return root_vfs->xFullPathname(root_vfs, name, size, out);
+}
+
+void* compressedDlOpen(sqlite3_vfs*, const char* name) {
+    return root_vfs->xDlOpen(root_vfs, name);
+}
+
+void compressedDlError(sqlite3_vfs*, int size, char* message) {
+    root_vfs->xDlError(root_vfs, size, message);
+}
+
+void (*compressedDlSym(sqlite3_vfs*, void* handle, const char* symbol))(void) {
+    return root_vfs->xDlSym(root_vfs, handle, symbol);
+}
+
+void compressedDlClose(sqlite3_vfs*, void* handle) {
+    root_vfs->xDlClose(root_vfs, handle);
+}
+
+int compressedRandomness(sqlite3_vfs*, int size, char* out) {
+    return root_vfs->xRandomness(root_vfs, size, out);
+}
+
+int compressedSleep(sqlite3_vfs*, int microseconds) {
+    return root_vfs->xSleep(root_vfs, microseconds);
+}
+
+int compressedCurrentTime(sqlite3_vfs*, double* now) {
+    return root_vfs->xCurrentTime(root_vfs, now);
+}
+
+int compressedGetLastError(sqlite3_vfs*, int size, char* out) {
+    return root_vfs->xGetLastError ? root_vfs->xGetLastError(root_vfs, size, out) : 0;
+}
+
+int compressedCurrentTimeInt64(sqlite3_vfs*, sqlite3_int64* now) {
+    return root_vfs->xCurrentTimeInt64(root_vfs, now);
+}
+
+}  // namespace
+
+const char* const CompressedVfs::kVfsName = "mc_compressed";
+
+void CompressedVfs::install() {
+    std::call_once(install_once, []() {
+        // 叠加在I/O统计VFS之上，统计中看到的是压缩后的物理读写
+        IoStatsVfs::install();
+        root_vfs = sqlite3_vfs_find(IoStatsVfs::kVfsName);
+        if (!root_vfs) {
+            throw std::runtime_error("未找到I/O统计VFS");
+        }
+        
+        compressed_vfs = sqlite3_vfs();
+        compressed_vfs.iVersion = std::min(root_vfs->iVersion, 2);
+        compressed_vfs.szOsFile = static_cast<int>(sizeof(CompressedFile)) + root_vfs->szOsFile;
+        compressed_vfs.mxPathname = root_vfs->mxPathname;
+        compressed_vfs.zName = kVfsName;
+        compressed_vfs.xOpen = compressedOpen;
+        compressed_vfs.xDelete = compressedDelete;
+        compressed_vfs.xAccess = compressedAccess;
+        compressed_vfs.xFullPathname = compressedFullPathname;
+        compressed_vfs.xDlOpen = compressedDlOpen;
+        compressed_vfs.xDlError = compressedDlError;
+        compressed_vfs.xDlSym = compressedDlSym;
+        compressed_vfs.xDlClose = compressedDlClose;
+        compressed_vfs.xRandomness = compressedRandomness;
+        compressed_vfs.xSleep = compressedSleep;
+        compressed_vfs.xCurrentTime = compressedCurrentTime;
+        compressed_vfs.xGetLastError = compressedGetLastError;
+        compressed_vfs.xCurrentTimeInt64 = root_vfs->iVersion >= 2 ? compressedCurrentTimeInt64 : nullptr;
+        
+        if (sqlite3_vfs_register(&compressed_vfs, 0) != SQLITE_OK) {
+            throw std::runtime_error("注册压缩VFS失败");
+        }
+    });
+}
+
+std::vector<CompressedFileStats> CompressedVfs::snapshot() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::vector<CompressedFileStats> result;
+    for (const auto& item : reg.stores) {
+        Store& store = *item.second;
+        std::lock_guard<std::mutex> store_lock(store.mutex);
+        CompressedFileStats stats;
+        stats.path = store.path;
+        stats.logical_size = store.logical_size;
+        stats.physical_size = store.end_unit * kUnit;
+        stats.groups = store.groups.size();
+        stats.stored_bytes = 0;
+        for (const auto& group : store.groups) {
+            stats.stored_bytes += group.second.stored_len;
+        }
+        result.push_back(stats);
+    }
+    return result;
+}
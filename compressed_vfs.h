@@ -0,0 +1,39 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 压缩文件统计快照
+struct CompressedFileStats {
+    std::string path;
+    std::uint64_t logical_size;   // SQLite看到的文件大小
+    std::uint64_t physical_size;  // 磁盘上的文件大小
+    std::uint64_t groups;         // 已存储的页组数量
+    std::uint64_t stored_bytes;   // 页组压缩后的字节数合计
+};
+
+// 页组压缩VFS
+//
+// 只压缩主数据库文件，WAL、共享内存与回滚日志原样透传。主库按固定大小的逻辑
+// 页组（64KB）以zlib压缩后写入物理文件，页组到物理位置的映射常驻内存，
+// 在每次xSync时整体写出并通过双槽位超级块切换生效：
+//
+//   单位0、1：超级块槽位A/B（代数、映射位置、校验和），取有效且代数较大者
+//   其余空间：页组记录与映射记录，按512字节单位分配
+//
+// 页组总是写时复制到新位置，被替换的旧位置在新映射持久化之后才会复用，
+// 因此崩溃时磁盘上总有一份完整且一致的映射。同一进程内同一文件的多个连接
+// 共享页组缓存与映射；不支持多进程同时打开压缩文件，也不支持mmap。
+// 已存在的未压缩数据库文件不能通过本VFS打开。
+class CompressedVfs {
+public:
+    static const char* const kVfsName;
+    
+    // 注册VFS（不设为默认），叠加在I/O统计VFS之上，可重复调用
+    static void install();
+    
+    // 当前打开的压缩文件统计
+    static std::vector<CompressedFileStats> snapshot();
+};
@@ -86,10 +86,14 @@ void DatabaseManager::configureDatabase() {
 }
 
 std::shared_ptr<sqlite3> DatabaseManager::getConnection() {
-    std::lock_guard<std::mutex> lock(connection_mutex_);
+    // db_connection_在构造函数中发布（由call_once同步），之后只读
     return db_connection_;
 }
 
+sqlite3* DatabaseManager::borrowConnection() const {
+    return db_connection_.get();
+}
+
 void DatabaseManager::initializeTables() {
     auto db = db_connection_.get();
     char* error_msg = nullptr;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "sqlite_deleter.h"
 #include <sqlite3.h>
 #include <memory>
 #include <mutex>
@@ -10,6 +11,8 @@ class DatabaseManager {
 public:
     static DatabaseManager& getInstance();
     std::shared_ptr<sqlite3> getConnection();
+    // 借用连接：返回不持有所有权的裸指针，热路径上无锁、无引用计数开销
+    sqlite3* borrowConnection() const;
     void initializeTables();
     ~DatabaseManager();
     
@@ -21,19 +24,10 @@ private:
     void openDatabase();
     void configureDatabase();
     
+    // 构造完成后不再修改，并发读取无需加锁
     std::shared_ptr<sqlite3> db_connection_;
-    std::mutex connection_mutex_;
     static std::once_flag initialized_;
     static std::unique_ptr<DatabaseManager> instance_;
     
     const std::string db_path_ = "app_database.db";
 };
-
-// 自定义删除器用于sqlite3指针
-struct SQLiteDeleter {
-    void operator()(sqlite3* db) {
-        if (db) {
-            sqlite3_close_v2(db);
-        }
-    }
-};
@@ -0,0 +1,165 @@
+#include "maintenance_runner.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 数据库维护工具
+//
+// 用法: db_maintenance [--threads 线程数] [--full] [--whole-file] [--skip-check]
+//                      [--offline [--sort-threads 线程数] [--index 数据库名 "CREATE INDEX ..."]...]
+// 默认只并行检查所有数据库文件并报告进度：执行quick_check并按表拆分，--full改为
+// integrity_check，--whole-file按整个文件检查（包括空闲页列表）。检查只在读者连接上
+// 读取，可与应用同时运行。
+// --offline时先构建各数据库声明的延后索引与--index指定的索引，须在应用停止后运行：
+// 每个索引在一个写事务内构建，准入只约束本进程，应用的写入无法使构建让路，只能在
+// SQLite忙等待中等待，大文件上会超时失败。需要与线上流量共存的构建应在应用进程内
+// 调用MaintenanceRunner，由其准入控制让路。
+// 管理器以维护工具模式打开，不触碰应用的协调者日志，也不运行后台维护任务。
+// 退出码：0 全部正常，2 发现损坏，1 出错或有文件未能检查。
+
+namespace {
+
+const char* statusName(IndexBuildStatus status) {
+    switch (status) {
+        case IndexBuildStatus::BUILT:
+            return "已构建";
+        case IndexBuildStatus::EXISTS:
+            return "已存在";
+        case IndexBuildStatus::YIELDED:
+            return "已让路，未完成";
+        case IndexBuildStatus::FAILED:
+            return "失败";
+    }
+    return "未知";
+}
+
+void printIndex(const IndexBuildResult& result) {
+    std::cout << "索引 " << (result.index.empty() ? "(未命名)" : result.index) << " @ " << result.path << ": "
+              << statusName(result.status);
+    if (result.status != IndexBuildStatus::EXISTS) {
+        std::cout << ", 尝试 " << result.attempts << " 次, 耗时 " << result.elapsed_ms << " 毫秒, 最长持有写入准入 "
+                  << result.longest_hold_ms << " 毫秒";
+    }
+    if (!result.error.empty()) {
+        std::cout << " (" << result.error << ")";
+    }
+    std::cout << std::endl;
+}
+
+void printProgress(const IntegrityProgress& progress) {
+    std::cout << "[" << progress.completed << "/" << progress.total << "] ";
+    if (!progress.finished) {
+        std::cout << "检查中, " << progress.running << " 项进行中, 已用 " << progress.elapsed_ms / 1000 << " 秒"
+                  << std::endl;
+        return;
+    }
+    const IntegrityResult& result = *progress.finished;
+    std::cout << result.path;
+    if (!result.table.empty()) {
+        std::cout << " (" << result.table << ")";
+    }
+    std::cout << ": " << (!result.checked ? "未检查" : (result.ok ? "正常" : "损坏")) << ", 耗时 "
+              << result.elapsed_ms << " 毫秒" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    IndexBuildOptions build_options;
+    IntegrityOptions check_options;
+    std::vector<std::pair<std::string, std::string>> indexes;
+    bool check = true;
+    bool offline = false;
+    bool usage_error = false;
+    
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            check_options.threads = std::atoi(argv[++i]);
+            usage_error = usage_error || check_options.threads <= 0;
+        } else if (std::strcmp(argv[i], "--sort-threads") == 0 && i + 1 < argc) {
+            build_options.sort_threads = std::atoi(argv[++i]);
+            usage_error = usage_error || build_options.sort_threads < 0;
+        } else if (std::strcmp(argv[i], "--offline") == 0) {
+            offline = true;
+        } else if (std::strcmp(argv[i], "--index") == 0 && i + 2 < argc) {
+            indexes.push_back(std::make_pair(argv[i + 1], argv[i + 2]));
+            i += 2;
+        } else if (std::strcmp(argv[i], "--full") == 0) {
+            check_options.quick = false;
+        } else if (std::strcmp(argv[i], "--whole-file") == 0) {
+            check_options.split_tables = false;
+        } else if (std::strcmp(argv[i], "--skip-check") == 0) {
+            check = false;
+        } else {
+            usage_error = true;
+        }
+    }
+    // 索引构建只在离线时进行
+    usage_error = usage_error || (!offline && !indexes.empty());
+    if (usage_error) {
+        std::cerr << "用法: " << argv[0] << " [--threads 线程数] [--full] [--whole-file] [--skip-check]"
+                  << " [--offline [--sort-threads 线程数] [--index 数据库名 \"CREATE INDEX ...\"]...]" << std::endl;
+        return 1;
+    }
+    
+    bool failed = false;
+    bool corrupted = false;
+    try {
+        MultiConnectionDatabaseManager::useToolMode();
+        auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+        build_options.on_index = printIndex;
+        // 离线时没有需要让路的写入
+        build_options.yield_after_ms = 0;
+        check_options.on_progress = printProgress;
+        
+        std::vector<IndexBuildResult> built;
+        if (offline) {
+            built = MaintenanceRunner::buildDeferredIndexes(build_options);
+        }
+        for (const auto& index : indexes) {
+            if (!db_manager.hasDatabase(index.first)) {
+                std::cerr << "未知的数据库: " << index.first << std::endl;
+                return 1;
+            }
+            std::vector<IndexBuildResult> results =
+                MaintenanceRunner::buildIndexes(db_manager.findDatabase(index.first), index.second, build_options);
+            built.insert(built.end(), results.begin(), results.end());
+        }
+        for (const auto& result : built) {
+            failed = failed || result.status == IndexBuildStatus::FAILED ||
+                     result.status == IndexBuildStatus::YIELDED;
+        }
+        
+        if (check) {
+            std::vector<IntegrityResult> results = MaintenanceRunner::checkIntegrity(check_options);
+            long long slowest_ms = 0;
+            for (const auto& result : results) {
+                slowest_ms = std::max(slowest_ms, result.elapsed_ms);
+                if (!result.checked) {
+                    failed = true;
+                    std::cerr << "未检查 " << result.path << ": " << result.errors.front() << std::endl;
+                } else if (!result.ok) {
+                    corrupted = true;
+                    for (const auto& error : result.errors) {
+                        std::cout << result.path << ": " << error << std::endl;
+                    }
+                }
+            }
+            std::cout << (check_options.quick ? "quick_check" : "integrity_check") << ": " << results.size()
+                      << " 项, " << check_options.threads << " 线程, 最长单项 " << slowest_ms << " 毫秒, "
+                      << (corrupted ? "发现损坏" : "未发现损坏") << std::endl;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "维护出错: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    if (corrupted) {
+        return 2;
+    }
+    return failed ? 1 : 0;
+}
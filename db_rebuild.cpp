@@ -0,0 +1,207 @@
+#include <sqlite3.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 离线重建工具
+//
+// 用法: db_rebuild [--page-size 字节] [--auto-vacuum none|full|incremental] <数据库文件>...
+// 以新的页大小与自动清理模式重写已有数据库文件，同时整理碎片。先用VACUUM INTO
+// 写出副本并做完整性检查，成功后才替换原文件；原文件保持WAL模式时副本同样
+// 切换为WAL。运行期间不得有其他进程打开该文件。
+
+namespace {
+
+struct FileLayout {
+    long long file_bytes;
+    int page_size;
+    int page_count;
+    int freelist_count;
+    int auto_vacuum;
+    std::string journal_mode;
+};
+
+const char* const kAutoVacuumNames[] = {"none", "full", "incremental"};
+
+long long fileSize(const std::string& path) {
+    struct stat file_stat;
+    return stat(path.c_str(), &file_stat) == 0 ? static_cast<long long>(file_stat.st_size) : 0;
+}
+
+std::string pragmaText(sqlite3* db, const std::string& pragma) {
+    sqlite3_stmt* stmt = nullptr;
+    std::string value;
+    std::string sql = "PRAGMA " + pragma;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        value = text ? reinterpret_cast<const char*>(text) : "";
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+FileLayout readLayout(sqlite3* db, const std::string& path) {
+    FileLayout layout;
+    layout.file_bytes = fileSize(path);
+    layout.page_size = std::atoi(pragmaText(db, "page_size").c_str());
+    layout.page_count = std::atoi(pragmaText(db, "page_count").c_str());
+    layout.freelist_count = std::atoi(pragmaText(db, "freelist_count").c_str());
+    layout.auto_vacuum = std::atoi(pragmaText(db, "auto_vacuum").c_str());
+    layout.journal_mode = pragmaText(db, "journal_mode");
+    return layout;
+}
+
+void printLayout(const char* label, const FileLayout& layout) {
+    std::cout << "  " << label << ": " << layout.file_bytes / 1024 << " KB, 页大小 " << layout.page_size
+              << ", 页数 " << layout.page_count << ", 空闲页 " << layout.freelist_count
+              << ", auto_vacuum " << kAutoVacuumNames[layout.auto_vacuum < 0 || layout.auto_vacuum > 2 ? 0 : layout.auto_vacuum]
+              << ", 日志模式 " << layout.journal_mode << std::endl;
+}
+
+bool syncPath(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    return ok;
+}
+
+// 副本落盘后改名替换原文件，再同步所在目录，使崩溃后看到的要么是原文件、要么是完整的副本；
+// 只有改名之前的失败返回false
+bool replaceFileDurably(const std::string& temp_path, const std::string& path) {
+    if (!syncPath(temp_path) || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        return false;
+    }
+    std::string::size_type slash = path.find_last_of('/');
+    if (!syncPath(slash == std::string::npos ? "." : path.substr(0, slash + 1))) {
+        std::cerr << "  警告: 目录同步失败，系统崩溃后可能仍看到原文件" << std::endl;
+    }
+    return true;
+}
+
+bool execute(sqlite3* db, const std::string& sql) {
+    char* error_msg = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error_msg) != SQLITE_OK) {
+        std::cerr << "  执行失败 (" << sql << "): " << (error_msg ? error_msg : "未知错误") << std::endl;
+        sqlite3_free(error_msg);
+        return false;
+    }
+    return true;
+}
+
+sqlite3* openDatabase(const std::string& path) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+        std::cerr << "  无法打开 " << path << ": " << (db ? sqlite3_errmsg(db) : "内存不足") << std::endl;
+        sqlite3_close(db);
+        return nullptr;
+    }
+    sqlite3_busy_timeout(db, 30000);
+    return db;
+}
+
+bool rebuild(const std::string& path, int page_size, const std::string& auto_vacuum) {
+    std::cout << path << std::endl;
+    std::string temp_path = path + ".rebuild";
+    std::remove(temp_path.c_str());
+    auto start = std::chrono::steady_clock::now();
+    
+    // 先把WAL内容检查点回主文件，使原文件自身完整
+    sqlite3* db = openDatabase(path);
+    if (!db) {
+        return false;
+    }
+    bool ok = execute(db, "PRAGMA wal_checkpoint(TRUNCATE);");
+    FileLayout before = readLayout(db, path);
+    printLayout("重建前", before);
+    
+    // VACUUM INTO采用连接上待生效的页大小与自动清理模式
+    if (ok && page_size > 0) {
+        ok = execute(db, "PRAGMA page_size=" + std::to_string(page_size) + ";");
+    }
+    if (ok && !auto_vacuum.empty()) {
+        ok = execute(db, "PRAGMA auto_vacuum=" + auto_vacuum + ";");
+    }
+    char* quoted = sqlite3_mprintf("VACUUM INTO %Q;", temp_path.c_str());
+    ok = ok && execute(db, quoted);
+    sqlite3_free(quoted);
+    sqlite3_close(db);
+    
+    // 校验副本并恢复原日志模式
+    sqlite3* rebuilt = ok ? openDatabase(temp_path) : nullptr;
+    FileLayout after = FileLayout();
+    if (rebuilt) {
+        ok = pragmaText(rebuilt, "integrity_check") == "ok";
+        if (!ok) {
+            std::cerr << "  副本完整性检查失败" << std::endl;
+        }
+        if (ok && before.journal_mode == "wal") {
+            ok = execute(rebuilt, "PRAGMA journal_mode=WAL;");
+        }
+        after = readLayout(rebuilt, temp_path);
+        sqlite3_close(rebuilt);
+    } else {
+        ok = false;
+    }
+    
+    if (!ok || !replaceFileDurably(temp_path, path)) {
+        std::remove(temp_path.c_str());
+        std::cerr << "  重建失败，原文件未改动" << std::endl;
+        return false;
+    }
+    // 原文件的WAL已在检查点后清空，替换后不能与新文件混用
+    std::remove((path + "-wal").c_str());
+    std::remove((path + "-shm").c_str());
+    
+    long long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    after.file_bytes = fileSize(path);
+    printLayout("重建后", after);
+    std::cout << "  耗时 " << elapsed_ms << " 毫秒, 空间变化 "
+              << (after.file_bytes - before.file_bytes) / 1024 << " KB" << std::endl;
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int page_size = 0;
+    std::string auto_vacuum;
+    std::vector<std::string> paths;
+    
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--page-size") == 0 && i + 1 < argc) {
+            page_size = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--auto-vacuum") == 0 && i + 1 < argc) {
+            auto_vacuum = argv[++i];
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    
+    bool valid_page_size = page_size == 0 || (page_size >= 512 && page_size <= 65536 && (page_size & (page_size - 1)) == 0);
+    bool valid_auto_vacuum = auto_vacuum.empty() || auto_vacuum == "none" || auto_vacuum == "full" ||
+                             auto_vacuum == "incremental";
+    if (paths.empty() || !valid_page_size || !valid_auto_vacuum) {
+        std::cerr << "用法: " << argv[0]
+                  << " [--page-size 字节] [--auto-vacuum none|full|incremental] <数据库文件>..." << std::endl;
+        return 1;
+    }
+    
+    int failed = 0;
+    for (const auto& path : paths) {
+        if (!rebuild(path, page_size, auto_vacuum)) {
+            ++failed;
+        }
+    }
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+#include "epoch_reclaimer.h"
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+std::once_flag EpochReclaimer::initialized_;
+EpochReclaimer* EpochReclaimer::instance_ = nullptr;
+
+// 线程的读者状态：槽位在首次进入Guard时占用，线程退出时归还
+struct EpochReclaimer::ThreadState {
+    EpochReclaimer* reclaimer = nullptr;
+    Slot* slot = nullptr;
+    int depth = 0;
+    
+    ~ThreadState() {
+        if (slot) {
+            slot->state.store(0);
+            slot->claimed.store(false);
+        }
+    }
+};
+
+EpochReclaimer& EpochReclaimer::getInstance() {
+    // 有意不析构：管理器单例在进程退出析构时仍可能退役对象或进入Guard
+    std::call_once(initialized_, []() {
+        instance_ = new EpochReclaimer();
+    });
+    return *instance_;
+}
+
+EpochReclaimer::EpochReclaimer() : slot_high_water_(0), global_epoch_(1), reclaimed_(0) {
+    for (auto& slot : slots_) {
+        slot.state.store(0, std::memory_order_relaxed);
+        slot.claimed.store(false, std::memory_order_relaxed);
+    }
+}
+
+EpochReclaimer::ThreadState& EpochReclaimer::threadState() {
+    static thread_local ThreadState state;
+    return state;
+}
+
+EpochReclaimer::Slot* EpochReclaimer::claimSlot() {
+    for (std::size_t i = 0; i < kMaxReaders; ++i) {
+        bool expected = false;
+        if (!slots_[i].claimed.load() && slots_[i].claimed.compare_exchange_strong(expected, true)) {
+            std::size_t high_water = slot_high_water_.load();
+            while (high_water < i + 1 && !slot_high_water_.compare_exchange_weak(high_water, i + 1)) {
+            }
+            return &slots_[i];
+        }
+    }
+    throw std::runtime_error("并发读者线程数超过上限: " + std::to_string(kMaxReaders));
+}
+
+EpochReclaimer::Guard::Guard() {
+    ThreadState& state = threadState();
+    if (state.depth++ > 0) {
+        return;
+    }
+    if (!state.slot) {
+        state.reclaimer = &getInstance();
+        try {
+            state.slot = state.reclaimer->claimSlot();
+        } catch (...) {
+            --state.depth;
+            throw;
+        }
+    }
+    // 公告后的全序栅栏与collect()扫描前的栅栏配对：扫描若未看到本次公告，
+    // 则之后对共享指针的加载一定能看到扫描前已完成的摘除
+    state.slot->state.store(state.reclaimer->global_epoch_.load(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+EpochReclaimer::Guard::~Guard() {
+    ThreadState& state = threadState();
+    if (--state.depth == 0) {
+        state.slot->state.store(0, std::memory_order_release);
+    }
+}
+
+void EpochReclaimer::retire(std::function<void()> deleter) {
+    std::function<void()> wake;
+    {
+        std::lock_guard<std::mutex> lock(limbo_mutex_);
+        limbo_.emplace_back(global_epoch_.load(), std::move(deleter));
+        wake = collector_;
+    }
+    if (wake) {
+        wake();
+    } else {
+        collect();
+    }
+}
+
+std::size_t EpochReclaimer::collect() {
+    std::vector<std::function<void()>> ready;
+    {
+        std::lock_guard<std::mutex> lock(limbo_mutex_);
+        if (limbo_.empty()) {
+            return 0;
+        }
+        // 纪元只在持有limbo_mutex_时推进；一次最多推进两个纪元，足以释放此前退役的对象
+        std::uint64_t epoch = global_epoch_.load();
+        for (int round = 0; round < 2 && limbo_.front().first + 2 > epoch; ++round) {
+            // 仍有读者停留在更早的纪元时不能推进
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool observed_by_all = true;
+            std::size_t readers = slot_high_water_.load();
+            for (std::size_t i = 0; i < readers; ++i) {
+                std::uint64_t observed = slots_[i].state.load();
+                if (observed != 0 && observed != epoch) {
+                    observed_by_all = false;
+                    break;
+                }
+            }
+            if (!observed_by_all) {
+                break;
+            }
+            global_epoch_.store(++epoch);
+        }
+        while (!limbo_.empty() && limbo_.front().first + 2 <= epoch) {
+            ready.push_back(std::move(limbo_.front().second));
+            limbo_.pop_front();
+        }
+    }
+    
+    // 在锁外释放：deleter可能再次退役对象
+    for (auto& deleter : ready) {
+        deleter();
+    }
+    reclaimed_ += ready.size();
+    return ready.size();
+}
+
+void EpochReclaimer::setCollector(std::function<void()> wake) {
+    std::lock_guard<std::mutex> lock(limbo_mutex_);
+    collector_ = std::move(wake);
+}
+
+std::size_t EpochReclaimer::pending() const {
+    std::lock_guard<std::mutex> lock(limbo_mutex_);
+    return limbo_.size();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+// 基于纪元的内存回收（EBR）
+//
+// 无锁读者在Guard作用域内加载共享指针并解引用，期间不修改任何引用计数。
+// 写入方以原子指针发布新对象后调用retire()退役旧对象；旧对象在所有可能持有它的
+// 读者离开Guard后才被释放。
+//
+// 全局纪元只在所有活跃读者都已观察到当前纪元时推进；在纪元e退役的对象于全局纪元
+// 达到e+2后释放。每个线程首次进入Guard时占用一个读者槽位，线程退出时归还。
+// Guard可嵌套；读者在Guard内阻塞会推迟回收，但不影响正确性。
+//
+// 回收（collect）可由任意线程调用；设置了后台回收者时，退役对象后会唤醒它
+// （多连接版本由MultiConnectionDatabaseManager的维护线程承担）。
+class EpochReclaimer {
+public:
+    static EpochReclaimer& getInstance();
+    
+    // 读者临界区
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+        
+    private:
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+    
+    // 退役一个已从共享结构上摘除的对象，deleter在安全时执行
+    void retire(std::function<void()> deleter);
+    
+    template <typename T>
+    void retire(T* object) {
+        retire([object]() { delete object; });
+    }
+    
+    // 尝试推进全局纪元并释放已安全的对象，返回释放数
+    std::size_t collect();
+    
+    // 设置后台回收者：有待释放的对象时调用，应尽快安排一次collect()
+    void setCollector(std::function<void()> wake);
+    
+    std::size_t pending() const;
+    
+    std::uint64_t epoch() const {
+        return global_epoch_.load();
+    }
+    
+    std::uint64_t reclaimed() const {
+        return reclaimed_.load();
+    }
+    
+private:
+    EpochReclaimer();
+    EpochReclaimer(const EpochReclaimer&) = delete;
+    EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+    
+    static const std::size_t kMaxReaders = 1024;
+    
+    // 读者槽位：state为0表示不在Guard内，否则为进入时观察到的全局纪元。
+    // 按缓存行填充，避免不同读者的进出互相失效
+    struct Slot {
+        std::atomic<std::uint64_t> state;
+        std::atomic<bool> claimed;
+        char padding[64 - sizeof(std::atomic<std::uint64_t>) - sizeof(std::atomic<bool>)];
+    };
+    
+    struct ThreadState;
+    static ThreadState& threadState();
+    Slot* claimSlot();
+    
+    Slot slots_[kMaxReaders];
+    std::atomic<std::size_t> slot_high_water_;  // 曾被占用的最大槽位数，回收时只扫描这一段
+    std::atomic<std::uint64_t> global_epoch_;
+    std::atomic<std::uint64_t> reclaimed_;
+    
+    // 待释放对象，按退役纪元递增排列
+    mutable std::mutex limbo_mutex_;
+    std::deque<std::pair<std::uint64_t, std::function<void()>>> limbo_;
+    std::function<void()> collector_;
+    
+    static std::once_flag initialized_;
+    static EpochReclaimer* instance_;
+};
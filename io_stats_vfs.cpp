@@ -0,0 +1,369 @@
+#include "io_stats_vfs.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+// 计数器条目：按路径创建后不再释放，打开的文件直接持有其指针
+struct StatsEntry {
+    IoFileKind kind;
+    std::atomic<std::uint64_t> reads;
+    std::atomic<std::uint64_t> read_bytes;
+    std::atomic<std::uint64_t> read_ns;
+    std::atomic<std::uint64_t> writes;
+    std::atomic<std::uint64_t> write_bytes;
+    std::atomic<std::uint64_t> write_ns;
+    std::atomic<std::uint64_t> syncs;
+    std::atomic<std::uint64_t> sync_ns;
+    std::atomic<std::uint64_t> truncates;
+    std::atomic<std::uint64_t> shm_maps;
+    std::atomic<std::uint64_t> shm_locks;
+    
+    explicit StatsEntry(IoFileKind k)
+        : kind(k), reads(0), read_bytes(0), read_ns(0), writes(0), write_bytes(0), write_ns(0),
+          syncs(0), sync_ns(0), truncates(0), shm_maps(0), shm_locks(0) {}
+};
+
+// 条目表有意不析构：单例管理器在静态析构阶段关闭连接时仍会触发检查点写入
+struct Registry {
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<StatsEntry>> entries;
+};
+
+Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+sqlite3_vfs stats_vfs;
+sqlite3_vfs* root_vfs = nullptr;
+std::once_flag install_once;
+
+// 包装文件：底层文件对象紧随其后分配
+struct StatsFile {
+    sqlite3_file base;
+    StatsEntry* main_stats;  // 本文件的统计
+    StatsEntry* shm_stats;   // 主数据库文件对应的共享内存统计
+    sqlite3_file* real;
+};
+
+StatsEntry* entryFor(const std::string& path, IoFileKind kind) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::unique_ptr<StatsEntry>& entry = reg.entries[path];
+    if (!entry) {
+        entry.reset(new StatsEntry(kind));
+    }
+    return entry.get();
+}
+
+IoFileKind kindFromFlags(int flags) {
+    if (flags & SQLITE_OPEN_MAIN_DB) {
+        return IoFileKind::MAIN_DB;
+    }
+    if (flags & SQLITE_OPEN_WAL) {
+        return IoFileKind::WAL;
+    }
+    if (flags & SQLITE_OPEN_MAIN_JOURNAL) {
+        return IoFileKind::JOURNAL;
+    }
+    return IoFileKind::OTHER;
+}
+
+// 计时辅助：构造时记录开始时间，析构时累加耗时
+class Timer {
+public:
+    explicit Timer(std::atomic<std::uint64_t>& total)
+        : total_(total), start_(std::chrono::steady_clock::now()) {}
+        
+    ~Timer() {
+        total_ += static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_).count());
+    }
+    
+private:
+    std::atomic<std::uint64_t>& total_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+sqlite3_file* realFile(sqlite3_file* file) {
+    return reinterpret_cast<StatsFile*>(file)->real;
+}
+
+StatsEntry* stats(sqlite3_file* file) {
+    return reinterpret_cast<StatsFile*>(file)->main_stats;
+}
+
+// ---- 文件方法：统计后转发 ----
+
+int statsClose(sqlite3_file* file) {
+    sqlite3_file* real = realFile(file);
+    int result = real->pMethods ? real->pMethods->xClose(real) : SQLITE_OK;
+    file->pMethods = nullptr;
+    return result;
+}
+
+int statsRead(sqlite3_file* file, void* buffer, int amount, sqlite3_int64 offset) {
+    StatsEntry* entry = stats(file);
+    Timer timer(entry->read_ns);
+    int result = realFile(file)->pMethods->xRead(realFile(file), buffer, amount, offset);
+    ++entry->reads;
+    entry->read_bytes += static_cast<std::uint64_t>(amount);
+    return result;
+}
+
+int statsWrite(sqlite3_file* file, const void* buffer, int amount, sqlite3_int64 offset) {
+    StatsEntry* entry = stats(file);
+    Timer timer(entry->write_ns);
+    int result = realFile(file)->pMethods->xWrite(realFile(file), buffer, amount, offset);
+    ++entry->writes;
+    entry->write_bytes += static_cast<std::uint64_t>(amount);
+    return result;
+}
+
+int statsTruncate(sqlite3_file* file, sqlite3_int64 size) {
+    ++stats(file)->truncates;
+    return realFile(file)->pMethods->xTruncate(realFile(file), size);
+}
+
+int statsSync(sqlite3_file* file, int flags) {
+    StatsEntry* entry = stats(file);
+    Timer timer(entry->sync_ns);
+    ++entry->syncs;
+    return realFile(file)->pMethods->xSync(realFile(file), flags);
+}
+
+int statsFileSize(sqlite3_file* file, sqlite3_int64* size) {
+    return realFile(file)->pMethods->xFileSize(realFile(file), size);
+}
+
+int statsLock(sqlite3_file* file, int lock) {
+    return realFile(file)->pMethods->xLock(realFile(file), lock);
+}
+
+int statsUnlock(sqlite3_file* file, int lock) {
+    return realFile(file)->pMethods->xUnlock(realFile(file), lock);
+}
+
+int statsCheckReservedLock(sqlite3_file* file, int* result) {
+    return realFile(file)->pMethods->xCheckReservedLock(realFile(file), result);
+}
+
+int statsFileControl(sqlite3_file* file, int op, void* arg) {
+    return realFile(file)->pMethods->xFileControl(realFile(file), op, arg);
+}
+
+int statsSectorSize(sqlite3_file* file) {
+    return realFile(file)->pMethods->xSectorSize(realFile(file));
+}
+
+int statsDeviceCharacteristics(sqlite3_file* file) {
+    return realFile(file)->pMethods->xDeviceCharacteristics(realFile(file));
+}
+
+int statsShmMap(sqlite3_file* file, int region, int size, int extend, void volatile** pages) {
+    ++reinterpret_cast<StatsFile*>(file)->shm_stats->shm_maps;
+    return realFile(file)->pMethods->xShmMap(realFile(file), region, size, extend, pages);
+}
+
+int statsShmLock(sqlite3_file* file, int offset, int n, int flags) {
+    ++reinterpret_cast<StatsFile*>(file)->shm_stats->shm_locks;
+    return realFile(file)->pMethods->xShmLock(realFile(file), offset, n, flags);
+}
+
+void statsShmBarrier(sqlite3_file* file) {
+    realFile(file)->pMethods->xShmBarrier(realFile(file));
+}
+
+int statsShmUnmap(sqlite3_file* file, int delete_flag) {
+    return realFile(file)->pMethods->xShmUnmap(realFile(file), delete_flag);
+}
+
+int statsFetch(sqlite3_file* file, sqlite3_int64 offset, int amount, void** page) {
+    return realFile(file)->pMethods->xFetch(realFile(file), offset, amount, page);
+}
+
+int statsUnfetch(sqlite3_file* file, sqlite3_int64 offset, void* page) {
+    return realFile(file)->pMethods->xUnfetch(realFile(file), offset, page);
+}
+
+// 按底层文件方法的版本提供对应的方法表，不宣称底层不支持的能力
+const sqlite3_io_methods kMethods[3] = {
+    {1, statsClose, statsRead, statsWrite, statsTruncate, statsSync, statsFileSize, statsLock, statsUnlock,
+     statsCheckReservedLock, statsFileControl, statsSectorSize, statsDeviceCharacteristics,
+     nullptr, nullptr, nullptr, nullptr, nullptr, nullptr},
+    {2, statsClose, statsRead, statsWrite, statsTruncate, statsSync, statsFileSize, statsLock, statsUnlock,
+     statsCheckReservedLock, statsFileControl, statsSectorSize, statsDeviceCharacteristics,
+     statsShmMap, statsShmLock, statsShmBarrier, statsShmUnmap, nullptr, nullptr},
+    {3, statsClose, statsRead, statsWrite, statsTruncate, statsSync, statsFileSize, statsLock, statsUnlock,
+     statsCheckReservedLock, statsFileControl, statsSectorSize, statsDeviceCharacteristics,
+     statsShmMap, statsShmLock, statsShmBarrier, statsShmUnmap, statsFetch, statsUnfetch}
+};
+
+// ---- VFS方法 ----
+
+int statsOpen(sqlite3_vfs*, sqlite3_filename name, sqlite3_file* file, int flags, int* out_flags) {
+    StatsFile* wrapper = reinterpret_cast<StatsFile*>(file);
+    wrapper->base.pMethods = nullptr;
+    wrapper->real = reinterpret_cast<sqlite3_file*>(wrapper + 1);
+    
+    int result = root_vfs->xOpen(root_vfs, name, wrapper->real, flags, out_flags);
+    if (result != SQLITE_OK || !wrapper->real->pMethods) {
+        return result;
+    }
+    
+    // 临时文件没有名称，统一计入一个条目
+    std::string path = name ? name : "(temp)";
+    IoFileKind kind = kindFromFlags(flags);
+    wrapper->main_stats = entryFor(path, kind);
+    wrapper->shm_stats = kind == IoFileKind::MAIN_DB ? entryFor(path + "-shm", IoFileKind::SHM) : wrapper->main_stats;
+    
+    int version = std::min(std::max(wrapper->real->pMethods->iVersion, 1), 3);
+    wrapper->base.pMethods = &kMethods[version - 1];
+    return SQLITE_OK;
+}
+
+int statsDelete(sqlite3_vfs*, const char* name, int sync_dir) {
+    return root_vfs->xDelete(root_vfs, name, sync_dir);
+}
+
+int statsAccess(sqlite3_vfs*, const char* name, int flags, int* result) {
+    return root_vfs->xAccess(root_vfs, name, flags, result);
+}
+
+int statsFullPathname(sqlite3_vfs*, const char* name, int size, char* out) {
+    return root_vfs->xFullPathname(root_vfs, name, size, out);
+}
+
+void* statsDlOpen(sqlite3_vfs*, const char* name) {
+    return root_vfs->xDlOpen(root_vfs, name);
+}
+
+void statsDlError(sqlite3_vfs*, int size, char* message) {
+    root_vfs->xDlError(root_vfs, size, message);
+}
+
+void (*statsDlSym(sqlite3_vfs*, void* handle, const char* symbol))(void) {
+    return root_vfs->xDlSym(root_vfs, handle, symbol);
+}
+
+void statsDlClose(sqlite3_vfs*, void* handle) {
+    root_vfs->xDlClose(root_vfs, handle);
+}
+
+int statsRandomness(sqlite3_vfs*, int size, char* out) {
+    return root_vfs->xRandomness(root_vfs, size, out);
+}
+
+int statsSleep(sqlite3_vfs*, int microseconds) {
+    return root_vfs->xSleep(root_vfs, microseconds);
+}
+
+int statsCurrentTime(sqlite3_vfs*, double* now) {
+    return root_vfs->xCurrentTime(root_vfs, now);
+}
+
+int statsGetLastError(sqlite3_vfs*, int size, char* out) {
+    return root_vfs->xGetLastError ? root_vfs->xGetLastError(root_vfs, size, out) : 0;
+}
+
+int statsCurrentTimeInt64(sqlite3_vfs*, sqlite3_int64* now) {
+    return root_vfs->xCurrentTimeInt64(root_vfs, now);
+}
+
+}  // namespace
+
+const char* const IoStatsVfs::kVfsName = "mc_iostats";
+
+void IoStatsVfs::install() {
+    std::call_once(install_once, []() {
+        root_vfs = sqlite3_vfs_find(nullptr);
+        if (!root_vfs) {
+            throw std::runtime_error("未找到默认SQLite VFS");
+        }
+        
+        stats_vfs = sqlite3_vfs();
+        // 版本2足以转发xCurrentTimeInt64；系统调用替换接口仅用于测试，不转发
+        stats_vfs.iVersion = std::min(root_vfs->iVersion, 2);
+        stats_vfs.szOsFile = static_cast<int>(sizeof(StatsFile)) + root_vfs->szOsFile;
+        stats_vfs.mxPathname = root_vfs->mxPathname;
+        stats_vfs.zName = kVfsName;
+        stats_vfs.xOpen = statsOpen;
+        stats_vfs.xDelete = statsDelete;
+        stats_vfs.xAccess = statsAccess;
+        stats_vfs.xFullPathname = statsFullPathname;
+        stats_vfs.xDlOpen = statsDlOpen;
+        stats_vfs.xDlError = statsDlError;
+        stats_vfs.xDlSym = statsDlSym;
+        stats_vfs.xDlClose = statsDlClose;
+        stats_vfs.xRandomness = statsRandomness;
+        stats_vfs.xSleep = statsSleep;
+        stats_vfs.xCurrentTime = statsCurrentTime;
+        stats_vfs.xGetLastError = statsGetLastError;
+        stats_vfs.xCurrentTimeInt64 = root_vfs->iVersion >= 2 ? statsCurrentTimeInt64 : nullptr;
+        
+        if (sqlite3_vfs_register(&stats_vfs, 0) != SQLITE_OK) {
+            throw std::runtime_error("注册I/O统计VFS失败");
+        }
+    });
+}
+
+std::vector<IoFileStats> IoStatsVfs::snapshot() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::vector<IoFileStats> result;
+    for (const auto& item : reg.entries) {
+        const StatsEntry& entry = *item.second;
+        IoFileStats file_stats;
+        file_stats.path = item.first;
+        file_stats.kind = entry.kind;
+        file_stats.reads = entry.reads.load();
+        file_stats.read_bytes = entry.read_bytes.load();
+        file_stats.read_ns = entry.read_ns.load();
+        file_stats.writes = entry.writes.load();
+        file_stats.write_bytes = entry.write_bytes.load();
+        file_stats.write_ns = entry.write_ns.load();
+        file_stats.syncs = entry.syncs.load();
+        file_stats.sync_ns = entry.sync_ns.load();
+        file_stats.truncates = entry.truncates.load();
+        file_stats.shm_maps = entry.shm_maps.load();
+        file_stats.shm_locks = entry.shm_locks.load();
+        result.push_back(file_stats);
+    }
+    return result;
+}
+
+void IoStatsVfs::reset() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& item : reg.entries) {
+        StatsEntry& entry = *item.second;
+        entry.reads = 0;
+        entry.read_bytes = 0;
+        entry.read_ns = 0;
+        entry.writes = 0;
+        entry.write_bytes = 0;
+        entry.write_ns = 0;
+        entry.syncs = 0;
+        entry.sync_ns = 0;
+        entry.truncates = 0;
+        entry.shm_maps = 0;
+        entry.shm_locks = 0;
+    }
+}
+
+const char* ioFileKindName(IoFileKind kind) {
+    switch (kind) {
+        case IoFileKind::MAIN_DB: return "db";
+        case IoFileKind::WAL: return "wal";
+        case IoFileKind::JOURNAL: return "journal";
+        case IoFileKind::SHM: return "shm";
+        case IoFileKind::OTHER: return "other";
+    }
+    return "other";
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 文件类别，由SQLite打开文件时的标志区分
+enum class IoFileKind {
+    MAIN_DB,
+    WAL,
+    JOURNAL,
+    SHM,      // 共享内存索引（WAL模式），只统计映射与锁操作
+    OTHER     // 临时文件、子日志等
+};
+
+const char* ioFileKindName(IoFileKind kind);
+
+// 单个文件的I/O统计快照
+struct IoFileStats {
+    std::string path;
+    IoFileKind kind;
+    std::uint64_t reads;
+    std::uint64_t read_bytes;
+    std::uint64_t read_ns;
+    std::uint64_t writes;
+    std::uint64_t write_bytes;
+    std::uint64_t write_ns;
+    std::uint64_t syncs;
+    std::uint64_t sync_ns;
+    std::uint64_t truncates;
+    std::uint64_t shm_maps;
+    std::uint64_t shm_locks;
+};
+
+// I/O统计VFS
+//
+// 包装系统默认VFS的透传层：所有调用转发给底层VFS，同时按文件路径累计读、写、
+// 同步的次数、字节数与耗时。打开数据库时指定kVfsName即可启用，计数器为原子
+// 变量，统计开销为每次I/O两次时钟读取。
+class IoStatsVfs {
+public:
+    static const char* const kVfsName;
+    
+    // 注册VFS（不设为默认），可重复调用
+    static void install();
+    
+    // 所有文件的统计快照，按路径排序
+    static std::vector<IoFileStats> snapshot();
+    
+    // 将所有计数器清零（文件条目保留）
+    static void reset();
+};
@@ -0,0 +1,426 @@
+#include "maintenance_runner.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+long long elapsedMs(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+// 按SQLite的语句完整性判断切分多条语句
+std::vector<std::string> splitStatements(const std::string& sql) {
+    std::vector<std::string> statements;
+    std::string current;
+    for (char c : sql) {
+        current.push_back(c);
+        if (c == ';' && sqlite3_complete(current.c_str())) {
+            statements.push_back(current);
+            current.clear();
+        }
+    }
+    if (current.find_first_not_of(" \t\r\n") != std::string::npos) {
+        statements.push_back(current + ";");
+    }
+    return statements;
+}
+
+// CREATE [UNIQUE] INDEX [IF NOT EXISTS] [schema.]name ON ... 中的索引名，无法识别时为空
+std::string indexName(const std::string& sql) {
+    std::vector<std::string> tokens;
+    std::size_t pos = 0;
+    while (tokens.size() < 8 && pos < sql.size()) {
+        while (pos < sql.size() && std::isspace(static_cast<unsigned char>(sql[pos]))) {
+            ++pos;
+        }
+        if (pos >= sql.size()) {
+            break;
+        }
+        std::string token;
+        char quote = sql[pos] == '"' || sql[pos] == '`' ? sql[pos] : (sql[pos] == '[' ? ']' : '\0');
+        if (quote) {
+            std::size_t end = sql.find(quote, pos + 1);
+            token = sql.substr(pos + 1, end == std::string::npos ? std::string::npos : end - pos - 1);
+            pos = end == std::string::npos ? sql.size() : end + 1;
+        } else {
+            while (pos < sql.size() && !std::isspace(static_cast<unsigned char>(sql[pos])) && sql[pos] != '(' &&
+                   sql[pos] != '.') {
+                token.push_back(sql[pos]);
+                ++pos;
+            }
+        }
+        if (pos < sql.size() && sql[pos] == '.') {
+            ++pos;  // 跳过模式名，保留其后的索引名
+            continue;
+        }
+        tokens.push_back(token);
+    }
+    
+    auto upper = [](std::string text) {
+        for (auto& c : text) {
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        return text;
+    };
+    std::size_t i = 0;
+    if (i < tokens.size() && upper(tokens[i]) == "CREATE") {
+        ++i;
+    }
+    if (i < tokens.size() && upper(tokens[i]) == "UNIQUE") {
+        ++i;
+    }
+    if (i >= tokens.size() || upper(tokens[i]) != "INDEX") {
+        return std::string();
+    }
+    ++i;
+    if (i + 2 < tokens.size() && upper(tokens[i]) == "IF" && upper(tokens[i + 1]) == "NOT" &&
+        upper(tokens[i + 2]) == "EXISTS") {
+        i += 3;
+    }
+    return i < tokens.size() ? tokens[i] : std::string();
+}
+
+bool indexExists(sqlite3* db, const std::string& name) {
+    sqlite3_stmt* stmt = nullptr;
+    bool found = false;
+    if (sqlite3_prepare_v2(db, "SELECT 1 FROM sqlite_master WHERE type = 'index' AND name = ?", -1, &stmt,
+                           nullptr) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_TRANSIENT);
+        found = sqlite3_step(stmt) == SQLITE_ROW;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// 构建中的让路判断，由SQLite的进度回调调用
+struct YieldState {
+    Clock::time_point deadline;
+    AdmissionController* admission;
+};
+
+int yieldToInteractive(void* context) {
+    YieldState* state = static_cast<YieldState*>(context);
+    return Clock::now() >= state->deadline && state->admission->interactiveWaiting() ? 1 : 0;
+}
+
+// 一个数据库文件上待构建的索引
+struct IndexJob {
+    MultiConnectionDatabaseManager::DatabaseId id;
+    std::size_t shard;
+    std::string database;
+    std::vector<std::string> statements;
+};
+
+void buildOnFile(const std::string& path, const std::vector<IndexJob>& jobs, const IndexBuildOptions& options,
+                 std::mutex& report_mutex, std::vector<IndexBuildResult>& results) {
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    AdmissionController& admission = db_manager.admissionController(jobs.front().id, jobs.front().shard);
+    
+    std::shared_ptr<sqlite3> connection;
+    std::string open_error;
+    try {
+        connection = db_manager.openMaintenanceConnection(jobs.front().id, jobs.front().shard);
+        std::string pragmas = "PRAGMA threads=" + std::to_string(options.sort_threads) +
+                              "; PRAGMA cache_size=" + std::to_string(-1024LL * options.cache_mb) + ";";
+        sqlite3_exec(connection.get(), pragmas.c_str(), nullptr, nullptr, nullptr);
+    } catch (const std::exception& e) {
+        open_error = e.what();
+    }
+    sqlite3* db = connection.get();
+    
+    for (const auto& job : jobs) {
+        for (const auto& statement : job.statements) {
+            IndexBuildResult result = {job.database, path, indexName(statement), IndexBuildStatus::FAILED, 0, 0, 0,
+                                       open_error};
+            auto start = Clock::now();
+            if (!db) {
+                // 无法打开专用连接，如内存模式数据库
+            } else if (!result.index.empty() && indexExists(db, result.index)) {
+                result.status = IndexBuildStatus::EXISTS;
+            } else {
+                long long yield_after_ms = options.yield_after_ms;
+                for (int attempt = 1;; ++attempt) {
+                    result.attempts = attempt;
+                    int rc;
+                    auto hold_start = Clock::now();
+                    {
+                        // 批量优先级：排队中的交互式写入先执行，构建期间新到的交互式写入在准入队列中等待
+                        AdmissionController::Ticket ticket(admission, AdmissionPriority::BATCH);
+                        if (!ticket.admitted()) {
+                            result.error = "未获得写入准入";
+                            break;
+                        }
+                        hold_start = Clock::now();
+                        YieldState state = {hold_start + std::chrono::milliseconds(yield_after_ms), &admission};
+                        if (yield_after_ms > 0) {
+                            sqlite3_progress_handler(db, 10000, yieldToInteractive, &state);
+                        }
+                        rc = sqlite3_exec(db, statement.c_str(), nullptr, nullptr, nullptr);
+                        sqlite3_progress_handler(db, 0, nullptr, nullptr);
+                    }
+                    result.longest_hold_ms = std::max(result.longest_hold_ms, elapsedMs(hold_start));
+                    if (rc == SQLITE_OK) {
+                        result.status = IndexBuildStatus::BUILT;
+                        break;
+                    }
+                    if (rc != SQLITE_INTERRUPT) {
+                        result.error = sqlite3_errmsg(db);
+                        break;
+                    }
+                    if (attempt >= options.max_attempts) {
+                        result.status = IndexBuildStatus::YIELDED;
+                        break;
+                    }
+                    // 已回滚：归还准入后等待交互式写入排空再重试。让路时限加倍，持续有写入时
+                    // 重复的工作量不超过最后一次尝试的量级
+                    std::this_thread::sleep_for(std::chrono::milliseconds(options.pause_ms));
+                    yield_after_ms *= 2;
+                }
+            }
+            result.elapsed_ms = elapsedMs(start);
+            
+            std::lock_guard<std::mutex> lock(report_mutex);
+            results.push_back(result);
+            if (options.on_index) {
+                options.on_index(results.back());
+            }
+        }
+    }
+}
+
+std::vector<IndexBuildResult> buildJobs(const std::vector<std::pair<std::string, IndexJob>>& jobs,
+                                        const IndexBuildOptions& options) {
+    // 按文件分组，保持注册顺序
+    std::vector<std::string> paths;
+    std::map<std::string, std::vector<IndexJob>> by_path;
+    for (const auto& job : jobs) {
+        if (job.second.statements.empty()) {
+            continue;
+        }
+        if (by_path.find(job.first) == by_path.end()) {
+            paths.push_back(job.first);
+        }
+        by_path[job.first].push_back(job.second);
+    }
+    
+    std::mutex report_mutex;
+    std::vector<std::vector<IndexBuildResult>> file_results(paths.size());
+    std::atomic<std::size_t> next_path(0);
+    auto worker = [&]() {
+        for (std::size_t index = next_path++; index < paths.size(); index = next_path++) {
+            buildOnFile(paths[index], by_path[paths[index]], options, report_mutex, file_results[index]);
+        }
+    };
+    std::vector<std::thread> workers;
+    std::size_t worker_count = std::min<std::size_t>(std::max(1, options.parallel_files), paths.size());
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    
+    std::vector<IndexBuildResult> results;
+    for (auto& file : file_results) {
+        results.insert(results.end(), file.begin(), file.end());
+    }
+    return results;
+}
+
+std::vector<std::string> listTables(sqlite3* db) {
+    std::vector<std::string> tables;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT name FROM sqlite_master WHERE type = 'table' ORDER BY name", -1, &stmt,
+                           nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            tables.push_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+        }
+    }
+    sqlite3_finalize(stmt);
+    return tables;
+}
+
+std::string quoteIdentifier(const std::string& name) {
+    std::string quoted = "\"";
+    for (char c : name) {
+        quoted.push_back(c);
+        if (c == '"') {
+            quoted.push_back('"');
+        }
+    }
+    return quoted + "\"";
+}
+
+// 一项完整性检查：某文件的一张表，或table为空时整个文件
+struct IntegrityTask {
+    MultiConnectionDatabaseManager::DatabaseId id;
+    std::size_t shard;
+    std::string path;
+    std::string table;
+};
+
+void runCheck(const IntegrityTask& task, const IntegrityOptions& options, IntegrityResult& result) {
+    auto start = Clock::now();
+    result.path = task.path;
+    result.table = task.table;
+    result.checked = false;
+    result.ok = false;
+    
+    std::shared_ptr<sqlite3> connection;
+    try {
+        connection = MultiConnectionDatabaseManager::getInstance().openReaderConnection(task.id, task.shard);
+    } catch (const std::exception& e) {
+        result.errors.push_back(e.what());
+        result.elapsed_ms = elapsedMs(start);
+        return;
+    }
+    result.checked = true;
+    
+    // 按表检查时参数为表名，错误数由读取的行数限制
+    std::string sql = std::string("PRAGMA ") + (options.quick ? "quick_check" : "integrity_check") + "(" +
+                      (task.table.empty() ? std::to_string(options.max_errors) : quoteIdentifier(task.table)) + ")";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(connection.get(), sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        result.errors.push_back(sqlite3_errmsg(connection.get()));
+        result.elapsed_ms = elapsedMs(start);
+        return;
+    }
+    int step;
+    while ((step = sqlite3_step(stmt)) == SQLITE_ROW &&
+           result.errors.size() < static_cast<std::size_t>(options.max_errors)) {
+        const unsigned char* text = sqlite3_column_text(stmt, 0);
+        std::string line = text ? reinterpret_cast<const char*>(text) : "";
+        if (line != "ok") {
+            result.errors.push_back(line);
+        }
+    }
+    if (step != SQLITE_ROW && step != SQLITE_DONE) {
+        result.errors.push_back(sqlite3_errmsg(connection.get()));
+    }
+    sqlite3_finalize(stmt);
+    result.ok = result.errors.empty();
+    result.elapsed_ms = elapsedMs(start);
+}
+
+}  // namespace
+
+std::vector<IndexBuildResult> MaintenanceRunner::buildDeferredIndexes(const IndexBuildOptions& options) {
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    std::vector<std::pair<std::string, IndexJob>> jobs;
+    for (DatabaseId id = 0; id < db_manager.databaseCount(); ++id) {
+        std::vector<std::string> statements = splitStatements(db_manager.deferredIndexSql(id));
+        for (std::size_t shard = 0; shard < db_manager.shardCount(id); ++shard) {
+            IndexJob job = {id, shard, db_manager.databaseName(id), statements};
+            jobs.push_back(std::make_pair(db_manager.shardPath(id, shard), job));
+        }
+    }
+    return buildJobs(jobs, options);
+}
+
+std::vector<IndexBuildResult> MaintenanceRunner::buildIndexes(DatabaseId id, const std::string& index_sql,
+                                                              const IndexBuildOptions& options) {
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    std::vector<std::string> statements = splitStatements(index_sql);
+    std::vector<std::pair<std::string, IndexJob>> jobs;
+    for (std::size_t shard = 0; shard < db_manager.shardCount(id); ++shard) {
+        IndexJob job = {id, shard, db_manager.databaseName(id), statements};
+        jobs.push_back(std::make_pair(db_manager.shardPath(id, shard), job));
+    }
+    return buildJobs(jobs, options);
+}
+
+std::vector<IntegrityResult> MaintenanceRunner::checkIntegrity(const IntegrityOptions& options) {
+    auto start = Clock::now();
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    
+    // 同文件放置的数据库共用分片，每个文件只检查一次
+    std::vector<IntegrityTask> tasks;
+    std::vector<IntegrityResult> skipped;
+    std::vector<std::string> seen;
+    for (DatabaseId id = 0; id < db_manager.databaseCount(); ++id) {
+        for (std::size_t shard = 0; shard < db_manager.shardCount(id); ++shard) {
+            const std::string& path = db_manager.shardPath(id, shard);
+            if (std::find(seen.begin(), seen.end(), path) != seen.end()) {
+                continue;
+            }
+            seen.push_back(path);
+            IntegrityTask task = {id, shard, path, std::string()};
+            if (!options.split_tables) {
+                tasks.push_back(task);
+                continue;
+            }
+            std::shared_ptr<sqlite3> connection;
+            try {
+                connection = db_manager.openReaderConnection(id, shard);
+            } catch (const std::exception& e) {
+                IntegrityResult result = {path, std::string(), false, false, {e.what()}, 0};
+                skipped.push_back(result);
+                continue;
+            }
+            for (const auto& table : listTables(connection.get())) {
+                task.table = table;
+                tasks.push_back(task);
+            }
+        }
+    }
+    
+    std::vector<IntegrityResult> results(tasks.size());
+    std::mutex mutex;
+    std::condition_variable finished_cv;
+    std::size_t completed = 0;
+    std::size_t running = 0;
+    std::atomic<std::size_t> next_task(0);
+    auto worker = [&]() {
+        for (std::size_t index = next_task++; index < tasks.size(); index = next_task++) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ++running;
+            }
+            runCheck(tasks[index], options, results[index]);
+            std::lock_guard<std::mutex> lock(mutex);
+            --running;
+            ++completed;
+            if (options.on_progress) {
+                IntegrityProgress progress = {completed, tasks.size(), running, elapsedMs(start), &results[index]};
+                options.on_progress(progress);
+            }
+            finished_cv.notify_all();
+        }
+    };
+    std::vector<std::thread> workers;
+    std::size_t worker_count = std::min<std::size_t>(std::max(1, options.threads), tasks.size());
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(worker);
+    }
+    
+    // 调用线程定时报告进度，大文件上单项检查可能持续很久
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (completed < tasks.size()) {
+            if (options.progress_interval_ms <= 0 || !options.on_progress) {
+                finished_cv.wait(lock);
+            } else if (!finished_cv.wait_for(lock, std::chrono::milliseconds(options.progress_interval_ms),
+                                             [&]() { return completed == tasks.size(); })) {
+                IntegrityProgress progress = {completed, tasks.size(), running, elapsedMs(start), nullptr};
+                options.on_progress(progress);
+            }
+        }
+    }
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    
+    results.insert(results.end(), skipped.begin(), skipped.end());
+    return results;
+}
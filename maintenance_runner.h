@@ -0,0 +1,102 @@
+#pragma once
+
+#include "multi_connection_database_manager.h"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// 索引构建结果
+enum class IndexBuildStatus {
+    BUILT,    // 已构建
+    EXISTS,   // 索引已存在，跳过
+    YIELDED,  // 多次为交互式写入让路后仍未完成，留待下次
+    FAILED    // SQLite执行错误
+};
+
+struct IndexBuildResult {
+    std::string database;
+    std::string path;
+    std::string index;
+    IndexBuildStatus status;
+    int attempts;
+    long long elapsed_ms;
+    long long longest_hold_ms;  // 单次尝试持有写入准入的最长时间，即交互式写入可能被推迟的上限
+    std::string error;
+};
+
+struct IndexBuildOptions {
+    IndexBuildOptions()
+        : sort_threads(4), cache_mb(256), parallel_files(2), yield_after_ms(250), pause_ms(1000), max_attempts(3) {}
+    
+    int sort_threads;    // 排序的辅助线程数（PRAGMA threads，SQLite上限为8）
+    int cache_mb;        // 构建连接的页缓存大小
+    int parallel_files;  // 同时构建的数据库文件数；同一文件上的索引依次构建
+    // 构建已超过yield_after_ms且有交互式写入在等待时中止本次构建（已完成的部分随之回滚），
+    // 等待pause_ms后重试，每次重试让路时限加倍，至多max_attempts次，仍未完成时报告YIELDED；
+    // 0表示不让路，整个构建持有一张准入，期间的交互式写入排队直至截止时间
+    int yield_after_ms;
+    int pause_ms;
+    int max_attempts;
+    std::function<void(const IndexBuildResult&)> on_index;  // 每个索引完成后调用（已串行化）
+};
+
+// 完整性检查结果：一个文件或文件中的一张表
+struct IntegrityResult {
+    std::string path;
+    std::string table;  // 为空表示整个文件
+    bool checked;       // 无法打开读者连接（如内存模式数据库）时为false，errors中为原因
+    bool ok;
+    std::vector<std::string> errors;
+    long long elapsed_ms;
+};
+
+struct IntegrityProgress {
+    std::size_t completed;
+    std::size_t total;
+    std::size_t running;
+    long long elapsed_ms;
+    const IntegrityResult* finished;  // 刚完成的检查，定时报告时为nullptr
+};
+
+struct IntegrityOptions {
+    IntegrityOptions() : quick(true), threads(4), max_errors(100), split_tables(true), progress_interval_ms(1000) {}
+    
+    bool quick;             // quick_check：不比对索引与表内容，耗时约为integrity_check的几分之一
+    int threads;            // 并行检查数，每个检查一个读者连接
+    int max_errors;         // 每项检查最多记录的错误数
+    // 同一文件按表拆分为并行的检查；拆分后不检查未被任何表引用的页（空闲页列表），
+    // 需要时设为false按整个文件检查
+    bool split_tables;
+    int progress_interval_ms;  // 定时报告的间隔，0表示只在检查完成时报告
+    std::function<void(const IntegrityProgress&)> on_progress;  // 已串行化
+};
+
+// 数据库维护
+//
+// 索引构建：SQLite在一个写事务内构建整个索引，无法拆分为多个事务，因此以单个
+// 索引为一批，构建时间随表大小增长，没有上限。每批在专用连接上执行（排序可使用
+// 多个辅助线程），先以批量优先级获得写入准入：排队中的交互式写入先于构建执行，
+// 构建期间经由写入连接的读取不被阻塞，交互式写入在准入队列中等待。默认在构建
+// 超过yield_after_ms后为等待中的交互式写入让路，让路即回滚，持续有写入时大索引
+// 会反复重建直至报告YIELDED，宜在低峰时以yield_after_ms=0构建。
+// 准入只约束本进程内的写入：其他进程的写入不可见、不会触发让路，它们在SQLite
+// 忙等待中等待构建事务结束，超过其忙等待时限时失败。
+// 索引之间归还准入，不同文件的索引并行构建。
+//
+// 完整性检查：每个数据库文件（同文件放置的数据库只检查一次）在各自的读者连接上
+// 执行quick_check或integrity_check，可按表拆分以在大文件内并行。检查在WAL读事务
+// 中进行，不阻塞写入，但检查期间检查点无法越过其快照，WAL文件会增长。
+class MaintenanceRunner {
+public:
+    typedef MultiConnectionDatabaseManager::DatabaseId DatabaseId;
+    
+    // 构建所有已注册数据库声明的延后索引（DatabaseSpec::deferred_index_sql）
+    static std::vector<IndexBuildResult> buildDeferredIndexes(const IndexBuildOptions& options = IndexBuildOptions());
+    // 在数据库的每个分片上构建index_sql中的索引（一条或多条CREATE INDEX语句）
+    static std::vector<IndexBuildResult> buildIndexes(DatabaseId id, const std::string& index_sql,
+                                                      const IndexBuildOptions& options = IndexBuildOptions());
+    
+    // 检查所有已注册数据库文件
+    static std::vector<IntegrityResult> checkIntegrity(const IntegrityOptions& options = IntegrityOptions());
+};
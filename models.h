@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+
+// 业务实体，单文件与多文件两种存储布局共用
+
+struct User {
+    int id;
+    std::string username;
+    std::string email;
+    std::string created_at;
+    std::string updated_at;
+    int version;  // 行版本，每次写入递增，用于乐观并发控制；单文件布局不维护，恒为0
+};
+
+struct Order {
+    int id;
+    int user_id;
+    double total_amount;
+    std::string status;
+    std::string created_at;
+    std::string updated_at;
+};
+
+struct Product {
+    int id;
+    std::string name;
+    std::string description;
+    double price;
+    int stock_quantity;
+    std::string created_at;
+    std::string updated_at;
+    int version;  // 同User::version
+};
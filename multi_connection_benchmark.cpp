@@ -0,0 +1,1204 @@
+#include "multi_connection_database_manager.h"
+#include "multi_connection_order_manager.h"
+#include "multi_connection_product_manager.h"
+#include "multi_connection_checkout_manager.h"
+#include "multi_connection_user_manager.h"
+#include "workload_capture.h"
+#include "compressed_vfs.h"
+#include "epoch_reclaimer.h"
+#include "order_exporter.h"
+#include "maintenance_runner.h"
+#include <sys/stat.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// 多连接架构基准测试
+//
+// 用法: multi_connection_benchmark [线程数] [每线程操作数]
+
+namespace {
+
+struct BenchmarkResult {
+    int succeeded;
+    int failed;
+    long long elapsed_ms;
+};
+
+void printResult(const std::string& name, const BenchmarkResult& result) {
+    int total = result.succeeded + result.failed;
+    std::cout << name << ": 成功 " << result.succeeded << ", 失败 " << result.failed
+              << ", 耗时 " << result.elapsed_ms << " 毫秒";
+    if (result.elapsed_ms > 0) {
+        std::cout << ", 吞吐量 " << (total * 1000.0 / result.elapsed_ms) << " 次/秒";
+    }
+    std::cout << std::endl;
+    
+    // 本场景期间经由SQLite的文件I/O（runThreads开始时清零）
+    std::uint64_t writes = 0, write_bytes = 0, syncs = 0, sync_ns = 0;
+    for (const auto& file : IoStatsVfs::snapshot()) {
+        writes += file.writes;
+        write_bytes += file.write_bytes;
+        syncs += file.syncs;
+        sync_ns += file.sync_ns;
+    }
+    std::cout << "  I/O: 写入 " << writes << " 次 / " << (write_bytes / 1024) << " KB, 同步 " << syncs
+              << " 次 / " << (sync_ns / 1000000) << " 毫秒";
+    if (total > 0) {
+        std::cout << ", 每操作同步 " << (static_cast<double>(syncs) / total) << " 次";
+    }
+    std::cout << std::endl;
+}
+
+// 准备库存充足的测试产品
+std::vector<int> prepareProducts(int count) {
+    auto& product_manager = MultiConnectionProductManager::getInstance();
+    std::vector<int> product_ids;
+    for (int i = 0; i < count; ++i) {
+        std::string name = "bench_product_" + std::to_string(i);
+        Product product = product_manager.getProductByName(name);
+        if (product.id == 0 && product_manager.createProduct(name, "基准测试产品", 10.0 + i, 1000000)) {
+            product = product_manager.getProductByName(name);
+        }
+        if (product.id != 0) {
+            product_ids.push_back(product.id);
+        }
+    }
+    return product_ids;
+}
+
+std::vector<CheckoutItem> randomItems(std::mt19937& gen, const std::vector<int>& product_ids) {
+    std::uniform_int_distribution<> product_dis(0, static_cast<int>(product_ids.size()) - 1);
+    std::uniform_int_distribution<> line_dis(1, 4);
+    std::uniform_int_distribution<> quantity_dis(1, 3);
+    
+    std::vector<CheckoutItem> items;
+    int lines = line_dis(gen);
+    for (int k = 0; k < lines; ++k) {
+        items.push_back({product_ids[product_dis(gen)], quantity_dis(gen)});
+    }
+    return items;
+}
+
+template <typename Operation>
+BenchmarkResult runThreads(int thread_count, int operations_per_thread, Operation operation) {
+    std::atomic<int> succeeded(0);
+    std::atomic<int> failed(0);
+    std::vector<std::thread> threads;
+    IoStatsVfs::reset();
+    auto start_time = std::chrono::high_resolution_clock::now();
+    
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([i, operations_per_thread, &operation, &succeeded, &failed]() {
+            std::mt19937 gen(static_cast<unsigned>(i + 1));
+            for (int j = 0; j < operations_per_thread; ++j) {
+                if (operation(i, gen)) {
+                    ++succeeded;
+                } else {
+                    ++failed;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    auto end_time = std::chrono::high_resolution_clock::now();
+    BenchmarkResult result = {succeeded.load(), failed.load(),
+                              std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count()};
+    return result;
+}
+
+// 下单：逐项扣减库存后创建订单，每步独立提交且不具备原子性
+void benchmarkPerItemCheckout(int thread_count, int operations_per_thread, const std::vector<int>& product_ids) {
+    auto& product_manager = MultiConnectionProductManager::getInstance();
+    auto& order_manager = MultiConnectionOrderManager::getInstance();
+    
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread,
+        [&](int thread_index, std::mt19937& gen) {
+            double total_amount = 0.0;
+            for (const auto& item : randomItems(gen, product_ids)) {
+                if (!product_manager.decreaseStock(item.product_id, item.quantity)) {
+                    return false;
+                }
+                total_amount += product_manager.getProductById(item.product_id).price * item.quantity;
+            }
+            return order_manager.createOrder(thread_index + 1, total_amount);
+        });
+    printResult("逐项提交下单", result);
+}
+
+// 下单：checkout()在每个数据库上各一个事务内完成
+void benchmarkAtomicCheckout(int thread_count, int operations_per_thread, const std::vector<int>& product_ids) {
+    auto& checkout_manager = MultiConnectionCheckoutManager::getInstance();
+    
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread,
+        [&](int thread_index, std::mt19937& gen) {
+            return checkout_manager.checkout(thread_index + 1, randomItems(gen, product_ids)) == CheckoutResult::SUCCESS;
+        });
+    printResult("原子下单", result);
+}
+
+// 热点产品库存增减：对比逐条UPDATE与写合并
+void benchmarkHotStockUpdates(int thread_count, int operations_per_thread, const std::vector<int>& product_ids,
+                              bool coalescing) {
+    auto& product_manager = MultiConnectionProductManager::getInstance();
+    // 只使用前两个产品，模拟热点SKU
+    std::vector<int> hot_ids(product_ids.begin(), product_ids.begin() + std::min<std::size_t>(2, product_ids.size()));
+    
+    if (coalescing) {
+        product_manager.enableStockCoalescing(5);
+    }
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread,
+        [&](int thread_index, std::mt19937& gen) {
+            int id = hot_ids[gen() % hot_ids.size()];
+            return thread_index % 2 == 0 ? product_manager.decreaseStock(id, 1) : product_manager.increaseStock(id, 1);
+        });
+    if (coalescing) {
+        product_manager.disableStockCoalescing();
+    }
+    printResult(coalescing ? "热点库存（写合并）" : "热点库存（逐条UPDATE）", result);
+}
+
+// 过载：大量写入者争用订单库，短截止时间下观察拒绝与超时
+void benchmarkOverload(int thread_count, int operations_per_thread) {
+    auto& order_manager = MultiConnectionOrderManager::getInstance();
+    AdmissionController& admission = MultiConnectionDatabaseManager::getInstance().admissionController(
+        MultiConnectionDatabaseManager::TableType::ORDERS);
+    AdmissionMetrics before = admission.metrics();
+    
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread,
+        [&](int thread_index, std::mt19937&) {
+            AdmissionController::ScopedDeadline deadline(std::chrono::milliseconds(2));
+            return order_manager.createOrder(thread_index + 1, 1.0);
+        });
+    printResult("过载写入", result);
+    
+    AdmissionMetrics after = admission.metrics();
+    std::cout << "准入 " << (after.admitted - before.admitted)
+              << ", 拒绝 " << (after.rejected - before.rejected)
+              << ", 超时 " << (after.deadline_exceeded - before.deadline_exceeded)
+              << ", 峰值队列 " << after.peak_queue_depth;
+    if (after.admitted > before.admitted) {
+        std::cout << ", 平均排队 " << (after.total_wait_us - before.total_wait_us) / (after.admitted - before.admitted) << " 微秒";
+    }
+    std::cout << std::endl;
+}
+
+// 大批量导入期间的交互式写入延迟：对比整批事务与分块导入
+void benchmarkInteractiveDuringImport(int import_rows, bool chunked) {
+    auto& order_manager = MultiConnectionOrderManager::getInstance();
+    
+    std::vector<std::tuple<int, double, std::string>> rows;
+    for (int i = 0; i < import_rows; ++i) {
+        rows.push_back(std::make_tuple(i % 1000 + 1, 9.99, std::string("imported")));
+    }
+    
+    std::atomic<bool> importing(true);
+    std::thread importer([&]() {
+        if (chunked) {
+            order_manager.importOrders(rows, 1000);
+        } else {
+            order_manager.createOrdersTransaction(rows);
+        }
+        importing = false;
+    });
+    
+    // 导入进行期间持续发起交互式写入并记录延迟
+    std::vector<long long> latencies_us;
+    while (importing) {
+        auto start = std::chrono::steady_clock::now();
+        order_manager.createOrder(1, 1.0);
+        latencies_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    importer.join();
+    
+    std::sort(latencies_us.begin(), latencies_us.end());
+    std::cout << (chunked ? "分块导入" : "整批事务导入") << ": 交互式写入 " << latencies_us.size() << " 次";
+    if (!latencies_us.empty()) {
+        std::cout << ", p50 " << latencies_us[latencies_us.size() / 2] << " 微秒"
+                  << ", p99 " << latencies_us[latencies_us.size() * 99 / 100] << " 微秒"
+                  << ", 最大 " << latencies_us.back() << " 微秒";
+    }
+    std::cout << std::endl;
+}
+
+// 冷订单存储：对比未压缩与页组压缩的磁盘占用和全表扫描吞吐
+void benchmarkColdOrderStorage(int rows, bool compressed) {
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    std::string path = compressed ? "bench_orders_compressed.db" : "bench_orders_plain.db";
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+    
+    DatabaseSpec spec;
+    spec.name = compressed ? "bench_orders_compressed" : "bench_orders_plain";
+    spec.shard_paths.push_back(path);
+    spec.schema_sql = R"(
+        CREATE TABLE IF NOT EXISTS orders (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            user_id INTEGER NOT NULL,
+            total_amount DECIMAL(10,2) NOT NULL,
+            status TEXT DEFAULT 'pending',
+            created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            updated_at DATETIME DEFAULT CURRENT_TIMESTAMP
+        );
+    )";
+    // 页缓存很小，使扫描经过VFS读取
+    spec.policy.cache_size = 64;
+    if (compressed) {
+        spec.policy.vfs = CompressedVfs::kVfsName;
+    }
+    MultiConnectionDatabaseManager::DatabaseId id = db_manager.registerDatabase(spec);
+    sqlite3* db = db_manager.borrowConnection(id);
+    std::lock_guard<std::recursive_mutex> lock(db_manager.connectionMutex(id));
+    
+    static const char* const statuses[] = {"pending", "paid", "shipped", "delivered"};
+    auto load_start = std::chrono::steady_clock::now();
+    sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+    sqlite3_stmt* insert = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO orders (user_id, total_amount, status) VALUES (?, ?, ?)", -1, &insert, nullptr);
+    for (int i = 0; i < rows; ++i) {
+        sqlite3_bind_int(insert, 1, i % 1000 + 1);
+        sqlite3_bind_double(insert, 2, 10.0 + (i % 500) * 0.25);
+        sqlite3_bind_text(insert, 3, statuses[i % 4], -1, SQLITE_STATIC);
+        sqlite3_step(insert);
+        sqlite3_reset(insert);
+    }
+    sqlite3_finalize(insert);
+    sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    // 检查点把全部页写入主库文件，之后的扫描只读主库
+    sqlite3_exec(db, "PRAGMA wal_checkpoint(TRUNCATE);", nullptr, nullptr, nullptr);
+    long long load_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - load_start).count();
+    
+    struct stat file_stat;
+    long long disk_bytes = stat(path.c_str(), &file_stat) == 0 ? static_cast<long long>(file_stat.st_size) : 0;
+    long long logical_bytes = 0;
+    sqlite3_stmt* size_stmt = nullptr;
+    sqlite3_prepare_v2(db, "SELECT page_count * page_size FROM pragma_page_count(), pragma_page_size()", -1,
+                       &size_stmt, nullptr);
+    if (size_stmt && sqlite3_step(size_stmt) == SQLITE_ROW) {
+        logical_bytes = sqlite3_column_int64(size_stmt, 0);
+    }
+    sqlite3_finalize(size_stmt);
+    
+    // 不走索引的全表扫描
+    const int scans = 5;
+    sqlite3_stmt* scan = nullptr;
+    sqlite3_prepare_v2(db, "SELECT COUNT(*), SUM(total_amount) FROM orders WHERE created_at >= '2000-01-01'", -1,
+                       &scan, nullptr);
+    auto scan_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < scans; ++i) {
+        sqlite3_step(scan);
+        sqlite3_reset(scan);
+    }
+    sqlite3_finalize(scan);
+    double scan_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - scan_start).count();
+    
+    std::cout << (compressed ? "页组压缩" : "未压缩") << ": " << rows << " 行, 导入 " << load_ms << " 毫秒"
+              << ", 磁盘 " << disk_bytes / 1024 << " KB (逻辑 " << logical_bytes / 1024 << " KB";
+    if (disk_bytes > 0) {
+        std::cout << ", 压缩比 " << static_cast<double>(logical_bytes) / disk_bytes;
+    }
+    std::cout << "), 扫描 " << (scan_seconds > 0 ? logical_bytes * scans / scan_seconds / (1024 * 1024) : 0)
+              << " MB/秒" << std::endl;
+}
+
+// 页面布局：大量删除后对比不同页大小与自动清理模式的文件大小和扫描耗时
+void benchmarkPageLayout(int rows, int page_size, const std::string& auto_vacuum) {
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    std::string name = "bench_layout_" + std::to_string(page_size) + "_" + auto_vacuum;
+    std::string path = name + ".db";
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+    
+    DatabaseSpec spec;
+    spec.name = name;
+    spec.shard_paths.push_back(path);
+    spec.schema_sql = R"(
+        CREATE TABLE IF NOT EXISTS orders (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            user_id INTEGER NOT NULL,
+            total_amount DECIMAL(10,2) NOT NULL,
+            status TEXT DEFAULT 'pending',
+            created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            updated_at DATETIME DEFAULT CURRENT_TIMESTAMP
+        );
+        CREATE INDEX IF NOT EXISTS idx_orders_user_id ON orders(user_id);
+    )";
+    spec.policy.cache_size = 64;
+    spec.policy.page_size = page_size;
+    spec.policy.auto_vacuum = auto_vacuum;
+    spec.policy.vacuum_interval_ms = 20;
+    spec.policy.vacuum_step_pages = 256;
+    MultiConnectionDatabaseManager::DatabaseId id = db_manager.registerDatabase(spec);
+    sqlite3* db = db_manager.borrowConnection(id);
+    std::recursive_mutex& mutex = db_manager.connectionMutex(id);
+    
+    auto freelist = [&]() {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        sqlite3_stmt* stmt = nullptr;
+        int count = 0;
+        sqlite3_prepare_v2(db, "PRAGMA freelist_count", -1, &stmt, nullptr);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            count = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+        return count;
+    };
+    
+    // 写入后删除三分之二的行，模拟deleteOrder()造成的碎片
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+        sqlite3_stmt* insert = nullptr;
+        sqlite3_prepare_v2(db, "INSERT INTO orders (user_id, total_amount, status) VALUES (?, ?, 'pending')", -1,
+                           &insert, nullptr);
+        for (int i = 0; i < rows; ++i) {
+            sqlite3_bind_int(insert, 1, i % 1000 + 1);
+            sqlite3_bind_double(insert, 2, 10.0 + (i % 500) * 0.25);
+            sqlite3_step(insert);
+            sqlite3_reset(insert);
+        }
+        sqlite3_finalize(insert);
+        sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+        sqlite3_exec(db, "DELETE FROM orders WHERE id % 3 != 0;", nullptr, nullptr, nullptr);
+    }
+    int freed = freelist();
+    
+    // INCREMENTAL模式等待后台清理归还空闲页
+    auto vacuum_start = std::chrono::steady_clock::now();
+    while (auto_vacuum == "INCREMENTAL" && freelist() > 0 &&
+           std::chrono::steady_clock::now() - vacuum_start < std::chrono::seconds(10)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    long long vacuum_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - vacuum_start).count();
+    int remaining = freelist();
+    
+    long long scan_us = 0;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        sqlite3_exec(db, "PRAGMA wal_checkpoint(TRUNCATE);", nullptr, nullptr, nullptr);
+        sqlite3_stmt* scan = nullptr;
+        sqlite3_prepare_v2(db, "SELECT COUNT(*), SUM(total_amount) FROM orders WHERE status = 'pending'", -1, &scan,
+                           nullptr);
+        auto scan_start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 5; ++i) {
+            sqlite3_step(scan);
+            sqlite3_reset(scan);
+        }
+        scan_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - scan_start).count() / 5;
+        sqlite3_finalize(scan);
+    }
+    
+    struct stat file_stat;
+    long long disk_bytes = stat(path.c_str(), &file_stat) == 0 ? static_cast<long long>(file_stat.st_size) : 0;
+    std::cout << "页大小 " << page_size << ", " << auto_vacuum << ": 删除后空闲页 " << freed
+              << ", 剩余空闲页 " << remaining;
+    if (auto_vacuum == "INCREMENTAL") {
+        std::cout << " (后台清理 " << vacuum_ms << " 毫秒)";
+    }
+    std::cout << ", 文件 " << disk_bytes / 1024 << " KB, 全表扫描 " << scan_us << " 微秒" << std::endl;
+}
+
+// 单行写入延迟：对比磁盘（WAL）与内存模式
+void benchmarkWriteLatency(int rows, bool in_memory) {
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    std::string path = in_memory ? "bench_latency_memory.db" : "bench_latency_disk.db";
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+    
+    DatabaseSpec spec;
+    spec.name = in_memory ? "bench_latency_memory" : "bench_latency_disk";
+    spec.shard_paths.push_back(path);
+    spec.schema_sql = "CREATE TABLE IF NOT EXISTS events (id INTEGER PRIMARY KEY, payload TEXT NOT NULL);";
+    spec.policy.in_memory = in_memory;
+    MultiConnectionDatabaseManager::DatabaseId id = db_manager.registerDatabase(spec);
+    sqlite3* db = db_manager.borrowConnection(id);
+    std::recursive_mutex& mutex = db_manager.connectionMutex(id);
+    
+    sqlite3_stmt* insert = nullptr;
+    sqlite3_prepare_v2(db, "INSERT INTO events (payload) VALUES (?)", -1, &insert, nullptr);
+    std::vector<long long> latencies_ns;
+    for (int i = 0; i < rows; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            sqlite3_bind_text(insert, 1, "event payload", -1, SQLITE_STATIC);
+            sqlite3_step(insert);
+            sqlite3_reset(insert);
+        }
+        latencies_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    sqlite3_finalize(insert);
+    
+    // 内存模式的持久化代价：一次完整快照
+    long long snapshot_us = 0;
+    if (in_memory) {
+        auto start = std::chrono::steady_clock::now();
+        db_manager.snapshotInMemoryDatabases();
+        snapshot_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+    
+    std::sort(latencies_ns.begin(), latencies_ns.end());
+    std::cout << (in_memory ? "内存模式" : "磁盘WAL") << ": " << rows << " 次单行写入"
+              << ", p50 " << latencies_ns[latencies_ns.size() / 2] / 1000.0 << " 微秒"
+              << ", p99 " << latencies_ns[latencies_ns.size() * 99 / 100] / 1000.0 << " 微秒";
+    if (in_memory) {
+        std::cout << ", 快照 " << snapshot_us << " 微秒";
+    }
+    std::cout << std::endl;
+}
+
+// 删除延迟：对比同步DELETE与软删除（置标记、后台分批清理）
+void benchmarkOrderDelete(int rows, bool soft_delete) {
+    auto& order_manager = MultiConnectionOrderManager::getInstance();
+    const int user_id = soft_delete ? 900002 : 900001;
+    
+    std::vector<std::tuple<int, double, std::string>> orders;
+    for (int i = 0; i < rows; ++i) {
+        orders.push_back(std::make_tuple(user_id, 19.99, std::string(i % 2 ? "shipped" : "pending")));
+    }
+    order_manager.importOrders(orders);
+    std::vector<Order> created = order_manager.getOrdersByUserId(user_id);
+    
+    if (soft_delete) {
+        order_manager.enableSoftDelete(64, 10);
+    }
+    std::uint64_t purged_before = order_manager.purgedOrders();
+    std::vector<long long> latencies_us;
+    for (const auto& order : created) {
+        auto start = std::chrono::steady_clock::now();
+        order_manager.deleteOrder(order.id);
+        latencies_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+    
+    // 软删除：等待后台清理完成物理删除
+    long long purge_ms = 0;
+    if (soft_delete) {
+        auto start = std::chrono::steady_clock::now();
+        while (order_manager.purgedOrders() - purged_before < created.size() &&
+               std::chrono::steady_clock::now() - start < std::chrono::seconds(30)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        purge_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        order_manager.disableSoftDelete();
+    }
+    
+    std::sort(latencies_us.begin(), latencies_us.end());
+    std::cout << (soft_delete ? "软删除" : "同步删除") << ": " << latencies_us.size() << " 次删除";
+    if (!latencies_us.empty()) {
+        std::cout << ", p50 " << latencies_us[latencies_us.size() / 2] << " 微秒"
+                  << ", p99 " << latencies_us[latencies_us.size() * 99 / 100] << " 微秒";
+    }
+    if (soft_delete) {
+        std::cout << ", 后台清理 " << (order_manager.purgedOrders() - purged_before) << " 行 / "
+                  << purge_ms << " 毫秒";
+    }
+    std::cout << ", 剩余可见 " << order_manager.getOrdersByUserId(user_id).size() << " 行" << std::endl;
+}
+
+// 看板读取：写入持续进行时反复查询同一状态的订单，对比写入连接与快照读者
+void benchmarkDashboardReads(int thread_count, int operations_per_thread, bool snapshot) {
+    auto& order_manager = MultiConnectionOrderManager::getInstance();
+    if (order_manager.getOrderCountByStatus("dashboard") == 0) {
+        std::vector<std::tuple<int, double, std::string>> rows;
+        for (int i = 0; i < 200; ++i) {
+            rows.push_back(std::make_tuple(i % 50 + 1, 49.5, std::string("dashboard")));
+        }
+        order_manager.createOrdersTransaction(rows);
+    }
+    if (snapshot) {
+        order_manager.enableSnapshotReads(200);
+    }
+    
+    // 后台写入者记录单次写入延迟
+    std::atomic<bool> reading(true);
+    std::vector<long long> write_latencies_us;
+    std::thread writer([&]() {
+        while (reading) {
+            auto start = std::chrono::steady_clock::now();
+            order_manager.createOrder(2, 5.0, "dashboard_writer");
+            write_latencies_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+    });
+    
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread, [&](int, std::mt19937&) {
+        return !order_manager.getOrdersByStatus("dashboard").empty();
+    });
+    reading = false;
+    writer.join();
+    if (snapshot) {
+        order_manager.disableSnapshotReads();
+    }
+    
+    printResult(snapshot ? "快照读者" : "写入连接", result);
+    std::sort(write_latencies_us.begin(), write_latencies_us.end());
+    if (!write_latencies_us.empty()) {
+        std::cout << "  并发写入 " << write_latencies_us.size() << " 次, p50 "
+                  << write_latencies_us[write_latencies_us.size() / 2] << " 微秒, p99 "
+                  << write_latencies_us[write_latencies_us.size() * 99 / 100] << " 微秒" << std::endl;
+    }
+}
+
+// 列表查询：少量固定参数的重复查询与低频写入并存，对比直接查询与结果缓存
+void benchmarkListingCache(int thread_count, int operations_per_thread, const std::vector<int>& product_ids,
+                           bool cached) {
+    auto& product_manager = MultiConnectionProductManager::getInstance();
+    auto& order_manager = MultiConnectionOrderManager::getInstance();
+    if (cached) {
+        product_manager.enableResultCache();
+        order_manager.enableResultCache();
+    }
+    
+    // 每毫秒一次价格写入，使产品列表的缓存持续失效
+    std::atomic<bool> reading(true);
+    std::atomic<int> writes(0);
+    std::thread writer([&]() {
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<> product_dis(0, static_cast<int>(product_ids.size()) - 1);
+        while (reading) {
+            if (product_manager.updateProductPrice(product_ids[product_dis(gen)], 10.0 + writes % 20)) {
+                ++writes;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread, [&](int, std::mt19937& gen) {
+        switch (gen() % 3) {
+            case 0:
+                return !product_manager.getProductsByPriceRange(10.0, 20.0 + gen() % 4).empty();
+            case 1:
+                return !product_manager.getProductsInStock().empty();
+            default:
+                return !order_manager.getOrdersByStatus("dashboard").empty();
+        }
+    });
+    reading = false;
+    writer.join();
+    if (cached) {
+        product_manager.disableResultCache();
+        order_manager.disableResultCache();
+    }
+    
+    printResult(cached ? "结果缓存" : "直接查询", result);
+    std::cout << "  并发价格写入 " << writes.load() << " 次" << std::endl;
+}
+
+// 注册前的可用性检查：绝大多数名称从未出现过，少量为重复注册
+void benchmarkNameAvailability(int thread_count, int operations_per_thread, bool filtered) {
+    auto& user_manager = MultiConnectionUserManager::getInstance();
+    if (user_manager.getUserByUsername("bench_taken").id == 0) {
+        user_manager.createUser("bench_taken", "bench_taken@example.com");
+    }
+    
+    std::atomic<int> duplicates(0);
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread, [&](int thread, std::mt19937& gen) {
+        if (gen() % 10 == 0) {
+            // 重复注册：过滤器命中后以只读探测拒绝，不开启写事务
+            if (!user_manager.createUser("bench_taken", "bench_taken@example.com")) {
+                ++duplicates;
+            }
+            return true;
+        }
+        std::string username = "fresh_" + std::to_string(thread) + "_" + std::to_string(gen());
+        if (filtered) {
+            return user_manager.isUsernameAvailable(username) &&
+                   user_manager.isEmailAvailable(username + "@example.com");
+        }
+        return user_manager.getUserByUsername(username).id == 0;
+    });
+    
+    printResult(filtered ? "布隆过滤器" : "按用户名查询", result);
+    std::cout << "  拒绝重复注册 " << duplicates.load() << " 次" << std::endl;
+}
+
+// 按id与用户名的单行查询，伴随低频资料更新
+void benchmarkUserLookups(int thread_count, int operations_per_thread, bool directory) {
+    auto& user_manager = MultiConnectionUserManager::getInstance();
+    const int user_count = 1000;
+    if (user_manager.getUserByUsername("lookup_user_0").id == 0) {
+        std::vector<std::pair<std::string, std::string>> rows;
+        for (int i = 0; i < user_count; ++i) {
+            std::string username = "lookup_user_" + std::to_string(i);
+            rows.push_back(std::make_pair(username, username + "@example.com"));
+        }
+        user_manager.createUsersTransaction(rows);
+    }
+    std::vector<int> user_ids;
+    for (int i = 0; i < user_count; ++i) {
+        user_ids.push_back(user_manager.getUserByUsername("lookup_user_" + std::to_string(i)).id);
+    }
+    if (directory) {
+        user_manager.enableUserDirectory();
+    }
+    
+    // 每毫秒更新一次邮箱，验证查询期间的写入同步
+    std::atomic<bool> reading(true);
+    std::atomic<int> writes(0);
+    std::thread writer([&]() {
+        std::mt19937 gen(11);
+        std::uniform_int_distribution<> user_dis(0, user_count - 1);
+        while (reading) {
+            int i = user_dis(gen);
+            std::string username = "lookup_user_" + std::to_string(i);
+            if (user_manager.updateUser(user_ids[i], username, username + "." + std::to_string(writes) + "@example.com")) {
+                ++writes;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread, [&](int, std::mt19937& gen) {
+        int i = static_cast<int>(gen() % user_count);
+        if (gen() % 2 == 0) {
+            return user_manager.getUserById(user_ids[i]).id == user_ids[i];
+        }
+        return user_manager.getUserByUsername("lookup_user_" + std::to_string(i)).id == user_ids[i];
+    });
+    reading = false;
+    writer.join();
+    if (directory) {
+        user_manager.disableUserDirectory();
+    }
+    
+    printResult(directory ? "内存目录" : "SQLite查询", result);
+    std::cout << "  并发资料更新 " << writes.load() << " 次" << std::endl;
+}
+
+// 共享配置对象的读取：对比std::atomic_load(shared_ptr)与EpochReclaimer::Guard加原始指针，
+// 写入者每毫秒整体替换一次对象
+struct SharedSettings {
+    int values[16];
+};
+
+void benchmarkReclamation(int thread_count, int operations_per_thread, bool epoch) {
+    std::shared_ptr<SharedSettings> shared(new SharedSettings());
+    std::atomic<SharedSettings*> current(new SharedSettings());
+    
+    std::atomic<bool> reading(true);
+    std::atomic<int> replacements(0);
+    std::thread writer([&]() {
+        while (reading) {
+            SharedSettings* settings = new SharedSettings();
+            for (int i = 0; i < 16; ++i) {
+                settings->values[i] = replacements;
+            }
+            if (epoch) {
+                EpochReclaimer::getInstance().retire(current.exchange(settings));
+            } else {
+                std::atomic_store(&shared, std::shared_ptr<SharedSettings>(settings));
+            }
+            ++replacements;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    
+    std::uint64_t reclaimed_before = EpochReclaimer::getInstance().reclaimed();
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread, [&](int, std::mt19937& gen) {
+        int index = static_cast<int>(gen() % 16);
+        if (epoch) {
+            EpochReclaimer::Guard guard;
+            return current.load(std::memory_order_acquire)->values[index] >= 0;
+        }
+        std::shared_ptr<SharedSettings> settings = std::atomic_load(&shared);
+        return settings->values[index] >= 0;
+    });
+    reading = false;
+    writer.join();
+    
+    printResult(epoch ? "纪元回收" : "shared_ptr", result);
+    std::cout << "  对象替换 " << replacements.load() << " 次";
+    if (epoch) {
+        std::cout << ", 期间回收 " << (EpochReclaimer::getInstance().reclaimed() - reclaimed_before) << " 个";
+        EpochReclaimer::getInstance().retire(current.exchange(nullptr));
+    }
+    std::cout << std::endl;
+}
+
+// 订单用户引用校验的校验开销：每次校验一批20个user_id，逐条getUserById()对比
+// 用户id集合；约5%的批次含不存在的用户。期间每毫秒更新一次用户资料
+void benchmarkUserReferenceChecks(int thread_count, int operations_per_thread, bool id_set) {
+    auto& user_manager = MultiConnectionUserManager::getInstance();
+    auto& order_manager = MultiConnectionOrderManager::getInstance();
+    const int user_count = 1000;
+    const int batch_size = 20;
+    if (user_manager.getUserByUsername("reference_user_0").id == 0) {
+        std::vector<std::pair<std::string, std::string>> rows;
+        for (int i = 0; i < user_count; ++i) {
+            std::string username = "reference_user_" + std::to_string(i);
+            rows.push_back(std::make_pair(username, username + "@example.com"));
+        }
+        user_manager.createUsersTransaction(rows);
+    }
+    std::vector<int> user_ids;
+    for (int i = 0; i < user_count; ++i) {
+        user_ids.push_back(user_manager.getUserByUsername("reference_user_" + std::to_string(i)).id);
+    }
+    if (id_set) {
+        order_manager.enableUserReferenceChecks();
+    }
+    
+    std::atomic<bool> checking(true);
+    std::atomic<int> writes(0);
+    std::thread writer([&]() {
+        std::mt19937 gen(13);
+        while (checking) {
+            int i = static_cast<int>(gen() % user_count);
+            std::string username = "reference_user_" + std::to_string(i);
+            if (user_manager.updateUser(user_ids[i], username, username + "." + std::to_string(writes) + "@example.com")) {
+                ++writes;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread, [&](int, std::mt19937& gen) {
+        bool orphan = gen() % 20 == 0;
+        std::vector<int> batch;
+        for (int k = 0; k < batch_size; ++k) {
+            batch.push_back(orphan && k == 0 ? -1 : user_ids[gen() % user_count]);
+        }
+        bool valid = true;
+        if (id_set) {
+            valid = user_manager.usersExist(batch);
+        } else {
+            for (int user_id : batch) {
+                if (user_manager.getUserById(user_id).id == 0) {
+                    valid = false;
+                    break;
+                }
+            }
+        }
+        return valid != orphan;
+    });
+    checking = false;
+    writer.join();
+    
+    printResult(id_set ? "用户id集合" : "逐条getUserById", result);
+    std::cout << "  并发资料更新 " << writes.load() << " 次";
+    if (id_set) {
+        // 启用校验后，引用不存在用户的订单写入被拒绝
+        std::uint64_t rejected_before = order_manager.rejectedUserReferences();
+        bool created = order_manager.createOrder(-1, 9.9, "reference_bench");
+        std::cout << ", 孤儿订单写入" << (created ? "未被拒绝" : "已拒绝") << " (拒绝计数 +"
+                  << (order_manager.rejectedUserReferences() - rejected_before) << ")";
+        order_manager.disableUserReferenceChecks();
+    }
+    std::cout << std::endl;
+}
+
+// 跨表事务：账户余额与流水分属两个数据库，对比分文件放置（经协调者日志提交）
+// 与同文件放置（本地提交，流水以外键引用账户）
+void benchmarkPlacement(int thread_count, int operations_per_thread, bool colocated) {
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    std::string suffix = colocated ? "shared" : "split";
+    std::vector<std::string> paths;
+    if (colocated) {
+        paths.push_back("bench_placement_shared.db");
+        paths.push_back("bench_placement_shared.db");
+    } else {
+        paths.push_back("bench_placement_accounts.db");
+        paths.push_back("bench_placement_ledger.db");
+    }
+    for (const auto& path : paths) {
+        for (const char* file_suffix : {"", "-wal", "-shm"}) {
+            std::remove((path + file_suffix).c_str());
+        }
+    }
+    
+    DatabaseSpec accounts;
+    accounts.name = "bench_accounts_" + suffix;
+    accounts.shard_paths.push_back(paths[0]);
+    accounts.schema_sql = "CREATE TABLE IF NOT EXISTS accounts (id INTEGER PRIMARY KEY, balance INTEGER NOT NULL);";
+    accounts.policy.foreign_keys = colocated;
+    
+    DatabaseSpec ledger;
+    ledger.name = "bench_ledger_" + suffix;
+    ledger.shard_paths.push_back(paths[1]);
+    ledger.schema_sql = colocated
+        ? "CREATE TABLE IF NOT EXISTS ledger (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+          "account_id INTEGER NOT NULL REFERENCES accounts(id), amount INTEGER NOT NULL);"
+        : "CREATE TABLE IF NOT EXISTS ledger (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+          "account_id INTEGER NOT NULL, amount INTEGER NOT NULL);";
+    
+    MultiConnectionDatabaseManager::DatabaseId accounts_id = db_manager.registerDatabase(accounts);
+    MultiConnectionDatabaseManager::DatabaseId ledger_id = db_manager.registerDatabase(ledger);
+    sqlite3* accounts_db = db_manager.borrowConnection(accounts_id);
+    sqlite3* ledger_db = db_manager.borrowConnection(ledger_id);
+    
+    const int account_count = 100;
+    sqlite3_stmt* credit = nullptr;
+    sqlite3_stmt* record = nullptr;
+    {
+        std::lock_guard<std::recursive_mutex> lock(db_manager.connectionMutex(accounts_id));
+        sqlite3_exec(accounts_db, "BEGIN;", nullptr, nullptr, nullptr);
+        for (int i = 1; i <= account_count; ++i) {
+            std::string sql = "INSERT INTO accounts (id, balance) VALUES (" + std::to_string(i) + ", 0);";
+            sqlite3_exec(accounts_db, sql.c_str(), nullptr, nullptr, nullptr);
+        }
+        sqlite3_exec(accounts_db, "COMMIT;", nullptr, nullptr, nullptr);
+        sqlite3_prepare_v2(accounts_db, "UPDATE accounts SET balance = balance + ? WHERE id = ?", -1, &credit, nullptr);
+        sqlite3_prepare_v2(ledger_db, "INSERT INTO ledger (account_id, amount) VALUES (?, ?)", -1, &record, nullptr);
+    }
+    
+    std::atomic<std::size_t> files(0);
+    BenchmarkResult result = runThreads(thread_count, operations_per_thread, [&](int, std::mt19937& gen) {
+        int account = static_cast<int>(gen() % account_count) + 1;
+        int amount = static_cast<int>(gen() % 100) + 1;
+        // 语句在事务持有两个连接的互斥量期间使用
+        DistributedTransaction transaction(std::vector<MultiConnectionDatabaseManager::DatabaseId>{accounts_id, ledger_id});
+        files = transaction.fileCount();
+        
+        sqlite3_bind_int(credit, 1, amount);
+        sqlite3_bind_int(credit, 2, account);
+        bool ok = sqlite3_step(credit) == SQLITE_DONE;
+        sqlite3_reset(credit);
+        sqlite3_bind_int(record, 1, account);
+        sqlite3_bind_int(record, 2, amount);
+        ok = ok && sqlite3_step(record) == SQLITE_DONE;
+        sqlite3_reset(record);
+        return ok && transaction.commit() == CommitResult::COMMITTED;
+    });
+    {
+        std::lock_guard<std::recursive_mutex> lock(db_manager.connectionMutex(accounts_id));
+        sqlite3_finalize(credit);
+        sqlite3_finalize(record);
+    }
+    
+    printResult(colocated ? "同文件放置" : "分文件放置", result);
+    std::cout << "  每个事务涉及 " << files.load() << " 个数据库文件" << std::endl;
+}
+
+void printExport(const std::string& name, std::int64_t rows, std::int64_t bytes, long long elapsed_ms) {
+    std::cout << name << ": " << rows << " 行, " << (bytes / 1024) << " KB, 耗时 " << elapsed_ms << " 毫秒";
+    if (elapsed_ms > 0) {
+        std::cout << ", " << (rows * 1000.0 / elapsed_ms) << " 行/秒, "
+                  << (bytes * 1000.0 / elapsed_ms / (1024 * 1024)) << " MB/秒";
+    }
+    std::cout << std::endl;
+}
+
+// 订单导出：对比getAllOrders()后单线程格式化与按rowid区间并行扫描的导出管道
+void benchmarkExport(int thread_count, int rows) {
+    auto& order_manager = MultiConnectionOrderManager::getInstance();
+    static const char* const statuses[] = {"pending", "paid", "shipped", "delivered"};
+    std::vector<std::tuple<int, double, std::string>> orders;
+    for (int i = 0; i < rows; ++i) {
+        orders.push_back(std::make_tuple(i % 1000 + 1, 10.0 + (i % 500) * 0.25, std::string(statuses[i % 4])));
+    }
+    order_manager.importOrders(orders);
+    
+    const std::string csv_path = "bench_orders_export.csv";
+    const std::string columnar_path = "bench_orders_export.col";
+    
+    // 基线：整表读入内存后在一个线程中格式化
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Order> all = order_manager.getAllOrders();
+        std::ofstream out(csv_path, std::ios::binary);
+        out << "id,user_id,total_amount,status,created_at,updated_at\n";
+        char amount[32];
+        for (const auto& order : all) {
+            std::snprintf(amount, sizeof(amount), "%.15g", order.total_amount);
+            out << order.id << ',' << order.user_id << ',' << amount << ',' << order.status << ','
+                << order.created_at << ',' << order.updated_at << '\n';
+        }
+        out.close();
+        long long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        struct stat file_stat;
+        std::int64_t bytes = stat(csv_path.c_str(), &file_stat) == 0 ? file_stat.st_size : 0;
+        printExport("getAllOrders + 单线程CSV", static_cast<std::int64_t>(all.size()), bytes, elapsed_ms);
+    }
+    
+    ExportOptions options;
+    ExportStats stats;
+    for (int threads : {1, thread_count}) {
+        options.threads = threads;
+        if (OrderExporter::exportOrders(csv_path, options, &stats)) {
+            printExport("并行导出CSV (" + std::to_string(threads) + " 线程)", stats.rows, stats.bytes,
+                        stats.elapsed_ms);
+        }
+    }
+    
+    options.format = ExportFormat::COLUMNAR;
+    if (OrderExporter::exportOrders(columnar_path, options, &stats)) {
+        printExport("并行导出列存 (" + std::to_string(thread_count) + " 线程)", stats.rows, stats.bytes,
+                    stats.elapsed_ms);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<Order> decoded;
+        bool ok = OrderExporter::readColumnar(columnar_path, decoded);
+        long long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "  列存解码: " << (ok ? "成功" : "失败") << ", " << decoded.size() << " 行, 耗时 "
+                  << elapsed_ms << " 毫秒" << std::endl;
+    }
+    
+    std::remove(csv_path.c_str());
+    std::remove(columnar_path.c_str());
+}
+
+// 索引构建期间的交互式读写：对比在写入连接上持锁建索引（启动时的方式）与维护工具的专用连接
+void benchmarkIndexBuild(int rows, bool online) {
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    std::string name = online ? "bench_index_online" : "bench_index_blocking";
+    std::string path = name + ".db";
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+        std::remove((path + suffix).c_str());
+    }
+    
+    DatabaseSpec spec;
+    spec.name = name;
+    spec.shard_paths.push_back(path);
+    spec.schema_sql = R"(
+        CREATE TABLE IF NOT EXISTS orders (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            user_id INTEGER NOT NULL,
+            total_amount DECIMAL(10,2) NOT NULL,
+            status TEXT DEFAULT 'pending',
+            created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            updated_at DATETIME DEFAULT CURRENT_TIMESTAMP
+        );
+    )";
+    MultiConnectionDatabaseManager::DatabaseId id = db_manager.registerDatabase(spec);
+    sqlite3* db = db_manager.borrowConnection(id);
+    std::recursive_mutex& mutex = db_manager.connectionMutex(id);
+    AdmissionController& admission = db_manager.admissionController(id);
+    
+    sqlite3_stmt* insert = nullptr;
+    sqlite3_stmt* select = nullptr;
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        sqlite3_prepare_v2(db, "INSERT INTO orders (user_id, total_amount, status) VALUES (?, ?, 'pending')", -1,
+                           &insert, nullptr);
+        sqlite3_prepare_v2(db, "SELECT total_amount FROM orders WHERE id = ?", -1, &select, nullptr);
+        sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+        std::mt19937 gen(7);
+        for (int i = 0; i < rows; ++i) {
+            sqlite3_bind_int(insert, 1, static_cast<int>(gen() % 100000));
+            sqlite3_bind_double(insert, 2, (gen() % 100000) / 100.0);
+            sqlite3_step(insert);
+            sqlite3_reset(insert);
+        }
+        sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+    }
+    
+    // 构建期间持续进行交互式读取与写入，记录读取延迟
+    std::atomic<bool> building(true);
+    std::vector<long long> read_latencies_us;
+    int writes_ok = 0;
+    int writes_failed = 0;
+    std::thread traffic([&]() {
+        std::mt19937 gen(11);
+        while (building) {
+            auto start = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::recursive_mutex> lock(mutex);
+                sqlite3_bind_int(select, 1, static_cast<int>(gen() % rows) + 1);
+                sqlite3_step(select);
+                sqlite3_reset(select);
+            }
+            read_latencies_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count());
+            
+            if (read_latencies_us.size() % 10 == 0) {
+                AdmissionController::ScopedDeadline deadline(std::chrono::milliseconds(200));
+                AdmissionController::Ticket ticket(admission);
+                bool ok = ticket.admitted();
+                if (ok) {
+                    std::lock_guard<std::recursive_mutex> lock(mutex);
+                    sqlite3_bind_int(insert, 1, 1);
+                    sqlite3_bind_double(insert, 2, 1.0);
+                    ok = sqlite3_step(insert) == SQLITE_DONE;
+                    sqlite3_reset(insert);
+                }
+                ok ? ++writes_ok : ++writes_failed;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    
+    const char* index_sql = "CREATE INDEX IF NOT EXISTS idx_bench_user_amount ON orders(user_id, total_amount);";
+    auto start = std::chrono::steady_clock::now();
+    std::vector<IndexBuildResult> built;
+    if (online) {
+        IndexBuildOptions options;
+        built = MaintenanceRunner::buildIndexes(id, index_sql, options);
+    } else {
+        AdmissionController::Ticket ticket(admission, AdmissionPriority::BATCH);
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        sqlite3_exec(db, index_sql, nullptr, nullptr, nullptr);
+    }
+    long long build_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    building = false;
+    traffic.join();
+    {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        sqlite3_finalize(insert);
+        sqlite3_finalize(select);
+    }
+    
+    std::sort(read_latencies_us.begin(), read_latencies_us.end());
+    std::cout << (online ? "专用连接构建" : "写入连接持锁构建") << ": " << rows << " 行, 构建 " << build_ms
+              << " 毫秒, 期间读取 " << read_latencies_us.size() << " 次";
+    if (!read_latencies_us.empty()) {
+        std::cout << " (p99 " << read_latencies_us[read_latencies_us.size() * 99 / 100] << " 微秒, 最大 "
+                  << read_latencies_us.back() << " 微秒)";
+    }
+    std::cout << ", 写入成功 " << writes_ok << " / 超时 " << writes_failed;
+    for (const auto& result : built) {
+        std::cout << ", " << (result.status == IndexBuildStatus::BUILT ? "已构建" : "未完成") << " (尝试 "
+                  << result.attempts << " 次, 最长持有写入准入 " << result.longest_hold_ms << " 毫秒)";
+    }
+    std::cout << std::endl;
+}
+
+// 完整性检查：所有已注册数据库文件上按表拆分的quick_check
+void benchmarkIntegrityCheck(int threads) {
+    IntegrityOptions options;
+    options.threads = threads;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<IntegrityResult> results = MaintenanceRunner::checkIntegrity(options);
+    long long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    
+    std::size_t problems = 0;
+    std::size_t unchecked = 0;
+    long long slowest_ms = 0;
+    for (const auto& result : results) {
+        problems += result.checked && !result.ok ? 1 : 0;
+        unchecked += result.checked ? 0 : 1;
+        slowest_ms = std::max(slowest_ms, result.elapsed_ms);
+    }
+    std::cout << "quick_check (" << threads << " 线程): " << results.size() << " 项, 耗时 " << elapsed_ms
+              << " 毫秒, 最长单项 " << slowest_ms << " 毫秒, 异常 " << problems << " 项, 未检查（内存模式） "
+              << unchecked << " 项" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int thread_count = argc > 1 ? std::atoi(argv[1]) : 4;
+    int operations_per_thread = argc > 2 ? std::atoi(argv[2]) : 200;
+    if (thread_count <= 0 || operations_per_thread <= 0) {
+        std::cerr << "用法: " << argv[0] << " [线程数] [每线程操作数]" << std::endl;
+        return 1;
+    }
+    
+    try {
+        MultiConnectionDatabaseManager::getInstance();
+        
+        // 设置MC_WORKLOAD_CAPTURE时捕获所有管理器调用，供workload_replay重放
+        if (const char* capture_path = std::getenv("MC_WORKLOAD_CAPTURE")) {
+            WorkloadCapture::getInstance().start(capture_path);
+        }
+        
+        std::vector<int> product_ids = prepareProducts(20);
+        if (product_ids.empty()) {
+            std::cerr << "无法准备测试产品" << std::endl;
+            return 1;
+        }
+        
+        std::cout << "\n=== 下单基准测试 ===" << std::endl;
+        std::cout << "线程数: " << thread_count << ", 每线程操作数: " << operations_per_thread << std::endl;
+        benchmarkPerItemCheckout(thread_count, operations_per_thread, product_ids);
+        benchmarkAtomicCheckout(thread_count, operations_per_thread, product_ids);
+        
+        std::cout << "\n=== 热点库存基准测试 ===" << std::endl;
+        benchmarkHotStockUpdates(thread_count, operations_per_thread * 10, product_ids, false);
+        benchmarkHotStockUpdates(thread_count, operations_per_thread * 10, product_ids, true);
+        
+        std::cout << "\n=== 过载准入基准测试 ===" << std::endl;
+        benchmarkOverload(thread_count * 32, operations_per_thread);
+        
+        std::cout << "\n=== 导入期间交互式写入基准测试 ===" << std::endl;
+        benchmarkInteractiveDuringImport(operations_per_thread * 1000, false);
+        benchmarkInteractiveDuringImport(operations_per_thread * 1000, true);
+        
+        std::cout << "\n=== 冷订单存储基准测试 ===" << std::endl;
+        benchmarkColdOrderStorage(operations_per_thread * 1000, false);
+        benchmarkColdOrderStorage(operations_per_thread * 1000, true);
+        
+        std::cout << "\n=== 页面布局与增量清理基准测试 ===" << std::endl;
+        benchmarkPageLayout(operations_per_thread * 1000, 4096, "NONE");
+        benchmarkPageLayout(operations_per_thread * 1000, 4096, "INCREMENTAL");
+        benchmarkPageLayout(operations_per_thread * 1000, 8192, "INCREMENTAL");
+        benchmarkPageLayout(operations_per_thread * 1000, 16384, "INCREMENTAL");
+        
+        std::cout << "\n=== 内存模式写入延迟基准测试 ===" << std::endl;
+        benchmarkWriteLatency(operations_per_thread * 50, false);
+        benchmarkWriteLatency(operations_per_thread * 50, true);
+        
+        std::cout << "\n=== 订单删除延迟基准测试 ===" << std::endl;
+        benchmarkOrderDelete(operations_per_thread * 10, false);
+        benchmarkOrderDelete(operations_per_thread * 10, true);
+        
+        std::cout << "\n=== 有界陈旧读基准测试 ===" << std::endl;
+        benchmarkDashboardReads(thread_count, operations_per_thread * 5, false);
+        benchmarkDashboardReads(thread_count, operations_per_thread * 5, true);
+        
+        std::cout << "\n=== 列表查询结果缓存基准测试 ===" << std::endl;
+        benchmarkListingCache(thread_count, operations_per_thread * 10, product_ids, false);
+        benchmarkListingCache(thread_count, operations_per_thread * 10, product_ids, true);
+        
+        std::cout << "\n=== 用户名可用性检查基准测试 ===" << std::endl;
+        benchmarkNameAvailability(thread_count, operations_per_thread * 50, false);
+        benchmarkNameAvailability(thread_count, operations_per_thread * 50, true);
+        
+        std::cout << "\n=== 用户单行查询基准测试 ===" << std::endl;
+        benchmarkUserLookups(thread_count, operations_per_thread * 50, false);
+        benchmarkUserLookups(thread_count, operations_per_thread * 50, true);
+        
+        std::cout << "\n=== 订单用户引用校验基准测试 ===" << std::endl;
+        benchmarkUserReferenceChecks(thread_count, operations_per_thread * 20, false);
+        benchmarkUserReferenceChecks(thread_count, operations_per_thread * 20, true);
+        
+        std::cout << "\n=== 跨表事务放置基准测试 ===" << std::endl;
+        benchmarkPlacement(thread_count, operations_per_thread * 5, false);
+        benchmarkPlacement(thread_count, operations_per_thread * 5, true);
+        
+        std::cout << "\n=== 无锁读者内存回收基准测试 ===" << std::endl;
+        benchmarkReclamation(thread_count, operations_per_thread * 1000, false);
+        benchmarkReclamation(thread_count, operations_per_thread * 1000, true);
+        
+        std::cout << "\n=== 订单导出基准测试 ===" << std::endl;
+        benchmarkExport(thread_count, operations_per_thread * 1000);
+        
+        std::cout << "\n=== 索引构建与完整性检查基准测试 ===" << std::endl;
+        benchmarkIndexBuild(operations_per_thread * 2000, false);
+        benchmarkIndexBuild(operations_per_thread * 2000, true);
+        benchmarkIntegrityCheck(1);
+        benchmarkIntegrityCheck(thread_count);
+        
+    } catch (const std::exception& e) {
+        std::cerr << "基准测试出错: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
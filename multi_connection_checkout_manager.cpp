@@ -0,0 +1,152 @@
+#include "multi_connection_checkout_manager.h"
+#include "multi_connection_product_manager.h"
+#include "multi_connection_order_manager.h"
+#include "multi_connection_user_manager.h"
+#include "workload_capture.h"
+#include <algorithm>
+#include <limits>
+
+std::once_flag MultiConnectionCheckoutManager::initialized_;
+std::unique_ptr<MultiConnectionCheckoutManager> MultiConnectionCheckoutManager::instance_;
+
+MultiConnectionCheckoutManager& MultiConnectionCheckoutManager::getInstance() {
+    std::call_once(initialized_, []() {
+        instance_ = std::unique_ptr<MultiConnectionCheckoutManager>(new MultiConnectionCheckoutManager());
+    });
+    return *instance_;
+}
+
+MultiConnectionCheckoutManager::MultiConnectionCheckoutManager()
+    : products_connection_(MultiConnectionDatabaseManager::getInstance().borrowConnection(MultiConnectionDatabaseManager::TableType::PRODUCTS)),
+      orders_connection_(MultiConnectionDatabaseManager::getInstance().borrowConnection(MultiConnectionDatabaseManager::TableType::ORDERS)),
+      take_stock_stmt_(nullptr), product_exists_stmt_(nullptr), insert_order_stmt_(nullptr) {
+    prepareStatements();
+}
+
+MultiConnectionCheckoutManager::~MultiConnectionCheckoutManager() {
+    finalizeStatements();
+}
+
+void MultiConnectionCheckoutManager::prepareStatements() {
+    // 条件扣减与读取单价合并为一条语句，库存不足时不返回行
+    const char* take_stock_sql = "UPDATE products SET stock_quantity = stock_quantity - ?, version = version + 1, updated_at = CURRENT_TIMESTAMP "
+                                 "WHERE id = ? AND stock_quantity >= ? RETURNING price";
+    sqlite3_prepare_v2(products_connection_, take_stock_sql, -1, &take_stock_stmt_, nullptr);
+    
+    // 扣减失败时区分产品不存在与库存不足
+    const char* product_exists_sql = "SELECT 1 FROM products WHERE id = ?";
+    sqlite3_prepare_v2(products_connection_, product_exists_sql, -1, &product_exists_stmt_, nullptr);
+    
+    const char* insert_order_sql = "INSERT INTO orders (user_id, total_amount, status) VALUES (?, ?, 'pending')";
+    sqlite3_prepare_v2(orders_connection_, insert_order_sql, -1, &insert_order_stmt_, nullptr);
+}
+
+void MultiConnectionCheckoutManager::finalizeStatements() {
+    if (take_stock_stmt_) sqlite3_finalize(take_stock_stmt_);
+    if (product_exists_stmt_) sqlite3_finalize(product_exists_stmt_);
+    if (insert_order_stmt_) sqlite3_finalize(insert_order_stmt_);
+}
+
+CheckoutResult MultiConnectionCheckoutManager::checkout(int user_id, const std::vector<CheckoutItem>& items, int* order_id) {
+    std::vector<std::pair<int, int>> captured;
+    if (WorkloadCapture::enabled()) {
+        for (const auto& item : items) {
+            captured.push_back(std::make_pair(item.product_id, item.quantity));
+        }
+    }
+    WorkloadCapture::Call capture(WorkloadOp::CHECKOUT, user_id, captured);
+    
+    if (items.empty()) {
+        return CheckoutResult::INVALID_ITEMS;
+    }
+    // 与订单管理器相同的用户引用校验，在锁定任何连接之前进行
+    if (MultiConnectionOrderManager::getInstance().userReferenceChecksEnabled() &&
+        !MultiConnectionUserManager::getInstance().userExists(user_id)) {
+        return CheckoutResult::USER_NOT_FOUND;
+    }
+    
+    // 按产品ID排序并合并重复明细，扣减顺序确定，同一产品只更新一次
+    std::vector<CheckoutItem> lines(items);
+    std::sort(lines.begin(), lines.end(), [](const CheckoutItem& a, const CheckoutItem& b) {
+        return a.product_id < b.product_id;
+    });
+    std::vector<CheckoutItem> merged;
+    for (const auto& line : lines) {
+        if (line.quantity <= 0) {
+            return CheckoutResult::INVALID_ITEMS;
+        }
+        if (!merged.empty() && merged.back().product_id == line.product_id) {
+            if (line.quantity > std::numeric_limits<int>::max() - merged.back().quantity) {
+                return CheckoutResult::INVALID_ITEMS;  // 合并后的数量超出int范围
+            }
+            merged.back().quantity += line.quantity;
+        } else {
+            merged.push_back(line);
+        }
+    }
+    
+    // 锁定产品与订单所在的连接并开始事务，之后的语句均在事务内执行；
+    // 两表同文件放置时只有一个连接，提交即本地提交
+    std::unique_ptr<DistributedTransaction> transaction;
+    try {
+        transaction.reset(new DistributedTransaction({MultiConnectionDatabaseManager::TableType::PRODUCTS,
+                                                      MultiConnectionDatabaseManager::TableType::ORDERS}));
+    } catch (const AdmissionRejected&) {
+        return CheckoutResult::REJECTED;
+    } catch (const std::exception&) {
+        return CheckoutResult::FAILED;
+    }
+    
+    auto& product_manager = MultiConnectionProductManager::getInstance();
+    double total_amount = 0.0;
+    for (const auto& line : merged) {
+        // 库存写合并挂起的扣减量已承诺给其他调用方，不可再分配
+        int reserved = product_manager.reservedStock(line.product_id);
+        
+        sqlite3_reset(take_stock_stmt_);
+        sqlite3_bind_int(take_stock_stmt_, 1, line.quantity);
+        sqlite3_bind_int(take_stock_stmt_, 2, line.product_id);
+        sqlite3_bind_int64(take_stock_stmt_, 3, static_cast<sqlite3_int64>(line.quantity) + reserved);
+        
+        int result = sqlite3_step(take_stock_stmt_);
+        if (result == SQLITE_ROW) {
+            total_amount += sqlite3_column_double(take_stock_stmt_, 0) * line.quantity;
+            // 执行到完成，RETURNING语句的修改在首行返回前已生效
+            result = sqlite3_step(take_stock_stmt_);
+            sqlite3_reset(take_stock_stmt_);
+            if (result != SQLITE_DONE) {
+                return CheckoutResult::FAILED;  // 分布式事务析构时回滚
+            }
+            continue;
+        }
+        sqlite3_reset(take_stock_stmt_);
+        if (result != SQLITE_DONE) {
+            return CheckoutResult::FAILED;
+        }
+        
+        sqlite3_reset(product_exists_stmt_);
+        sqlite3_bind_int(product_exists_stmt_, 1, line.product_id);
+        bool exists = sqlite3_step(product_exists_stmt_) == SQLITE_ROW;
+        sqlite3_reset(product_exists_stmt_);
+        return exists ? CheckoutResult::INSUFFICIENT_STOCK : CheckoutResult::PRODUCT_NOT_FOUND;
+    }
+    
+    sqlite3_reset(insert_order_stmt_);
+    sqlite3_bind_int(insert_order_stmt_, 1, user_id);
+    sqlite3_bind_double(insert_order_stmt_, 2, total_amount);
+    if (sqlite3_step(insert_order_stmt_) != SQLITE_DONE) {
+        sqlite3_reset(insert_order_stmt_);
+        return CheckoutResult::FAILED;
+    }
+    sqlite3_reset(insert_order_stmt_);
+    int new_order_id = static_cast<int>(sqlite3_last_insert_rowid(orders_connection_));
+    
+    CommitResult committed = transaction->commit();
+    if (committed == CommitResult::ABORTED) {
+        return CheckoutResult::FAILED;
+    }
+    if (order_id) {
+        *order_id = new_order_id;
+    }
+    return committed == CommitResult::COMMITTED ? CheckoutResult::SUCCESS : CheckoutResult::IN_DOUBT;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "multi_connection_database_manager.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+
+// 下单明细
+struct CheckoutItem {
+    int product_id;
+    int quantity;
+};
+
+// 下单结果
+enum class CheckoutResult {
+    SUCCESS,
+    INVALID_ITEMS,       // 明细为空、数量不为正或同一产品合计数量超出int范围
+    PRODUCT_NOT_FOUND,
+    USER_NOT_FOUND,      // 启用用户引用校验时，user_id不存在
+    INSUFFICIENT_STOCK,
+    REJECTED,            // 写入未获准入（过载），详见AdmissionController::lastStatus()
+    FAILED,              // SQLite执行错误或提交失败，未产生任何写入
+    // 提交决定已落盘但未能在所有数据库上提交，订单在重启恢复后生效；order_id已返回，
+    // 调用方不得重试，否则重复下单
+    IN_DOUBT
+};
+
+// 下单管理器：在一次分布式事务内校验并扣减所有库存、写入订单
+//
+// 产品库与订单库各只有一个本地事务，参与者按数据库文件路径顺序加锁，
+// 明细按产品ID排序合并后逐行扣减，保证并发下单的加锁顺序一致。
+class MultiConnectionCheckoutManager {
+public:
+    static MultiConnectionCheckoutManager& getInstance();
+    ~MultiConnectionCheckoutManager();
+    
+    // 成功或IN_DOUBT时通过order_id返回新订单ID
+    CheckoutResult checkout(int user_id, const std::vector<CheckoutItem>& items, int* order_id = nullptr);
+    
+private:
+    MultiConnectionCheckoutManager();
+    MultiConnectionCheckoutManager(const MultiConnectionCheckoutManager&) = delete;
+    MultiConnectionCheckoutManager& operator=(const MultiConnectionCheckoutManager&) = delete;
+    
+    void prepareStatements();
+    void finalizeStatements();
+    
+    // 借用的连接句柄，语句在持有对应连接互斥量（由分布式事务获取）时使用
+    sqlite3* products_connection_;
+    sqlite3* orders_connection_;
+    
+    // 预编译的SQL语句
+    sqlite3_stmt* take_stock_stmt_;     // 条件扣减库存并返回单价
+    sqlite3_stmt* product_exists_stmt_;
+    sqlite3_stmt* insert_order_stmt_;
+    
+    static std::once_flag initialized_;
+    static std::unique_ptr<MultiConnectionCheckoutManager> instance_;
+};
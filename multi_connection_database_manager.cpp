@@ -1,8 +1,424 @@
 #include "multi_connection_database_manager.h"
+#include "compressed_vfs.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <map>
+
+namespace {
+
+// 每个分片上的分布式事务水位：记录该分片已提交的最大事务ID。
+// 同一分片上的分布式事务由连接锁串行化，且事务ID在持锁后分配，
+// 因此单调递增，单行水位即可判断某事务是否已在该分片提交。
+const char* kTxnStateSchema = R"(
+    CREATE TABLE IF NOT EXISTS _distributed_txn_state (
+        id INTEGER PRIMARY KEY CHECK (id = 0),
+        last_txid INTEGER NOT NULL
+    );
+)";
+
+const char* kIntentLogPath = "distributed_txn.log";
+
+// 每轮增量清理最多执行的步数，剩余空闲页留到下一轮
+const int kMaxVacuumStepsPerRound = 16;
+
+// 有退役对象尚未回收时，维护线程重试回收的间隔
+const int kReclaimRetryMs = 10;
+
+// hybrid放置下用户与产品共用的文件
+const char* kCorePath = "core_db.db";
+
+// 内置表的文件放置，由环境变量MC_PLACEMENT配置：
+//   未设置或"per_table"  每表一个文件
+//   "hybrid"             用户与产品同放core_db.db，订单独占orders_db.db
+//   "表=文件,..."         逐表指定，如"users=core_db.db,products=core_db.db"，未列出的表使用默认文件
+std::string placedPath(const std::string& table, const std::string& default_path) {
+    const char* placement = std::getenv("MC_PLACEMENT");
+    if (!placement || !*placement || std::string(placement) == "per_table") {
+        return default_path;
+    }
+    std::string config(placement);
+    if (config == "hybrid") {
+        return table == "orders" ? default_path : kCorePath;
+    }
+    
+    std::string path = default_path;
+    std::string::size_type start = 0;
+    while (start <= config.size()) {
+        std::string::size_type end = config.find(',', start);
+        if (end == std::string::npos) {
+            end = config.size();
+        }
+        std::string item = config.substr(start, end - start);
+        std::string::size_type equals = item.find('=');
+        if (equals == std::string::npos || equals == 0 || equals + 1 == item.size()) {
+            throw std::runtime_error("无法解析表放置配置: " + config);
+        }
+        std::string name = item.substr(0, equals);
+        if (name != "users" && name != "orders" && name != "products") {
+            throw std::runtime_error("表放置配置中的未知表: " + name);
+        }
+        if (name == table) {
+            path = item.substr(equals + 1);
+        }
+        start = end + 1;
+    }
+    return path;
+}
+
+// 分片已提交的最大分布式事务ID，尚无记录时为0
+std::uint64_t readWatermark(sqlite3* db) {
+    sqlite3_stmt* stmt = nullptr;
+    std::uint64_t last_txid = 0;
+    sqlite3_prepare_v2(db, "SELECT last_txid FROM _distributed_txn_state WHERE id = 0", -1, &stmt, nullptr);
+    if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+        last_txid = static_cast<std::uint64_t>(sqlite3_column_int64(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    return last_txid;
+}
+
+std::string watermarkSql(std::uint64_t txid) {
+    return "INSERT OR REPLACE INTO _distributed_txn_state (id, last_txid) VALUES (0, " +
+           std::to_string(txid) + ");";
+}
+
+// 更新钩子：递增所属分片的写入代数
+void bumpWriteGeneration(void* context, int, const char*, const char*, sqlite3_int64) {
+    static_cast<std::atomic<std::uint64_t>*>(context)->fetch_add(1, std::memory_order_release);
+}
+
+// 回滚钩子：回滚撤销的行写入不经过更新钩子，同样递增写入代数
+void bumpOnRollback(void* context) {
+    static_cast<std::atomic<std::uint64_t>*>(context)->fetch_add(1, std::memory_order_release);
+}
+
+// 连接所用VFS的名称，重放时需经由同一VFS打开文件（如压缩数据库）
+std::string connectionVfs(sqlite3* db) {
+    sqlite3_vfs* vfs = nullptr;
+    if (db && sqlite3_file_control(db, "main", SQLITE_FCNTL_VFS_POINTER, &vfs) == SQLITE_OK && vfs) {
+        return vfs->zName;
+    }
+    return std::string();
+}
+
+// 恢复连接上递增写入代数的更新钩子
+void restoreUpdateHook(sqlite3* db, std::atomic<std::uint64_t>* generation) {
+    sqlite3_update_hook(db, generation ? &bumpWriteGeneration : nullptr, generation);
+}
+
+std::string quoteName(const std::string& name) {
+    std::string quoted = "\"";
+    for (char c : name) {
+        quoted += c;
+        if (c == '"') {
+            quoted += '"';
+        }
+    }
+    return quoted + "\"";
+}
+
+std::string hexLiteral(const unsigned char* data, int bytes) {
+    static const char kDigits[] = "0123456789abcdef";
+    std::string literal = "X'";
+    for (int i = 0; i < bytes; ++i) {
+        literal += kDigits[data[i] >> 4];
+        literal += kDigits[data[i] & 0x0f];
+    }
+    return literal + "'";
+}
+
+// 把结果列渲染为SQL字面量，重放后的值与存储类型与原值完全相同
+void appendLiteral(std::string& out, sqlite3_stmt* stmt, int column) {
+    switch (sqlite3_column_type(stmt, column)) {
+        case SQLITE_INTEGER:
+            out += std::to_string(sqlite3_column_int64(stmt, column));
+            break;
+        case SQLITE_FLOAT: {
+            // 17位有效数字可精确往返任意双精度值；整数值补小数点以保持REAL类型
+            double value = sqlite3_column_double(stmt, column);
+            if (std::isinf(value)) {
+                out += value > 0 ? "9e999" : "-9e999";
+                break;
+            }
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+            out += buffer;
+            if (!std::strpbrk(buffer, ".e")) {
+                out += ".0";
+            }
+            break;
+        }
+        case SQLITE_TEXT: {
+            const unsigned char* text = sqlite3_column_text(stmt, column);
+            int bytes = sqlite3_column_bytes(stmt, column);
+            if (std::memchr(text, '\0', bytes)) {
+                out += "CAST(" + hexLiteral(text, bytes) + " AS TEXT)";
+                break;
+            }
+            out += '\'';
+            for (int i = 0; i < bytes; ++i) {
+                out += static_cast<char>(text[i]);
+                if (text[i] == '\'') {
+                    out += '\'';
+                }
+            }
+            out += '\'';
+            break;
+        }
+        case SQLITE_BLOB:
+            out += hexLiteral(static_cast<const unsigned char*>(sqlite3_column_blob(stmt, column)),
+                              sqlite3_column_bytes(stmt, column));
+            break;
+        default:
+            out += "NULL";
+            break;
+    }
+}
+
+// 读取被写入行在提交前的内容，生成重做语句：行仍存在时整行INSERT OR REPLACE（含rowid），
+// 已删除时按rowid删除。两种语句都是幂等的，只取决于行的最终内容，
+// 与事务中执行过哪些语句、回滚过哪些保存点无关
+class RowRedoBuilder {
+public:
+    explicit RowRedoBuilder(sqlite3* db) : db_(db) {}
+    
+    ~RowRedoBuilder() {
+        for (auto& table : tables_) {
+            sqlite3_finalize(table.second.select);
+        }
+    }
+    
+    bool append(const std::string& table, sqlite3_int64 rowid, std::vector<std::string>& redo) {
+        auto it = tables_.find(table);
+        if (it == tables_.end()) {
+            TableImage image = {nullptr, std::string(), std::string()};
+            if (!prepare(table, image)) {
+                return false;
+            }
+            it = tables_.insert(std::make_pair(table, image)).first;
+        }
+        TableImage& image = it->second;
+        
+        sqlite3_bind_int64(image.select, 1, rowid);
+        int result = sqlite3_step(image.select);
+        if (result == SQLITE_ROW) {
+            std::string statement = image.insert_prefix + std::to_string(rowid);
+            for (int i = 0; i < sqlite3_column_count(image.select); ++i) {
+                statement += ", ";
+                appendLiteral(statement, image.select, i);
+            }
+            redo.push_back(statement + ");");
+        } else if (result == SQLITE_DONE) {
+            redo.push_back(image.delete_prefix + std::to_string(rowid) + ";");
+        }
+        sqlite3_reset(image.select);
+        return result == SQLITE_ROW || result == SQLITE_DONE;
+    }
+    
+private:
+    RowRedoBuilder(const RowRedoBuilder&) = delete;
+    RowRedoBuilder& operator=(const RowRedoBuilder&) = delete;
+    
+    struct TableImage {
+        sqlite3_stmt* select;
+        std::string insert_prefix;
+        std::string delete_prefix;
+    };
+    
+    // 列清单取自table_xinfo，排除生成列等隐藏列
+    bool prepare(const std::string& table, TableImage& image) {
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(db_, "SELECT name FROM pragma_table_xinfo(?1, 'main') WHERE hidden = 0", -1,
+                               &stmt, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        sqlite3_bind_text(stmt, 1, table.c_str(), -1, SQLITE_TRANSIENT);
+        std::string columns;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            columns += (columns.empty() ? "" : ", ") +
+                       quoteName(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+        }
+        sqlite3_finalize(stmt);
+        if (columns.empty()) {
+            return false;
+        }
+        
+        std::string select_sql = "SELECT " + columns + " FROM main." + quoteName(table) + " WHERE rowid = ?1";
+        if (sqlite3_prepare_v2(db_, select_sql.c_str(), -1, &image.select, nullptr) != SQLITE_OK) {
+            return false;
+        }
+        image.insert_prefix = "INSERT OR REPLACE INTO " + quoteName(table) + " (rowid, " + columns + ") VALUES (";
+        image.delete_prefix = "DELETE FROM " + quoteName(table) + " WHERE rowid = ";
+        return true;
+    }
+    
+    sqlite3* db_;
+    std::map<std::string, TableImage> tables_;
+};
+
+// 在独立连接上重放某参与者的重做语句；已提交（水位不低于txid）时直接返回成功
+bool applyRedo(const std::string& db_path, const std::string& vfs, std::uint64_t txid,
+               const std::vector<std::string>& statements) {
+    // 内存模式数据库以"/路径"为名共享memdb存储
+    std::string name = vfs == "memdb" ? "/" + db_path : db_path;
+    sqlite3* raw_db = nullptr;
+    if (sqlite3_open_v2(name.c_str(), &raw_db, SQLITE_OPEN_READWRITE,
+                        vfs.empty() ? nullptr : vfs.c_str()) != SQLITE_OK) {
+        if (raw_db) {
+            sqlite3_close(raw_db);
+        }
+        return false;
+    }
+    std::unique_ptr<sqlite3, SQLiteDeleter> db(raw_db);
+    sqlite3_busy_timeout(db.get(), 30000);
+    // 行镜像已包含触发器写入的行，重放时不再触发
+    sqlite3_db_config(db.get(), SQLITE_DBCONFIG_ENABLE_TRIGGER, 0, nullptr);
+    
+    if (sqlite3_exec(db.get(), kTxnStateSchema, nullptr, nullptr, nullptr) != SQLITE_OK ||
+        sqlite3_exec(db.get(), "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    
+    if (readWatermark(db.get()) >= txid) {
+        sqlite3_exec(db.get(), "ROLLBACK;", nullptr, nullptr, nullptr);
+        return true;
+    }
+    
+    for (const auto& statement : statements) {
+        if (sqlite3_exec(db.get(), statement.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+            sqlite3_exec(db.get(), "ROLLBACK;", nullptr, nullptr, nullptr);
+            return false;
+        }
+    }
+    
+    if (sqlite3_exec(db.get(), watermarkSql(txid).c_str(), nullptr, nullptr, nullptr) != SQLITE_OK ||
+        sqlite3_exec(db.get(), "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        sqlite3_exec(db.get(), "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    return true;
+}
+
+// 将快照文件恢复到内存数据库；文件不存在时保持为空库
+void restoreSnapshot(sqlite3* memory_db, const std::string& path) {
+    if (::access(path.c_str(), F_OK) != 0) {
+        return;
+    }
+    sqlite3* raw_disk = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &raw_disk, SQLITE_OPEN_READWRITE, nullptr) != SQLITE_OK) {
+        std::string error = "无法打开快照 " + path + ": " + (raw_disk ? sqlite3_errmsg(raw_disk) : "内存不足");
+        sqlite3_close(raw_disk);
+        throw std::runtime_error(error);
+    }
+    // 关闭时会检查点并删除快照文件遗留的WAL，之后整体替换文件不会与旧WAL混用
+    std::unique_ptr<sqlite3, SQLiteDeleter> disk(raw_disk);
+    
+    sqlite3_backup* backup = sqlite3_backup_init(memory_db, "main", disk.get(), "main");
+    int result = backup ? sqlite3_backup_step(backup, -1) : SQLITE_ERROR;
+    sqlite3_backup_finish(backup);
+    if (result != SQLITE_DONE) {
+        throw std::runtime_error("从快照恢复失败 " + path + ": " + sqlite3_errmsg(memory_db));
+    }
+}
+
+// 写入临时文件并fsync后原子替换目标文件，再同步所在目录
+bool replaceFileDurably(const std::string& path, const unsigned char* data, std::size_t size) {
+    std::string temp_path = path + ".snapshot";
+    int fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    std::size_t written = 0;
+    while (written < size) {
+        ssize_t result = ::write(fd, data + written, size - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            return false;
+        }
+        written += static_cast<std::size_t>(result);
+    }
+    bool ok = ::fsync(fd) == 0;
+    ok = ::close(fd) == 0 && ok;
+    ok = ok && std::rename(temp_path.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+    
+    std::string::size_type slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : path.substr(0, slash + 1);
+    int dir_fd = ::open(directory.c_str(), O_RDONLY);
+    if (dir_fd >= 0) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
+
+int pragmaInt(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    int value = -1;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+// auto_vacuum模式名称对应的PRAGMA取值，未知名称返回-1
+int autoVacuumMode(std::string name) {
+    std::transform(name.begin(), name.end(), name.begin(), ::toupper);
+    if (name == "NONE") {
+        return 0;
+    }
+    if (name == "FULL") {
+        return 1;
+    }
+    if (name == "INCREMENTAL") {
+        return 2;
+    }
+    return -1;
+}
+
+bool hasColumn(sqlite3* db, const std::string& table, const std::string& column) {
+    std::string sql = "PRAGMA table_info(" + table + ")";
+    sqlite3_stmt* stmt = nullptr;
+    bool found = false;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            // table_info的第1列为列名
+            const unsigned char* name = sqlite3_column_text(stmt, 1);
+            if (name && column == reinterpret_cast<const char*>(name)) {
+                found = true;
+                break;
+            }
+        }
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+}  // namespace
 
 std::once_flag MultiConnectionDatabaseManager::initialized_;
 std::unique_ptr<MultiConnectionDatabaseManager> MultiConnectionDatabaseManager::instance_;
+bool MultiConnectionDatabaseManager::tool_mode_ = false;
+
+void MultiConnectionDatabaseManager::useToolMode() {
+    tool_mode_ = true;
+}
 
 MultiConnectionDatabaseManager& MultiConnectionDatabaseManager::getInstance() {
     std::call_once(initialized_, []() {
@@ -11,36 +427,159 @@ MultiConnectionDatabaseManager& MultiConnectionDatabaseManager::getInstance() {
     return *instance_;
 }
 
+const std::size_t MultiConnectionDatabaseManager::kTableTypeCount;
+
 MultiConnectionDatabaseManager::MultiConnectionDatabaseManager() 
-    : in_distributed_transaction_(false) {
+    : routing_table_(nullptr), next_txid_(1), vacuumed_pages_(0), maintenance_stop_(false),
+      reclaim_requested_(false) {
     
-    // 为每个表设置独立的数据库文件
-    db_paths_[TableType::USERS] = "users_db.db";
-    db_paths_[TableType::ORDERS] = "orders_db.db";
-    db_paths_[TableType::PRODUCTS] = "products_db.db";
+    // 发布空路由表，之后每次注册整体替换
+    std::unique_ptr<RoutingTable> empty(new RoutingTable());
+    routing_table_.store(empty.get(), std::memory_order_release);
+    routing_tables_.push_back(std::move(empty));
     
-    // 打开所有连接
-    for (const auto& pair : db_paths_) {
-        openConnection(pair.first, pair.second);
+    // 注册I/O统计与压缩VFS，之后打开的连接按策略经由它们访问文件
+    IoStatsVfs::install();
+    CompressedVfs::install();
+    
+    // 按TableType顺序注册内置表，使其取值与数据库ID一致
+    registerDatabase(builtinSpec(TableType::USERS));
+    registerDatabase(builtinSpec(TableType::ORDERS));
+    registerDatabase(builtinSpec(TableType::PRODUCTS));
+    
+    std::cout << "所有数据库表初始化完成" << std::endl;
+    
+    // 协调者日志属于运行中的应用，维护工具既不恢复也不重置它，退役对象在退役时直接回收
+    if (tool_mode_) {
+        return;
     }
     
-    // 初始化所有表
-    initializeAllTables();
+    // 打开协调者日志并完成上次崩溃遗留的跨库事务
+    intent_log_.reset(new TransactionIntentLog(kIntentLogPath));
+    recoverInDoubtTransactions();
+    
+    // 退役对象由维护线程回收。退役发生在持有连接互斥量的写入路径上，而维护线程
+    // 持有maintenance_mutex_时会获取连接互斥量，因此这里只尝试加锁，不能等待；
+    // 未能加锁时维护线程已在运行或即将运行，最迟在下一轮检查待回收对象
+    EpochReclaimer::getInstance().setCollector([this]() {
+        reclaim_requested_.store(true);
+        std::unique_lock<std::mutex> lock(maintenance_mutex_, std::try_to_lock);
+        if (lock.owns_lock()) {
+            startMaintenance();
+        }
+        maintenance_cv_.notify_all();
+    });
 }
 
 MultiConnectionDatabaseManager::~MultiConnectionDatabaseManager() {
+    // 停止快照线程，并在连接关闭前为内存模式数据库写最后一次快照
+    EpochReclaimer::getInstance().setCollector(nullptr);
+    {
+        std::lock_guard<std::mutex> lock(maintenance_mutex_);
+        maintenance_stop_ = true;
+    }
+    maintenance_cv_.notify_all();
+    if (maintenance_thread_.joinable()) {
+        maintenance_thread_.join();
+    }
+    std::lock_guard<std::mutex> lock(maintenance_mutex_);
+    for (auto& shard : memory_shards_) {
+        snapshotShard(shard, true);
+    }
     // shared_ptr会自动处理数据库连接的关闭
 }
 
-void MultiConnectionDatabaseManager::openConnection(TableType table, const std::string& db_path) {
+DatabaseSpec MultiConnectionDatabaseManager::builtinSpec(TableType table) {
+    DatabaseSpec spec;
+    
+    switch (table) {
+        case TableType::USERS:
+            spec.name = "users";
+            spec.shard_paths.push_back(placedPath(spec.name, "users_db.db"));
+            spec.schema_sql = R"(
+                CREATE TABLE IF NOT EXISTS users (
+                    id INTEGER PRIMARY KEY AUTOINCREMENT,
+                    username TEXT UNIQUE NOT NULL,
+                    email TEXT UNIQUE NOT NULL,
+                    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+                    updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+                    version INTEGER NOT NULL DEFAULT 0
+                );
+                CREATE INDEX IF NOT EXISTS idx_users_username ON users(username);
+                CREATE INDEX IF NOT EXISTS idx_users_email ON users(email);
+            )";
+            spec.added_columns.push_back({"users", "version", "INTEGER NOT NULL DEFAULT 0"});
+            break;
+            
+        case TableType::ORDERS:
+            spec.name = "orders";
+            spec.shard_paths.push_back(placedPath(spec.name, "orders_db.db"));
+            spec.schema_sql = R"(
+                CREATE TABLE IF NOT EXISTS orders (
+                    id INTEGER PRIMARY KEY AUTOINCREMENT,
+                    user_id INTEGER NOT NULL,
+                    total_amount DECIMAL(10,2) NOT NULL,
+                    status TEXT DEFAULT 'pending',
+                    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+                    updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+                    deleted INTEGER NOT NULL DEFAULT 0
+                );
+                CREATE INDEX IF NOT EXISTS idx_orders_user_id ON orders(user_id);
+                CREATE INDEX IF NOT EXISTS idx_orders_status ON orders(status);
+            )";
+            spec.added_columns.push_back({"orders", "deleted", "INTEGER NOT NULL DEFAULT 0"});
+            // 墓碑的部分索引：置删除标记只写入这一个小索引，后台清理按它定位待删除的行
+            spec.index_sql = "CREATE INDEX IF NOT EXISTS idx_orders_tombstones ON orders(id) WHERE deleted = 1;";
+            break;
+            
+        case TableType::PRODUCTS:
+            spec.name = "products";
+            spec.shard_paths.push_back(placedPath(spec.name, "products_db.db"));
+            spec.schema_sql = R"(
+                CREATE TABLE IF NOT EXISTS products (
+                    id INTEGER PRIMARY KEY AUTOINCREMENT,
+                    name TEXT NOT NULL,
+                    description TEXT,
+                    price DECIMAL(10,2) NOT NULL,
+                    stock_quantity INTEGER DEFAULT 0,
+                    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+                    updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+                    version INTEGER NOT NULL DEFAULT 0
+                );
+                CREATE INDEX IF NOT EXISTS idx_products_name ON products(name);
+                CREATE INDEX IF NOT EXISTS idx_products_price ON products(price);
+            )";
+            spec.added_columns.push_back({"products", "version", "INTEGER NOT NULL DEFAULT 0"});
+            break;
+    }
+    
+    // 删除产生的空闲页由后台增量清理归还；订单表以扫描为主，使用较大的页
+    spec.policy.auto_vacuum = "INCREMENTAL";
+    if (table == TableType::ORDERS) {
+        spec.policy.page_size = 8192;
+    }
+    
+    // MC_IN_MEMORY=1时内置数据库以内存模式运行，用于测试与预发环境
+    const char* in_memory = std::getenv("MC_IN_MEMORY");
+    spec.policy.in_memory = in_memory && std::string(in_memory) == "1";
+    
+    return spec;
+}
+
+std::shared_ptr<sqlite3> MultiConnectionDatabaseManager::openConnection(const std::string& db_path,
+                                                                        const ConnectionPolicy& policy) {
     sqlite3* raw_db = nullptr;
     
+    // 内存模式使用memdb VFS，以"/路径"命名使同一进程内的连接共享数据
+    std::string name = policy.in_memory ? "/" + db_path : db_path;
+    const char* vfs = policy.in_memory ? "memdb" : (policy.vfs.empty() ? nullptr : policy.vfs.c_str());
+    
     // 使用NOMUTEX模式获得最佳性能
     int result = sqlite3_open_v2(
-        db_path.c_str(),
+        name.c_str(),
         &raw_db,
         SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX,
-        nullptr
+        vfs
     );
     
     if (result != SQLITE_OK) {
@@ -52,28 +591,65 @@ void MultiConnectionDatabaseManager::openConnection(TableType table, const std::
         throw std::runtime_error(error_msg);
     }
     
-    // 配置数据库
-    configureConnection(raw_db);
+    // 使用shared_ptr管理数据库连接，配置失败时也能正确关闭
+    std::shared_ptr<sqlite3> connection(raw_db, SQLiteDeleter());
+    
+    // 内存模式：先从快照恢复；memdb不支持WAL，持久性由快照提供，无需同步
+    if (policy.in_memory) {
+        restoreSnapshot(raw_db, db_path);
+        ConnectionPolicy memory_policy = policy;
+        memory_policy.journal_mode = "MEMORY";
+        memory_policy.synchronous = "OFF";
+        configureConnection(raw_db, memory_policy);
+        std::cout << "已打开内存数据库: " << db_path << std::endl;
+        return connection;
+    }
     
-    // 使用shared_ptr管理数据库连接
-    connections_[table] = std::shared_ptr<sqlite3>(raw_db, SQLiteDeleter());
+    // 配置数据库
+    configureConnection(raw_db, policy);
     
     std::cout << "已打开数据库连接: " << db_path << std::endl;
+    return connection;
 }
 
-void MultiConnectionDatabaseManager::configureConnection(sqlite3* db) {
+void MultiConnectionDatabaseManager::configureConnection(sqlite3* db, const ConnectionPolicy& policy) {
     char* error_msg = nullptr;
     
-    // 启用WAL模式以提高并发性能
-    int result = sqlite3_exec(db, "PRAGMA journal_mode=WAL;", nullptr, nullptr, &error_msg);
+    // 页大小与自动清理须在建表及切换WAL之前设置，对已有文件不生效
+    int auto_vacuum = autoVacuumMode(policy.auto_vacuum);
+    if (auto_vacuum < 0) {
+        throw std::runtime_error("未知的auto_vacuum模式: " + policy.auto_vacuum);
+    }
+    // 先设页大小：设置auto_vacuum会读取文件头并固定页大小
+    std::string layout_sql;
+    if (policy.page_size > 0) {
+        layout_sql += "PRAGMA page_size=" + std::to_string(policy.page_size) + ";";
+    }
+    layout_sql += "PRAGMA auto_vacuum=" + std::to_string(auto_vacuum) + ";";
+    int result = sqlite3_exec(db, layout_sql.c_str(), nullptr, nullptr, &error_msg);
     if (result != SQLITE_OK) {
-        std::string error = "设置WAL模式失败: " + std::string(error_msg);
+        std::string error = "设置页面布局失败: " + std::string(error_msg);
         sqlite3_free(error_msg);
         throw std::runtime_error(error);
     }
+    if (pragmaInt(db, "PRAGMA auto_vacuum") != auto_vacuum ||
+        (policy.page_size > 0 && pragmaInt(db, "PRAGMA page_size") != policy.page_size)) {
+        std::cout << "提示: " << sqlite3_db_filename(db, "main")
+                  << " 的页大小或auto_vacuum与策略不一致，可用db_rebuild转换" << std::endl;
+    }
     
-    // 设置同步模式为NORMAL以平衡性能和安全性
-    result = sqlite3_exec(db, "PRAGMA synchronous=NORMAL;", nullptr, nullptr, &error_msg);
+    // 设置日志模式（默认WAL以提高并发性能）
+    std::string journal_sql = "PRAGMA journal_mode=" + policy.journal_mode + ";";
+    result = sqlite3_exec(db, journal_sql.c_str(), nullptr, nullptr, &error_msg);
+    if (result != SQLITE_OK) {
+        std::string error = "设置日志模式失败: " + std::string(error_msg);
+        sqlite3_free(error_msg);
+        throw std::runtime_error(error);
+    }
+    
+    // 设置同步模式（默认NORMAL以平衡性能和安全性）
+    std::string synchronous_sql = "PRAGMA synchronous=" + policy.synchronous + ";";
+    result = sqlite3_exec(db, synchronous_sql.c_str(), nullptr, nullptr, &error_msg);
     if (result != SQLITE_OK) {
         std::string error = "设置同步模式失败: " + std::string(error_msg);
         sqlite3_free(error_msg);
@@ -81,7 +657,8 @@ void MultiConnectionDatabaseManager::configureConnection(sqlite3* db) {
     }
     
     // 设置缓存大小
-    result = sqlite3_exec(db, "PRAGMA cache_size=5000;", nullptr, nullptr, &error_msg);
+    std::string cache_sql = "PRAGMA cache_size=" + std::to_string(policy.cache_size) + ";";
+    result = sqlite3_exec(db, cache_sql.c_str(), nullptr, nullptr, &error_msg);
     if (result != SQLITE_OK) {
         std::string error = "设置缓存大小失败: " + std::string(error_msg);
         sqlite3_free(error_msg);
@@ -96,156 +673,592 @@ void MultiConnectionDatabaseManager::configureConnection(sqlite3* db) {
         throw std::runtime_error(error);
     }
     
+    if (policy.foreign_keys) {
+        result = sqlite3_exec(db, "PRAGMA foreign_keys=ON;", nullptr, nullptr, &error_msg);
+        if (result != SQLITE_OK) {
+            std::string error = "启用外键约束失败: " + std::string(error_msg);
+            sqlite3_free(error_msg);
+            throw std::runtime_error(error);
+        }
+    }
+    
     // 设置忙等待超时
-    sqlite3_busy_timeout(db, 30000); // 30秒
+    sqlite3_busy_timeout(db, policy.busy_timeout_ms);
+}
+
+MultiConnectionDatabaseManager::DatabaseId MultiConnectionDatabaseManager::registerDatabase(const DatabaseSpec& spec) {
+    if (spec.name.empty() || spec.shard_paths.empty()) {
+        throw std::runtime_error("数据库声明缺少名称或文件路径");
+    }
+    
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    
+    const RoutingTable& current = routes();
+    for (const auto& entry : current.entries) {
+        if (entry.name == spec.name) {
+            throw std::runtime_error("数据库已注册: " + spec.name);
+        }
+    }
+    
+    // 打开并初始化所有分片，全部成功后才发布
+    RouteEntry entry;
+    entry.name = spec.name;
+    entry.schema_sql = spec.schema_sql;
+    entry.added_columns = spec.added_columns;
+    entry.index_sql = spec.index_sql;
+    entry.deferred_index_sql = spec.deferred_index_sql;
+    
+    std::vector<OwnedShard> owned;
+    std::vector<bool> opened;  // 本次新打开的分片，已有分片的维护任务已经登记
+    for (std::size_t i = 0; i < spec.shard_paths.size(); ++i) {
+        const std::string& path = spec.shard_paths[i];
+        if (std::find(spec.shard_paths.begin(), spec.shard_paths.begin() + i, path) != spec.shard_paths.begin() + i) {
+            throw std::runtime_error("数据库声明中的分片路径重复: " + path);
+        }
+        
+        OwnedShard shard;
+        const OwnedShard* existing = findOwnedShard(path);
+        if (existing) {
+            // 同文件放置：共用已打开的分片，在其上补建本数据库的表
+            if ((connectionVfs(existing->connection.get()) == "memdb") != spec.policy.in_memory) {
+                throw std::runtime_error("同一文件上的数据库内存模式不一致: " + path);
+            }
+            shard = *existing;
+            std::lock_guard<std::recursive_mutex> shard_lock(*shard.mutex);
+            initializeShard(shard.connection.get(), spec.schema_sql, spec.added_columns, spec.index_sql);
+            std::cout << "已共用数据库连接: " << path << " (" << spec.name << ")" << std::endl;
+        } else {
+            shard.connection = openConnection(path, spec.policy);
+            shard.mutex = std::make_shared<std::recursive_mutex>();
+            shard.admission = std::make_shared<AdmissionController>(
+                spec.policy.max_queued_writers, std::chrono::milliseconds(spec.policy.write_deadline_ms));
+            initializeShard(shard.connection.get(), spec.schema_sql, spec.added_columns, spec.index_sql);
+            
+            // 建表与迁移完成后才挂接更新钩子，此后连接上的每次行写入都递增写入代数
+            shard.generation = std::make_shared<std::atomic<std::uint64_t>>(0);
+            sqlite3_update_hook(shard.connection.get(), &bumpWriteGeneration, shard.generation.get());
+            sqlite3_rollback_hook(shard.connection.get(), &bumpOnRollback, shard.generation.get());
+        }
+        opened.push_back(!existing);
+        
+        ShardRoute route = {shard.connection.get(), shard.mutex.get(), shard.admission.get(), path,
+                            shard.generation.get()};
+        entry.shards.push_back(route);
+        owned.push_back(std::move(shard));
+    }
+    
+    // 写时复制：构造新路由表后原子替换
+    std::unique_ptr<RoutingTable> table(new RoutingTable(current));
+    table->entries.push_back(entry);
+    DatabaseId id = table->entries.size() - 1;
+    
+    connections_.push_back(std::move(owned));
+    // release语义保证读者看到完整初始化的路由表
+    routing_table_.store(table.get(), std::memory_order_release);
+    routing_tables_.push_back(std::move(table));
+    
+    // 登记后台维护任务；维护工具模式下不登记，也不为内存模式数据库写快照
+    if (tool_mode_) {
+        return id;
+    }
+    std::lock_guard<std::mutex> maintenance_lock(maintenance_mutex_);
+    for (std::size_t i = 0; i < entry.shards.size(); ++i) {
+        const ShardRoute& shard = entry.shards[i];
+        if (!opened[i]) {
+            continue;
+        }
+        if (spec.policy.in_memory) {
+            MemoryShard memory_shard = {shard.path, shard.connection, shard.mutex,
+                                        std::chrono::milliseconds(spec.policy.snapshot_interval_ms),
+                                        std::chrono::steady_clock::now(), -1};
+            memory_shard.next_due += memory_shard.interval;
+            memory_shards_.push_back(memory_shard);
+            if (spec.policy.snapshot_interval_ms > 0) {
+                startMaintenance();
+            }
+        }
+        // 只有文件实际处于INCREMENTAL模式时增量清理才有效
+        if (spec.policy.vacuum_interval_ms > 0 && pragmaInt(shard.connection, "PRAGMA auto_vacuum") == 2) {
+            VacuumShard vacuum_shard = {shard.connection, shard.mutex, shard.admission,
+                                        std::chrono::milliseconds(spec.policy.vacuum_interval_ms),
+                                        std::chrono::steady_clock::now(), spec.policy.vacuum_step_pages};
+            vacuum_shard.next_due += vacuum_shard.interval;
+            vacuum_shards_.push_back(vacuum_shard);
+            startMaintenance();
+        }
+    }
+    
+    return id;
+}
+
+const MultiConnectionDatabaseManager::OwnedShard* MultiConnectionDatabaseManager::findOwnedShard(
+    const std::string& path) const {
+    // connections_与路由表条目按数据库ID、分片下标一一对应
+    const RoutingTable& table = routes();
+    for (std::size_t id = 0; id < table.entries.size(); ++id) {
+        for (std::size_t shard = 0; shard < table.entries[id].shards.size(); ++shard) {
+            if (table.entries[id].shards[shard].path == path) {
+                return &connections_[id][shard];
+            }
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<sqlite3> MultiConnectionDatabaseManager::openSideConnection(DatabaseId id, std::size_t shard,
+                                                                           bool read_only) {
+    const ShardRoute& route = shardRoute(id, shard);
+    std::string vfs = connectionVfs(route.connection);
+    if (vfs == "memdb") {
+        throw std::runtime_error("内存模式数据库不支持独立连接: " + route.path);
+    }
+    
+    // 经由写入连接相同的VFS打开，页组压缩等文件格式才能被正确读取
+    sqlite3* raw_db = nullptr;
+    int result = sqlite3_open_v2(route.path.c_str(), &raw_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX,
+                                 vfs.empty() ? nullptr : vfs.c_str());
+    std::shared_ptr<sqlite3> connection(raw_db, SQLiteDeleter());
+    if (result != SQLITE_OK || (read_only &&
+        sqlite3_exec(raw_db, "PRAGMA query_only=1;", nullptr, nullptr, nullptr) != SQLITE_OK)) {
+        throw std::runtime_error("无法打开独立连接 " + route.path + ": " +
+                                 (raw_db ? sqlite3_errmsg(raw_db) : "内存不足"));
+    }
+    sqlite3_busy_timeout(raw_db, 30000);
+    return connection;
+}
+
+std::shared_ptr<sqlite3> MultiConnectionDatabaseManager::openReaderConnection(DatabaseId id, std::size_t shard) {
+    return openSideConnection(id, shard, true);
+}
+
+std::shared_ptr<sqlite3> MultiConnectionDatabaseManager::openMaintenanceConnection(DatabaseId id, std::size_t shard) {
+    return openSideConnection(id, shard, false);
+}
+
+const std::string& MultiConnectionDatabaseManager::deferredIndexSql(DatabaseId id) const {
+    return routeEntry(id).deferred_index_sql;
+}
+
+const std::string& MultiConnectionDatabaseManager::databaseName(DatabaseId id) const {
+    return routeEntry(id).name;
+}
+
+std::shared_ptr<SnapshotReader> MultiConnectionDatabaseManager::openSnapshotReader(DatabaseId id,
+                                                                                   std::chrono::milliseconds max_staleness,
+                                                                                   std::size_t shard) {
+    std::shared_ptr<sqlite3> connection = openReaderConnection(id, shard);
+    std::shared_ptr<SnapshotReader> reader(new SnapshotReader(connection, max_staleness));
+    std::lock_guard<std::mutex> lock(maintenance_mutex_);
+    snapshot_readers_.push_back(reader);
+    startMaintenance();
+    maintenance_cv_.notify_all();
+    return reader;
+}
+
+std::shared_ptr<SnapshotReader> MultiConnectionDatabaseManager::openSnapshotReader(TableType table,
+                                                                                   std::chrono::milliseconds max_staleness) {
+    return openSnapshotReader(static_cast<DatabaseId>(table), max_staleness);
+}
+
+std::uint64_t MultiConnectionDatabaseManager::vacuumedPages() const {
+    return vacuumed_pages_.load();
+}
+
+std::size_t MultiConnectionDatabaseManager::snapshotInMemoryDatabases() {
+    std::lock_guard<std::mutex> lock(maintenance_mutex_);
+    std::size_t written = 0;
+    for (auto& shard : memory_shards_) {
+        if (snapshotShard(shard, false)) {
+            ++written;
+        }
+    }
+    return written;
+}
+
+bool MultiConnectionDatabaseManager::snapshotShard(MemoryShard& shard, bool force) {
+    sqlite3_int64 size = 0;
+    unsigned char* image = nullptr;
+    int changes = 0;
+    {
+        // 在连接锁内复制数据库镜像：写入事务均在持锁期间完成，复制结果总是已提交状态
+        std::lock_guard<std::recursive_mutex> lock(*shard.mutex);
+        changes = sqlite3_total_changes(shard.connection);
+        if (!force && changes == shard.saved_changes) {
+            return false;
+        }
+        image = sqlite3_serialize(shard.connection, "main", &size, 0);
+    }
+    if (!image) {
+        return false;
+    }
+    
+    // 写盘在锁外进行，不阻塞读写
+    bool ok = replaceFileDurably(shard.path, image, static_cast<std::size_t>(size));
+    sqlite3_free(image);
+    if (ok) {
+        shard.saved_changes = changes;
+    } else {
+        std::cerr << "写入内存数据库快照失败: " << shard.path << std::endl;
+    }
+    return ok;
+}
+
+void MultiConnectionDatabaseManager::vacuumShard(VacuumShard& shard) {
+    std::string step_sql = "PRAGMA incremental_vacuum(" + std::to_string(shard.step_pages) + ");";
+    
+    // 每步是一个批量写入：交互式写入可在步与步之间插队，排队过久则留到下一轮
+    for (int step = 0; step < kMaxVacuumStepsPerRound; ++step) {
+        AdmissionController::ScopedDeadline deadline(std::chrono::milliseconds(100));
+        AdmissionController::Ticket ticket(*shard.admission, AdmissionPriority::BATCH);
+        if (!ticket.admitted()) {
+            return;
+        }
+        
+        std::lock_guard<std::recursive_mutex> lock(*shard.mutex);
+        int before = pragmaInt(shard.connection, "PRAGMA freelist_count");
+        if (before <= 0 || sqlite3_exec(shard.connection, step_sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+            return;
+        }
+        int after = pragmaInt(shard.connection, "PRAGMA freelist_count");
+        if (after >= 0 && after < before) {
+            vacuumed_pages_ += static_cast<std::uint64_t>(before - after);
+        }
+        if (after <= 0) {
+            return;
+        }
+    }
+}
+
+void MultiConnectionDatabaseManager::startMaintenance() {
+    if (!maintenance_thread_.joinable()) {
+        maintenance_thread_ = std::thread(&MultiConnectionDatabaseManager::maintenanceLoop, this);
+    }
+}
+
+void MultiConnectionDatabaseManager::maintenanceLoop() {
+    std::unique_lock<std::mutex> lock(maintenance_mutex_);
+    while (!maintenance_stop_) {
+        // 等到最早到期的任务
+        auto now = std::chrono::steady_clock::now();
+        auto wake = now + std::chrono::seconds(1);
+        for (const auto& shard : memory_shards_) {
+            if (shard.interval.count() > 0) {
+                wake = std::min(wake, shard.next_due);
+            }
+        }
+        for (const auto& shard : vacuum_shards_) {
+            wake = std::min(wake, shard.next_due);
+        }
+        for (const auto& weak_reader : snapshot_readers_) {
+            if (auto reader = weak_reader.lock()) {
+                wake = std::min(wake, now + reader->maxStaleness());
+            }
+        }
+        // 仍有读者未离开时纪元无法推进，稍后重试
+        if (EpochReclaimer::getInstance().pending() > 0) {
+            wake = std::min(wake, now + std::chrono::milliseconds(kReclaimRetryMs));
+        }
+        if (maintenance_cv_.wait_until(lock, wake, [this]() {
+                return maintenance_stop_ || reclaim_requested_.load();
+            }) && maintenance_stop_) {
+            break;
+        }
+        reclaim_requested_.store(false);
+        
+        now = std::chrono::steady_clock::now();
+        for (auto& shard : vacuum_shards_) {
+            if (shard.next_due <= now) {
+                vacuumShard(shard);
+                shard.next_due = std::chrono::steady_clock::now() + shard.interval;
+            }
+        }
+        for (auto& shard : memory_shards_) {
+            if (shard.interval.count() > 0 && shard.next_due <= now) {
+                snapshotShard(shard, false);
+                shard.next_due = std::chrono::steady_clock::now() + shard.interval;
+            }
+        }
+        // 结束空闲读者的过期读事务，并移除已释放的读者
+        for (auto it = snapshot_readers_.begin(); it != snapshot_readers_.end();) {
+            if (auto reader = it->lock()) {
+                reader->expireIfStale();
+                ++it;
+            } else {
+                it = snapshot_readers_.erase(it);
+            }
+        }
+        EpochReclaimer::getInstance().collect();
+    }
+}
+
+const MultiConnectionDatabaseManager::RoutingTable& MultiConnectionDatabaseManager::routes() const {
+    return *routing_table_.load(std::memory_order_acquire);
+}
+
+const MultiConnectionDatabaseManager::RouteEntry& MultiConnectionDatabaseManager::routeEntry(DatabaseId id) const {
+    const RoutingTable& table = routes();
+    if (id >= table.entries.size()) {
+        throw std::runtime_error("未找到指定的数据库: " + std::to_string(id));
+    }
+    return table.entries[id];
+}
+
+MultiConnectionDatabaseManager::DatabaseId MultiConnectionDatabaseManager::findDatabase(const std::string& name) const {
+    const RoutingTable& table = routes();
+    for (std::size_t i = 0; i < table.entries.size(); ++i) {
+        if (table.entries[i].name == name) {
+            return i;
+        }
+    }
+    throw std::runtime_error("未找到指定的数据库: " + name);
+}
+
+bool MultiConnectionDatabaseManager::hasDatabase(const std::string& name) const {
+    const RoutingTable& table = routes();
+    for (const auto& entry : table.entries) {
+        if (entry.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const MultiConnectionDatabaseManager::ShardRoute& MultiConnectionDatabaseManager::shardRoute(DatabaseId id,
+                                                                                             std::size_t shard) const {
+    const RouteEntry& entry = routeEntry(id);
+    if (shard >= entry.shards.size()) {
+        throw std::runtime_error("分片下标越界: " + entry.name);
+    }
+    return entry.shards[shard];
+}
+
+sqlite3* MultiConnectionDatabaseManager::borrowConnection(DatabaseId id, std::size_t shard) const {
+    return shardRoute(id, shard).connection;
+}
+
+sqlite3* MultiConnectionDatabaseManager::borrowConnection(TableType table) const {
+    return borrowConnection(static_cast<DatabaseId>(table));
+}
+
+std::recursive_mutex& MultiConnectionDatabaseManager::connectionMutex(DatabaseId id, std::size_t shard) const {
+    return *shardRoute(id, shard).mutex;
+}
+
+std::recursive_mutex& MultiConnectionDatabaseManager::connectionMutex(TableType table) const {
+    return connectionMutex(static_cast<DatabaseId>(table));
+}
+
+AdmissionController& MultiConnectionDatabaseManager::admissionController(DatabaseId id, std::size_t shard) const {
+    return *shardRoute(id, shard).admission;
+}
+
+AdmissionController& MultiConnectionDatabaseManager::admissionController(TableType table) const {
+    return admissionController(static_cast<DatabaseId>(table));
+}
+
+std::uint64_t MultiConnectionDatabaseManager::writeGeneration(DatabaseId id, std::size_t shard) const {
+    return shardRoute(id, shard).generation->load(std::memory_order_acquire);
+}
+
+std::uint64_t MultiConnectionDatabaseManager::writeGeneration(TableType table) const {
+    return writeGeneration(static_cast<DatabaseId>(table));
+}
+
+std::vector<IoFileStats> MultiConnectionDatabaseManager::ioStatistics() const {
+    return IoStatsVfs::snapshot();
+}
+
+const std::string& MultiConnectionDatabaseManager::shardPath(DatabaseId id, std::size_t shard) const {
+    return shardRoute(id, shard).path;
+}
+
+std::size_t MultiConnectionDatabaseManager::shardCount(DatabaseId id) const {
+    return routeEntry(id).shards.size();
+}
+
+std::size_t MultiConnectionDatabaseManager::shardFor(DatabaseId id, std::int64_t key) const {
+    std::size_t count = shardCount(id);
+    std::uint64_t hashed = static_cast<std::uint64_t>(key);
+    return static_cast<std::size_t>(hashed % count);
+}
+
+std::size_t MultiConnectionDatabaseManager::databaseCount() const {
+    return routes().entries.size();
 }
 
 std::shared_ptr<sqlite3> MultiConnectionDatabaseManager::getConnection(TableType table) {
     std::lock_guard<std::mutex> lock(connections_mutex_);
-    auto it = connections_.find(table);
-    if (it != connections_.end()) {
-        return it->second;
+    std::size_t index = static_cast<std::size_t>(table);
+    if (index < connections_.size() && !connections_[index].empty()) {
+        return connections_[index][0].connection;
     }
     throw std::runtime_error("未找到指定表的数据库连接");
 }
 
 void MultiConnectionDatabaseManager::initializeAllTables() {
-    initializeTable(TableType::USERS);
-    initializeTable(TableType::ORDERS);
-    initializeTable(TableType::PRODUCTS);
+    const RoutingTable& table = routes();
+    for (const auto& entry : table.entries) {
+        for (const auto& shard : entry.shards) {
+            initializeShard(shard.connection, entry.schema_sql, entry.added_columns, entry.index_sql);
+        }
+    }
     std::cout << "所有数据库表初始化完成" << std::endl;
 }
 
-void MultiConnectionDatabaseManager::initializeTable(TableType table) {
-    auto db = getConnection(table).get();
-    char* error_msg = nullptr;
-    const char* create_sql = nullptr;
+void MultiConnectionDatabaseManager::initializeShard(sqlite3* db, const std::string& schema_sql,
+                                                     const std::vector<ColumnMigration>& added_columns,
+                                                     const std::string& index_sql) {
+    // 每个分片都需要分布式事务水位表
+    std::string sql = schema_sql + kTxnStateSchema;
     
-    switch (table) {
-        case TableType::USERS:
-            create_sql = R"(
-                CREATE TABLE IF NOT EXISTS users (
-                    id INTEGER PRIMARY KEY AUTOINCREMENT,
-                    username TEXT UNIQUE NOT NULL,
-                    email TEXT UNIQUE NOT NULL,
-                    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-                    updated_at DATETIME DEFAULT CURRENT_TIMESTAMP
-                );
-                CREATE INDEX IF NOT EXISTS idx_users_username ON users(username);
-                CREATE INDEX IF NOT EXISTS idx_users_email ON users(email);
-            )";
-            break;
-            
-        case TableType::ORDERS:
-            create_sql = R"(
-                CREATE TABLE IF NOT EXISTS orders (
-                    id INTEGER PRIMARY KEY AUTOINCREMENT,
-                    user_id INTEGER NOT NULL,
-                    total_amount DECIMAL(10,2) NOT NULL,
-                    status TEXT DEFAULT 'pending',
-                    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-                    updated_at DATETIME DEFAULT CURRENT_TIMESTAMP
-                );
-                CREATE INDEX IF NOT EXISTS idx_orders_user_id ON orders(user_id);
-                CREATE INDEX IF NOT EXISTS idx_orders_status ON orders(status);
-            )";
-            break;
-            
-        case TableType::PRODUCTS:
-            create_sql = R"(
-                CREATE TABLE IF NOT EXISTS products (
-                    id INTEGER PRIMARY KEY AUTOINCREMENT,
-                    name TEXT NOT NULL,
-                    description TEXT,
-                    price DECIMAL(10,2) NOT NULL,
-                    stock_quantity INTEGER DEFAULT 0,
-                    created_at DATETIME DEFAULT CURRENT_TIMESTAMP,
-                    updated_at DATETIME DEFAULT CURRENT_TIMESTAMP
-                );
-                CREATE INDEX IF NOT EXISTS idx_products_name ON products(name);
-                CREATE INDEX IF NOT EXISTS idx_products_price ON products(price);
-            )";
-            break;
-    }
-    
-    int result = sqlite3_exec(db, create_sql, nullptr, nullptr, &error_msg);
+    char* error_msg = nullptr;
+    int result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error_msg);
     if (result != SQLITE_OK) {
         std::string error = "创建表失败: " + std::string(error_msg);
         sqlite3_free(error_msg);
         throw std::runtime_error(error);
     }
-}
-
-bool MultiConnectionDatabaseManager::beginDistributedTransaction() {
-    std::lock_guard<std::mutex> lock(transaction_mutex_);
     
-    if (in_distributed_transaction_) {
-        return false; // 已经在事务中
+    for (const auto& migration : added_columns) {
+        if (!hasColumn(db, migration.table, migration.column)) {
+            std::string alter_sql = "ALTER TABLE " + migration.table + " ADD COLUMN " +
+                                    migration.column + " " + migration.definition;
+            result = sqlite3_exec(db, alter_sql.c_str(), nullptr, nullptr, &error_msg);
+            if (result != SQLITE_OK) {
+                std::string error = "添加列失败: " + std::string(error_msg);
+                sqlite3_free(error_msg);
+                throw std::runtime_error(error);
+            }
+            std::cout << "已为表 " << migration.table << " 添加列: " << migration.column << std::endl;
+        }
     }
     
-    // 在所有连接上开始事务
-    for (const auto& pair : connections_) {
-        char* error_msg = nullptr;
-        int result = sqlite3_exec(pair.second.get(), "BEGIN IMMEDIATE;", nullptr, nullptr, &error_msg);
+    if (!index_sql.empty()) {
+        result = sqlite3_exec(db, index_sql.c_str(), nullptr, nullptr, &error_msg);
         if (result != SQLITE_OK) {
-            // 回滚已经开始的事务
-            rollbackDistributedTransaction();
+            std::string error = "创建索引失败: " + std::string(error_msg);
             sqlite3_free(error_msg);
-            return false;
+            throw std::runtime_error(error);
         }
     }
     
-    in_distributed_transaction_ = true;
-    return true;
+    // 分布式事务经由更新钩子捕获写入的行，WITHOUT ROWID表与虚拟表的写入不触发该钩子
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db, "SELECT name FROM pragma_table_list WHERE schema = 'main' AND "
+                           "(wr = 1 OR type IN ('virtual', 'shadow')) LIMIT 1", -1, &stmt, nullptr);
+    std::string unsupported;
+    if (stmt && sqlite3_step(stmt) == SQLITE_ROW) {
+        unsupported = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    if (!unsupported.empty()) {
+        throw std::runtime_error("分布式事务不支持WITHOUT ROWID表或虚拟表: " + unsupported);
+    }
+    
+    // 事务ID须高于所有分片的水位：协调者日志丢失或被重建后若从1重新分配，重放时
+    // 水位检查会把新事务当作已提交而跳过其重做
+    std::uint64_t next = readWatermark(db) + 1;
+    std::uint64_t current = next_txid_.load();
+    while (current < next && !next_txid_.compare_exchange_weak(current, next)) {
+    }
 }
 
-bool MultiConnectionDatabaseManager::commitDistributedTransaction() {
-    std::lock_guard<std::mutex> lock(transaction_mutex_);
-    
-    if (!in_distributed_transaction_) {
-        return false;
+TransactionIntentLog& MultiConnectionDatabaseManager::intentLog() {
+    if (!intent_log_) {
+        throw std::runtime_error("维护工具模式下不支持分布式事务");
     }
-    
-    // 在所有连接上提交事务
-    for (const auto& pair : connections_) {
-        char* error_msg = nullptr;
-        int result = sqlite3_exec(pair.second.get(), "COMMIT;", nullptr, nullptr, &error_msg);
-        if (result != SQLITE_OK) {
-            // 如果提交失败，回滚所有事务
-            rollbackDistributedTransaction();
-            sqlite3_free(error_msg);
-            return false;
+    return *intent_log_;
+}
+
+std::uint64_t MultiConnectionDatabaseManager::nextTransactionId() {
+    return next_txid_.fetch_add(1);
+}
+
+std::string MultiConnectionDatabaseManager::vfsForPath(const std::string& path) const {
+    for (const auto& entry : routes().entries) {
+        for (const auto& shard : entry.shards) {
+            if (shard.path == path) {
+                return connectionVfs(shard.connection);
+            }
         }
     }
-    
-    in_distributed_transaction_ = false;
-    return true;
+    return std::string();
 }
 
-bool MultiConnectionDatabaseManager::rollbackDistributedTransaction() {
-    std::lock_guard<std::mutex> lock(transaction_mutex_);
+void MultiConnectionDatabaseManager::recoverInDoubtTransactions() {
+    std::uint64_t max_txid = 0;
+    auto transactions = intent_log_->recover(max_txid);
     
-    if (!in_distributed_transaction_) {
-        return false;
-    }
+    std::vector<TransactionIntentLog::RecoveredTransaction> unresolved;
+    int completed = 0;
+    int aborted = 0;
     
-    // 在所有连接上回滚事务
-    for (const auto& pair : connections_) {
-        sqlite3_exec(pair.second.get(), "ROLLBACK;", nullptr, nullptr, nullptr);
+    for (const auto& transaction : transactions) {
+        if (transaction.ended) {
+            continue;
+        }
+        
+        // 推定回滚：提交决定未落盘时没有任何参与者开始提交，SQLite已自行回滚
+        if (!transaction.committed) {
+            ++aborted;
+            continue;
+        }
+        
+        // 已决定提交：在尚未提交的参与者上重放重做语句
+        TransactionIntentLog::RecoveredTransaction remaining = transaction;
+        remaining.participants.clear();
+        for (const auto& prepare : transaction.participants) {
+            if (!applyRedo(prepare.db_path, vfsForPath(prepare.db_path), transaction.txid,
+                           prepare.redo_statements)) {
+                remaining.participants.push_back(prepare);
+            }
+        }
+        
+        if (remaining.participants.empty()) {
+            ++completed;
+        } else {
+            std::cerr << "分布式事务 " << transaction.txid << " 恢复失败，保留至下次启动" << std::endl;
+            unresolved.push_back(remaining);
+        }
     }
     
-    in_distributed_transaction_ = false;
-    return true;
+    // 注册各分片时已按其水位抬高next_txid_，取两者中较大者
+    std::uint64_t next_txid = std::max<std::uint64_t>(max_txid + 1, next_txid_.load());
+    next_txid_.store(next_txid);
+    intent_log_->reset(next_txid, unresolved);
+    
+    if (completed > 0 || aborted > 0) {
+        std::cout << "分布式事务恢复完成: 补齐提交 " << completed << " 个, 回滚 " << aborted << " 个" << std::endl;
+    }
 }
 
 // 分布式事务RAII管理器实现
 DistributedTransaction::DistributedTransaction() 
     : db_manager_(MultiConnectionDatabaseManager::getInstance()),
-      committed_(false), rolled_back_(false) {
+      txid_(0), committed_(false), rolled_back_(false) {
+    
+    std::vector<DatabaseId> databases;
+    for (std::size_t id = 0; id < db_manager_.databaseCount(); ++id) {
+        databases.push_back(id);
+    }
+    begin(databases);
+}
+
+DistributedTransaction::DistributedTransaction(const std::vector<TableType>& tables)
+    : db_manager_(MultiConnectionDatabaseManager::getInstance()),
+      txid_(0), committed_(false), rolled_back_(false) {
     
-    if (!db_manager_.beginDistributedTransaction()) {
-        throw std::runtime_error("无法开始分布式事务");
+    std::vector<DatabaseId> databases;
+    for (TableType table : tables) {
+        databases.push_back(static_cast<DatabaseId>(table));
     }
+    begin(databases);
+}
+
+DistributedTransaction::DistributedTransaction(const std::vector<DatabaseId>& databases)
+    : db_manager_(MultiConnectionDatabaseManager::getInstance()),
+      txid_(0), committed_(false), rolled_back_(false) {
+    begin(databases);
 }
 
 DistributedTransaction::~DistributedTransaction() {
@@ -254,18 +1267,222 @@ DistributedTransaction::~DistributedTransaction() {
     }
 }
 
-bool DistributedTransaction::commit() {
+void DistributedTransaction::begin(const std::vector<DatabaseId>& databases) {
+    // 没有协调者日志（维护工具模式）时在加锁之前即抛出
+    db_manager_.intentLog();
+    
+    std::vector<DatabaseId> sorted = databases;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+    
+    // 同文件放置的数据库共用连接，只作为一个参与者，否则会在同一连接上重复开始事务
+    for (DatabaseId id : sorted) {
+        for (std::size_t shard = 0; shard < db_manager_.shardCount(id); ++shard) {
+            sqlite3* db = db_manager_.borrowConnection(id, shard);
+            if (std::any_of(participants_.begin(), participants_.end(),
+                            [db](const Participant& other) { return other.db == db; })) {
+                continue;
+            }
+            Participant participant;
+            participant.database = id;
+            participant.shard = shard;
+            participant.db = db;
+            participant.generation = nullptr;
+            participant.mutex = &db_manager_.connectionMutex(id, shard);
+            participant.path = db_manager_.shardPath(id, shard);
+            participants_.push_back(participant);
+        }
+    }
+    // 按连接（文件路径）而非数据库ID排序后再取准入和加锁：混合放置时同一连接可能先被
+    // 不同的数据库收集到，按数据库ID的顺序在各事务之间并不一致，会造成锁顺序反转而死锁
+    std::sort(participants_.begin(), participants_.end(), [](const Participant& a, const Participant& b) {
+        return a.path != b.path ? a.path < b.path : std::less<sqlite3*>()(a.db, b.db);
+    });
+    
+    // 先获得全部准入再加锁：准入等待有截止时间，连接锁等待则没有
+    for (auto& participant : participants_) {
+        std::unique_ptr<AdmissionController::Ticket> ticket(
+            new AdmissionController::Ticket(db_manager_.admissionController(participant.database, participant.shard)));
+        if (!ticket->admitted()) {
+            AdmissionStatus status = ticket->status();
+            admissions_.clear();
+            participants_.clear();
+            throw AdmissionRejected("分布式事务未获准入: " + participant.path, status);
+        }
+        admissions_.push_back(std::move(ticket));
+    }
+    
+    for (auto& participant : participants_) {
+        participant.mutex->lock();
+    }
+    
+    // 持有所有参与者的锁之后分配事务ID，保证同一分片上的事务ID单调递增
+    txid_ = db_manager_.nextTransactionId();
+    
+    for (std::size_t i = 0; i < participants_.size(); ++i) {
+        Participant& participant = participants_[i];
+        int result = sqlite3_exec(participant.db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr);
+        if (result != SQLITE_OK) {
+            // 回滚已经开始的事务
+            for (std::size_t j = 0; j < i; ++j) {
+                restoreUpdateHook(participants_[j].db, participants_[j].generation);
+                sqlite3_exec(participants_[j].db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            }
+            release();
+            throw std::runtime_error("无法开始分布式事务");
+        }
+        
+        // 记录本事务写入的行，提交时生成协调者日志中的重做记录；原钩子的参数是写入代数
+        participant.generation = static_cast<std::atomic<std::uint64_t>*>(
+            sqlite3_update_hook(participant.db, &DistributedTransaction::captureRow, &participant));
+    }
+}
+
+void DistributedTransaction::captureRow(void* context, int, const char* database, const char* table,
+                                        sqlite3_int64 rowid) {
+    Participant* participant = static_cast<Participant*>(context);
+    if (participant->generation) {
+        participant->generation->fetch_add(1, std::memory_order_release);
+    }
+    // 临时表不落盘，无需重做
+    if (std::strcmp(database, "main") == 0) {
+        participant->changed_rows.insert(std::make_pair(std::string(table), rowid));
+    }
+}
+
+void DistributedTransaction::stopCapture() {
+    for (auto& participant : participants_) {
+        restoreUpdateHook(participant.db, participant.generation);
+    }
+}
+
+void DistributedTransaction::release() {
+    for (auto it = participants_.rbegin(); it != participants_.rend(); ++it) {
+        it->mutex->unlock();
+    }
+    participants_.clear();
+    while (!admissions_.empty()) {
+        admissions_.pop_back();
+    }
+}
+
+CommitResult DistributedTransaction::commit() {
     if (committed_ || rolled_back_) {
-        return false;
+        return CommitResult::ABORTED;
+    }
+    
+    stopCapture();
+    
+    std::size_t writers = 0;
+    for (const auto& participant : participants_) {
+        if (!participant.changed_rows.empty()) {
+            ++writers;
+        }
+    }
+    
+    // 单个写入参与者时本地提交即原子，无需协调者日志
+    if (writers <= 1) {
+        for (auto& participant : participants_) {
+            if (sqlite3_exec(participant.db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+                // 此时尚未有写入参与者提交成功，回滚所有事务
+                for (auto& other : participants_) {
+                    sqlite3_exec(other.db, "ROLLBACK;", nullptr, nullptr, nullptr);
+                }
+                rolled_back_ = true;
+                release();
+                return CommitResult::ABORTED;
+            }
+        }
+        committed_ = true;
+        release();
+        return CommitResult::COMMITTED;
+    }
+    
+    // 事务尚未提交，读取各写入行的最终内容作为重做语句；读取失败时无法保证可恢复，放弃提交
+    for (auto& participant : participants_) {
+        RowRedoBuilder builder(participant.db);
+        for (const auto& row : participant.changed_rows) {
+            if (!builder.append(row.first, row.second, participant.redo_statements)) {
+                std::cerr << "无法生成重做记录: " << participant.path << " (" << row.first << "): "
+                          << sqlite3_errmsg(participant.db) << std::endl;
+                rollback();
+                return CommitResult::ABORTED;
+            }
+        }
     }
     
-    committed_ = db_manager_.commitDistributedTransaction();
-    return committed_;
+    // 只读参与者不影响提交决定，先结束其事务并归还连接锁与准入，不必等待协调者日志落盘。
+    // 写入参与者的连接上事务仍未提交，其他线程无法使用这些连接，锁须持有到本地提交之后
+    for (std::size_t i = participants_.size(); i-- > 0;) {
+        if (participants_[i].changed_rows.empty()) {
+            if (sqlite3_exec(participants_[i].db, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+                sqlite3_exec(participants_[i].db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            }
+            participants_[i].mutex->unlock();
+            participants_.erase(participants_.begin() + i);
+            admissions_.erase(admissions_.begin() + i);
+        }
+    }
+    
+    // 准备记录与提交决定一起组提交，多个并发事务共享同一次fsync
+    TransactionIntentLog& log = db_manager_.intentLog();
+    for (const auto& participant : participants_) {
+        if (!participant.redo_statements.empty()) {
+            TransactionIntentLog::Prepare prepare;
+            prepare.db_path = participant.path;
+            prepare.redo_statements = participant.redo_statements;
+            log.appendPrepare(txid_, prepare);
+        }
+    }
+    try {
+        log.sync(log.appendDecision(txid_, true));
+    } catch (const std::exception& e) {
+        // 日志已截断回最后落盘的长度，本事务的提交决定不会在恢复时出现，可以回滚
+        std::cerr << "协调者日志写入失败: " << e.what() << std::endl;
+        rollback();
+        return CommitResult::ABORTED;
+    }
+    
+    // 提交决定已持久化，逐个提交；失败的参与者立即用重做语句补齐
+    bool all_committed = true;
+    for (auto& participant : participants_) {
+        bool writer = !participant.redo_statements.empty();
+        bool ok = !writer || sqlite3_exec(participant.db, watermarkSql(txid_).c_str(), nullptr, nullptr, nullptr) == SQLITE_OK;
+        ok = ok && sqlite3_exec(participant.db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK;
+        if (!ok) {
+            sqlite3_exec(participant.db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            if (writer && !applyRedo(participant.path, connectionVfs(participant.db), txid_,
+                                     participant.redo_statements)) {
+                all_committed = false;
+            }
+            // 重放在独立连接上写入，不触发本连接的钩子，需手动使缓存结果失效
+            if (writer && participant.generation) {
+                participant.generation->fetch_add(1, std::memory_order_release);
+            }
+        }
+    }
+    
+    // END记录无需立即落盘，丢失时恢复流程会发现各参与者均已提交
+    if (all_committed) {
+        log.appendEnd(txid_);
+    } else {
+        std::cerr << "分布式事务 " << txid_ << " 未能在所有参与者上提交，将在下次启动时恢复" << std::endl;
+    }
+    
+    // 未能补齐时其余参与者已经提交，事务不是回滚而是悬而未决
+    committed_ = true;
+    release();
+    return all_committed ? CommitResult::COMMITTED : CommitResult::IN_DOUBT;
 }
 
 void DistributedTransaction::rollback() {
     if (!committed_ && !rolled_back_) {
         rolled_back_ = true;
-        db_manager_.rollbackDistributedTransaction();
+        stopCapture();
+        // 推定回滚：提交决定之前的回滚无需写入协调者日志
+        for (auto& participant : participants_) {
+            sqlite3_exec(participant.db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        }
+        release();
     }
 }
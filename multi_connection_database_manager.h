@@ -1,29 +1,176 @@
 #pragma once
 
+#include "admission_controller.h"
+#include "epoch_reclaimer.h"
+#include "io_stats_vfs.h"
+#include "snapshot_reader.h"
+#include "sqlite_deleter.h"
+#include "transaction_intent_log.h"
 #include <sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 #include <stdexcept>
-#include <unordered_map>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 连接策略：每个数据库的PRAGMA与打开参数
+struct ConnectionPolicy {
+    ConnectionPolicy()
+        : journal_mode("WAL"), synchronous("NORMAL"),
+          cache_size(5000), busy_timeout_ms(30000),
+          max_queued_writers(64), write_deadline_ms(5000),
+          vfs(IoStatsVfs::kVfsName), in_memory(false), snapshot_interval_ms(1000),
+          page_size(0), auto_vacuum("NONE"), vacuum_interval_ms(1000), vacuum_step_pages(64),
+          foreign_keys(false) {}
+    
+    std::string journal_mode;
+    std::string synchronous;
+    int cache_size;
+    int busy_timeout_ms;
+    
+    // 写入准入：等待队列上限与默认排队截止时间
+    std::size_t max_queued_writers;
+    int write_deadline_ms;
+    
+    // 打开连接使用的VFS，默认为I/O统计VFS；为空时使用SQLite默认VFS。
+    // 设为CompressedVfs::kVfsName即对该数据库启用页组压缩（仅限新建的文件）
+    std::string vfs;
+    
+    // 内存模式：数据库完全驻留内存（memdb VFS，同名连接共享同一份数据），
+    // 启动时从分片路径上的快照文件恢复，按间隔及关闭时写回。间隔内的写入
+    // 在进程崩溃时丢失，只适用于可容忍该窗口的测试环境与缓存层
+    bool in_memory;
+    int snapshot_interval_ms;  // 0表示只在关闭时快照
+    
+    // 页大小与自动清理模式只在新建文件时生效，已有文件需用db_rebuild转换
+    int page_size;             // 0表示SQLite默认值
+    std::string auto_vacuum;   // NONE、FULL或INCREMENTAL
+    
+    // INCREMENTAL模式的后台清理：检查间隔与每步回收的页数，每步为一个批量写入
+    int vacuum_interval_ms;
+    int vacuum_step_pages;
+    
+    // 外键约束检查；外键只能引用同一文件中的表，即同文件放置的数据库之间
+    bool foreign_keys;
+};
+
+// 新增列：CREATE TABLE IF NOT EXISTS不会修改已存在的表，旧文件需通过ALTER补齐
+struct ColumnMigration {
+    std::string table;
+    std::string column;
+    std::string definition;  // 列定义，如 "INTEGER NOT NULL DEFAULT 0"
+};
+
+// 数据库声明：一个逻辑表对应一个或多个物理文件（分片）
+//
+// 分片路径与已注册数据库的分片相同时，两者放置在同一文件上，共用该分片的连接、
+// 互斥量、准入控制器与写入代数，连接策略以先注册者为准。同文件的表之间可以声明
+// 外键，跨这些表的事务是一次本地提交。
+struct DatabaseSpec {
+    std::string name;                      // 逻辑名称，如 "orders"
+    std::vector<std::string> shard_paths;  // 物理文件路径，至少一个
+    std::string schema_sql;                // 在每个分片上执行的建表SQL
+    std::vector<ColumnMigration> added_columns;  // 建表后检查并补齐的列
+    std::string index_sql;                 // 补齐列之后执行的建索引SQL，可引用新增列
+    // 延后构建的索引：启动时不执行，由MaintenanceRunner在专用连接上构建，
+    // 已有大文件上新增索引不会阻塞启动与该文件上的全部读写
+    std::string deferred_index_sql;
+    ConnectionPolicy policy;
+};
+
+// 乐观并发更新结果
+enum class UpdateResult {
+    UPDATED,    // 版本匹配，已写入
+    CONFLICT,   // 记录存在但版本已变化
+    NOT_FOUND,  // 记录不存在
+    REJECTED,   // 写入未获准入（过载），详见AdmissionController::lastStatus()
+    FAILED      // SQLite执行错误
+};
 
 // 多连接数据库管理器
 class MultiConnectionDatabaseManager {
 public:
+    // 内置表，其取值即为注册表中的数据库ID
     enum class TableType {
         USERS,
         ORDERS,
         PRODUCTS
     };
+    static const std::size_t kTableTypeCount = 3;
+    
+    typedef std::size_t DatabaseId;
     
     static MultiConnectionDatabaseManager& getInstance();
+    // 维护工具模式，须在首次getInstance()之前调用：只注册数据库、打开连接，不恢复也不
+    // 重置协调者日志，不登记后台维护任务，不支持分布式事务。供与应用同时运行的维护工具
+    // 使用，避免其改写运行中应用的协调者日志
+    static void useToolMode();
     std::shared_ptr<sqlite3> getConnection(TableType table);
+    // 借用连接：通过不可变路由表查找，无锁、无引用计数开销，供热路径使用
+    sqlite3* borrowConnection(TableType table) const;
+    // 连接互斥量：NOMUTEX连接的所有使用者（管理器、分布式事务）共享同一把递归锁
+    std::recursive_mutex& connectionMutex(TableType table) const;
+    // 写入准入控制器：写入者先获得准入再获取连接互斥量
+    AdmissionController& admissionController(TableType table) const;
     void initializeAllTables();
+    // 写入代数：该连接上每修改一行递增一次（更新钩子，在写入者持有连接互斥量时触发）。
+    // 代数不变即说明该表自上次读取后未被写入，供查询结果缓存判断失效，无锁读取。
+    // 同文件放置的表共用一个代数，任一表的写入都会使其他表的缓存失效（保守但正确）
+    std::uint64_t writeGeneration(TableType table) const;
+    
+    // 运行时注册数据库，返回其ID；名称重复时抛出异常
+    DatabaseId registerDatabase(const DatabaseSpec& spec);
+    DatabaseId findDatabase(const std::string& name) const;
+    bool hasDatabase(const std::string& name) const;
+    sqlite3* borrowConnection(DatabaseId id, std::size_t shard = 0) const;
+    std::recursive_mutex& connectionMutex(DatabaseId id, std::size_t shard = 0) const;
+    AdmissionController& admissionController(DatabaseId id, std::size_t shard = 0) const;
+    std::uint64_t writeGeneration(DatabaseId id, std::size_t shard = 0) const;
+    
+    // 立即为所有内存模式数据库写快照（跳过自上次快照后未修改的），返回写入数量。
+    // 调用方不得持有任何连接互斥量
+    std::size_t snapshotInMemoryDatabases();
+    
+    // 为分片打开有界陈旧读的快照读者（独立连接，只读），由后台维护线程在空闲时
+    // 结束过期的读事务。内存模式数据库不支持（memdb没有WAL，长读事务会阻塞写入），
+    // 打开失败时抛出异常
+    std::shared_ptr<SnapshotReader> openSnapshotReader(DatabaseId id, std::chrono::milliseconds max_staleness,
+                                                       std::size_t shard = 0);
+    std::shared_ptr<SnapshotReader> openSnapshotReader(TableType table, std::chrono::milliseconds max_staleness);
+    
+    // 为分片打开独立的只读连接（经由与写入连接相同的VFS），供导出、检查等批量读取
+    // 在写入连接之外并行扫描；调用方自行管理其读事务。内存模式数据库不支持，
+    // 打开失败时抛出异常
+    std::shared_ptr<sqlite3> openReaderConnection(DatabaseId id, std::size_t shard = 0);
+    // 为分片打开独立的可写连接，供索引构建等长时间的维护写入在连接互斥量之外执行，
+    // 期间经由写入连接的读取不受影响。调用方须在写入前获得该分片的写入准入
+    std::shared_ptr<sqlite3> openMaintenanceConnection(DatabaseId id, std::size_t shard = 0);
+    // 数据库声明中延后构建的索引SQL
+    const std::string& deferredIndexSql(DatabaseId id) const;
+    const std::string& databaseName(DatabaseId id) const;
     
-    // 跨表事务支持
-    bool beginDistributedTransaction();
-    bool commitDistributedTransaction();
-    bool rollbackDistributedTransaction();
+    // 后台增量清理累计回收的页数
+    std::uint64_t vacuumedPages() const;
+    
+    // 各数据库文件（主库、WAL、共享内存、日志）的I/O统计
+    std::vector<IoFileStats> ioStatistics() const;
+    const std::string& shardPath(DatabaseId id, std::size_t shard = 0) const;
+    std::size_t shardCount(DatabaseId id) const;
+    // 按键值选择分片（取模路由）
+    std::size_t shardFor(DatabaseId id, std::int64_t key) const;
+    std::size_t databaseCount() const;
+    
+    // 跨库事务支持：协调者日志与事务ID分配；维护工具模式下intentLog()抛出异常
+    TransactionIntentLog& intentLog();
+    std::uint64_t nextTransactionId();
     
     ~MultiConnectionDatabaseManager();
     
@@ -32,42 +179,179 @@ private:
     MultiConnectionDatabaseManager(const MultiConnectionDatabaseManager&) = delete;
     MultiConnectionDatabaseManager& operator=(const MultiConnectionDatabaseManager&) = delete;
     
-    void openConnection(TableType table, const std::string& db_path);
-    void configureConnection(sqlite3* db);
-    void initializeTable(TableType table);
+    static DatabaseSpec builtinSpec(TableType table);
+    
+    std::shared_ptr<sqlite3> openConnection(const std::string& db_path, const ConnectionPolicy& policy);
+    void configureConnection(sqlite3* db, const ConnectionPolicy& policy);
+    void initializeShard(sqlite3* db, const std::string& schema_sql,
+                         const std::vector<ColumnMigration>& added_columns, const std::string& index_sql);
+    void recoverInDoubtTransactions();
+    std::string vfsForPath(const std::string& path) const;
+    std::shared_ptr<sqlite3> openSideConnection(DatabaseId id, std::size_t shard, bool read_only);
     
-    std::unordered_map<TableType, std::shared_ptr<sqlite3>> connections_;
-    std::unordered_map<TableType, std::string> db_paths_;
-    std::mutex connections_mutex_;
+    // 内存模式分片的快照状态
+    struct MemoryShard {
+        std::string path;
+        sqlite3* connection;
+        std::recursive_mutex* mutex;
+        std::chrono::milliseconds interval;
+        std::chrono::steady_clock::time_point next_due;
+        int saved_changes;  // 上次快照时连接的累计修改行数
+    };
+    
+    // INCREMENTAL模式分片的后台清理状态
+    struct VacuumShard {
+        sqlite3* connection;
+        std::recursive_mutex* mutex;
+        AdmissionController* admission;
+        std::chrono::milliseconds interval;
+        std::chrono::steady_clock::time_point next_due;
+        int step_pages;
+    };
     
-    // 分布式事务状态
-    std::mutex transaction_mutex_;
-    bool in_distributed_transaction_;
+    bool snapshotShard(MemoryShard& shard, bool force);
+    void vacuumShard(VacuumShard& shard);
+    void startMaintenance();
+    void maintenanceLoop();
+    
+    // 分片路由：借用的连接句柄及其互斥量、准入控制器
+    struct ShardRoute {
+        sqlite3* connection;
+        std::recursive_mutex* mutex;
+        AdmissionController* admission;
+        std::string path;
+        std::atomic<std::uint64_t>* generation;
+    };
+    
+    // 路由表条目：一个已注册的数据库及其全部分片
+    struct RouteEntry {
+        std::string name;
+        std::string schema_sql;
+        std::vector<ColumnMigration> added_columns;
+        std::string index_sql;
+        std::string deferred_index_sql;
+        std::vector<ShardRoute> shards;
+    };
+    
+    // 分片所有权：同文件放置的数据库共同持有同一分片
+    struct OwnedShard {
+        // 写入代数先于连接声明：连接关闭之前更新钩子的上下文始终有效
+        std::shared_ptr<std::atomic<std::uint64_t>> generation;
+        std::shared_ptr<sqlite3> connection;
+        std::shared_ptr<std::recursive_mutex> mutex;
+        std::shared_ptr<AdmissionController> admission;
+    };
+    
+    // 不可变路由表：以数据库ID为下标，发布后只读，注册时整体复制替换
+    struct RoutingTable {
+        std::vector<RouteEntry> entries;
+    };
+    
+    const RoutingTable& routes() const;
+    const RouteEntry& routeEntry(DatabaseId id) const;
+    const ShardRoute& shardRoute(DatabaseId id, std::size_t shard) const;
+    // 已打开的同路径分片，用于同文件放置；调用方持有connections_mutex_
+    const OwnedShard* findOwnedShard(const std::string& path) const;
+    
+    // 连接所有权（冷路径，受connections_mutex_保护），按数据库ID、分片下标索引
+    std::vector<std::vector<OwnedShard>> connections_;
+    mutable std::mutex connections_mutex_;
+    
+    // 热路径路由：原子发布的路由表指针
+    // 旧路由表可能仍被无锁读者持有，因此保留至管理器析构
+    std::vector<std::unique_ptr<RoutingTable>> routing_tables_;
+    std::atomic<const RoutingTable*> routing_table_;
+    
+    // 分布式事务协调者日志
+    std::unique_ptr<TransactionIntentLog> intent_log_;
+    std::atomic<std::uint64_t> next_txid_;
+    
+    // 后台维护：内存模式快照、增量清理、快照读者过期与EpochReclaimer退役对象的回收
+    // （maintenance_mutex_保护任务列表并串行化执行）
+    std::vector<MemoryShard> memory_shards_;
+    std::vector<VacuumShard> vacuum_shards_;
+    std::vector<std::weak_ptr<SnapshotReader>> snapshot_readers_;
+    std::atomic<std::uint64_t> vacuumed_pages_;
+    std::mutex maintenance_mutex_;
+    std::condition_variable maintenance_cv_;
+    bool maintenance_stop_;
+    std::atomic<bool> reclaim_requested_;
+    std::thread maintenance_thread_;
     
     static std::once_flag initialized_;
     static std::unique_ptr<MultiConnectionDatabaseManager> instance_;
+    static bool tool_mode_;
 };
 
-// 自定义删除器用于sqlite3指针
-struct SQLiteDeleter {
-    void operator()(sqlite3* db) {
-        if (db) {
-            sqlite3_close_v2(db);
-        }
-    }
+// 分布式事务RAII管理器
+//
+// 构造时按连接的文件路径顺序获得所有参与者的写入准入（被拒绝时抛出
+// AdmissionRejected），再锁定所有参与者连接并开始事务，期间其他线程
+// 对这些连接的访问将被阻塞；事务必须在创建它的线程上提交或回滚。
+// 参与者按连接去重：同文件放置的多个表只是一个参与者。
+// 提交时若有多个参与者发生写入，先将各参与者的重做语句与提交决定组提交到
+// 协调者日志，再逐个提交；进程中途崩溃时由启动时的恢复流程补齐。未写入的
+// 参与者在日志同步之前即结束事务并解锁。
+// 重做语句是被写入行在提交时的完整内容（行镜像），值按存储类型精确渲染；
+// 更新钩子不覆盖WITHOUT ROWID表与虚拟表，注册数据库时拒绝这两类表。
+// 分布式事务提交结果
+enum class CommitResult {
+    COMMITTED,
+    ABORTED,   // 已回滚，没有参与者提交（已提交或已回滚的事务再次提交时也返回此值）
+    // 提交决定已落盘，但有参与者未能提交且补齐失败：重启后的恢复流程会完成提交，
+    // 调用方不得当作失败重试，否则重复执行
+    IN_DOUBT
 };
 
-// 分布式事务RAII管理器
 class DistributedTransaction {
 public:
+    typedef MultiConnectionDatabaseManager::DatabaseId DatabaseId;
+    typedef MultiConnectionDatabaseManager::TableType TableType;
+    
+    // 默认包含所有已注册数据库的所有分片
     DistributedTransaction();
+    explicit DistributedTransaction(const std::vector<TableType>& tables);
+    explicit DistributedTransaction(const std::vector<DatabaseId>& databases);
     ~DistributedTransaction();
     
-    bool commit();
+    CommitResult commit();
     void rollback();
     
+    std::uint64_t transactionId() const {
+        return txid_;
+    }
+    
+    // 参与的数据库文件数，为1时提交即本地提交（提交或回滚后为0）
+    std::size_t fileCount() const {
+        return participants_.size();
+    }
+    
 private:
+    DistributedTransaction(const DistributedTransaction&) = delete;
+    DistributedTransaction& operator=(const DistributedTransaction&) = delete;
+    
+    struct Participant {
+        DatabaseId database;
+        std::size_t shard;
+        sqlite3* db;
+        std::recursive_mutex* mutex;
+        std::string path;
+        std::atomic<std::uint64_t>* generation;  // 捕获期间由捕获钩子代为递增写入代数
+        // 本事务写过的(表, rowid)，提交时据此生成重做语句
+        std::set<std::pair<std::string, sqlite3_int64>> changed_rows;
+        std::vector<std::string> redo_statements;
+    };
+    
+    void begin(const std::vector<DatabaseId>& databases);
+    void stopCapture();
+    void release();
+    static void captureRow(void* context, int operation, const char* database, const char* table,
+                           sqlite3_int64 rowid);
+    
     MultiConnectionDatabaseManager& db_manager_;
+    std::vector<Participant> participants_;
+    std::vector<std::unique_ptr<AdmissionController::Ticket>> admissions_;
+    std::uint64_t txid_;
     bool committed_;
     bool rolled_back_;
 };
@@ -2,10 +2,14 @@
 #include "multi_connection_user_manager.h"
 #include "multi_connection_order_manager.h"
 #include "multi_connection_product_manager.h"
+#include "multi_connection_checkout_manager.h"
+#include "workload_capture.h"
+#include <cstdlib>
 #include <iostream>
 #include <thread>
 #include <vector>
 #include <chrono>
+#include <tuple>
 
 void demonstrateBasicOperations() {
     std::cout << "\n=== 多连接基本操作演示 ===" << std::endl;
@@ -47,8 +51,12 @@ void demonstrateDistributedTransaction() {
         bool order_created = order_manager.createOrder(1, 199.99, "pending");
         
         if (user_created && product_created && order_created) {
-            if (transaction.commit()) {
-                std::cout << "分布式事务提交成功" << std::endl;
+            std::size_t files = transaction.fileCount();
+            CommitResult committed = transaction.commit();
+            if (committed == CommitResult::COMMITTED) {
+                std::cout << "分布式事务提交成功（涉及 " << files << " 个数据库文件）" << std::endl;
+            } else if (committed == CommitResult::IN_DOUBT) {
+                std::cout << "分布式事务提交结果待恢复，将在下次启动时完成" << std::endl;
             } else {
                 std::cout << "分布式事务提交失败" << std::endl;
             }
@@ -62,6 +70,161 @@ void demonstrateDistributedTransaction() {
     }
 }
 
+void demonstrateComposedBatches() {
+    std::cout << "\n=== 批量操作组合提交演示 ===" << std::endl;
+    
+    try {
+        // 订单与库存两个批量操作在外层事务内以保存点执行，统一提交
+        DistributedTransaction transaction({MultiConnectionDatabaseManager::TableType::ORDERS,
+                                            MultiConnectionDatabaseManager::TableType::PRODUCTS});
+        
+        auto& order_manager = MultiConnectionOrderManager::getInstance();
+        auto& product_manager = MultiConnectionProductManager::getInstance();
+        
+        std::vector<std::tuple<int, double, std::string>> orders = {
+            std::make_tuple(2, 299.99, std::string("pending")),
+            std::make_tuple(3, 99.99, std::string("pending"))
+        };
+        std::vector<std::pair<int, int>> stock_updates = {{2, 49}, {3, 19}};
+        
+        if (order_manager.createOrdersTransaction(orders) &&
+            product_manager.updateStockTransaction(stock_updates) &&
+            transaction.commit() == CommitResult::COMMITTED) {
+            std::cout << "批量操作组合提交成功" << std::endl;
+        } else {
+            transaction.rollback();
+            std::cout << "批量操作失败，事务已回滚" << std::endl;
+        }
+        
+    } catch (const std::exception& e) {
+        std::cout << "批量操作异常: " << e.what() << std::endl;
+    }
+}
+
+void demonstrateCheckout() {
+    std::cout << "\n=== 原子下单演示 ===" << std::endl;
+    
+    auto& checkout_manager = MultiConnectionCheckoutManager::getInstance();
+    auto& product_manager = MultiConnectionProductManager::getInstance();
+    
+    // 同一产品出现两次的明细会被合并为一次扣减
+    std::vector<CheckoutItem> items = {{3, 1}, {1, 1}, {3, 2}};
+    int order_id = 0;
+    CheckoutResult result = checkout_manager.checkout(1, items, &order_id);
+    if (result == CheckoutResult::SUCCESS) {
+        std::cout << "下单成功，订单ID: " << order_id
+                  << "，产品3剩余库存: " << product_manager.getStockQuantity(3) << std::endl;
+    } else if (result == CheckoutResult::IN_DOUBT) {
+        std::cout << "下单结果待恢复，订单ID: " << order_id << "（重启后生效，不要重试）" << std::endl;
+    } else {
+        std::cout << "下单失败" << std::endl;
+    }
+    
+    // 库存不足时整单回滚，已扣减的其他产品库存随之恢复
+    int stock_before = product_manager.getStockQuantity(1);
+    std::vector<CheckoutItem> oversized = {{1, 1}, {2, 1000000}};
+    result = checkout_manager.checkout(1, oversized);
+    std::cout << "超量下单: " << (result == CheckoutResult::INSUFFICIENT_STOCK ? "库存不足，已回滚" : "意外结果")
+              << "，产品1库存: " << stock_before << " -> " << product_manager.getStockQuantity(1) << std::endl;
+}
+
+void demonstrateOptimisticUpdate() {
+    std::cout << "\n=== 乐观并发更新演示 ===" << std::endl;
+    
+    auto& product_manager = MultiConnectionProductManager::getInstance();
+    
+    // 两个编辑者读取同一版本，先写入者成功，后写入者得到冲突并需重新读取
+    Product first = product_manager.getProductById(1);
+    Product second = product_manager.getProductById(1);
+    if (first.id == 0) {
+        std::cout << "产品不存在，跳过演示" << std::endl;
+        return;
+    }
+    
+    UpdateResult result = product_manager.updateProductIfVersion(
+        first.id, first.version, first.name, "编辑者A修改的描述", first.price, first.stock_quantity);
+    std::cout << "编辑者A更新: " << (result == UpdateResult::UPDATED ? "成功" : "失败") << std::endl;
+    
+    result = product_manager.updateProductIfVersion(
+        second.id, second.version, second.name, "编辑者B修改的描述", second.price, second.stock_quantity);
+    if (result == UpdateResult::CONFLICT) {
+        Product latest = product_manager.getProductById(1);
+        std::cout << "编辑者B版本冲突，当前版本: " << latest.version << "，重新读取后重试" << std::endl;
+        result = product_manager.updateProductIfVersion(
+            latest.id, latest.version, latest.name, "编辑者B修改的描述", latest.price, latest.stock_quantity);
+        std::cout << "编辑者B重试: " << (result == UpdateResult::UPDATED ? "成功" : "失败") << std::endl;
+    }
+    
+    // 写合并开启且有挂起增量时，按版本条件更新同样成功，且覆盖挂起的增量
+    product_manager.enableStockCoalescing(60000);
+    product_manager.increaseStock(1, 5);
+    Product latest = product_manager.getProductById(1);
+    int target = product_manager.getStockQuantity(1) + 1;
+    result = product_manager.updateProductIfVersion(
+        latest.id, latest.version, latest.name, latest.description, latest.price, target);
+    int stock = product_manager.getStockQuantity(1);
+    product_manager.disableStockCoalescing();
+    std::cout << "写合并期间按版本更新: " << (result == UpdateResult::UPDATED ? "成功" : "失败") << "，库存 "
+              << stock << (stock == target && product_manager.getStockQuantity(1) == target ? "（正确）" : "（错误）")
+              << std::endl;
+}
+
+void demonstrateDynamicRegistration() {
+    std::cout << "\n=== 动态注册数据库演示 ===" << std::endl;
+    
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    
+    // 热点表 inventory_events 拆分为两个物理文件，各自拥有独立写入者
+    if (!db_manager.hasDatabase("inventory_events")) {
+        DatabaseSpec inventory_spec;
+        inventory_spec.name = "inventory_events";
+        inventory_spec.shard_paths.push_back("inventory_events_0_db.db");
+        inventory_spec.shard_paths.push_back("inventory_events_1_db.db");
+        inventory_spec.schema_sql = R"(
+            CREATE TABLE IF NOT EXISTS inventory_events (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                product_id INTEGER NOT NULL,
+                delta INTEGER NOT NULL,
+                created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+            );
+            CREATE INDEX IF NOT EXISTS idx_inventory_events_product_id ON inventory_events(product_id);
+        )";
+        db_manager.registerDatabase(inventory_spec);
+    }
+    
+    // 审计日志只追加写入，放宽同步级别
+    if (!db_manager.hasDatabase("audit_log")) {
+        DatabaseSpec audit_spec;
+        audit_spec.name = "audit_log";
+        audit_spec.shard_paths.push_back("audit_log_db.db");
+        audit_spec.schema_sql = R"(
+            CREATE TABLE IF NOT EXISTS audit_log (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                action TEXT NOT NULL,
+                created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+            );
+        )";
+        audit_spec.policy.synchronous = "OFF";
+        db_manager.registerDatabase(audit_spec);
+    }
+    
+    // 按名称查找数据库，按键值路由到分片
+    auto inventory_id = db_manager.findDatabase("inventory_events");
+    for (int product_id = 1; product_id <= 4; ++product_id) {
+        std::size_t shard = db_manager.shardFor(inventory_id, product_id);
+        sqlite3* db = db_manager.borrowConnection(inventory_id, shard);
+        std::string sql = "INSERT INTO inventory_events (product_id, delta) VALUES (" +
+                          std::to_string(product_id) + ", -1);";
+        sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+    }
+    
+    sqlite3* audit_db = db_manager.borrowConnection(db_manager.findDatabase("audit_log"));
+    sqlite3_exec(audit_db, "INSERT INTO audit_log (action) VALUES ('inventory_adjusted');", nullptr, nullptr, nullptr);
+    
+    std::cout << "已注册数据库数: " << db_manager.databaseCount() << std::endl;
+    std::cout << "inventory_events 分片数: " << db_manager.shardCount(inventory_id) << std::endl;
+}
+
 void demonstrateParallelPerformance() {
     std::cout << "\n=== 并行性能测试 ===" << std::endl;
     
@@ -115,6 +278,32 @@ void demonstrateResourceUsage() {
     std::cout << "订单表记录数: " << orders.size() << std::endl;
     std::cout << "产品表记录数: " << products.size() << std::endl;
     std::cout << "总记录数: " << (users.size() + orders.size() + products.size()) << std::endl;
+    
+    // 各数据库写入准入统计
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    for (std::size_t id = 0; id < MultiConnectionDatabaseManager::kTableTypeCount; ++id) {
+        AdmissionMetrics metrics = db_manager.admissionController(id).metrics();
+        std::cout << "写入准入 " << db_manager.shardPath(id) << ": 准入 " << metrics.admitted
+                  << ", 拒绝 " << metrics.rejected << ", 超时 " << metrics.deadline_exceeded
+                  << ", 峰值队列 " << metrics.peak_queue_depth
+                  << ", 批量准入 " << metrics.batch_admitted << ", 插队 " << metrics.preemptions << std::endl;
+    }
+    
+    // 各文件的I/O统计（经由I/O统计VFS）
+    for (const auto& file : db_manager.ioStatistics()) {
+        if (file.reads == 0 && file.writes == 0 && file.syncs == 0 && file.shm_maps == 0) {
+            continue;
+        }
+        std::string name = file.path.substr(file.path.find_last_of('/') + 1);
+        std::cout << "文件I/O " << name << " [" << ioFileKindName(file.kind) << "]: 读 " << file.reads
+                  << " 次/" << (file.read_bytes / 1024) << " KB, 写 " << file.writes
+                  << " 次/" << (file.write_bytes / 1024) << " KB, 同步 " << file.syncs
+                  << " 次/" << (file.sync_ns / 1000000) << " 毫秒";
+        if (file.kind == IoFileKind::SHM) {
+            std::cout << ", 映射 " << file.shm_maps << ", 加锁 " << file.shm_locks;
+        }
+        std::cout << std::endl;
+    }
 }
 
 int main() {
@@ -125,12 +314,29 @@ int main() {
         // 初始化数据库（会自动创建3个独立的数据库文件）
         MultiConnectionDatabaseManager::getInstance();
         
+        // 设置MC_WORKLOAD_CAPTURE时捕获所有管理器调用，供workload_replay重放
+        if (const char* capture_path = std::getenv("MC_WORKLOAD_CAPTURE")) {
+            WorkloadCapture::getInstance().start(capture_path);
+        }
+        
         // 演示基本操作
         demonstrateBasicOperations();
         
         // 演示分布式事务
         demonstrateDistributedTransaction();
         
+        // 演示批量操作组合进同一次提交
+        demonstrateComposedBatches();
+        
+        // 演示跨订单库与产品库的原子下单
+        demonstrateCheckout();
+        
+        // 演示基于行版本的乐观并发更新
+        demonstrateOptimisticUpdate();
+        
+        // 演示动态注册数据库与分片
+        demonstrateDynamicRegistration();
+        
         // 演示并行性能
         demonstrateParallelPerformance();
         
@@ -1,9 +1,48 @@
 #include "multi_connection_order_manager.h"
+#include "multi_connection_user_manager.h"
+#include "transaction_scope.h"
+#include "chunked_batch.h"
+#include "workload_capture.h"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <random>
 
+namespace {
+
+// 订单列表的缓存编码
+std::string encodeOrders(const std::vector<Order>& orders) {
+    ResultEncoder encoder;
+    for (const auto& order : orders) {
+        encoder.putInt(order.id);
+        encoder.putInt(order.user_id);
+        encoder.putDouble(order.total_amount);
+        encoder.putText(order.status);
+        encoder.putText(order.created_at);
+        encoder.putText(order.updated_at);
+    }
+    return std::move(encoder.buffer());
+}
+
+std::vector<Order> decodeOrders(const std::string& encoded) {
+    std::vector<Order> orders;
+    ResultDecoder decoder(encoded);
+    while (!decoder.done()) {
+        Order order;
+        order.id = static_cast<int>(decoder.getInt());
+        order.user_id = static_cast<int>(decoder.getInt());
+        order.total_amount = decoder.getDouble();
+        order.status = decoder.getText();
+        order.created_at = decoder.getText();
+        order.updated_at = decoder.getText();
+        orders.push_back(order);
+    }
+    return orders;
+}
+
+}  // namespace
+
 std::once_flag MultiConnectionOrderManager::initialized_;
 std::unique_ptr<MultiConnectionOrderManager> MultiConnectionOrderManager::instance_;
 
@@ -15,61 +54,77 @@ MultiConnectionOrderManager& MultiConnectionOrderManager::getInstance() {
 }
 
 MultiConnectionOrderManager::MultiConnectionOrderManager() 
-    : db_connection_(MultiConnectionDatabaseManager::getInstance().getConnection(MultiConnectionDatabaseManager::TableType::ORDERS)),
+    : db_connection_(MultiConnectionDatabaseManager::getInstance().borrowConnection(MultiConnectionDatabaseManager::TableType::ORDERS)),
+      operation_mutex_(MultiConnectionDatabaseManager::getInstance().connectionMutex(MultiConnectionDatabaseManager::TableType::ORDERS)),
+      admission_(MultiConnectionDatabaseManager::getInstance().admissionController(MultiConnectionDatabaseManager::TableType::ORDERS)),
       insert_stmt_(nullptr), select_all_stmt_(nullptr), 
       select_by_user_id_stmt_(nullptr), select_by_status_stmt_(nullptr),
       select_by_id_stmt_(nullptr), update_status_stmt_(nullptr),
       update_amount_stmt_(nullptr), delete_stmt_(nullptr),
-      total_amount_by_user_stmt_(nullptr), count_by_status_stmt_(nullptr) {
+      total_amount_by_user_stmt_(nullptr), count_by_status_stmt_(nullptr),
+      tombstone_stmt_(nullptr), purge_stmt_(nullptr),
+      soft_delete_(false), purged_orders_(0), purge_stop_(false),
+      purge_batch_rows_(64), purge_interval_(100), check_user_references_(false),
+      rejected_user_references_(0), result_cache_(nullptr) {
     prepareStatements();
 }
 
 MultiConnectionOrderManager::~MultiConnectionOrderManager() {
+    disableSoftDelete();
     finalizeStatements();
+    delete result_cache_.load();
 }
 
 void MultiConnectionOrderManager::prepareStatements() {
-    auto db = db_connection_.get();
+    auto db = db_connection_;
     
     // 准备插入语句
     const char* insert_sql = "INSERT INTO orders (user_id, total_amount, status) VALUES (?, ?, ?)";
     sqlite3_prepare_v2(db, insert_sql, -1, &insert_stmt_, nullptr);
     
     // 准备查询所有订单语句
-    const char* select_all_sql = "SELECT id, user_id, total_amount, status, created_at, updated_at FROM orders ORDER BY created_at DESC";
+    const char* select_all_sql = "SELECT id, user_id, total_amount, status, created_at, updated_at FROM orders WHERE deleted = 0 ORDER BY created_at DESC";
     sqlite3_prepare_v2(db, select_all_sql, -1, &select_all_stmt_, nullptr);
     
     // 准备根据用户ID查询语句
-    const char* select_by_user_id_sql = "SELECT id, user_id, total_amount, status, created_at, updated_at FROM orders WHERE user_id = ? ORDER BY created_at DESC";
+    const char* select_by_user_id_sql = "SELECT id, user_id, total_amount, status, created_at, updated_at FROM orders WHERE user_id = ? AND deleted = 0 ORDER BY created_at DESC";
     sqlite3_prepare_v2(db, select_by_user_id_sql, -1, &select_by_user_id_stmt_, nullptr);
     
     // 准备根据状态查询语句
-    const char* select_by_status_sql = "SELECT id, user_id, total_amount, status, created_at, updated_at FROM orders WHERE status = ? ORDER BY created_at DESC";
+    const char* select_by_status_sql = "SELECT id, user_id, total_amount, status, created_at, updated_at FROM orders WHERE status = ? AND deleted = 0 ORDER BY created_at DESC";
     sqlite3_prepare_v2(db, select_by_status_sql, -1, &select_by_status_stmt_, nullptr);
     
     // 准备根据ID查询语句
-    const char* select_by_id_sql = "SELECT id, user_id, total_amount, status, created_at, updated_at FROM orders WHERE id = ?";
+    const char* select_by_id_sql = "SELECT id, user_id, total_amount, status, created_at, updated_at FROM orders WHERE id = ? AND deleted = 0";
     sqlite3_prepare_v2(db, select_by_id_sql, -1, &select_by_id_stmt_, nullptr);
     
     // 准备更新状态语句
-    const char* update_status_sql = "UPDATE orders SET status = ?, updated_at = CURRENT_TIMESTAMP WHERE id = ?";
+    const char* update_status_sql = "UPDATE orders SET status = ?, updated_at = CURRENT_TIMESTAMP WHERE id = ? AND deleted = 0";
     sqlite3_prepare_v2(db, update_status_sql, -1, &update_status_stmt_, nullptr);
     
     // 准备更新金额语句
-    const char* update_amount_sql = "UPDATE orders SET total_amount = ?, updated_at = CURRENT_TIMESTAMP WHERE id = ?";
+    const char* update_amount_sql = "UPDATE orders SET total_amount = ?, updated_at = CURRENT_TIMESTAMP WHERE id = ? AND deleted = 0";
     sqlite3_prepare_v2(db, update_amount_sql, -1, &update_amount_stmt_, nullptr);
     
     // 准备删除语句
-    const char* delete_sql = "DELETE FROM orders WHERE id = ?";
+    const char* delete_sql = "DELETE FROM orders WHERE id = ? AND deleted = 0";
     sqlite3_prepare_v2(db, delete_sql, -1, &delete_stmt_, nullptr);
     
     // 准备统计用户总金额语句
-    const char* total_amount_sql = "SELECT COALESCE(SUM(total_amount), 0) FROM orders WHERE user_id = ?";
+    const char* total_amount_sql = "SELECT COALESCE(SUM(total_amount), 0) FROM orders WHERE user_id = ? AND deleted = 0";
     sqlite3_prepare_v2(db, total_amount_sql, -1, &total_amount_by_user_stmt_, nullptr);
     
     // 准备统计状态数量语句
-    const char* count_by_status_sql = "SELECT COUNT(*) FROM orders WHERE status = ?";
+    const char* count_by_status_sql = "SELECT COUNT(*) FROM orders WHERE status = ? AND deleted = 0";
     sqlite3_prepare_v2(db, count_by_status_sql, -1, &count_by_status_stmt_, nullptr);
+    
+    // 准备置删除标记语句：不涉及user_id、status列，SQLite不会改写这两个索引
+    const char* tombstone_sql = "UPDATE orders SET deleted = 1, updated_at = CURRENT_TIMESTAMP WHERE id = ? AND deleted = 0";
+    sqlite3_prepare_v2(db, tombstone_sql, -1, &tombstone_stmt_, nullptr);
+    
+    // 准备批量清理语句：经墓碑部分索引定位已标记的行
+    const char* purge_sql = "DELETE FROM orders WHERE id IN (SELECT id FROM orders WHERE deleted = 1 LIMIT ?)";
+    sqlite3_prepare_v2(db, purge_sql, -1, &purge_stmt_, nullptr);
 }
 
 void MultiConnectionOrderManager::finalizeStatements() {
@@ -83,10 +138,76 @@ void MultiConnectionOrderManager::finalizeStatements() {
     if (delete_stmt_) sqlite3_finalize(delete_stmt_);
     if (total_amount_by_user_stmt_) sqlite3_finalize(total_amount_by_user_stmt_);
     if (count_by_status_stmt_) sqlite3_finalize(count_by_status_stmt_);
+    if (tombstone_stmt_) sqlite3_finalize(tombstone_stmt_);
+    if (purge_stmt_) sqlite3_finalize(purge_stmt_);
+}
+
+Order MultiConnectionOrderManager::readOrder(sqlite3_stmt* stmt) {
+    Order order;
+    order.id = sqlite3_column_int(stmt, 0);
+    order.user_id = sqlite3_column_int(stmt, 1);
+    order.total_amount = sqlite3_column_double(stmt, 2);
+    order.status = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+    order.created_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+    order.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+    return order;
+}
+
+template <typename Bind>
+bool MultiConnectionOrderManager::readSnapshot(const std::string& key, sqlite3_stmt* primary_stmt, Bind bind,
+                                               std::vector<Order>& orders) {
+    std::shared_ptr<SnapshotReader> reader = std::atomic_load(&snapshot_reader_);
+    if (!reader) {
+        return false;
+    }
+    // 读者连接上使用与写入连接相同的SQL
+    return reader->read(key, [primary_stmt, &bind](SnapshotReader::Session& session) {
+        sqlite3_stmt* stmt = session.statement(sqlite3_sql(primary_stmt));
+        bind(stmt);
+        std::vector<Order> rows;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            rows.push_back(readOrder(stmt));
+        }
+        return rows;
+    }, orders);
+}
+
+void MultiConnectionOrderManager::enableResultCache(std::size_t capacity_bytes) {
+    QueryResultCache* previous = result_cache_.exchange(new QueryResultCache(capacity_bytes));
+    if (previous) {
+        EpochReclaimer::getInstance().retire(previous);
+    }
+}
+
+void MultiConnectionOrderManager::disableResultCache() {
+    QueryResultCache* previous = result_cache_.exchange(nullptr);
+    if (previous) {
+        EpochReclaimer::getInstance().retire(previous);
+    }
+}
+
+void MultiConnectionOrderManager::enableSnapshotReads(int max_staleness_ms) {
+    std::shared_ptr<SnapshotReader> reader = MultiConnectionDatabaseManager::getInstance().openSnapshotReader(
+        MultiConnectionDatabaseManager::TableType::ORDERS, std::chrono::milliseconds(max_staleness_ms));
+    std::atomic_store(&snapshot_reader_, reader);
+}
+
+void MultiConnectionOrderManager::disableSnapshotReads() {
+    std::atomic_store(&snapshot_reader_, std::shared_ptr<SnapshotReader>());
 }
 
 bool MultiConnectionOrderManager::createOrder(int user_id, double total_amount, const std::string& status) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::CREATE_ORDER, user_id, total_amount, status);
+    // 引用校验在获取订单连接之前：回退路径会获取用户连接，不能与订单连接交叉持有
+    if (check_user_references_.load(std::memory_order_relaxed) &&
+        !MultiConnectionUserManager::getInstance().userExists(user_id)) {
+        ++rejected_user_references_;
+        return false;
+    }
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
     
     sqlite3_reset(insert_stmt_);
     sqlite3_bind_int(insert_stmt_, 1, user_id);
@@ -98,120 +219,237 @@ bool MultiConnectionOrderManager::createOrder(int user_id, double total_amount,
 }
 
 std::vector<Order> MultiConnectionOrderManager::getAllOrders() {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::GET_ALL_ORDERS);
     std::vector<Order> orders;
+    if (readSnapshot("all", select_all_stmt_, [](sqlite3_stmt*) {}, orders)) {
+        return orders;
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
     
     sqlite3_reset(select_all_stmt_);
     
     while (sqlite3_step(select_all_stmt_) == SQLITE_ROW) {
-        Order order;
-        order.id = sqlite3_column_int(select_all_stmt_, 0);
-        order.user_id = sqlite3_column_int(select_all_stmt_, 1);
-        order.total_amount = sqlite3_column_double(select_all_stmt_, 2);
-        order.status = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 3));
-        order.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 4));
-        order.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 5));
-        orders.push_back(order);
+        orders.push_back(readOrder(select_all_stmt_));
     }
     
     return orders;
 }
 
 std::vector<Order> MultiConnectionOrderManager::getOrdersByUserId(int user_id) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::GET_ORDERS_BY_USER_ID, user_id);
     std::vector<Order> orders;
+    if (readSnapshot("user:" + std::to_string(user_id), select_by_user_id_stmt_,
+                     [user_id](sqlite3_stmt* stmt) { sqlite3_bind_int(stmt, 1, user_id); }, orders)) {
+        return orders;
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
     
     sqlite3_reset(select_by_user_id_stmt_);
     sqlite3_bind_int(select_by_user_id_stmt_, 1, user_id);
     
     while (sqlite3_step(select_by_user_id_stmt_) == SQLITE_ROW) {
-        Order order;
-        order.id = sqlite3_column_int(select_by_user_id_stmt_, 0);
-        order.user_id = sqlite3_column_int(select_by_user_id_stmt_, 1);
-        order.total_amount = sqlite3_column_double(select_by_user_id_stmt_, 2);
-        order.status = reinterpret_cast<const char*>(sqlite3_column_text(select_by_user_id_stmt_, 3));
-        order.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_user_id_stmt_, 4));
-        order.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_user_id_stmt_, 5));
-        orders.push_back(order);
+        orders.push_back(readOrder(select_by_user_id_stmt_));
     }
     
     return orders;
 }
 
 std::vector<Order> MultiConnectionOrderManager::getOrdersByStatus(const std::string& status) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::GET_ORDERS_BY_STATUS, status);
     std::vector<Order> orders;
+    // 缓存命中不获取连接互斥量；Guard使缓存在整个查询期间有效，未命中时填充同一个缓存
+    EpochReclaimer::Guard guard;
+    QueryResultCache* cache = result_cache_.load(std::memory_order_acquire);
+    std::string key;
+    if (cache) {
+        ResultEncoder params;
+        params.putText(status);
+        key = std::string(sqlite3_sql(select_by_status_stmt_)) + '\0' + params.buffer();
+        std::string encoded;
+        if (cache->lookup(key, MultiConnectionDatabaseManager::getInstance().writeGeneration(
+                                   MultiConnectionDatabaseManager::TableType::ORDERS), encoded)) {
+            return decodeOrders(encoded);
+        }
+    }
+    if (readSnapshot("status:" + status, select_by_status_stmt_,
+                     [&status](sqlite3_stmt* stmt) { sqlite3_bind_text(stmt, 1, status.c_str(), -1, SQLITE_STATIC); },
+                     orders)) {
+        return orders;
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    // 持锁后、查询前读取代数，缓存的结果不会比代数更旧
+    std::uint64_t generation = MultiConnectionDatabaseManager::getInstance().writeGeneration(
+        MultiConnectionDatabaseManager::TableType::ORDERS);
     
     sqlite3_reset(select_by_status_stmt_);
     sqlite3_bind_text(select_by_status_stmt_, 1, status.c_str(), -1, SQLITE_STATIC);
     
     while (sqlite3_step(select_by_status_stmt_) == SQLITE_ROW) {
-        Order order;
-        order.id = sqlite3_column_int(select_by_status_stmt_, 0);
-        order.user_id = sqlite3_column_int(select_by_status_stmt_, 1);
-        order.total_amount = sqlite3_column_double(select_by_status_stmt_, 2);
-        order.status = reinterpret_cast<const char*>(sqlite3_column_text(select_by_status_stmt_, 3));
-        order.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_status_stmt_, 4));
-        order.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_status_stmt_, 5));
-        orders.push_back(order);
+        orders.push_back(readOrder(select_by_status_stmt_));
     }
     
+    // 调用方事务中读到的可能是未提交的行，不填充缓存
+    if (cache && sqlite3_get_autocommit(db_connection_)) {
+        cache->insert(key, generation, encodeOrders(orders));
+    }
     return orders;
 }
 
 Order MultiConnectionOrderManager::getOrderById(int id) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::GET_ORDER_BY_ID, id);
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
     Order order = {0, 0, 0.0, "", "", ""};
     
     sqlite3_reset(select_by_id_stmt_);
     sqlite3_bind_int(select_by_id_stmt_, 1, id);
     
     if (sqlite3_step(select_by_id_stmt_) == SQLITE_ROW) {
-        order.id = sqlite3_column_int(select_by_id_stmt_, 0);
-        order.user_id = sqlite3_column_int(select_by_id_stmt_, 1);
-        order.total_amount = sqlite3_column_double(select_by_id_stmt_, 2);
-        order.status = reinterpret_cast<const char*>(sqlite3_column_text(select_by_id_stmt_, 3));
-        order.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_id_stmt_, 4));
-        order.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_id_stmt_, 5));
+        order = readOrder(select_by_id_stmt_);
     }
     
     return order;
 }
 
 bool MultiConnectionOrderManager::updateOrderStatus(int id, const std::string& status) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::UPDATE_ORDER_STATUS, id, status);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
     
     sqlite3_reset(update_status_stmt_);
     sqlite3_bind_text(update_status_stmt_, 1, status.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int(update_status_stmt_, 2, id);
     
     int result = sqlite3_step(update_status_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool MultiConnectionOrderManager::updateOrderAmount(int id, double total_amount) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::UPDATE_ORDER_AMOUNT, id, total_amount);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
     
     sqlite3_reset(update_amount_stmt_);
     sqlite3_bind_double(update_amount_stmt_, 1, total_amount);
     sqlite3_bind_int(update_amount_stmt_, 2, id);
     
     int result = sqlite3_step(update_amount_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool MultiConnectionOrderManager::deleteOrder(int id) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::DELETE_ORDER, id);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
     
-    sqlite3_reset(delete_stmt_);
-    sqlite3_bind_int(delete_stmt_, 1, id);
+    // 软删除模式下只置标记，索引维护留给后台清理
+    sqlite3_stmt* stmt = soft_delete_.load() ? tombstone_stmt_ : delete_stmt_;
+    sqlite3_reset(stmt);
+    sqlite3_bind_int(stmt, 1, id);
     
-    int result = sqlite3_step(delete_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    int result = sqlite3_step(stmt);
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
+}
+
+void MultiConnectionOrderManager::enableSoftDelete(int purge_batch_rows, int purge_interval_ms) {
+    std::lock_guard<std::mutex> lock(purge_mutex_);
+    purge_batch_rows_ = purge_batch_rows > 0 ? purge_batch_rows : 1;
+    purge_interval_ = std::chrono::milliseconds(purge_interval_ms > 0 ? purge_interval_ms : 1);
+    soft_delete_ = true;
+    if (!purge_thread_.joinable()) {
+        purge_stop_ = false;
+        purge_thread_ = std::thread(&MultiConnectionOrderManager::purgeLoop, this);
+    }
+}
+
+void MultiConnectionOrderManager::disableSoftDelete() {
+    soft_delete_ = false;
+    {
+        std::lock_guard<std::mutex> lock(purge_mutex_);
+        purge_stop_ = true;
+    }
+    purge_cv_.notify_all();
+    if (purge_thread_.joinable()) {
+        purge_thread_.join();
+    }
+}
+
+bool MultiConnectionOrderManager::softDeleteEnabled() const {
+    return soft_delete_.load();
+}
+
+std::uint64_t MultiConnectionOrderManager::purgedOrders() const {
+    return purged_orders_.load();
+}
+
+void MultiConnectionOrderManager::enableUserReferenceChecks() {
+    MultiConnectionUserManager::getInstance().enableUserIdSet();
+    check_user_references_.store(true);
+}
+
+void MultiConnectionOrderManager::disableUserReferenceChecks() {
+    check_user_references_.store(false);
+    MultiConnectionUserManager::getInstance().disableUserIdSet();
+}
+
+bool MultiConnectionOrderManager::userReferenceChecksEnabled() const {
+    return check_user_references_.load();
+}
+
+std::uint64_t MultiConnectionOrderManager::rejectedUserReferences() const {
+    return rejected_user_references_.load();
+}
+
+int MultiConnectionOrderManager::purgeDeletedOrders(int max_rows) {
+    // 清理是批量写入：交互式写入优先准入，排队过久则留到下一批
+    AdmissionController::ScopedDeadline deadline(std::chrono::milliseconds(100));
+    AdmissionController::WriteGuard write(admission_, operation_mutex_, AdmissionPriority::BATCH);
+    if (!write.admitted()) {
+        return 0;
+    }
+    
+    sqlite3_reset(purge_stmt_);
+    sqlite3_bind_int(purge_stmt_, 1, max_rows);
+    
+    if (sqlite3_step(purge_stmt_) != SQLITE_DONE) {
+        return 0;
+    }
+    int purged = sqlite3_changes(db_connection_);
+    purged_orders_ += static_cast<std::uint64_t>(purged);
+    return purged;
+}
+
+void MultiConnectionOrderManager::purgeLoop() {
+    std::unique_lock<std::mutex> lock(purge_mutex_);
+    while (!purge_stop_) {
+        // 每个间隔至多清理一批，限制后台删除占用的写入带宽
+        if (purge_cv_.wait_for(lock, purge_interval_, [this]() { return purge_stop_; })) {
+            break;
+        }
+        int batch_rows = purge_batch_rows_;
+        lock.unlock();
+        purgeDeletedOrders(batch_rows);
+        lock.lock();
+    }
 }
 
 double MultiConnectionOrderManager::getTotalAmountByUserId(int user_id) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::GET_TOTAL_AMOUNT_BY_USER_ID, user_id);
+    std::shared_ptr<SnapshotReader> reader = std::atomic_load(&snapshot_reader_);
+    double total = 0.0;
+    if (reader && reader->read("total:" + std::to_string(user_id), [this, user_id](SnapshotReader::Session& session) {
+            sqlite3_stmt* stmt = session.statement(sqlite3_sql(total_amount_by_user_stmt_));
+            sqlite3_bind_int(stmt, 1, user_id);
+            return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_double(stmt, 0) : 0.0;
+        }, total)) {
+        return total;
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
     
     sqlite3_reset(total_amount_by_user_stmt_);
     sqlite3_bind_int(total_amount_by_user_stmt_, 1, user_id);
@@ -224,7 +462,17 @@ double MultiConnectionOrderManager::getTotalAmountByUserId(int user_id) {
 }
 
 int MultiConnectionOrderManager::getOrderCountByStatus(const std::string& status) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::GET_ORDER_COUNT_BY_STATUS, status);
+    std::shared_ptr<SnapshotReader> reader = std::atomic_load(&snapshot_reader_);
+    int count = 0;
+    if (reader && reader->read("count:" + status, [this, &status](SnapshotReader::Session& session) {
+            sqlite3_stmt* stmt = session.statement(sqlite3_sql(count_by_status_stmt_));
+            sqlite3_bind_text(stmt, 1, status.c_str(), -1, SQLITE_STATIC);
+            return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
+        }, count)) {
+        return count;
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
     
     sqlite3_reset(count_by_status_stmt_);
     sqlite3_bind_text(count_by_status_stmt_, 1, status.c_str(), -1, SQLITE_STATIC);
@@ -237,14 +485,28 @@ int MultiConnectionOrderManager::getOrderCountByStatus(const std::string& status
 }
 
 bool MultiConnectionOrderManager::createOrdersTransaction(const std::vector<std::tuple<int, double, std::string>>& orders) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
-    auto db = db_connection_.get();
-    
-    // 开始事务
-    char* error_msg = nullptr;
-    int result = sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
+    WorkloadCapture::Call capture(WorkloadOp::CREATE_ORDERS_TRANSACTION, orders);
+    if (check_user_references_.load(std::memory_order_relaxed)) {
+        std::vector<int> user_ids;
+        for (const auto& order_tuple : orders) {
+            user_ids.push_back(std::get<0>(order_tuple));
+        }
+        std::sort(user_ids.begin(), user_ids.end());
+        user_ids.erase(std::unique(user_ids.begin(), user_ids.end()), user_ids.end());
+        if (!MultiConnectionUserManager::getInstance().usersExist(user_ids)) {
+            ++rejected_user_references_;
+            return false;
+        }
+    }
+    // 批量操作走批量通道，交互式写入优先准入
+    AdmissionController::WriteGuard write(admission_, operation_mutex_, AdmissionPriority::BATCH);
+    if (!write.admitted()) {
+        return false;
+    }
+    
+    // 开始事务（调用方已在事务中时使用保存点）
+    TransactionScope transaction(db_connection_);
+    if (!transaction.active()) {
         return false;
     }
     
@@ -256,20 +518,25 @@ bool MultiConnectionOrderManager::createOrdersTransaction(const std::vector<std:
         sqlite3_bind_text(insert_stmt_, 3, std::get<2>(order_tuple).c_str(), -1, SQLITE_STATIC);
         
         if (sqlite3_step(insert_stmt_) != SQLITE_DONE) {
-            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-            return false;
+            return false; // 作用域析构时回滚
         }
     }
     
-    // 提交事务
-    result = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
-        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-        return false;
-    }
-    
-    return true;
+    // 提交事务（嵌套时释放保存点，由外层事务统一提交）
+    return transaction.commit();
+}
+
+std::size_t MultiConnectionOrderManager::importOrders(const std::vector<std::tuple<int, double, std::string>>& orders, std::size_t chunk_rows) {
+    WorkloadCapture::Call capture(WorkloadOp::IMPORT_ORDERS, orders, static_cast<std::uint64_t>(chunk_rows));
+    // 分块提交，块间让出连接给交互式写入
+    return writeInChunks(admission_, operation_mutex_, db_connection_, orders, chunk_rows,
+        [this](const std::tuple<int, double, std::string>& order_tuple) {
+        sqlite3_reset(insert_stmt_);
+        sqlite3_bind_int(insert_stmt_, 1, std::get<0>(order_tuple));
+        sqlite3_bind_double(insert_stmt_, 2, std::get<1>(order_tuple));
+        sqlite3_bind_text(insert_stmt_, 3, std::get<2>(order_tuple).c_str(), -1, SQLITE_STATIC);
+        return sqlite3_step(insert_stmt_) == SQLITE_DONE;
+        });
 }
 
 void MultiConnectionOrderManager::performanceTest(int thread_count, int operations_per_thread) {
@@ -1,19 +1,18 @@
 #pragma once
 
 #include "multi_connection_database_manager.h"
+#include "models.h"
+#include "result_cache.h"
+#include "epoch_reclaimer.h"
 #include <vector>
 #include <string>
 #include <memory>
 #include <mutex>
-
-struct Order {
-    int id;
-    int user_id;
-    double total_amount;
-    std::string status;
-    std::string created_at;
-    std::string updated_at;
-};
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <thread>
 
 class MultiConnectionOrderManager {
 public:
@@ -36,6 +35,43 @@ public:
     
     // 批量操作
     bool createOrdersTransaction(const std::vector<std::tuple<int, double, std::string>>& orders);
+    // 大批量导入：按chunk_rows分块提交，不具备整体原子性，返回已提交的行数
+    std::size_t importOrders(const std::vector<std::tuple<int, double, std::string>>& orders, std::size_t chunk_rows = 1000);
+    
+    // 有界陈旧读（可选）：启用后列表与统计查询（getAllOrders、getOrdersByUserId、
+    // getOrdersByStatus、getTotalAmountByUserId、getOrderCountByStatus）改在快照读者上
+    // 执行，不再与写入者竞争连接互斥量，结果可能落后至多max_staleness_ms毫秒。
+    // getOrderById始终读取最新数据
+    void enableSnapshotReads(int max_staleness_ms = 200);
+    void disableSnapshotReads();
+    
+    // 查询结果缓存（可选）：getOrdersByStatus的结果按语句与参数缓存，任何对订单表的
+    // 写入都会使其失效；命中时不获取连接互斥量
+    void enableResultCache(std::size_t capacity_bytes = 4 * 1024 * 1024);
+    void disableResultCache();
+    
+    // 软删除（墓碑）模式：deleteOrder()只置删除标记，请求路径上只写入墓碑部分索引，
+    // 不改写用户与状态索引；后台清理线程每隔purge_interval_ms物理删除至多
+    // purge_batch_rows个已标记的订单，每批为一个批量写入。关闭后已标记的订单
+    // 仍对查询不可见，留待再次开启或purgeDeletedOrders()清理
+    void enableSoftDelete(int purge_batch_rows = 64, int purge_interval_ms = 100);
+    void disableSoftDelete();
+    bool softDeleteEnabled() const;
+    // 立即物理删除至多max_rows个已标记的订单，返回删除的行数
+    int purgeDeletedOrders(int max_rows);
+    // 累计物理删除的已标记订单数
+    std::uint64_t purgedOrders() const;
+    
+    // 用户引用校验（可选）：订单库与用户库分属两个文件，外键无法由SQLite检查。
+    // 启用后createOrder()与createOrdersTransaction()在获取订单连接前以用户管理器的
+    // 用户id集合校验user_id（整批只做一次检查），引用不存在的用户时拒绝写入并返回false。
+    // 校验与写入不在同一事务中，校验之后被删除的用户仍可能留下孤儿订单；
+    // importOrders()面向迁移不做校验。两者均可用离线工具orphan_check检查
+    void enableUserReferenceChecks();
+    void disableUserReferenceChecks();
+    bool userReferenceChecksEnabled() const;
+    // 因引用不存在的用户而被拒绝的订单数
+    std::uint64_t rejectedUserReferences() const;
     
     // 性能测试方法
     void performanceTest(int thread_count, int operations_per_thread);
@@ -47,9 +83,17 @@ private:
     
     void prepareStatements();
     void finalizeStatements();
+    void purgeLoop();
+    static Order readOrder(sqlite3_stmt* stmt);
+    template <typename Bind>
+    bool readSnapshot(const std::string& key, sqlite3_stmt* primary_stmt, Bind bind, std::vector<Order>& orders);
     
-    std::shared_ptr<sqlite3> db_connection_;
-    std::mutex operation_mutex_;
+    // 借用的连接句柄，不持有所有权，生命周期由数据库管理器保证
+    sqlite3* db_connection_;
+    // 连接互斥量由数据库管理器持有，与分布式事务共享
+    std::recursive_mutex& operation_mutex_;
+    // 写入准入控制器，按到达顺序排队、过载时拒绝
+    AdmissionController& admission_;
     
     // 预编译的SQL语句
     sqlite3_stmt* insert_stmt_;
@@ -62,6 +106,27 @@ private:
     sqlite3_stmt* delete_stmt_;
     sqlite3_stmt* total_amount_by_user_stmt_;
     sqlite3_stmt* count_by_status_stmt_;
+    sqlite3_stmt* tombstone_stmt_;
+    sqlite3_stmt* purge_stmt_;
+    
+    // 软删除模式与后台清理线程（purge_mutex_保护清理参数与线程启停）
+    std::atomic<bool> soft_delete_;
+    std::atomic<std::uint64_t> purged_orders_;
+    std::mutex purge_mutex_;
+    std::condition_variable purge_cv_;
+    bool purge_stop_;
+    int purge_batch_rows_;
+    std::chrono::milliseconds purge_interval_;
+    std::thread purge_thread_;
+    
+    // 用户引用校验
+    std::atomic<bool> check_user_references_;
+    std::atomic<std::uint64_t> rejected_user_references_;
+    
+    // 快照读者，为空表示未启用；以std::atomic_load/atomic_store访问
+    std::shared_ptr<SnapshotReader> snapshot_reader_;
+    // 查询结果缓存，为空表示未启用；查询在EpochReclaimer::Guard内加载，停用或替换后旧缓存退役
+    std::atomic<QueryResultCache*> result_cache_;
     
     static std::once_flag initialized_;
     static std::unique_ptr<MultiConnectionOrderManager> instance_;
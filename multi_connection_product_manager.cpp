@@ -1,8 +1,74 @@
 #include "multi_connection_product_manager.h"
+#include "transaction_scope.h"
+#include "chunked_batch.h"
+#include "workload_capture.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <random>
+#include <sstream>
+
+namespace {
+
+// 快照记忆的键：价格按完整精度编码，相近的区间不会共用结果
+std::string priceRangeKey(double min_price, double max_price) {
+    std::ostringstream key;
+    key.precision(17);
+    key << "price_range:" << min_price << ":" << max_price;
+    return key.str();
+}
+
+// 产品列表的缓存编码
+std::string encodeProducts(const std::vector<Product>& products) {
+    ResultEncoder encoder;
+    for (const auto& product : products) {
+        encoder.putInt(product.id);
+        encoder.putText(product.name);
+        encoder.putText(product.description);
+        encoder.putDouble(product.price);
+        encoder.putInt(product.stock_quantity);
+        encoder.putText(product.created_at);
+        encoder.putText(product.updated_at);
+        encoder.putInt(product.version);
+    }
+    return std::move(encoder.buffer());
+}
+
+std::vector<Product> decodeProducts(const std::string& encoded) {
+    std::vector<Product> products;
+    ResultDecoder decoder(encoded);
+    while (!decoder.done()) {
+        Product product;
+        product.id = static_cast<int>(decoder.getInt());
+        product.name = decoder.getText();
+        product.description = decoder.getText();
+        product.price = decoder.getDouble();
+        product.stock_quantity = static_cast<int>(decoder.getInt());
+        product.created_at = decoder.getText();
+        product.updated_at = decoder.getText();
+        product.version = static_cast<int>(decoder.getInt());
+        products.push_back(product);
+    }
+    return products;
+}
+
+// 缓存键：语句SQL与编码后的绑定参数
+std::string cacheKey(sqlite3_stmt* stmt, ResultEncoder& params) {
+    return std::string(sqlite3_sql(stmt)) + '\0' + params.buffer();
+}
+
+// 按产品表当前的写入代数查找，命中时不获取连接互斥量
+bool lookupProducts(QueryResultCache& cache, const std::string& key, std::vector<Product>& products) {
+    std::string encoded;
+    if (!cache.lookup(key, MultiConnectionDatabaseManager::getInstance().writeGeneration(
+                               MultiConnectionDatabaseManager::TableType::PRODUCTS), encoded)) {
+        return false;
+    }
+    products = decodeProducts(encoded);
+    return true;
+}
+
+}  // namespace
 
 std::once_flag MultiConnectionProductManager::initialized_;
 std::unique_ptr<MultiConnectionProductManager> MultiConnectionProductManager::instance_;
@@ -15,51 +81,134 @@ MultiConnectionProductManager& MultiConnectionProductManager::getInstance() {
 }
 
 MultiConnectionProductManager::MultiConnectionProductManager() 
-    : db_connection_(MultiConnectionDatabaseManager::getInstance().getConnection(MultiConnectionDatabaseManager::TableType::PRODUCTS)),
+    : db_connection_(MultiConnectionDatabaseManager::getInstance().borrowConnection(MultiConnectionDatabaseManager::TableType::PRODUCTS)),
+      operation_mutex_(MultiConnectionDatabaseManager::getInstance().connectionMutex(MultiConnectionDatabaseManager::TableType::PRODUCTS)),
+      admission_(MultiConnectionDatabaseManager::getInstance().admissionController(MultiConnectionDatabaseManager::TableType::PRODUCTS)),
       insert_stmt_(nullptr), select_all_stmt_(nullptr), 
       select_by_price_range_stmt_(nullptr), select_in_stock_stmt_(nullptr),
       select_by_id_stmt_(nullptr), select_by_name_stmt_(nullptr),
       update_stmt_(nullptr), update_stock_stmt_(nullptr),
       update_price_stmt_(nullptr), delete_stmt_(nullptr),
       increase_stock_stmt_(nullptr), decrease_stock_stmt_(nullptr),
-      get_stock_stmt_(nullptr) {
+      get_stock_stmt_(nullptr), update_if_version_stmt_(nullptr),
+      get_version_stmt_(nullptr), stock_coalescing_(false), flusher_stop_(false),
+      result_cache_(nullptr) {
     prepareStatements();
 }
 
 MultiConnectionProductManager::~MultiConnectionProductManager() {
+    // 落盘剩余增量后才能释放语句
+    disableStockCoalescing();
     finalizeStatements();
+    delete result_cache_.load();
 }
 
 void MultiConnectionProductManager::prepareStatements() {
-    auto db = db_connection_.get();
+    auto db = db_connection_;
     
     // 准备插入语句
     const char* insert_sql = "INSERT INTO products (name, description, price, stock_quantity) VALUES (?, ?, ?, ?)";
     sqlite3_prepare_v2(db, insert_sql, -1, &insert_stmt_, nullptr);
     
     // 准备查询所有产品语句
-    const char* select_all_sql = "SELECT id, name, description, price, stock_quantity, created_at, updated_at FROM products ORDER BY name";
+    const char* select_all_sql = "SELECT id, name, description, price, stock_quantity, created_at, updated_at, version FROM products ORDER BY name";
     sqlite3_prepare_v2(db, select_all_sql, -1, &select_all_stmt_, nullptr);
     
-    // 其他语句准备（简化版本，只实现核心功能）
-    const char* select_by_id_sql = "SELECT id, name, description, price, stock_quantity, created_at, updated_at FROM products WHERE id = ?";
+    // 准备价格范围查询语句
+    const char* select_by_price_range_sql = "SELECT id, name, description, price, stock_quantity, created_at, updated_at, version FROM products WHERE price BETWEEN ? AND ? ORDER BY price";
+    sqlite3_prepare_v2(db, select_by_price_range_sql, -1, &select_by_price_range_stmt_, nullptr);
+    
+    // 准备有库存产品查询语句
+    const char* select_in_stock_sql = "SELECT id, name, description, price, stock_quantity, created_at, updated_at, version FROM products WHERE stock_quantity > 0 ORDER BY name";
+    sqlite3_prepare_v2(db, select_in_stock_sql, -1, &select_in_stock_stmt_, nullptr);
+    
+    // 准备根据ID查询语句
+    const char* select_by_id_sql = "SELECT id, name, description, price, stock_quantity, created_at, updated_at, version FROM products WHERE id = ?";
     sqlite3_prepare_v2(db, select_by_id_sql, -1, &select_by_id_stmt_, nullptr);
     
-    const char* update_stock_sql = "UPDATE products SET stock_quantity = ?, updated_at = CURRENT_TIMESTAMP WHERE id = ?";
+    // 准备根据名称查询语句
+    const char* select_by_name_sql = "SELECT id, name, description, price, stock_quantity, created_at, updated_at, version FROM products WHERE name = ?";
+    sqlite3_prepare_v2(db, select_by_name_sql, -1, &select_by_name_stmt_, nullptr);
+    
+    // 所有写语句都递增version，保证版本比较能观察到任何修改
+    
+    // 准备更新语句
+    const char* update_sql = "UPDATE products SET name = ?, description = ?, price = ?, stock_quantity = ?, version = version + 1, updated_at = CURRENT_TIMESTAMP WHERE id = ?";
+    sqlite3_prepare_v2(db, update_sql, -1, &update_stmt_, nullptr);
+    
+    // 准备按版本条件更新语句（比较并交换）
+    const char* update_if_version_sql = "UPDATE products SET name = ?, description = ?, price = ?, stock_quantity = ?, version = version + 1, updated_at = CURRENT_TIMESTAMP WHERE id = ? AND version = ?";
+    sqlite3_prepare_v2(db, update_if_version_sql, -1, &update_if_version_stmt_, nullptr);
+    
+    // 准备更新库存语句
+    const char* update_stock_sql = "UPDATE products SET stock_quantity = ?, version = version + 1, updated_at = CURRENT_TIMESTAMP WHERE id = ?";
     sqlite3_prepare_v2(db, update_stock_sql, -1, &update_stock_stmt_, nullptr);
+    
+    // 准备更新价格语句
+    const char* update_price_sql = "UPDATE products SET price = ?, version = version + 1, updated_at = CURRENT_TIMESTAMP WHERE id = ?";
+    sqlite3_prepare_v2(db, update_price_sql, -1, &update_price_stmt_, nullptr);
+    
+    // 准备删除语句
+    const char* delete_sql = "DELETE FROM products WHERE id = ?";
+    sqlite3_prepare_v2(db, delete_sql, -1, &delete_stmt_, nullptr);
+    
+    // 准备增加库存语句
+    const char* increase_stock_sql = "UPDATE products SET stock_quantity = stock_quantity + ?, version = version + 1, updated_at = CURRENT_TIMESTAMP WHERE id = ?";
+    sqlite3_prepare_v2(db, increase_stock_sql, -1, &increase_stock_stmt_, nullptr);
+    
+    // 准备减少库存语句
+    const char* decrease_stock_sql = "UPDATE products SET stock_quantity = stock_quantity - ?, version = version + 1, updated_at = CURRENT_TIMESTAMP WHERE id = ? AND stock_quantity >= ?";
+    sqlite3_prepare_v2(db, decrease_stock_sql, -1, &decrease_stock_stmt_, nullptr);
+    
+    // 准备获取库存语句
+    const char* get_stock_sql = "SELECT stock_quantity FROM products WHERE id = ?";
+    sqlite3_prepare_v2(db, get_stock_sql, -1, &get_stock_stmt_, nullptr);
+    
+    // 准备获取版本语句（区分版本冲突与记录不存在）
+    const char* get_version_sql = "SELECT version FROM products WHERE id = ?";
+    sqlite3_prepare_v2(db, get_version_sql, -1, &get_version_stmt_, nullptr);
 }
 
 void MultiConnectionProductManager::finalizeStatements() {
     if (insert_stmt_) sqlite3_finalize(insert_stmt_);
     if (select_all_stmt_) sqlite3_finalize(select_all_stmt_);
+    if (select_by_price_range_stmt_) sqlite3_finalize(select_by_price_range_stmt_);
+    if (select_in_stock_stmt_) sqlite3_finalize(select_in_stock_stmt_);
     if (select_by_id_stmt_) sqlite3_finalize(select_by_id_stmt_);
+    if (select_by_name_stmt_) sqlite3_finalize(select_by_name_stmt_);
+    if (update_stmt_) sqlite3_finalize(update_stmt_);
+    if (update_if_version_stmt_) sqlite3_finalize(update_if_version_stmt_);
     if (update_stock_stmt_) sqlite3_finalize(update_stock_stmt_);
-    // 其他语句清理...
+    if (update_price_stmt_) sqlite3_finalize(update_price_stmt_);
+    if (delete_stmt_) sqlite3_finalize(delete_stmt_);
+    if (increase_stock_stmt_) sqlite3_finalize(increase_stock_stmt_);
+    if (decrease_stock_stmt_) sqlite3_finalize(decrease_stock_stmt_);
+    if (get_stock_stmt_) sqlite3_finalize(get_stock_stmt_);
+    if (get_version_stmt_) sqlite3_finalize(get_version_stmt_);
+}
+
+Product MultiConnectionProductManager::readProduct(sqlite3_stmt* stmt) {
+    Product product;
+    product.id = sqlite3_column_int(stmt, 0);
+    product.name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    // description可为NULL
+    const unsigned char* description = sqlite3_column_text(stmt, 2);
+    product.description = description ? reinterpret_cast<const char*>(description) : "";
+    product.price = sqlite3_column_double(stmt, 3);
+    product.stock_quantity = sqlite3_column_int(stmt, 4);
+    product.created_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 5));
+    product.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 6));
+    product.version = sqlite3_column_int(stmt, 7);
+    return product;
 }
 
 bool MultiConnectionProductManager::createProduct(const std::string& name, const std::string& description, 
                                                  double price, int stock_quantity) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::CREATE_PRODUCT, name, description, price, stock_quantity);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
     
     sqlite3_reset(insert_stmt_);
     sqlite3_bind_text(insert_stmt_, 1, name.c_str(), -1, SQLITE_STATIC);
@@ -71,41 +220,556 @@ bool MultiConnectionProductManager::createProduct(const std::string& name, const
     return result == SQLITE_DONE;
 }
 
+template <typename Bind>
+bool MultiConnectionProductManager::readSnapshot(const std::string& key, sqlite3_stmt* primary_stmt, Bind bind,
+                                                 std::vector<Product>& products) {
+    std::shared_ptr<SnapshotReader> reader = std::atomic_load(&snapshot_reader_);
+    if (!reader) {
+        return false;
+    }
+    // 读者连接上使用与写入连接相同的SQL
+    return reader->read(key, [primary_stmt, &bind](SnapshotReader::Session& session) {
+        sqlite3_stmt* stmt = session.statement(sqlite3_sql(primary_stmt));
+        bind(stmt);
+        std::vector<Product> rows;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            rows.push_back(readProduct(stmt));
+        }
+        return rows;
+    }, products);
+}
+
+void MultiConnectionProductManager::enableResultCache(std::size_t capacity_bytes) {
+    QueryResultCache* previous = result_cache_.exchange(new QueryResultCache(capacity_bytes));
+    if (previous) {
+        EpochReclaimer::getInstance().retire(previous);
+    }
+}
+
+void MultiConnectionProductManager::disableResultCache() {
+    QueryResultCache* previous = result_cache_.exchange(nullptr);
+    if (previous) {
+        EpochReclaimer::getInstance().retire(previous);
+    }
+}
+
+void MultiConnectionProductManager::enableSnapshotReads(int max_staleness_ms) {
+    std::shared_ptr<SnapshotReader> reader = MultiConnectionDatabaseManager::getInstance().openSnapshotReader(
+        MultiConnectionDatabaseManager::TableType::PRODUCTS, std::chrono::milliseconds(max_staleness_ms));
+    std::atomic_store(&snapshot_reader_, reader);
+}
+
+void MultiConnectionProductManager::disableSnapshotReads() {
+    std::atomic_store(&snapshot_reader_, std::shared_ptr<SnapshotReader>());
+}
+
 std::vector<Product> MultiConnectionProductManager::getAllProducts() {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::GET_ALL_PRODUCTS);
     std::vector<Product> products;
+    if (readSnapshot("all", select_all_stmt_, [](sqlite3_stmt*) {}, products)) {
+        return products;
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
     
     sqlite3_reset(select_all_stmt_);
     
     while (sqlite3_step(select_all_stmt_) == SQLITE_ROW) {
-        Product product;
-        product.id = sqlite3_column_int(select_all_stmt_, 0);
-        product.name = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 1));
-        product.description = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 2));
-        product.price = sqlite3_column_double(select_all_stmt_, 3);
-        product.stock_quantity = sqlite3_column_int(select_all_stmt_, 4);
-        product.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 5));
-        product.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 6));
-        products.push_back(product);
+        products.push_back(readProduct(select_all_stmt_));
     }
     
     return products;
 }
 
-// 简化实现其他方法
-std::vector<Product> MultiConnectionProductManager::getProductsByPriceRange(double, double) { return {}; }
-std::vector<Product> MultiConnectionProductManager::getProductsInStock() { return {}; }
-Product MultiConnectionProductManager::getProductById(int) { return {0, "", "", 0.0, 0, "", ""}; }
-Product MultiConnectionProductManager::getProductByName(const std::string&) { return {0, "", "", 0.0, 0, "", ""}; }
-bool MultiConnectionProductManager::updateProduct(int, const std::string&, const std::string&, double, int) { return false; }
-bool MultiConnectionProductManager::updateProductStock(int, int) { return false; }
-bool MultiConnectionProductManager::updateProductPrice(int, double) { return false; }
-bool MultiConnectionProductManager::deleteProduct(int) { return false; }
-bool MultiConnectionProductManager::increaseStock(int, int) { return false; }
-bool MultiConnectionProductManager::decreaseStock(int, int) { return false; }
-int MultiConnectionProductManager::getStockQuantity(int) { return 0; }
-bool MultiConnectionProductManager::createProductsTransaction(const std::vector<std::tuple<std::string, std::string, double, int>>&) { return false; }
-bool MultiConnectionProductManager::updateStockTransaction(const std::vector<std::pair<int, int>>&) { return false; }
+std::vector<Product> MultiConnectionProductManager::getProductsByPriceRange(double min_price, double max_price) {
+    WorkloadCapture::Call capture(WorkloadOp::GET_PRODUCTS_BY_PRICE_RANGE, min_price, max_price);
+    std::vector<Product> products;
+    // 缓存在整个查询期间有效，未命中时填充的仍是同一个缓存
+    EpochReclaimer::Guard guard;
+    QueryResultCache* cache = result_cache_.load(std::memory_order_acquire);
+    std::string key;
+    if (cache) {
+        ResultEncoder params;
+        params.putDouble(min_price);
+        params.putDouble(max_price);
+        key = cacheKey(select_by_price_range_stmt_, params);
+        if (lookupProducts(*cache, key, products)) {
+            return products;
+        }
+    }
+    if (readSnapshot(priceRangeKey(min_price, max_price), select_by_price_range_stmt_,
+                     [min_price, max_price](sqlite3_stmt* stmt) {
+                         sqlite3_bind_double(stmt, 1, min_price);
+                         sqlite3_bind_double(stmt, 2, max_price);
+                     }, products)) {
+        return products;
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    // 持锁后、查询前读取代数，缓存的结果不会比代数更旧
+    std::uint64_t generation = MultiConnectionDatabaseManager::getInstance().writeGeneration(
+        MultiConnectionDatabaseManager::TableType::PRODUCTS);
+    
+    sqlite3_reset(select_by_price_range_stmt_);
+    sqlite3_bind_double(select_by_price_range_stmt_, 1, min_price);
+    sqlite3_bind_double(select_by_price_range_stmt_, 2, max_price);
+    
+    while (sqlite3_step(select_by_price_range_stmt_) == SQLITE_ROW) {
+        products.push_back(readProduct(select_by_price_range_stmt_));
+    }
+    
+    // 调用方事务中读到的可能是未提交的行，不填充缓存
+    if (cache && sqlite3_get_autocommit(db_connection_)) {
+        cache->insert(key, generation, encodeProducts(products));
+    }
+    return products;
+}
+
+std::vector<Product> MultiConnectionProductManager::getProductsInStock() {
+    WorkloadCapture::Call capture(WorkloadOp::GET_PRODUCTS_IN_STOCK);
+    std::vector<Product> products;
+    EpochReclaimer::Guard guard;
+    QueryResultCache* cache = result_cache_.load(std::memory_order_acquire);
+    std::string key;
+    if (cache) {
+        ResultEncoder params;
+        key = cacheKey(select_in_stock_stmt_, params);
+        if (lookupProducts(*cache, key, products)) {
+            return products;
+        }
+    }
+    if (readSnapshot("in_stock", select_in_stock_stmt_, [](sqlite3_stmt*) {}, products)) {
+        return products;
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    std::uint64_t generation = MultiConnectionDatabaseManager::getInstance().writeGeneration(
+        MultiConnectionDatabaseManager::TableType::PRODUCTS);
+    
+    sqlite3_reset(select_in_stock_stmt_);
+    
+    while (sqlite3_step(select_in_stock_stmt_) == SQLITE_ROW) {
+        products.push_back(readProduct(select_in_stock_stmt_));
+    }
+    
+    // 调用方事务中读到的可能是未提交的行，不填充缓存
+    if (cache && sqlite3_get_autocommit(db_connection_)) {
+        cache->insert(key, generation, encodeProducts(products));
+    }
+    return products;
+}
+
+Product MultiConnectionProductManager::getProductById(int id) {
+    WorkloadCapture::Call capture(WorkloadOp::GET_PRODUCT_BY_ID, id);
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    Product product = {0, "", "", 0.0, 0, "", "", 0};
+    
+    sqlite3_reset(select_by_id_stmt_);
+    sqlite3_bind_int(select_by_id_stmt_, 1, id);
+    
+    if (sqlite3_step(select_by_id_stmt_) == SQLITE_ROW) {
+        product = readProduct(select_by_id_stmt_);
+    }
+    
+    return product;
+}
+
+Product MultiConnectionProductManager::getProductByName(const std::string& name) {
+    WorkloadCapture::Call capture(WorkloadOp::GET_PRODUCT_BY_NAME, name);
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    Product product = {0, "", "", 0.0, 0, "", "", 0};
+    
+    sqlite3_reset(select_by_name_stmt_);
+    sqlite3_bind_text(select_by_name_stmt_, 1, name.c_str(), -1, SQLITE_STATIC);
+    
+    if (sqlite3_step(select_by_name_stmt_) == SQLITE_ROW) {
+        product = readProduct(select_by_name_stmt_);
+    }
+    
+    return product;
+}
+
+bool MultiConnectionProductManager::updateProduct(int id, const std::string& name, const std::string& description, 
+                                                 double price, int stock_quantity) {
+    WorkloadCapture::Call capture(WorkloadOp::UPDATE_PRODUCT, id, name, description, price, stock_quantity);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
+    
+    // 本次写入覆盖库存，挂起的增量随之合并（见unappliedStock）
+    int unapplied = unappliedStock(id);
+    
+    sqlite3_reset(update_stmt_);
+    sqlite3_bind_text(update_stmt_, 1, name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(update_stmt_, 2, description.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_double(update_stmt_, 3, price);
+    sqlite3_bind_int64(update_stmt_, 4, static_cast<sqlite3_int64>(stock_quantity) - unapplied);
+    sqlite3_bind_int(update_stmt_, 5, id);
+    
+    int result = sqlite3_step(update_stmt_);
+    if (result != SQLITE_DONE || sqlite3_changes(db_connection_) == 0) {
+        return false;
+    }
+    settleStock(id);
+    return true;
+}
+
+UpdateResult MultiConnectionProductManager::updateProductIfVersion(int id, int expected_version,
+                                                                  const std::string& name, const std::string& description,
+                                                                  double price, int stock_quantity) {
+    WorkloadCapture::Call capture(WorkloadOp::UPDATE_PRODUCT_IF_VERSION, id, expected_version, name, description, price, stock_quantity);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return UpdateResult::REJECTED;
+    }
+    
+    // 本次写入覆盖库存，挂起的增量随之合并（见unappliedStock）
+    int unapplied = unappliedStock(id);
+    
+    // 单条UPDATE在自动提交模式下执行，写锁只在该语句期间持有
+    sqlite3_reset(update_if_version_stmt_);
+    sqlite3_bind_text(update_if_version_stmt_, 1, name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(update_if_version_stmt_, 2, description.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_double(update_if_version_stmt_, 3, price);
+    sqlite3_bind_int64(update_if_version_stmt_, 4, static_cast<sqlite3_int64>(stock_quantity) - unapplied);
+    sqlite3_bind_int(update_if_version_stmt_, 5, id);
+    sqlite3_bind_int(update_if_version_stmt_, 6, expected_version);
+    
+    if (sqlite3_step(update_if_version_stmt_) != SQLITE_DONE) {
+        return UpdateResult::FAILED;
+    }
+    if (sqlite3_changes(db_connection_) > 0) {
+        settleStock(id);
+        return UpdateResult::UPDATED;
+    }
+    
+    // 未更新任何行：记录不存在或版本已被其他写入者推进
+    sqlite3_reset(get_version_stmt_);
+    sqlite3_bind_int(get_version_stmt_, 1, id);
+    return sqlite3_step(get_version_stmt_) == SQLITE_ROW ? UpdateResult::CONFLICT : UpdateResult::NOT_FOUND;
+}
+
+bool MultiConnectionProductManager::updateProductStock(int id, int stock_quantity) {
+    WorkloadCapture::Call capture(WorkloadOp::UPDATE_PRODUCT_STOCK, id, stock_quantity);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
+    
+    // 本次写入覆盖库存，挂起的增量随之合并（见unappliedStock）
+    int unapplied = unappliedStock(id);
+    
+    sqlite3_reset(update_stock_stmt_);
+    sqlite3_bind_int64(update_stock_stmt_, 1, static_cast<sqlite3_int64>(stock_quantity) - unapplied);
+    sqlite3_bind_int(update_stock_stmt_, 2, id);
+    
+    int result = sqlite3_step(update_stock_stmt_);
+    if (result != SQLITE_DONE || sqlite3_changes(db_connection_) == 0) {
+        return false;
+    }
+    settleStock(id);
+    return true;
+}
+
+bool MultiConnectionProductManager::updateProductPrice(int id, double price) {
+    WorkloadCapture::Call capture(WorkloadOp::UPDATE_PRODUCT_PRICE, id, price);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
+    
+    sqlite3_reset(update_price_stmt_);
+    sqlite3_bind_double(update_price_stmt_, 1, price);
+    sqlite3_bind_int(update_price_stmt_, 2, id);
+    
+    int result = sqlite3_step(update_price_stmt_);
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
+}
+
+bool MultiConnectionProductManager::deleteProduct(int id) {
+    WorkloadCapture::Call capture(WorkloadOp::DELETE_PRODUCT, id);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
+    
+    sqlite3_reset(delete_stmt_);
+    sqlite3_bind_int(delete_stmt_, 1, id);
+    
+    int result = sqlite3_step(delete_stmt_);
+    if (result != SQLITE_DONE || sqlite3_changes(db_connection_) == 0) {
+        return false;
+    }
+    // 删除已提交时挂起的库存增量不再有意义；调用方事务中保留，事务回滚后仍需落盘，
+    // 提交后落盘时更新不到行，随下次落盘清除
+    if (sqlite3_get_autocommit(db_connection_)) {
+        pending_stock_deltas_.erase(id);
+    }
+    return true;
+}
+
+bool MultiConnectionProductManager::increaseStock(int id, int quantity) {
+    WorkloadCapture::Call capture(WorkloadOp::INCREASE_STOCK, id, quantity);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
+    
+    if (stock_coalescing_.load(std::memory_order_relaxed)) {
+        if (getStockQuantity(id) < 0) {
+            return false; // 产品不存在
+        }
+        pending_stock_deltas_[id] += quantity;
+        return true;
+    }
+    
+    sqlite3_reset(increase_stock_stmt_);
+    sqlite3_bind_int(increase_stock_stmt_, 1, quantity);
+    sqlite3_bind_int(increase_stock_stmt_, 2, id);
+    
+    int result = sqlite3_step(increase_stock_stmt_);
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
+}
+
+bool MultiConnectionProductManager::decreaseStock(int id, int quantity) {
+    WorkloadCapture::Call capture(WorkloadOp::DECREASE_STOCK, id, quantity);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
+    
+    if (stock_coalescing_.load(std::memory_order_relaxed)) {
+        // 可用库存 = 已落盘库存 + 挂起增量，与直接执行的条件UPDATE语义一致
+        int available = getStockQuantity(id);
+        if (available < quantity) {
+            return false;
+        }
+        pending_stock_deltas_[id] -= quantity;
+        return true;
+    }
+    
+    sqlite3_reset(decrease_stock_stmt_);
+    sqlite3_bind_int(decrease_stock_stmt_, 1, quantity);
+    sqlite3_bind_int(decrease_stock_stmt_, 2, id);
+    sqlite3_bind_int(decrease_stock_stmt_, 3, quantity);
+    
+    int result = sqlite3_step(decrease_stock_stmt_);
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
+}
+
+int MultiConnectionProductManager::getStockQuantity(int id) {
+    WorkloadCapture::Call capture(WorkloadOp::GET_STOCK_QUANTITY, id);
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    
+    sqlite3_reset(get_stock_stmt_);
+    sqlite3_bind_int(get_stock_stmt_, 1, id);
+    
+    if (sqlite3_step(get_stock_stmt_) == SQLITE_ROW) {
+        int stock = sqlite3_column_int(get_stock_stmt_, 0);
+        auto pending = pending_stock_deltas_.find(id);
+        return pending == pending_stock_deltas_.end() ? stock : stock + pending->second;
+    }
+    
+    return -1; // 产品不存在
+}
+
+int MultiConnectionProductManager::reservedStock(int id) {
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    auto pending = pending_stock_deltas_.find(id);
+    // 挂起的净增加量尚未落盘，不能提供给其他写入者
+    return pending == pending_stock_deltas_.end() || pending->second >= 0 ? 0 : -pending->second;
+}
+
+int MultiConnectionProductManager::unappliedStock(int id) const {
+    auto pending = pending_stock_deltas_.find(id);
+    if (pending == pending_stock_deltas_.end()) {
+        return 0;
+    }
+    // 自动提交模式下写入即覆盖挂起的增量，写入成功后丢弃增量，不单独落盘（落盘会递增
+    // version，使同一次调用中的按版本条件更新必然冲突）。调用方事务中写入"目标库存 - 增量"，
+    // 增量保留，提交后落盘与之相加恰为目标库存，回滚时增量与原库存一并保留
+    return sqlite3_get_autocommit(db_connection_) ? 0 : pending->second;
+}
+
+void MultiConnectionProductManager::settleStock(int id) {
+    if (sqlite3_get_autocommit(db_connection_)) {
+        pending_stock_deltas_.erase(id);
+    }
+}
+
+bool MultiConnectionProductManager::flushPendingStock() {
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
+    return flushPendingStockLocked();
+}
+
+bool MultiConnectionProductManager::flushPendingStockLocked() {
+    if (pending_stock_deltas_.empty()) {
+        return true;
+    }
+    // 在调用方事务中落盘后清空增量，事务回滚时增量即丢失
+    if (!sqlite3_get_autocommit(db_connection_)) {
+        return false;
+    }
+    
+    // 所有产品的增量在同一事务内落盘，每个产品一条UPDATE
+    TransactionScope transaction(db_connection_);
+    if (!transaction.active()) {
+        return false;
+    }
+    
+    for (const auto& pending : pending_stock_deltas_) {
+        if (pending.second == 0) {
+            continue; // 增减相抵，无需写入
+        }
+        sqlite3_reset(increase_stock_stmt_);
+        sqlite3_bind_int(increase_stock_stmt_, 1, pending.second);
+        sqlite3_bind_int(increase_stock_stmt_, 2, pending.first);
+        if (sqlite3_step(increase_stock_stmt_) != SQLITE_DONE) {
+            return false; // 作用域析构时回滚，增量保留到下次落盘
+        }
+    }
+    
+    if (!transaction.commit()) {
+        return false;
+    }
+    pending_stock_deltas_.clear();
+    return true;
+}
+
+void MultiConnectionProductManager::enableStockCoalescing(int flush_interval_ms) {
+    std::lock_guard<std::mutex> lock(flusher_mutex_);
+    if (stock_coalescing_.load()) {
+        return;
+    }
+    flusher_stop_ = false;
+    stock_coalescing_.store(true);
+    stock_flusher_ = std::thread(&MultiConnectionProductManager::stockFlusherLoop, this, flush_interval_ms);
+}
+
+void MultiConnectionProductManager::disableStockCoalescing() {
+    {
+        std::lock_guard<std::mutex> lock(flusher_mutex_);
+        if (!stock_coalescing_.load()) {
+            return;
+        }
+        flusher_stop_ = true;
+    }
+    flusher_cv_.notify_all();
+    stock_flusher_.join();
+    
+    // 停止合并与落盘剩余增量在同一次准入内完成，之后的调用直接写库。准入被拒绝时重试，
+    // 不能在增量仍挂起时关闭合并（之后再无后台落盘）
+    while (true) {
+        AdmissionController::WriteGuard write(admission_, operation_mutex_);
+        if (!write.admitted()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            continue;
+        }
+        stock_coalescing_.store(false);
+        if (!flushPendingStockLocked()) {
+            std::cerr << "库存增量落盘失败，剩余 " << pending_stock_deltas_.size() << " 个产品未写入" << std::endl;
+        }
+        return;
+    }
+}
+
+void MultiConnectionProductManager::stockFlusherLoop(int flush_interval_ms) {
+    std::unique_lock<std::mutex> lock(flusher_mutex_);
+    while (!flusher_stop_) {
+        flusher_cv_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms));
+        if (flusher_stop_) {
+            break;
+        }
+        lock.unlock();
+        flushPendingStock();
+        lock.lock();
+    }
+}
+
+bool MultiConnectionProductManager::createProductsTransaction(const std::vector<std::tuple<std::string, std::string, double, int>>& products) {
+    WorkloadCapture::Call capture(WorkloadOp::CREATE_PRODUCTS_TRANSACTION, products);
+    // 批量操作走批量通道，交互式写入优先准入
+    AdmissionController::WriteGuard write(admission_, operation_mutex_, AdmissionPriority::BATCH);
+    if (!write.admitted()) {
+        return false;
+    }
+    
+    // 开始事务（调用方已在事务中时使用保存点）
+    TransactionScope transaction(db_connection_);
+    if (!transaction.active()) {
+        return false;
+    }
+    
+    // 批量插入产品
+    for (const auto& product_tuple : products) {
+        sqlite3_reset(insert_stmt_);
+        sqlite3_bind_text(insert_stmt_, 1, std::get<0>(product_tuple).c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(insert_stmt_, 2, std::get<1>(product_tuple).c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_double(insert_stmt_, 3, std::get<2>(product_tuple));
+        sqlite3_bind_int(insert_stmt_, 4, std::get<3>(product_tuple));
+        
+        if (sqlite3_step(insert_stmt_) != SQLITE_DONE) {
+            return false; // 作用域析构时回滚
+        }
+    }
+    
+    // 提交事务（嵌套时释放保存点，由外层事务统一提交）
+    return transaction.commit();
+}
+
+std::size_t MultiConnectionProductManager::importProducts(const std::vector<std::tuple<std::string, std::string, double, int>>& products, std::size_t chunk_rows) {
+    WorkloadCapture::Call capture(WorkloadOp::IMPORT_PRODUCTS, products, static_cast<std::uint64_t>(chunk_rows));
+    // 分块提交，块间让出连接给交互式写入
+    return writeInChunks(admission_, operation_mutex_, db_connection_, products, chunk_rows,
+        [this](const std::tuple<std::string, std::string, double, int>& product_tuple) {
+        sqlite3_reset(insert_stmt_);
+        sqlite3_bind_text(insert_stmt_, 1, std::get<0>(product_tuple).c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(insert_stmt_, 2, std::get<1>(product_tuple).c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_double(insert_stmt_, 3, std::get<2>(product_tuple));
+        sqlite3_bind_int(insert_stmt_, 4, std::get<3>(product_tuple));
+        return sqlite3_step(insert_stmt_) == SQLITE_DONE;
+        });
+}
+
+bool MultiConnectionProductManager::updateStockTransaction(const std::vector<std::pair<int, int>>& stock_updates) {
+    WorkloadCapture::Call capture(WorkloadOp::UPDATE_STOCK_TRANSACTION, stock_updates);
+    // 批量操作走批量通道，交互式写入优先准入
+    AdmissionController::WriteGuard write(admission_, operation_mutex_, AdmissionPriority::BATCH);
+    if (!write.admitted()) {
+        return false;
+    }
+    
+    // 挂起的库存增量先于本批写入生效；调用方事务中不落盘，按增量修正写入值（见unappliedStock）
+    if (sqlite3_get_autocommit(db_connection_) && !flushPendingStockLocked()) {
+        return false;
+    }
+    
+    // 开始事务（调用方已在事务中时使用保存点）
+    TransactionScope transaction(db_connection_);
+    if (!transaction.active()) {
+        return false;
+    }
+    
+    // 批量更新库存
+    for (const auto& stock_pair : stock_updates) {
+        auto pending = pending_stock_deltas_.find(stock_pair.first);
+        sqlite3_int64 stock = stock_pair.second;
+        if (pending != pending_stock_deltas_.end()) {
+            stock -= pending->second;
+        }
+        sqlite3_reset(update_stock_stmt_);
+        sqlite3_bind_int64(update_stock_stmt_, 1, stock);
+        sqlite3_bind_int(update_stock_stmt_, 2, stock_pair.first);
+        
+        if (sqlite3_step(update_stock_stmt_) != SQLITE_DONE) {
+            return false; // 作用域析构时回滚
+        }
+    }
+    
+    // 提交事务（嵌套时释放保存点，由外层事务统一提交）
+    return transaction.commit();
+}
 
 void MultiConnectionProductManager::performanceTest(int thread_count, int operations_per_thread) {
     std::cout << "\n=== 产品管理器性能测试 ===" << std::endl;
@@ -1,20 +1,17 @@
 #pragma once
 
 #include "multi_connection_database_manager.h"
+#include "models.h"
+#include "result_cache.h"
+#include "epoch_reclaimer.h"
 #include <vector>
 #include <string>
 #include <memory>
 #include <mutex>
-
-struct Product {
-    int id;
-    std::string name;
-    std::string description;
-    double price;
-    int stock_quantity;
-    std::string created_at;
-    std::string updated_at;
-};
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <unordered_map>
 
 class MultiConnectionProductManager {
 public:
@@ -31,6 +28,10 @@ public:
     Product getProductByName(const std::string& name);
     bool updateProduct(int id, const std::string& name, const std::string& description, 
                       double price, int stock_quantity);
+    // 乐观并发更新：仅当当前版本等于expected_version时写入，否则返回CONFLICT
+    UpdateResult updateProductIfVersion(int id, int expected_version,
+                                        const std::string& name, const std::string& description,
+                                        double price, int stock_quantity);
     bool updateProductStock(int id, int stock_quantity);
     bool updateProductPrice(int id, double price);
     bool deleteProduct(int id);
@@ -40,8 +41,35 @@ public:
     bool decreaseStock(int id, int quantity);
     int getStockQuantity(int id);
     
+    // 库存写合并（可选）：启用后increaseStock/decreaseStock只在内存中累计每个产品的
+    // 增量，由后台线程每隔flush_interval_ms毫秒以每产品一条UPDATE落盘。
+    // 扣减时以"当前库存 + 挂起增量"校验，挂起的净扣减量作为预留余额，
+    // 绕过合并的写入（如下单）须通过reservedStock()扣除，保证库存不为负。
+    // 合并的增量独立于调用方的事务落盘，需要原子性的场景应使用批量操作或下单。
+    // 增量只在自动提交模式下落盘，调用方事务中flushPendingStock()返回false
+    // （落盘后事务回滚会连同增量一起撤销），由后台线程在事务外落盘。
+    void enableStockCoalescing(int flush_interval_ms = 5);
+    void disableStockCoalescing();
+    bool flushPendingStock();
+    // 尚未落盘的净扣减量，调用方需持有产品库连接互斥量
+    int reservedStock(int id);
+    
+    // 有界陈旧读（可选）：启用后列表查询（getAllProducts、getProductsByPriceRange、
+    // getProductsInStock）改在快照读者上执行，不再与写入者竞争连接互斥量，
+    // 结果可能落后至多max_staleness_ms毫秒，且不含尚未落盘的合并库存增量。
+    // 按ID、名称的单行查询始终读取最新数据
+    void enableSnapshotReads(int max_staleness_ms = 200);
+    void disableSnapshotReads();
+    
+    // 查询结果缓存（可选）：getProductsByPriceRange与getProductsInStock的结果按
+    // 语句与参数缓存，任何对产品表的写入都会使其失效；命中时不获取连接互斥量
+    void enableResultCache(std::size_t capacity_bytes = 4 * 1024 * 1024);
+    void disableResultCache();
+    
     // 批量操作
     bool createProductsTransaction(const std::vector<std::tuple<std::string, std::string, double, int>>& products);
+    // 大批量导入：按chunk_rows分块提交，不具备整体原子性，返回已提交的行数
+    std::size_t importProducts(const std::vector<std::tuple<std::string, std::string, double, int>>& products, std::size_t chunk_rows = 1000);
     bool updateStockTransaction(const std::vector<std::pair<int, int>>& stock_updates);
     
     // 性能测试方法
@@ -54,9 +82,21 @@ private:
     
     void prepareStatements();
     void finalizeStatements();
+    static Product readProduct(sqlite3_stmt* stmt);
+    // 覆盖库存的写入与挂起增量的合并：写入值减去unappliedStock()，写入成功后settleStock()
+    int unappliedStock(int id) const;
+    void settleStock(int id);
+    bool flushPendingStockLocked();
+    void stockFlusherLoop(int flush_interval_ms);
+    template <typename Bind>
+    bool readSnapshot(const std::string& key, sqlite3_stmt* primary_stmt, Bind bind, std::vector<Product>& products);
     
-    std::shared_ptr<sqlite3> db_connection_;
-    std::mutex operation_mutex_;
+    // 借用的连接句柄，不持有所有权，生命周期由数据库管理器保证
+    sqlite3* db_connection_;
+    // 连接互斥量由数据库管理器持有，与分布式事务共享
+    std::recursive_mutex& operation_mutex_;
+    // 写入准入控制器，按到达顺序排队、过载时拒绝
+    AdmissionController& admission_;
     
     // 预编译的SQL语句
     sqlite3_stmt* insert_stmt_;
@@ -72,6 +112,21 @@ private:
     sqlite3_stmt* increase_stock_stmt_;
     sqlite3_stmt* decrease_stock_stmt_;
     sqlite3_stmt* get_stock_stmt_;
+    sqlite3_stmt* update_if_version_stmt_;
+    sqlite3_stmt* get_version_stmt_;
+    
+    // 挂起的库存增量（产品ID -> 净增量），受operation_mutex_保护
+    std::unordered_map<int, int> pending_stock_deltas_;
+    std::atomic<bool> stock_coalescing_;
+    std::thread stock_flusher_;
+    std::mutex flusher_mutex_;
+    std::condition_variable flusher_cv_;
+    bool flusher_stop_;
+    
+    // 快照读者，为空表示未启用；以std::atomic_load/atomic_store访问
+    std::shared_ptr<SnapshotReader> snapshot_reader_;
+    // 查询结果缓存，为空表示未启用；查询在EpochReclaimer::Guard内加载，停用或替换后旧缓存退役
+    std::atomic<QueryResultCache*> result_cache_;
     
     static std::once_flag initialized_;
     static std::unique_ptr<MultiConnectionProductManager> instance_;
@@ -1,9 +1,20 @@
 #include "multi_connection_user_manager.h"
+#include "transaction_scope.h"
+#include "chunked_batch.h"
+#include "workload_capture.h"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <chrono>
 #include <random>
 
+namespace {
+
+// 用户目录中被替换记录超过该字节数且过半时重新加载
+const std::size_t kDirectoryCompactionBytes = 4 * 1024 * 1024;
+
+}  // namespace
+
 std::once_flag MultiConnectionUserManager::initialized_;
 std::unique_ptr<MultiConnectionUserManager> MultiConnectionUserManager::instance_;
 
@@ -15,43 +26,87 @@ MultiConnectionUserManager& MultiConnectionUserManager::getInstance() {
 }
 
 MultiConnectionUserManager::MultiConnectionUserManager() 
-    : db_connection_(MultiConnectionDatabaseManager::getInstance().getConnection(MultiConnectionDatabaseManager::TableType::USERS)),
+    : db_connection_(MultiConnectionDatabaseManager::getInstance().borrowConnection(MultiConnectionDatabaseManager::TableType::USERS)),
+      operation_mutex_(MultiConnectionDatabaseManager::getInstance().connectionMutex(MultiConnectionDatabaseManager::TableType::USERS)),
+      admission_(MultiConnectionDatabaseManager::getInstance().admissionController(MultiConnectionDatabaseManager::TableType::USERS)),
       insert_stmt_(nullptr), select_all_stmt_(nullptr), 
       select_by_id_stmt_(nullptr), select_by_username_stmt_(nullptr),
-      update_stmt_(nullptr), delete_stmt_(nullptr) {
+      update_stmt_(nullptr), delete_stmt_(nullptr),
+      update_if_version_stmt_(nullptr), get_version_stmt_(nullptr),
+      username_exists_stmt_(nullptr), email_exists_stmt_(nullptr), select_names_stmt_(nullptr),
+      select_ids_stmt_(nullptr), name_filter_(nullptr), filter_names_(0), retired_names_(0), name_filter_stale_(false),
+      user_directory_(nullptr), user_ids_(nullptr), indexes_behind_(false) {
     prepareStatements();
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    rebuildNameFilter();
 }
 
 MultiConnectionUserManager::~MultiConnectionUserManager() {
     finalizeStatements();
+    delete user_directory_.load();
+    delete user_ids_.load();
+    delete name_filter_.load();
 }
 
 void MultiConnectionUserManager::prepareStatements() {
-    auto db = db_connection_.get();
+    auto db = db_connection_;
     
     // 准备插入语句
     const char* insert_sql = "INSERT INTO users (username, email) VALUES (?, ?)";
     sqlite3_prepare_v2(db, insert_sql, -1, &insert_stmt_, nullptr);
     
     // 准备查询所有用户语句
-    const char* select_all_sql = "SELECT id, username, email, created_at, updated_at FROM users ORDER BY id";
+    const char* select_all_sql = "SELECT id, username, email, created_at, updated_at, version FROM users ORDER BY id";
     sqlite3_prepare_v2(db, select_all_sql, -1, &select_all_stmt_, nullptr);
     
     // 准备根据ID查询语句
-    const char* select_by_id_sql = "SELECT id, username, email, created_at, updated_at FROM users WHERE id = ?";
+    const char* select_by_id_sql = "SELECT id, username, email, created_at, updated_at, version FROM users WHERE id = ?";
     sqlite3_prepare_v2(db, select_by_id_sql, -1, &select_by_id_stmt_, nullptr);
     
     // 准备根据用户名查询语句
-    const char* select_by_username_sql = "SELECT id, username, email, created_at, updated_at FROM users WHERE username = ?";
+    const char* select_by_username_sql = "SELECT id, username, email, created_at, updated_at, version FROM users WHERE username = ?";
     sqlite3_prepare_v2(db, select_by_username_sql, -1, &select_by_username_stmt_, nullptr);
     
-    // 准备更新语句
-    const char* update_sql = "UPDATE users SET username = ?, email = ?, updated_at = CURRENT_TIMESTAMP WHERE id = ?";
+    // 准备更新语句（所有写语句都递增version）
+    const char* update_sql = "UPDATE users SET username = ?, email = ?, version = version + 1, updated_at = CURRENT_TIMESTAMP WHERE id = ?";
     sqlite3_prepare_v2(db, update_sql, -1, &update_stmt_, nullptr);
     
+    // 准备按版本条件更新语句（比较并交换）
+    const char* update_if_version_sql = "UPDATE users SET username = ?, email = ?, version = version + 1, updated_at = CURRENT_TIMESTAMP WHERE id = ? AND version = ?";
+    sqlite3_prepare_v2(db, update_if_version_sql, -1, &update_if_version_stmt_, nullptr);
+    
+    // 准备获取版本语句（区分版本冲突与记录不存在）
+    const char* get_version_sql = "SELECT version FROM users WHERE id = ?";
+    sqlite3_prepare_v2(db, get_version_sql, -1, &get_version_stmt_, nullptr);
+    
     // 准备删除语句
     const char* delete_sql = "DELETE FROM users WHERE id = ?";
     sqlite3_prepare_v2(db, delete_sql, -1, &delete_stmt_, nullptr);
+    
+    // 准备用户名、邮箱存在性探测语句（只访问唯一索引）
+    const char* username_exists_sql = "SELECT 1 FROM users WHERE username = ?";
+    sqlite3_prepare_v2(db, username_exists_sql, -1, &username_exists_stmt_, nullptr);
+    const char* email_exists_sql = "SELECT 1 FROM users WHERE email = ?";
+    sqlite3_prepare_v2(db, email_exists_sql, -1, &email_exists_stmt_, nullptr);
+    
+    // 准备重建过滤器的全量名称扫描语句
+    const char* select_names_sql = "SELECT username, email FROM users";
+    sqlite3_prepare_v2(db, select_names_sql, -1, &select_names_stmt_, nullptr);
+    
+    // 准备加载用户id集合的语句（按主键顺序，最后一行即最大id）
+    const char* select_ids_sql = "SELECT id FROM users ORDER BY id";
+    sqlite3_prepare_v2(db, select_ids_sql, -1, &select_ids_stmt_, nullptr);
+}
+
+User MultiConnectionUserManager::readUser(sqlite3_stmt* stmt) {
+    User user;
+    user.id = sqlite3_column_int(stmt, 0);
+    user.username = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    user.email = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+    user.created_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+    user.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 4));
+    user.version = sqlite3_column_int(stmt, 5);
+    return user;
 }
 
 void MultiConnectionUserManager::finalizeStatements() {
@@ -61,76 +116,370 @@ void MultiConnectionUserManager::finalizeStatements() {
     if (select_by_username_stmt_) sqlite3_finalize(select_by_username_stmt_);
     if (update_stmt_) sqlite3_finalize(update_stmt_);
     if (delete_stmt_) sqlite3_finalize(delete_stmt_);
+    if (update_if_version_stmt_) sqlite3_finalize(update_if_version_stmt_);
+    if (get_version_stmt_) sqlite3_finalize(get_version_stmt_);
+    if (username_exists_stmt_) sqlite3_finalize(username_exists_stmt_);
+    if (email_exists_stmt_) sqlite3_finalize(email_exists_stmt_);
+    if (select_names_stmt_) sqlite3_finalize(select_names_stmt_);
+    if (select_ids_stmt_) sqlite3_finalize(select_ids_stmt_);
+}
+
+void MultiConnectionUserManager::rebuildNameFilter() {
+    std::vector<std::pair<std::string, std::string>> names;
+    sqlite3_reset(select_names_stmt_);
+    while (sqlite3_step(select_names_stmt_) == SQLITE_ROW) {
+        names.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(select_names_stmt_, 0)),
+                           reinterpret_cast<const char*>(sqlite3_column_text(select_names_stmt_, 1)));
+    }
+    sqlite3_reset(select_names_stmt_);
+    
+    // 预留一倍余量，避免注册高峰期频繁重建
+    BlockedBloomFilter* filter = new BlockedBloomFilter(std::max<std::size_t>(names.size() * 4, 4096));
+    for (const auto& name : names) {
+        filter->insert(name.first, 0);
+        filter->insert(name.second, 1);
+    }
+    filter_names_ = names.size() * 2;
+    retired_names_ = 0;
+    name_filter_stale_ = false;
+    BlockedBloomFilter* previous = name_filter_.exchange(filter);
+    if (previous) {
+        EpochReclaimer::getInstance().retire(previous);
+    }
+}
+
+void MultiConnectionUserManager::addNames(const std::string& username, const std::string& email) {
+    if (filter_names_ + 2 > name_filter_.load()->capacity()) {
+        name_filter_stale_ = true;
+    }
+    // 事务中超出容量时继续插入，只抬高假阳性率，不会漏报
+    if (name_filter_stale_ && sqlite3_get_autocommit(db_connection_)) {
+        rebuildNameFilter();
+    }
+    BlockedBloomFilter* filter = name_filter_.load();
+    filter->insert(username, 0);
+    filter->insert(email, 1);
+    filter_names_ += 2;
+}
+
+void MultiConnectionUserManager::retireNames() {
+    retired_names_ += 2;
+    // 过半名称已失效时假阳性明显上升，按当前表内容重建
+    if (retired_names_ * 2 > filter_names_) {
+        name_filter_stale_ = true;
+    }
+    // 外层事务中的表内容含未提交的删除，按其重建会在回滚后漏掉仍存在的名称
+    if (name_filter_stale_ && sqlite3_get_autocommit(db_connection_)) {
+        rebuildNameFilter();
+    }
+}
+
+bool MultiConnectionUserManager::nameExists(sqlite3_stmt* exists_stmt, const std::string& value) {
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    sqlite3_reset(exists_stmt);
+    sqlite3_bind_text(exists_stmt, 1, value.c_str(), -1, SQLITE_STATIC);
+    bool exists = sqlite3_step(exists_stmt) == SQLITE_ROW;
+    sqlite3_reset(exists_stmt);
+    return exists;
+}
+
+bool MultiConnectionUserManager::isUsernameAvailable(const std::string& username) {
+    WorkloadCapture::Call capture(WorkloadOp::IS_USERNAME_AVAILABLE, username);
+    {
+        EpochReclaimer::Guard guard;
+        if (!name_filter_.load(std::memory_order_acquire)->mayContain(username, 0)) {
+            return true;
+        }
+    }
+    return !nameExists(username_exists_stmt_, username);
+}
+
+bool MultiConnectionUserManager::isEmailAvailable(const std::string& email) {
+    WorkloadCapture::Call capture(WorkloadOp::IS_EMAIL_AVAILABLE, email);
+    {
+        EpochReclaimer::Guard guard;
+        if (!name_filter_.load(std::memory_order_acquire)->mayContain(email, 1)) {
+            return true;
+        }
+    }
+    return !nameExists(email_exists_stmt_, email);
+}
+
+void MultiConnectionUserManager::enableUserDirectory() {
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    std::vector<User> users;
+    sqlite3_reset(select_all_stmt_);
+    while (sqlite3_step(select_all_stmt_) == SQLITE_ROW) {
+        users.push_back(readUser(select_all_stmt_));
+    }
+    sqlite3_reset(select_all_stmt_);
+    
+    UserDirectory* directory = new UserDirectory(users.size());
+    for (const auto& user : users) {
+        directory->put(user);
+    }
+    UserDirectory* previous = user_directory_.exchange(directory);
+    if (previous) {
+        EpochReclaimer::getInstance().retire(previous);
+    }
+    // 待同步的id可能也属于用户id集合，由同步统一处理
+    syncUserIndexes();
+}
+
+void MultiConnectionUserManager::disableUserDirectory() {
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    UserDirectory* previous = user_directory_.exchange(nullptr);
+    if (previous) {
+        EpochReclaimer::getInstance().retire(previous);
+    }
+    syncUserIndexes();
+}
+
+void MultiConnectionUserManager::enableUserIdSet() {
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    std::vector<int> ids;
+    sqlite3_reset(select_ids_stmt_);
+    while (sqlite3_step(select_ids_stmt_) == SQLITE_ROW) {
+        ids.push_back(sqlite3_column_int(select_ids_stmt_, 0));
+    }
+    sqlite3_reset(select_ids_stmt_);
+    
+    UserIdSet* user_ids = new UserIdSet(ids.empty() ? 0 : ids.back());
+    for (int id : ids) {
+        user_ids->insert(id);
+    }
+    UserIdSet* previous = user_ids_.exchange(user_ids);
+    if (previous) {
+        EpochReclaimer::getInstance().retire(previous);
+    }
+    syncUserIndexes();
+}
+
+void MultiConnectionUserManager::disableUserIdSet() {
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    UserIdSet* previous = user_ids_.exchange(nullptr);
+    if (previous) {
+        EpochReclaimer::getInstance().retire(previous);
+    }
+    syncUserIndexes();
+}
+
+bool MultiConnectionUserManager::userExistsInTable(int id) {
+    sqlite3_reset(get_version_stmt_);
+    sqlite3_bind_int(get_version_stmt_, 1, id);
+    bool exists = sqlite3_step(get_version_stmt_) == SQLITE_ROW;
+    sqlite3_reset(get_version_stmt_);
+    return exists;
+}
+
+bool MultiConnectionUserManager::userExists(int id) {
+    return usersExist(std::vector<int>(1, id));
+}
+
+bool MultiConnectionUserManager::usersExist(const std::vector<int>& ids) {
+    {
+        EpochReclaimer::Guard guard;
+        UserIdSet* user_ids = user_ids_.load(std::memory_order_acquire);
+        if (user_ids && !indexes_behind_.load()) {
+            for (int id : ids) {
+                if (!user_ids->contains(id)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+    // 在本连接上探测：调用方所在的外层事务中尚未提交的用户同样可见
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    syncUserIndexes();
+    for (int id : ids) {
+        if (!userExistsInTable(id)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MultiConnectionUserManager::noteUserWrite(int id) {
+    if (!user_directory_.load(std::memory_order_relaxed) && !user_ids_.load(std::memory_order_relaxed)) {
+        return;
+    }
+    pending_ids_.push_back(id);
+    indexes_behind_.store(true);
+}
+
+void MultiConnectionUserManager::syncUserIndexes() {
+    if (pending_ids_.empty()) {
+        return;
+    }
+    UserDirectory* directory = user_directory_.load(std::memory_order_relaxed);
+    UserIdSet* user_ids = user_ids_.load(std::memory_order_relaxed);
+    if (!directory && !user_ids) {
+        pending_ids_.clear();
+        indexes_behind_.store(false);
+        return;
+    }
+    // 外层事务尚未结束，写入可能回滚，等事务结束后再同步
+    if (!sqlite3_get_autocommit(db_connection_)) {
+        return;
+    }
+    
+    // 以表中已提交的行为准：存在则覆盖，已不存在（删除或回滚）则移除
+    for (int id : pending_ids_) {
+        sqlite3_reset(select_by_id_stmt_);
+        sqlite3_bind_int(select_by_id_stmt_, 1, id);
+        bool exists = sqlite3_step(select_by_id_stmt_) == SQLITE_ROW;
+        if (directory) {
+            if (exists) {
+                directory->put(readUser(select_by_id_stmt_));
+            } else {
+                directory->erase(id);
+            }
+        }
+        if (user_ids) {
+            if (exists) {
+                user_ids->insert(id);
+            } else {
+                user_ids->erase(id);
+            }
+        }
+    }
+    sqlite3_reset(select_by_id_stmt_);
+    pending_ids_.clear();
+    indexes_behind_.store(false);
+    
+    // 被替换的记录过多时整体重新加载，旧目录退役
+    if (directory && directory->garbageBytes() > kDirectoryCompactionBytes &&
+        directory->garbageBytes() * 2 > directory->memoryBytes()) {
+        enableUserDirectory();
+    }
 }
 
 bool MultiConnectionUserManager::createUser(const std::string& username, const std::string& email) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::CREATE_USER, username, email);
+    // 过滤器命中时先以只读探测确认重复，重复注册不再开启写事务
+    bool username_seen;
+    bool email_seen;
+    {
+        EpochReclaimer::Guard guard;
+        BlockedBloomFilter* filter = name_filter_.load(std::memory_order_acquire);
+        username_seen = filter->mayContain(username, 0);
+        email_seen = filter->mayContain(email, 1);
+    }
+    if ((username_seen && nameExists(username_exists_stmt_, username)) ||
+        (email_seen && nameExists(email_exists_stmt_, email))) {
+        return false;
+    }
+    
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
+    addNames(username, email);
     
     sqlite3_reset(insert_stmt_);
     sqlite3_bind_text(insert_stmt_, 1, username.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_text(insert_stmt_, 2, email.c_str(), -1, SQLITE_STATIC);
     
     int result = sqlite3_step(insert_stmt_);
-    return result == SQLITE_DONE;
+    if (result != SQLITE_DONE) {
+        return false;
+    }
+    noteUserWrite(static_cast<int>(sqlite3_last_insert_rowid(db_connection_)));
+    syncUserIndexes();
+    return true;
+}
+
+void MultiConnectionUserManager::enableSnapshotReads(int max_staleness_ms) {
+    std::shared_ptr<SnapshotReader> reader = MultiConnectionDatabaseManager::getInstance().openSnapshotReader(
+        MultiConnectionDatabaseManager::TableType::USERS, std::chrono::milliseconds(max_staleness_ms));
+    std::atomic_store(&snapshot_reader_, reader);
+}
+
+void MultiConnectionUserManager::disableSnapshotReads() {
+    std::atomic_store(&snapshot_reader_, std::shared_ptr<SnapshotReader>());
 }
 
 std::vector<User> MultiConnectionUserManager::getAllUsers() {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::GET_ALL_USERS);
     std::vector<User> users;
+    std::shared_ptr<SnapshotReader> reader = std::atomic_load(&snapshot_reader_);
+    if (reader && reader->read("all", [this](SnapshotReader::Session& session) {
+            sqlite3_stmt* stmt = session.statement(sqlite3_sql(select_all_stmt_));
+            std::vector<User> rows;
+            while (sqlite3_step(stmt) == SQLITE_ROW) {
+                rows.push_back(readUser(stmt));
+            }
+            return rows;
+        }, users)) {
+        return users;
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
     
     sqlite3_reset(select_all_stmt_);
     
     while (sqlite3_step(select_all_stmt_) == SQLITE_ROW) {
-        User user;
-        user.id = sqlite3_column_int(select_all_stmt_, 0);
-        user.username = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 1));
-        user.email = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 2));
-        user.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 3));
-        user.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 4));
-        users.push_back(user);
+        users.push_back(readUser(select_all_stmt_));
     }
     
     return users;
 }
 
 User MultiConnectionUserManager::getUserById(int id) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
-    User user = {0, "", "", "", ""};
+    WorkloadCapture::Call capture(WorkloadOp::GET_USER_BY_ID, id);
+    User user = {0, "", "", "", "", 0};
+    {
+        EpochReclaimer::Guard guard;
+        UserDirectory* directory = user_directory_.load(std::memory_order_acquire);
+        if (directory && !indexes_behind_.load()) {
+            directory->findById(id, user);
+            return user;
+        }
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    syncUserIndexes();
     
     sqlite3_reset(select_by_id_stmt_);
     sqlite3_bind_int(select_by_id_stmt_, 1, id);
     
     if (sqlite3_step(select_by_id_stmt_) == SQLITE_ROW) {
-        user.id = sqlite3_column_int(select_by_id_stmt_, 0);
-        user.username = reinterpret_cast<const char*>(sqlite3_column_text(select_by_id_stmt_, 1));
-        user.email = reinterpret_cast<const char*>(sqlite3_column_text(select_by_id_stmt_, 2));
-        user.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_id_stmt_, 3));
-        user.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_id_stmt_, 4));
+        user = readUser(select_by_id_stmt_);
     }
     
     return user;
 }
 
 User MultiConnectionUserManager::getUserByUsername(const std::string& username) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
-    User user = {0, "", "", "", ""};
+    WorkloadCapture::Call capture(WorkloadOp::GET_USER_BY_USERNAME, username);
+    User user = {0, "", "", "", "", 0};
+    {
+        EpochReclaimer::Guard guard;
+        UserDirectory* directory = user_directory_.load(std::memory_order_acquire);
+        if (directory && !indexes_behind_.load()) {
+            directory->findByUsername(username, user);
+            return user;
+        }
+    }
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    syncUserIndexes();
     
     sqlite3_reset(select_by_username_stmt_);
     sqlite3_bind_text(select_by_username_stmt_, 1, username.c_str(), -1, SQLITE_STATIC);
     
     if (sqlite3_step(select_by_username_stmt_) == SQLITE_ROW) {
-        user.id = sqlite3_column_int(select_by_username_stmt_, 0);
-        user.username = reinterpret_cast<const char*>(sqlite3_column_text(select_by_username_stmt_, 1));
-        user.email = reinterpret_cast<const char*>(sqlite3_column_text(select_by_username_stmt_, 2));
-        user.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_username_stmt_, 3));
-        user.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_username_stmt_, 4));
+        user = readUser(select_by_username_stmt_);
     }
     
     return user;
 }
 
 bool MultiConnectionUserManager::updateUser(int id, const std::string& username, const std::string& email) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::UPDATE_USER, id, username, email);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
+    addNames(username, email);
     
     sqlite3_reset(update_stmt_);
     sqlite3_bind_text(update_stmt_, 1, username.c_str(), -1, SQLITE_STATIC);
@@ -138,54 +487,129 @@ bool MultiConnectionUserManager::updateUser(int id, const std::string& username,
     sqlite3_bind_int(update_stmt_, 3, id);
     
     int result = sqlite3_step(update_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    bool updated = result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
+    if (updated) {
+        retireNames();
+        noteUserWrite(id);
+        syncUserIndexes();
+    }
+    return updated;
+}
+
+UpdateResult MultiConnectionUserManager::updateUserIfVersion(int id, int expected_version,
+                                                             const std::string& username, const std::string& email) {
+    WorkloadCapture::Call capture(WorkloadOp::UPDATE_USER_IF_VERSION, id, expected_version, username, email);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return UpdateResult::REJECTED;
+    }
+    addNames(username, email);
+    
+    // 单条UPDATE在自动提交模式下执行，写锁只在该语句期间持有
+    sqlite3_reset(update_if_version_stmt_);
+    sqlite3_bind_text(update_if_version_stmt_, 1, username.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(update_if_version_stmt_, 2, email.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(update_if_version_stmt_, 3, id);
+    sqlite3_bind_int(update_if_version_stmt_, 4, expected_version);
+    
+    if (sqlite3_step(update_if_version_stmt_) != SQLITE_DONE) {
+        return UpdateResult::FAILED;
+    }
+    if (sqlite3_changes(db_connection_) > 0) {
+        retireNames();
+        noteUserWrite(id);
+        syncUserIndexes();
+        return UpdateResult::UPDATED;
+    }
+    
+    // 未更新任何行：记录不存在或版本已被其他写入者推进
+    sqlite3_reset(get_version_stmt_);
+    sqlite3_bind_int(get_version_stmt_, 1, id);
+    return sqlite3_step(get_version_stmt_) == SQLITE_ROW ? UpdateResult::CONFLICT : UpdateResult::NOT_FOUND;
 }
 
 bool MultiConnectionUserManager::deleteUser(int id) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
+    WorkloadCapture::Call capture(WorkloadOp::DELETE_USER, id);
+    AdmissionController::WriteGuard write(admission_, operation_mutex_);
+    if (!write.admitted()) {
+        return false;
+    }
     
     sqlite3_reset(delete_stmt_);
     sqlite3_bind_int(delete_stmt_, 1, id);
     
     int result = sqlite3_step(delete_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    bool deleted = result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
+    if (deleted) {
+        // 立即移除：外层事务提交前也不再接受引用该用户的新订单，回滚时同步会加回
+        UserIdSet* user_ids = user_ids_.load(std::memory_order_relaxed);
+        if (user_ids) {
+            user_ids->erase(id);
+        }
+        retireNames();
+        noteUserWrite(id);
+        syncUserIndexes();
+    }
+    return deleted;
 }
 
 bool MultiConnectionUserManager::createUsersTransaction(const std::vector<std::pair<std::string, std::string>>& users) {
-    std::lock_guard<std::mutex> lock(operation_mutex_);
-    auto db = db_connection_.get();
-    
-    // 开始事务
-    char* error_msg = nullptr;
-    int result = sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
+    WorkloadCapture::Call capture(WorkloadOp::CREATE_USERS_TRANSACTION, users);
+    // 批量操作走批量通道，交互式写入优先准入
+    AdmissionController::WriteGuard write(admission_, operation_mutex_, AdmissionPriority::BATCH);
+    if (!write.admitted()) {
+        return false;
+    }
+    
+    // 开始事务（调用方已在事务中时使用保存点）
+    TransactionScope transaction(db_connection_);
+    if (!transaction.active()) {
         return false;
     }
     
     // 批量插入用户
     for (const auto& user_pair : users) {
+        addNames(user_pair.first, user_pair.second);
         sqlite3_reset(insert_stmt_);
         sqlite3_bind_text(insert_stmt_, 1, user_pair.first.c_str(), -1, SQLITE_STATIC);
         sqlite3_bind_text(insert_stmt_, 2, user_pair.second.c_str(), -1, SQLITE_STATIC);
         
         if (sqlite3_step(insert_stmt_) != SQLITE_DONE) {
-            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-            return false;
+            return false; // 作用域析构时回滚
         }
+        noteUserWrite(static_cast<int>(sqlite3_last_insert_rowid(db_connection_)));
     }
     
-    // 提交事务
-    result = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
-        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+    // 提交事务（嵌套时释放保存点，由外层事务统一提交）
+    if (!transaction.commit()) {
         return false;
     }
-    
+    syncUserIndexes();
     return true;
 }
 
+std::size_t MultiConnectionUserManager::importUsers(const std::vector<std::pair<std::string, std::string>>& users, std::size_t chunk_rows) {
+    WorkloadCapture::Call capture(WorkloadOp::IMPORT_USERS, users, static_cast<std::uint64_t>(chunk_rows));
+    // 分块提交，块间让出连接给交互式写入
+    std::size_t committed = writeInChunks(admission_, operation_mutex_, db_connection_, users, chunk_rows,
+        [this](const std::pair<std::string, std::string>& user_pair) {
+        addNames(user_pair.first, user_pair.second);
+        sqlite3_reset(insert_stmt_);
+        sqlite3_bind_text(insert_stmt_, 1, user_pair.first.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(insert_stmt_, 2, user_pair.second.c_str(), -1, SQLITE_STATIC);
+        if (sqlite3_step(insert_stmt_) != SQLITE_DONE) {
+            return false;
+        }
+        noteUserWrite(static_cast<int>(sqlite3_last_insert_rowid(db_connection_)));
+        return true;
+        });
+    
+    // 回滚的块中记录的id在同步时按表中不存在处理
+    std::lock_guard<std::recursive_mutex> lock(operation_mutex_);
+    syncUserIndexes();
+    return committed;
+}
+
 void MultiConnectionUserManager::performanceTest(int thread_count, int operations_per_thread) {
     std::cout << "\n=== 用户管理器性能测试 ===" << std::endl;
     std::cout << "线程数: " << thread_count << ", 每线程操作数: " << operations_per_thread << std::endl;
@@ -1,19 +1,17 @@
 #pragma once
 
 #include "multi_connection_database_manager.h"
+#include "models.h"
+#include "bloom_filter.h"
+#include "user_directory.h"
+#include "user_id_set.h"
+#include "epoch_reclaimer.h"
+#include <atomic>
 #include <vector>
 #include <string>
 #include <memory>
 #include <mutex>
 
-struct User {
-    int id;
-    std::string username;
-    std::string email;
-    std::string created_at;
-    std::string updated_at;
-};
-
 class MultiConnectionUserManager {
 public:
     static MultiConnectionUserManager& getInstance();
@@ -25,10 +23,41 @@ public:
     User getUserById(int id);
     User getUserByUsername(const std::string& username);
     bool updateUser(int id, const std::string& username, const std::string& email);
+    // 乐观并发更新：仅当当前版本等于expected_version时写入，否则返回CONFLICT
+    UpdateResult updateUserIfVersion(int id, int expected_version,
+                                     const std::string& username, const std::string& email);
     bool deleteUser(int id);
     
+    // 可用性检查：用户名与邮箱的布隆过滤器判定一定不存在时不访问SQLite，
+    // 否则以索引探测确认。结果只反映调用时刻，最终以createUser()的唯一约束为准
+    bool isUsernameAvailable(const std::string& username);
+    bool isEmailAvailable(const std::string& email);
+    
+    // 有界陈旧读（可选）：启用后getAllUsers()改在快照读者上执行，不再与写入者
+    // 竞争连接互斥量，结果可能落后至多max_staleness_ms毫秒。单行查询始终读取最新数据
+    void enableSnapshotReads(int max_staleness_ms = 200);
+    void disableSnapshotReads();
+    
+    // 内存常驻用户目录（可选）：启用时从users表全量加载，之后getUserById()与
+    // getUserByUsername()直接查目录，不获取连接互斥量。本管理器的写入提交后同步到目录；
+    // 绕过本管理器直接写入users表的变更需重新启用以加载
+    void enableUserDirectory();
+    void disableUserDirectory();
+    
+    // 用户id集合（可选），供订单等跨库引用校验使用：启用时从users表加载全部id，
+    // 之后由本管理器的写入路径维护。userExists()/usersExist()在集合已同步时为
+    // 无锁的O(1)查询，否则（未启用，或外层事务中有未提交的用户写入）回退到SQLite。
+    // 删除在语句执行时即从集合移除，新建在提交后才加入
+    void enableUserIdSet();
+    void disableUserIdSet();
+    bool userExists(int id);
+    // 全部存在时返回true；一次Guard或一次加锁完成整批检查
+    bool usersExist(const std::vector<int>& ids);
+    
     // 批量操作
     bool createUsersTransaction(const std::vector<std::pair<std::string, std::string>>& users);
+    // 大批量导入：按chunk_rows分块提交，不具备整体原子性，返回已提交的行数
+    std::size_t importUsers(const std::vector<std::pair<std::string, std::string>>& users, std::size_t chunk_rows = 1000);
     
     // 性能测试方法
     void performanceTest(int thread_count, int operations_per_thread);
@@ -41,9 +70,25 @@ private:
     // 预编译语句
     void prepareStatements();
     void finalizeStatements();
+    static User readUser(sqlite3_stmt* stmt);
     
-    std::shared_ptr<sqlite3> db_connection_;
-    std::mutex operation_mutex_;
+    // 用户名/邮箱过滤器维护，调用方需持有operation_mutex_
+    void rebuildNameFilter();
+    void addNames(const std::string& username, const std::string& email);
+    void retireNames();
+    bool nameExists(sqlite3_stmt* exists_stmt, const std::string& value);
+    
+    // 用户目录与用户id集合的同步，调用方需持有operation_mutex_
+    void noteUserWrite(int id);
+    void syncUserIndexes();
+    bool userExistsInTable(int id);
+    
+    // 借用的连接句柄，不持有所有权，生命周期由数据库管理器保证
+    sqlite3* db_connection_;
+    // 连接互斥量由数据库管理器持有，与分布式事务共享
+    std::recursive_mutex& operation_mutex_;
+    // 写入准入控制器，按到达顺序排队、过载时拒绝
+    AdmissionController& admission_;
     
     // 预编译的SQL语句
     sqlite3_stmt* insert_stmt_;
@@ -52,6 +97,35 @@ private:
     sqlite3_stmt* select_by_username_stmt_;
     sqlite3_stmt* update_stmt_;
     sqlite3_stmt* delete_stmt_;
+    sqlite3_stmt* update_if_version_stmt_;
+    sqlite3_stmt* get_version_stmt_;
+    sqlite3_stmt* username_exists_stmt_;
+    sqlite3_stmt* email_exists_stmt_;
+    sqlite3_stmt* select_names_stmt_;
+    sqlite3_stmt* select_ids_stmt_;
+    
+    // 用户名与邮箱的布隆过滤器：写入前先加入新名称，因此不会漏报；被删除或替换的
+    // 名称只造成假阳性，累计过多或超出设计容量时在写入路径上重建。重建按表内容进行，
+    // 外层事务中的删除可能回滚，因此只在自动提交模式下重建，事务中只记下待重建。
+    // 绕过本管理器直接写入users表的变更不会反映到过滤器中。
+    // 查询在EpochReclaimer::Guard内加载，重建后旧过滤器退役；计数受operation_mutex_保护
+    std::atomic<BlockedBloomFilter*> name_filter_;
+    std::size_t filter_names_;    // 已加入过滤器的名称数
+    std::size_t retired_names_;   // 已删除或被替换、仍留在过滤器中的名称数
+    bool name_filter_stale_;      // 需要重建，等外层事务结束后的下一次写入执行
+    
+    // 快照读者，为空表示未启用；以std::atomic_load/atomic_store访问
+    std::shared_ptr<SnapshotReader> snapshot_reader_;
+    
+    // 用户目录，为空表示未启用。查询在EpochReclaimer::Guard内加载，
+    // 停用或重新加载后旧目录退役
+    std::atomic<UserDirectory*> user_directory_;
+    // 用户id集合，为空表示未启用；加载与退役方式同用户目录
+    std::atomic<UserIdSet*> user_ids_;
+    // 已写入但尚未同步到目录与id集合的用户id，受operation_mutex_保护。外层事务
+    // 未结束时无法同步，期间indexes_behind_为true，查询回退到SQLite
+    std::vector<int> pending_ids_;
+    std::atomic<bool> indexes_behind_;
     
     static std::once_flag initialized_;
     static std::unique_ptr<MultiConnectionUserManager> instance_;
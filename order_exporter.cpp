@@ -0,0 +1,640 @@
+#include "order_exporter.h"
+#include "multi_connection_database_manager.h"
+#include <sqlite3.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+const char kColumnarMagic[8] = {'O', 'R', 'D', 'C', 'O', 'L', '1', '\n'};
+const char* const kCsvHeader = "id,user_id,total_amount,status,created_at,updated_at\n";
+const char* const kChunkSql =
+    "SELECT id, user_id, total_amount, status, created_at, updated_at FROM orders "
+    "WHERE id >= ? AND id < ? AND deleted = 0 ORDER BY id";
+
+// 时间列的编码标记
+const char kTimeSeconds = 0;
+const char kTimeText = 1;
+// 每行至少占用的块体字节数：id、user_id、状态下标各1字节，金额8字节，两个时间列各1字节
+const std::size_t kMinRowBytes = 13;
+
+void putU32(std::string& out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void putVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putSigned(std::string& out, std::int64_t value) {
+    putVarint(out, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+}
+
+void putText(std::string& out, const std::string& text) {
+    putVarint(out, text.size());
+    out.append(text);
+}
+
+// 解码游标：越界时置failed，之后的读取均返回零值
+struct Reader {
+    const char* cursor;
+    const char* end;
+    bool failed;
+    
+    std::uint32_t u32() {
+        if (end - cursor < 4) {
+            failed = true;
+            return 0;
+        }
+        std::uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<std::uint32_t>(static_cast<unsigned char>(cursor[i])) << (8 * i);
+        }
+        cursor += 4;
+        return value;
+    }
+    
+    std::uint64_t varint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (cursor == end) {
+                break;
+            }
+            unsigned char byte = static_cast<unsigned char>(*cursor++);
+            value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+        failed = true;
+        return 0;
+    }
+    
+    std::int64_t signedVarint() {
+        std::uint64_t value = varint();
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+    
+    std::string text() {
+        std::uint64_t size = varint();
+        if (failed || static_cast<std::uint64_t>(end - cursor) < size) {
+            failed = true;
+            return std::string();
+        }
+        std::string value(cursor, static_cast<std::size_t>(size));
+        cursor += size;
+        return value;
+    }
+    
+    double float64() {
+        if (end - cursor < 8) {
+            failed = true;
+            return 0;
+        }
+        std::uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i) {
+            bits |= static_cast<std::uint64_t>(static_cast<unsigned char>(cursor[i])) << (8 * i);
+        }
+        cursor += 8;
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+// 公历日期与1970-01-01之间的天数换算（Howard Hinnant的days_from_civil算法）
+std::int64_t daysFromCivil(std::int64_t year, int month, int day) {
+    year -= month <= 2;
+    std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    std::int64_t year_of_era = year - era * 400;
+    std::int64_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    std::int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+void civilFromDays(std::int64_t days, std::int64_t& year, int& month, int& day) {
+    days += 719468;
+    std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    std::int64_t day_of_era = days - era * 146097;
+    std::int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+    std::int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+    std::int64_t mp = (5 * day_of_year + 2) / 153;
+    day = static_cast<int>(day_of_year - (153 * mp + 2) / 5 + 1);
+    month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    year = year_of_era + era * 400 + (month <= 2);
+}
+
+// 只接受CURRENT_TIMESTAMP的格式"YYYY-MM-DD HH:MM:SS"，解码后能逐字节还原
+bool parseTimestamp(const std::string& text, std::int64_t& seconds) {
+    static const char pattern[] = "dddd-dd-dd dd:dd:dd";
+    if (text.size() != sizeof(pattern) - 1) {
+        return false;
+    }
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        bool digit = text[i] >= '0' && text[i] <= '9';
+        if (pattern[i] == 'd' ? !digit : text[i] != pattern[i]) {
+            return false;
+        }
+    }
+    auto field = [&text](std::size_t pos, std::size_t len) {
+        int value = 0;
+        for (std::size_t i = pos; i < pos + len; ++i) {
+            value = value * 10 + (text[i] - '0');
+        }
+        return value;
+    };
+    int month = field(5, 2);
+    int day = field(8, 2);
+    int hour = field(11, 2);
+    int minute = field(14, 2);
+    int second = field(17, 2);
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+    std::int64_t year = field(0, 4);
+    std::int64_t days = daysFromCivil(year, month, day);
+    std::int64_t check_year;
+    int check_month;
+    int check_day;
+    civilFromDays(days, check_year, check_month, check_day);
+    if (check_year != year || check_month != month || check_day != day) {
+        return false;  // 如2月30日
+    }
+    seconds = days * 86400 + hour * 3600 + minute * 60 + second;
+    return true;
+}
+
+std::string formatTimestamp(std::int64_t seconds) {
+    std::int64_t days = seconds / 86400;
+    std::int64_t rest = seconds % 86400;
+    if (rest < 0) {
+        rest += 86400;
+        --days;
+    }
+    std::int64_t year;
+    int month;
+    int day;
+    civilFromDays(days, year, month, day);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04lld-%02d-%02d %02d:%02d:%02d", static_cast<long long>(year), month,
+                  day, static_cast<int>(rest / 3600), static_cast<int>(rest / 60 % 60), static_cast<int>(rest % 60));
+    return buffer;
+}
+
+void encodeTimes(std::string& out, const std::vector<std::string>& texts) {
+    std::vector<std::int64_t> seconds(texts.size());
+    bool parsed = true;
+    for (std::size_t i = 0; i < texts.size() && parsed; ++i) {
+        parsed = parseTimestamp(texts[i], seconds[i]);
+    }
+    if (!parsed) {
+        out.push_back(kTimeText);
+        for (const auto& text : texts) {
+            putText(out, text);
+        }
+        return;
+    }
+    out.push_back(kTimeSeconds);
+    std::int64_t previous = 0;
+    for (std::int64_t value : seconds) {
+        putSigned(out, value - previous);
+        previous = value;
+    }
+}
+
+bool decodeTimes(Reader& reader, std::vector<std::string>& texts) {
+    if (reader.cursor == reader.end) {
+        return false;
+    }
+    char encoding = *reader.cursor++;
+    if (encoding != kTimeSeconds && encoding != kTimeText) {
+        return false;
+    }
+    std::int64_t previous = 0;
+    for (auto& text : texts) {
+        if (encoding == kTimeText) {
+            text = reader.text();
+        } else {
+            previous += reader.signedVarint();
+            text = formatTimestamp(previous);
+        }
+    }
+    return !reader.failed;
+}
+
+std::string columnText(sqlite3_stmt* stmt, int column) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    return text ? std::string(reinterpret_cast<const char*>(text), sqlite3_column_bytes(stmt, column)) : std::string();
+}
+
+void appendCsvField(std::string& out, sqlite3_stmt* stmt, int column) {
+    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+    if (!text) {
+        return;
+    }
+    int size = sqlite3_column_bytes(stmt, column);
+    if (std::find_if(text, text + size, [](char c) { return c == ',' || c == '"' || c == '\n' || c == '\r'; }) ==
+        text + size) {
+        out.append(text, size);
+        return;
+    }
+    out.push_back('"');
+    for (int i = 0; i < size; ++i) {
+        if (text[i] == '"') {
+            out.push_back('"');
+        }
+        out.push_back(text[i]);
+    }
+    out.push_back('"');
+}
+
+// 扫描一个区间并格式化，返回扫描是否完整
+bool formatCsvChunk(sqlite3_stmt* stmt, std::string& out, std::int64_t& rows) {
+    char number[64];
+    int step;
+    while ((step = sqlite3_step(stmt)) == SQLITE_ROW) {
+        int length = std::snprintf(number, sizeof(number), "%lld,%lld,%.15g,",
+                                   static_cast<long long>(sqlite3_column_int64(stmt, 0)),
+                                   static_cast<long long>(sqlite3_column_int64(stmt, 1)),
+                                   sqlite3_column_double(stmt, 2));
+        out.append(number, length);
+        appendCsvField(out, stmt, 3);
+        out.push_back(',');
+        appendCsvField(out, stmt, 4);
+        out.push_back(',');
+        appendCsvField(out, stmt, 5);
+        out.push_back('\n');
+        ++rows;
+    }
+    return step == SQLITE_DONE;
+}
+
+bool formatColumnarChunk(sqlite3_stmt* stmt, std::string& out, std::int64_t& rows) {
+    std::vector<std::int64_t> ids;
+    std::vector<std::int64_t> user_ids;
+    std::vector<double> amounts;
+    std::vector<std::uint64_t> status_codes;
+    std::vector<std::string> dictionary;
+    std::unordered_map<std::string, std::uint64_t> codes;
+    std::vector<std::string> created;
+    std::vector<std::string> updated;
+    int step;
+    while ((step = sqlite3_step(stmt)) == SQLITE_ROW) {
+        ids.push_back(sqlite3_column_int64(stmt, 0));
+        user_ids.push_back(sqlite3_column_int64(stmt, 1));
+        amounts.push_back(sqlite3_column_double(stmt, 2));
+        std::string status = columnText(stmt, 3);
+        auto code = codes.find(status);
+        if (code == codes.end()) {
+            code = codes.insert(std::make_pair(status, dictionary.size())).first;
+            dictionary.push_back(status);
+        }
+        status_codes.push_back(code->second);
+        created.push_back(columnText(stmt, 4));
+        updated.push_back(columnText(stmt, 5));
+    }
+    if (step != SQLITE_DONE) {
+        return false;
+    }
+    if (ids.empty()) {
+        return true;  // 区间内没有行（已删除），不输出数据块
+    }
+    
+    std::string body;
+    body.reserve(ids.size() * 16);
+    std::int64_t previous = 0;
+    for (std::int64_t id : ids) {
+        putSigned(body, id - previous);
+        previous = id;
+    }
+    for (std::int64_t user_id : user_ids) {
+        putSigned(body, user_id);
+    }
+    for (double amount : amounts) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &amount, sizeof(bits));
+        for (int i = 0; i < 8; ++i) {
+            body.push_back(static_cast<char>((bits >> (8 * i)) & 0xff));
+        }
+    }
+    putVarint(body, dictionary.size());
+    for (const auto& status : dictionary) {
+        putText(body, status);
+    }
+    for (std::uint64_t code : status_codes) {
+        putVarint(body, code);
+    }
+    encodeTimes(body, created);
+    encodeTimes(body, updated);
+    
+    putU32(out, static_cast<std::uint32_t>(ids.size()));
+    putU32(out, static_cast<std::uint32_t>(body.size()));
+    out.append(body);
+    rows += static_cast<std::int64_t>(ids.size());
+    return true;
+}
+
+struct Chunk {
+    std::string data;
+    std::int64_t rows;
+};
+
+// 工作线程与写出线程之间的共享状态
+struct Pipeline {
+    std::mutex mutex;
+    std::condition_variable formatted;  // 有数据块完成格式化
+    std::condition_variable drained;    // 有数据块被写出，缓冲区有空位
+    std::map<std::size_t, Chunk> done;
+    std::size_t next_claim;
+    std::size_t next_write;
+    bool failed;
+};
+
+void scanChunks(sqlite3* db, const ExportOptions& options, std::int64_t low, std::int64_t high,
+                std::size_t chunk_count, std::size_t max_buffered, Pipeline& pipeline) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, kChunkSql, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "导出订单失败: " << sqlite3_errmsg(db) << std::endl;
+        std::lock_guard<std::mutex> lock(pipeline.mutex);
+        pipeline.failed = true;
+        // 写出线程与等待缓冲区空位的其他工作线程都需要被唤醒，否则导出在join()中挂起
+        pipeline.formatted.notify_all();
+        pipeline.drained.notify_all();
+        return;
+    }
+    
+    while (true) {
+        std::size_t index;
+        {
+            std::unique_lock<std::mutex> lock(pipeline.mutex);
+            // 领先写出位置过多时等待，限制缓冲的数据块数
+            pipeline.drained.wait(lock, [&]() {
+                return pipeline.failed || pipeline.next_claim >= chunk_count ||
+                       pipeline.next_claim < pipeline.next_write + max_buffered;
+            });
+            if (pipeline.failed || pipeline.next_claim >= chunk_count) {
+                break;
+            }
+            index = pipeline.next_claim++;
+        }
+        
+        std::int64_t begin = low + static_cast<std::int64_t>(index) * options.chunk_rows;
+        std::int64_t end = std::min(begin + options.chunk_rows, high + 1);
+        sqlite3_bind_int64(stmt, 1, begin);
+        sqlite3_bind_int64(stmt, 2, end);
+        Chunk chunk;
+        chunk.rows = 0;
+        bool ok = options.format == ExportFormat::CSV ? formatCsvChunk(stmt, chunk.data, chunk.rows)
+                                                      : formatColumnarChunk(stmt, chunk.data, chunk.rows);
+        if (!ok) {
+            std::cerr << "导出订单失败: 扫描区间 [" << begin << ", " << end << ") 出错: " << sqlite3_errmsg(db)
+                      << std::endl;
+        }
+        sqlite3_reset(stmt);
+        
+        std::lock_guard<std::mutex> lock(pipeline.mutex);
+        if (!ok) {
+            pipeline.failed = true;
+        } else {
+            pipeline.done[index] = std::move(chunk);
+        }
+        pipeline.formatted.notify_all();
+        if (!ok) {
+            pipeline.drained.notify_all();
+            break;
+        }
+    }
+    sqlite3_finalize(stmt);
+}
+
+// 在连接上开始读事务并立即建立快照
+bool beginSnapshot(sqlite3* db) {
+    return sqlite3_exec(db, "BEGIN; SELECT COUNT(*) FROM sqlite_master;", nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+bool queryIdBounds(sqlite3* db, std::int64_t& low, std::int64_t& high, bool& empty) {
+    sqlite3_stmt* stmt = nullptr;
+    bool ok = sqlite3_prepare_v2(db, "SELECT MIN(id), MAX(id) FROM orders", -1, &stmt, nullptr) == SQLITE_OK &&
+              sqlite3_step(stmt) == SQLITE_ROW;
+    if (ok) {
+        empty = sqlite3_column_type(stmt, 0) == SQLITE_NULL;
+        low = sqlite3_column_int64(stmt, 0);
+        high = sqlite3_column_int64(stmt, 1);
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+}  // namespace
+
+bool OrderExporter::exportOrders(const std::string& path, const ExportOptions& options, ExportStats* stats) {
+    auto start_time = std::chrono::steady_clock::now();
+    if (options.threads <= 0 || options.chunk_rows <= 0) {
+        std::cerr << "导出订单失败: 线程数与区间大小必须为正数" << std::endl;
+        return false;
+    }
+    auto& db_manager = MultiConnectionDatabaseManager::getInstance();
+    MultiConnectionDatabaseManager::DatabaseId orders_id =
+        static_cast<MultiConnectionDatabaseManager::DatabaseId>(MultiConnectionDatabaseManager::TableType::ORDERS);
+    
+    std::vector<std::shared_ptr<sqlite3>> readers;
+    try {
+        for (int i = 0; i < options.threads; ++i) {
+            readers.push_back(db_manager.openReaderConnection(orders_id));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "导出订单失败: " << e.what() << std::endl;
+        return false;
+    }
+    
+    if (options.consistent) {
+        // 写入事务均在持有连接互斥量时完成，此时开始的读事务看到同一个已提交状态
+        std::lock_guard<std::recursive_mutex> lock(db_manager.connectionMutex(orders_id));
+        for (auto& reader : readers) {
+            if (!beginSnapshot(reader.get())) {
+                std::cerr << "导出订单失败: 无法开始读事务: " << sqlite3_errmsg(reader.get()) << std::endl;
+                return false;
+            }
+        }
+    }
+    
+    std::int64_t low = 0;
+    std::int64_t high = 0;
+    bool empty = true;
+    if (!queryIdBounds(readers[0].get(), low, high, empty)) {
+        std::cerr << "导出订单失败: " << sqlite3_errmsg(readers[0].get()) << std::endl;
+        return false;
+    }
+    std::size_t chunk_count = empty ? 0 : static_cast<std::size_t>((high - low) / options.chunk_rows + 1);
+    
+    std::string temp_path = path + ".tmp";
+    std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "导出订单失败: 无法创建 " << temp_path << std::endl;
+        return false;
+    }
+    std::int64_t bytes = 0;
+    std::string header = options.format == ExportFormat::CSV ? std::string(kCsvHeader)
+                                                             : std::string(kColumnarMagic, sizeof(kColumnarMagic));
+    bool ok = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+    bytes += header.size();
+    
+    Pipeline pipeline;
+    pipeline.next_claim = 0;
+    pipeline.next_write = 0;
+    pipeline.failed = !ok;
+    std::size_t worker_count = std::min<std::size_t>(readers.size(), chunk_count);
+    std::size_t max_buffered = options.max_buffered_chunks > 0 ? options.max_buffered_chunks : worker_count * 2;
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        workers.emplace_back(scanChunks, readers[i].get(), std::cref(options), low, high, chunk_count, max_buffered,
+                             std::ref(pipeline));
+    }
+    
+    // 调用线程按区间顺序写出
+    std::int64_t rows = 0;
+    std::int64_t chunks = 0;
+    for (std::size_t index = 0; index < chunk_count && ok; ++index) {
+        Chunk chunk;
+        {
+            std::unique_lock<std::mutex> lock(pipeline.mutex);
+            pipeline.formatted.wait(lock, [&]() {
+                return pipeline.failed || pipeline.done.count(index) > 0;
+            });
+            if (pipeline.failed) {
+                ok = false;
+                pipeline.drained.notify_all();
+                break;
+            }
+            chunk = std::move(pipeline.done[index]);
+            pipeline.done.erase(index);
+            pipeline.next_write = index + 1;
+            pipeline.drained.notify_all();
+        }
+        if (std::fwrite(chunk.data.data(), 1, chunk.data.size(), file) != chunk.data.size()) {
+            std::cerr << "导出订单失败: 写入 " << temp_path << " 出错" << std::endl;
+            ok = false;
+            std::lock_guard<std::mutex> lock(pipeline.mutex);
+            pipeline.failed = true;
+            pipeline.drained.notify_all();
+            break;
+        }
+        bytes += chunk.data.size();
+        rows += chunk.rows;
+        if (!chunk.data.empty()) {
+            ++chunks;
+        }
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    readers.clear();
+    
+    if (ok && options.format == ExportFormat::COLUMNAR) {
+        std::string trailer(8, '\0');
+        ok = std::fwrite(trailer.data(), 1, trailer.size(), file) == trailer.size();
+        bytes += trailer.size();
+    }
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok || std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        std::remove(temp_path.c_str());
+        if (ok) {
+            std::cerr << "导出订单失败: 无法改名为 " << path << std::endl;
+        }
+        return false;
+    }
+    
+    if (stats) {
+        stats->rows = rows;
+        stats->chunks = chunks;
+        stats->bytes = bytes;
+        stats->elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start_time).count();
+    }
+    return true;
+}
+
+bool OrderExporter::readColumnar(const std::string& path, std::vector<Order>& orders) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (content.size() < sizeof(kColumnarMagic) ||
+        std::memcmp(content.data(), kColumnarMagic, sizeof(kColumnarMagic)) != 0) {
+        return false;
+    }
+    
+    Reader reader = {content.data() + sizeof(kColumnarMagic), content.data() + content.size(), false};
+    while (true) {
+        std::uint32_t rows = reader.u32();
+        std::uint32_t body_bytes = reader.u32();
+        if (reader.failed || static_cast<std::size_t>(reader.end - reader.cursor) < body_bytes) {
+            return false;
+        }
+        if (rows == 0) {
+            return body_bytes == 0 && reader.cursor == reader.end;
+        }
+        // 行数来自文件，先按块体能容纳的行数校验，再据此分配
+        if (rows > body_bytes / kMinRowBytes) {
+            return false;
+        }
+        
+        Reader body = {reader.cursor, reader.cursor + body_bytes, false};
+        reader.cursor += body_bytes;
+        std::vector<Order> chunk(rows);
+        std::int64_t id = 0;
+        for (auto& order : chunk) {
+            id += body.signedVarint();
+            order.id = static_cast<int>(id);
+        }
+        for (auto& order : chunk) {
+            order.user_id = static_cast<int>(body.signedVarint());
+        }
+        for (auto& order : chunk) {
+            order.total_amount = body.float64();
+        }
+        std::uint64_t dictionary_size = body.varint();
+        if (dictionary_size > rows) {
+            return false;
+        }
+        std::vector<std::string> dictionary(static_cast<std::size_t>(dictionary_size));
+        for (auto& status : dictionary) {
+            status = body.text();
+        }
+        for (auto& order : chunk) {
+            std::uint64_t code = body.varint();
+            if (code >= dictionary.size()) {
+                return false;
+            }
+            order.status = dictionary[code];
+        }
+        std::vector<std::string> created(rows);
+        std::vector<std::string> updated(rows);
+        if (body.failed || !decodeTimes(body, created) || !decodeTimes(body, updated) || body.cursor != body.end) {
+            return false;
+        }
+        for (std::uint32_t i = 0; i < rows; ++i) {
+            chunk[i].created_at = std::move(created[i]);
+            chunk[i].updated_at = std::move(updated[i]);
+            orders.push_back(std::move(chunk[i]));
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "models.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 导出格式
+enum class ExportFormat {
+    CSV,      // 带表头的CSV，字段按RFC 4180加引号
+    COLUMNAR  // 紧凑的二进制列存格式，见OrderExporter说明
+};
+
+struct ExportOptions {
+    ExportOptions() : format(ExportFormat::CSV), threads(4), chunk_rows(16384), max_buffered_chunks(0), consistent(true) {}
+    
+    ExportFormat format;
+    int threads;                      // 扫描与格式化线程数，每个线程一个读者连接
+    std::int64_t chunk_rows;          // 每个rowid区间覆盖的id数，即一个数据块的行数上限
+    std::size_t max_buffered_chunks;  // 已格式化、等待写出的数据块上限，0表示线程数的两倍
+    bool consistent;                  // 所有读者连接在同一快照上读取
+};
+
+struct ExportStats {
+    std::int64_t rows;
+    std::int64_t chunks;
+    std::int64_t bytes;     // 写出的文件字节数
+    long long elapsed_ms;
+};
+
+// 订单导出管道
+//
+// 按id（rowid）把订单表切分为若干区间，每个工作线程在独立的读者连接上领取区间、
+// 按主键顺序扫描并格式化为数据块，调用线程按区间顺序把数据块追加写入文件，
+// 已格式化未写出的数据块数有上限，内存占用与表大小无关。已软删除的订单不导出。
+// 先写入"路径.tmp"，成功后改名为目标路径，失败时不留下不完整的文件。
+//
+// consistent为true时，各读者连接在持有订单连接互斥量期间开始读事务：写入事务
+// 均在持锁期间完成，各连接因此读到同一个已提交状态，导出结果是某一时刻的一致
+// 快照，写入只在开启读事务的瞬间被阻塞。读事务持续到导出结束，期间检查点无法
+// 越过该快照，WAL文件会增长。为false时每个区间单独读取，互不等待。
+//
+// 列存格式（整数均为小端，varint为LEB128，有符号数先做zigzag编码）：
+//   文件头  "ORDCOL1\n"（8字节）
+//   数据块  u32 行数，u32 块体字节数，块体：
+//           id         首个id(有符号varint)，其后为与前一行的差值(有符号varint)
+//           user_id    有符号varint
+//           金额       每行8字节IEEE 754双精度
+//           状态       字典大小(varint)、各字典项(长度varint+字节)，每行字典下标(varint)
+//           创建时间    编码标记(1字节)：0为秒级时间戳，首行及其后的差值均为有符号varint；
+//           更新时间    1为原始文本，每行长度varint+字节（时间无法按"YYYY-MM-DD HH:MM:SS"解析时）
+//   文件尾  行数为0的数据块头（8字节零）
+// 文本中的NULL导出为空串。
+class OrderExporter {
+public:
+    // 把订单表导出到path，失败时返回false并输出原因
+    static bool exportOrders(const std::string& path, const ExportOptions& options = ExportOptions(),
+                             ExportStats* stats = nullptr);
+    
+    // 读取列存格式文件，追加到orders；格式错误时返回false
+    static bool readColumnar(const std::string& path, std::vector<Order>& orders);
+};
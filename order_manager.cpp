@@ -1,4 +1,5 @@
 #include "order_manager.h"
+#include "transaction_scope.h"
 #include <iostream>
 
 std::once_flag OrderManager::initialized_;
@@ -12,7 +13,7 @@ OrderManager& OrderManager::getInstance() {
 }
 
 OrderManager::OrderManager() 
-    : db_connection_(DatabaseManager::getInstance().getConnection()),
+    : db_connection_(DatabaseManager::getInstance().borrowConnection()),
       insert_stmt_(nullptr), select_all_stmt_(nullptr), 
       select_by_user_id_stmt_(nullptr), select_by_status_stmt_(nullptr),
       select_by_id_stmt_(nullptr), update_status_stmt_(nullptr),
@@ -26,7 +27,7 @@ OrderManager::~OrderManager() {
 }
 
 void OrderManager::prepareStatements() {
-    auto db = db_connection_.get();
+    auto db = db_connection_;
     
     // 准备插入语句
     const char* insert_sql = "INSERT INTO orders (user_id, total_amount, status) VALUES (?, ?, ?)";
@@ -183,7 +184,7 @@ bool OrderManager::updateOrderStatus(int id, const std::string& status) {
     sqlite3_bind_int(update_status_stmt_, 2, id);
     
     int result = sqlite3_step(update_status_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool OrderManager::updateOrderAmount(int id, double total_amount) {
@@ -194,7 +195,7 @@ bool OrderManager::updateOrderAmount(int id, double total_amount) {
     sqlite3_bind_int(update_amount_stmt_, 2, id);
     
     int result = sqlite3_step(update_amount_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool OrderManager::deleteOrder(int id) {
@@ -204,7 +205,7 @@ bool OrderManager::deleteOrder(int id) {
     sqlite3_bind_int(delete_stmt_, 1, id);
     
     int result = sqlite3_step(delete_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 double OrderManager::getTotalAmountByUserId(int user_id) {
@@ -235,13 +236,10 @@ int OrderManager::getOrderCountByStatus(const std::string& status) {
 
 bool OrderManager::createOrdersTransaction(const std::vector<std::tuple<int, double, std::string>>& orders) {
     std::lock_guard<std::mutex> lock(operation_mutex_);
-    auto db = db_connection_.get();
     
-    // 开始事务
-    char* error_msg = nullptr;
-    int result = sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
+    // 开始事务（调用方已在事务中时使用保存点）
+    TransactionScope transaction(db_connection_);
+    if (!transaction.active()) {
         return false;
     }
     
@@ -253,18 +251,10 @@ bool OrderManager::createOrdersTransaction(const std::vector<std::tuple<int, dou
         sqlite3_bind_text(insert_stmt_, 3, std::get<2>(order_tuple).c_str(), -1, SQLITE_STATIC);
         
         if (sqlite3_step(insert_stmt_) != SQLITE_DONE) {
-            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-            return false;
+            return false; // 作用域析构时回滚
         }
     }
     
-    // 提交事务
-    result = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
-        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-        return false;
-    }
-    
-    return true;
+    // 提交事务（嵌套时释放保存点，由外层事务统一提交）
+    return transaction.commit();
 }
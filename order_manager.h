@@ -1,20 +1,12 @@
 #pragma once
 
 #include "database_manager.h"
+#include "models.h"
 #include <vector>
 #include <string>
 #include <memory>
 #include <mutex>
 
-struct Order {
-    int id;
-    int user_id;
-    double total_amount;
-    std::string status;
-    std::string created_at;
-    std::string updated_at;
-};
-
 class OrderManager {
 public:
     static OrderManager& getInstance();
@@ -45,7 +37,8 @@ private:
     void prepareStatements();
     void finalizeStatements();
     
-    std::shared_ptr<sqlite3> db_connection_;
+    // 借用的连接句柄，不持有所有权，生命周期由数据库管理器保证
+    sqlite3* db_connection_;
     std::mutex operation_mutex_;
     
     // 预编译的SQL语句
@@ -0,0 +1,238 @@
+#include <sqlite3.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 离线孤儿订单检查工具
+//
+// 用法: orphan_check [--threads 线程数] [--limit 行数] [用户库文件] [订单库文件]
+// 检查订单库中user_id不存在于用户库的订单（跨文件的外键无法由SQLite检查）。
+// 按用户id区间切分任务，每个工作线程在两个文件上各开一个只读连接，区间内
+// 用户表按主键、订单表按idx_orders_user_id索引有序读取并归并比较，不加载整表。
+// 两个文件不在同一快照中读取，运行期间的用户删除可能造成误报，宜在低峰时运行。
+// 退出码：0 无孤儿订单，2 发现孤儿订单，1 出错。
+
+namespace {
+
+// 每个线程分到的区间数，区间较多时线程间负载更均衡
+const int kRangesPerThread = 4;
+
+struct Orphan {
+    long long user_id;
+    long long orders;
+    long long first_order_id;
+};
+
+struct RangeResult {
+    std::vector<Orphan> orphans;
+    long long users;
+    long long order_groups;
+    bool ok;
+};
+
+sqlite3* openReadOnly(const std::string& path) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(path.c_str(), &db, SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+        std::cerr << "无法打开 " << path << ": " << (db ? sqlite3_errmsg(db) : "内存不足") << std::endl;
+        sqlite3_close(db);
+        return nullptr;
+    }
+    sqlite3_busy_timeout(db, 30000);
+    return db;
+}
+
+// 读取两列整数结果（如MIN、MAX），表为空时返回false
+bool queryBounds(sqlite3* db, const char* sql, long long& low, long long& high) {
+    sqlite3_stmt* stmt = nullptr;
+    bool found = false;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW &&
+        sqlite3_column_type(stmt, 0) != SQLITE_NULL) {
+        low = sqlite3_column_int64(stmt, 0);
+        high = sqlite3_column_int64(stmt, 1);
+        found = true;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+bool hasColumn(sqlite3* db, const std::string& table, const std::string& column) {
+    std::string sql = "PRAGMA table_info(" + table + ")";
+    sqlite3_stmt* stmt = nullptr;
+    bool found = false;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const unsigned char* name = sqlite3_column_text(stmt, 1);
+            if (name && column == reinterpret_cast<const char*>(name)) {
+                found = true;
+                break;
+            }
+        }
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+// 工作线程：依次领取区间[low, high)并归并比较
+void checkRanges(const std::string& users_path, const std::string& orders_path, const std::string& orders_sql,
+                 const std::vector<std::pair<long long, long long>>& ranges, std::atomic<std::size_t>& next_range,
+                 std::vector<RangeResult>& results) {
+    sqlite3* users_db = openReadOnly(users_path);
+    sqlite3* orders_db = openReadOnly(orders_path);
+    sqlite3_stmt* users_stmt = nullptr;
+    sqlite3_stmt* orders_stmt = nullptr;
+    bool ready = users_db && orders_db &&
+                 sqlite3_prepare_v2(users_db, "SELECT id FROM users WHERE id >= ? AND id < ? ORDER BY id", -1,
+                                    &users_stmt, nullptr) == SQLITE_OK &&
+                 sqlite3_prepare_v2(orders_db, orders_sql.c_str(), -1, &orders_stmt, nullptr) == SQLITE_OK;
+    
+    for (std::size_t index = next_range++; index < ranges.size(); index = next_range++) {
+        RangeResult& result = results[index];
+        result.users = 0;
+        result.order_groups = 0;
+        result.ok = ready;
+        if (!ready) {
+            continue;
+        }
+        
+        sqlite3_bind_int64(users_stmt, 1, ranges[index].first);
+        sqlite3_bind_int64(users_stmt, 2, ranges[index].second);
+        sqlite3_bind_int64(orders_stmt, 1, ranges[index].first);
+        sqlite3_bind_int64(orders_stmt, 2, ranges[index].second);
+        
+        // 两侧均按用户id递增：订单组的用户id小于当前用户id时即为孤儿
+        int user_step = sqlite3_step(users_stmt);
+        int order_step = sqlite3_step(orders_stmt);
+        while (order_step == SQLITE_ROW) {
+            long long user_id = sqlite3_column_int64(orders_stmt, 0);
+            while (user_step == SQLITE_ROW && sqlite3_column_int64(users_stmt, 0) < user_id) {
+                ++result.users;
+                user_step = sqlite3_step(users_stmt);
+            }
+            if (user_step != SQLITE_ROW || sqlite3_column_int64(users_stmt, 0) != user_id) {
+                Orphan orphan = {user_id, sqlite3_column_int64(orders_stmt, 1), sqlite3_column_int64(orders_stmt, 2)};
+                result.orphans.push_back(orphan);
+            }
+            ++result.order_groups;
+            order_step = sqlite3_step(orders_stmt);
+        }
+        while (user_step == SQLITE_ROW) {
+            ++result.users;
+            user_step = sqlite3_step(users_stmt);
+        }
+        if (user_step != SQLITE_DONE || order_step != SQLITE_DONE) {
+            std::cerr << "扫描区间 [" << ranges[index].first << ", " << ranges[index].second << ") 失败: "
+                      << sqlite3_errmsg(user_step != SQLITE_DONE ? users_db : orders_db) << std::endl;
+            result.ok = false;
+        }
+        sqlite3_reset(users_stmt);
+        sqlite3_reset(orders_stmt);
+    }
+    
+    sqlite3_finalize(users_stmt);
+    sqlite3_finalize(orders_stmt);
+    sqlite3_close(users_db);
+    sqlite3_close(orders_db);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    long long limit = 20;
+    std::vector<std::string> paths;
+    
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--limit") == 0 && i + 1 < argc) {
+            limit = std::atoll(argv[++i]);
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (threads <= 0 || limit < 0 || paths.size() > 2) {
+        std::cerr << "用法: " << argv[0] << " [--threads 线程数] [--limit 行数] [用户库文件] [订单库文件]" << std::endl;
+        return 1;
+    }
+    std::string users_path = paths.size() > 0 ? paths[0] : "users_db.db";
+    std::string orders_path = paths.size() > 1 ? paths[1] : "orders_db.db";
+    
+    auto start_time = std::chrono::steady_clock::now();
+    
+    // 订单的user_id范围决定需要检查的区间，两端取自索引，无需扫描
+    sqlite3* orders_db = openReadOnly(orders_path);
+    if (!orders_db) {
+        return 1;
+    }
+    std::string orders_sql = "SELECT user_id, COUNT(*), MIN(id) FROM orders WHERE user_id >= ? AND user_id < ?";
+    // 软删除的订单不再被引用，不视为孤儿
+    if (hasColumn(orders_db, "orders", "deleted")) {
+        orders_sql += " AND deleted = 0";
+    }
+    orders_sql += " GROUP BY user_id ORDER BY user_id";
+    long long low = 0;
+    long long high = -1;
+    bool has_orders = queryBounds(orders_db, "SELECT MIN(user_id), MAX(user_id) FROM orders", low, high);
+    sqlite3_close(orders_db);
+    
+    std::vector<std::pair<long long, long long>> ranges;
+    if (has_orders) {
+        long long span = high - low + 1;
+        long long count = std::min<long long>(span, static_cast<long long>(threads) * kRangesPerThread);
+        for (long long i = 0; i < count; ++i) {
+            ranges.push_back(std::make_pair(low + span * i / count, low + span * (i + 1) / count));
+        }
+    }
+    
+    std::vector<RangeResult> results(ranges.size());
+    std::atomic<std::size_t> next_range(0);
+    std::vector<std::thread> workers;
+    int worker_count = std::min<int>(threads, static_cast<int>(ranges.size()));
+    for (int i = 0; i < worker_count; ++i) {
+        workers.emplace_back(checkRanges, std::cref(users_path), std::cref(orders_path), std::cref(orders_sql),
+                             std::cref(ranges), std::ref(next_range), std::ref(results));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    
+    long long users = 0;
+    long long order_groups = 0;
+    long long orphan_users = 0;
+    long long orphan_orders = 0;
+    bool ok = true;
+    for (const auto& result : results) {
+        ok = ok && result.ok;
+        users += result.users;
+        order_groups += result.order_groups;
+        for (const auto& orphan : result.orphans) {
+            // 区间按用户id递增排列，输出自然有序
+            if (orphan_users < limit) {
+                std::cout << "孤儿订单: user_id " << orphan.user_id << ", 订单 " << orphan.orders
+                          << " 个 (首个订单ID " << orphan.first_order_id << ")" << std::endl;
+            }
+            ++orphan_users;
+            orphan_orders += orphan.orders;
+        }
+    }
+    if (orphan_users > limit) {
+        std::cout << "... 其余 " << (orphan_users - limit) << " 个用户id未列出" << std::endl;
+    }
+    
+    long long elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+    std::cout << users_path << " / " << orders_path << ": 区间内用户 " << users << " 个, 有订单的用户id "
+              << order_groups << " 个, 孤儿用户id " << orphan_users << " 个 (订单 " << orphan_orders << " 个), "
+              << worker_count << " 线程, 耗时 " << elapsed_ms << " 毫秒" << std::endl;
+    
+    if (!ok) {
+        return 1;
+    }
+    return orphan_users > 0 ? 2 : 0;
+}
@@ -1,4 +1,5 @@
 #include "product_manager.h"
+#include "transaction_scope.h"
 #include <iostream>
 
 std::once_flag ProductManager::initialized_;
@@ -12,7 +13,7 @@ ProductManager& ProductManager::getInstance() {
 }
 
 ProductManager::ProductManager() 
-    : db_connection_(DatabaseManager::getInstance().getConnection()),
+    : db_connection_(DatabaseManager::getInstance().borrowConnection()),
       insert_stmt_(nullptr), select_all_stmt_(nullptr), 
       select_by_price_range_stmt_(nullptr), select_in_stock_stmt_(nullptr),
       select_by_id_stmt_(nullptr), select_by_name_stmt_(nullptr),
@@ -28,7 +29,7 @@ ProductManager::~ProductManager() {
 }
 
 void ProductManager::prepareStatements() {
-    auto db = db_connection_.get();
+    auto db = db_connection_;
     
     // 准备插入语句
     const char* insert_sql = "INSERT INTO products (name, description, price, stock_quantity) VALUES (?, ?, ?, ?)";
@@ -128,6 +129,7 @@ std::vector<Product> ProductManager::getAllProducts() {
         product.stock_quantity = sqlite3_column_int(select_all_stmt_, 4);
         product.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 5));
         product.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 6));
+        product.version = 0;
         products.push_back(product);
     }
     
@@ -151,6 +153,7 @@ std::vector<Product> ProductManager::getProductsByPriceRange(double min_price, d
         product.stock_quantity = sqlite3_column_int(select_by_price_range_stmt_, 4);
         product.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_price_range_stmt_, 5));
         product.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_by_price_range_stmt_, 6));
+        product.version = 0;
         products.push_back(product);
     }
     
@@ -172,6 +175,7 @@ std::vector<Product> ProductManager::getProductsInStock() {
         product.stock_quantity = sqlite3_column_int(select_in_stock_stmt_, 4);
         product.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_in_stock_stmt_, 5));
         product.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_in_stock_stmt_, 6));
+        product.version = 0;
         products.push_back(product);
     }
     
@@ -180,7 +184,7 @@ std::vector<Product> ProductManager::getProductsInStock() {
 
 Product ProductManager::getProductById(int id) {
     std::lock_guard<std::mutex> lock(operation_mutex_);
-    Product product = {0, "", "", 0.0, 0, "", ""};
+    Product product = {0, "", "", 0.0, 0, "", "", 0};
     
     sqlite3_reset(select_by_id_stmt_);
     sqlite3_bind_int(select_by_id_stmt_, 1, id);
@@ -200,7 +204,7 @@ Product ProductManager::getProductById(int id) {
 
 Product ProductManager::getProductByName(const std::string& name) {
     std::lock_guard<std::mutex> lock(operation_mutex_);
-    Product product = {0, "", "", 0.0, 0, "", ""};
+    Product product = {0, "", "", 0.0, 0, "", "", 0};
     
     sqlite3_reset(select_by_name_stmt_);
     sqlite3_bind_text(select_by_name_stmt_, 1, name.c_str(), -1, SQLITE_STATIC);
@@ -230,7 +234,7 @@ bool ProductManager::updateProduct(int id, const std::string& name, const std::s
     sqlite3_bind_int(update_stmt_, 5, id);
     
     int result = sqlite3_step(update_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool ProductManager::updateProductStock(int id, int stock_quantity) {
@@ -241,7 +245,7 @@ bool ProductManager::updateProductStock(int id, int stock_quantity) {
     sqlite3_bind_int(update_stock_stmt_, 2, id);
     
     int result = sqlite3_step(update_stock_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool ProductManager::updateProductPrice(int id, double price) {
@@ -252,7 +256,7 @@ bool ProductManager::updateProductPrice(int id, double price) {
     sqlite3_bind_int(update_price_stmt_, 2, id);
     
     int result = sqlite3_step(update_price_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool ProductManager::deleteProduct(int id) {
@@ -262,7 +266,7 @@ bool ProductManager::deleteProduct(int id) {
     sqlite3_bind_int(delete_stmt_, 1, id);
     
     int result = sqlite3_step(delete_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool ProductManager::increaseStock(int id, int quantity) {
@@ -273,7 +277,7 @@ bool ProductManager::increaseStock(int id, int quantity) {
     sqlite3_bind_int(increase_stock_stmt_, 2, id);
     
     int result = sqlite3_step(increase_stock_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool ProductManager::decreaseStock(int id, int quantity) {
@@ -285,7 +289,7 @@ bool ProductManager::decreaseStock(int id, int quantity) {
     sqlite3_bind_int(decrease_stock_stmt_, 3, quantity);
     
     int result = sqlite3_step(decrease_stock_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 int ProductManager::getStockQuantity(int id) {
@@ -303,13 +307,10 @@ int ProductManager::getStockQuantity(int id) {
 
 bool ProductManager::createProductsTransaction(const std::vector<std::tuple<std::string, std::string, double, int>>& products) {
     std::lock_guard<std::mutex> lock(operation_mutex_);
-    auto db = db_connection_.get();
     
-    // 开始事务
-    char* error_msg = nullptr;
-    int result = sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
+    // 开始事务（调用方已在事务中时使用保存点）
+    TransactionScope transaction(db_connection_);
+    if (!transaction.active()) {
         return false;
     }
     
@@ -322,31 +323,20 @@ bool ProductManager::createProductsTransaction(const std::vector<std::tuple<std:
         sqlite3_bind_int(insert_stmt_, 4, std::get<3>(product_tuple));
         
         if (sqlite3_step(insert_stmt_) != SQLITE_DONE) {
-            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-            return false;
+            return false; // 作用域析构时回滚
         }
     }
     
-    // 提交事务
-    result = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
-        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-        return false;
-    }
-    
-    return true;
+    // 提交事务（嵌套时释放保存点，由外层事务统一提交）
+    return transaction.commit();
 }
 
 bool ProductManager::updateStockTransaction(const std::vector<std::pair<int, int>>& stock_updates) {
     std::lock_guard<std::mutex> lock(operation_mutex_);
-    auto db = db_connection_.get();
     
-    // 开始事务
-    char* error_msg = nullptr;
-    int result = sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
+    // 开始事务（调用方已在事务中时使用保存点）
+    TransactionScope transaction(db_connection_);
+    if (!transaction.active()) {
         return false;
     }
     
@@ -357,18 +347,10 @@ bool ProductManager::updateStockTransaction(const std::vector<std::pair<int, int
         sqlite3_bind_int(update_stock_stmt_, 2, stock_pair.first);
         
         if (sqlite3_step(update_stock_stmt_) != SQLITE_DONE) {
-            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-            return false;
+            return false; // 作用域析构时回滚
         }
     }
     
-    // 提交事务
-    result = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
-        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-        return false;
-    }
-    
-    return true;
+    // 提交事务（嵌套时释放保存点，由外层事务统一提交）
+    return transaction.commit();
 }
@@ -1,21 +1,12 @@
 #pragma once
 
 #include "database_manager.h"
+#include "models.h"
 #include <vector>
 #include <string>
 #include <memory>
 #include <mutex>
 
-struct Product {
-    int id;
-    std::string name;
-    std::string description;
-    double price;
-    int stock_quantity;
-    std::string created_at;
-    std::string updated_at;
-};
-
 class ProductManager {
 public:
     static ProductManager& getInstance();
@@ -52,7 +43,8 @@ private:
     void prepareStatements();
     void finalizeStatements();
     
-    std::shared_ptr<sqlite3> db_connection_;
+    // 借用的连接句柄，不持有所有权，生命周期由数据库管理器保证
+    sqlite3* db_connection_;
     std::mutex operation_mutex_;
     
     // 预编译的SQL语句
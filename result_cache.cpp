@@ -0,0 +1,81 @@
+#include "result_cache.h"
+#include <functional>
+#include <iterator>
+
+QueryResultCache::QueryResultCache(std::size_t capacity_bytes)
+    : segment_capacity_(capacity_bytes / kSegmentCount), hits_(0), misses_(0) {
+}
+
+QueryResultCache::Segment& QueryResultCache::segmentFor(const std::string& key) {
+    return segments_[std::hash<std::string>()(key) % kSegmentCount];
+}
+
+void QueryResultCache::erase(Segment& segment, std::list<Entry>::iterator it) {
+    segment.bytes -= it->value.size();
+    segment.index.erase(it->key);
+    segment.entries.erase(it);
+}
+
+bool QueryResultCache::lookup(const std::string& key, std::uint64_t generation, std::string& value) {
+    Segment& segment = segmentFor(key);
+    std::lock_guard<std::mutex> lock(segment.mutex);
+    
+    auto found = segment.index.find(key);
+    if (found == segment.index.end()) {
+        ++misses_;
+        return false;
+    }
+    // 填充后表已被写入：条目失效
+    if (found->second->generation != generation) {
+        erase(segment, found->second);
+        ++misses_;
+        return false;
+    }
+    segment.entries.splice(segment.entries.begin(), segment.entries, found->second);
+    value = found->second->value;
+    ++hits_;
+    return true;
+}
+
+void QueryResultCache::insert(const std::string& key, std::uint64_t generation, const std::string& value) {
+    // 超过分段容量的结果不缓存，避免一次插入清空整个分段
+    if (value.size() > segment_capacity_) {
+        return;
+    }
+    Segment& segment = segmentFor(key);
+    std::lock_guard<std::mutex> lock(segment.mutex);
+    
+    auto found = segment.index.find(key);
+    if (found != segment.index.end()) {
+        // 并发填充时保留代数较新的结果
+        if (found->second->generation > generation) {
+            return;
+        }
+        erase(segment, found->second);
+    }
+    
+    segment.entries.push_front(Entry{key, generation, value});
+    segment.index[key] = segment.entries.begin();
+    segment.bytes += value.size();
+    while (segment.bytes > segment_capacity_ && !segment.entries.empty()) {
+        erase(segment, std::prev(segment.entries.end()));
+    }
+}
+
+void QueryResultCache::clear() {
+    for (auto& segment : segments_) {
+        std::lock_guard<std::mutex> lock(segment.mutex);
+        segment.entries.clear();
+        segment.index.clear();
+        segment.bytes = 0;
+    }
+}
+
+std::size_t QueryResultCache::bytes() const {
+    std::size_t total = 0;
+    for (auto& segment : segments_) {
+        std::lock_guard<std::mutex> lock(segment.mutex);
+        total += segment.bytes;
+    }
+    return total;
+}
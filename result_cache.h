@@ -0,0 +1,143 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 查询结果的紧凑编码：整数为zigzag变长整数，浮点数为8字节，文本为长度前缀
+class ResultEncoder {
+public:
+    void putInt(std::int64_t value) {
+        std::uint64_t zigzag = (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+        while (zigzag >= 0x80) {
+            buffer_.push_back(static_cast<char>(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        buffer_.push_back(static_cast<char>(zigzag));
+    }
+    
+    void putDouble(double value) {
+        char bytes[sizeof(double)];
+        std::memcpy(bytes, &value, sizeof(double));
+        buffer_.append(bytes, sizeof(double));
+    }
+    
+    void putText(const std::string& value) {
+        putInt(static_cast<std::int64_t>(value.size()));
+        buffer_.append(value);
+    }
+    
+    std::string& buffer() {
+        return buffer_;
+    }
+    
+private:
+    std::string buffer_;
+};
+
+class ResultDecoder {
+public:
+    explicit ResultDecoder(const std::string& buffer)
+        : data_(buffer.data()), end_(buffer.data() + buffer.size()) {}
+    
+    bool done() const {
+        return data_ >= end_;
+    }
+    
+    std::int64_t getInt() {
+        std::uint64_t zigzag = 0;
+        int shift = 0;
+        while (data_ < end_) {
+            unsigned char byte = static_cast<unsigned char>(*data_++);
+            zigzag |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                break;
+            }
+            shift += 7;
+        }
+        return static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+    }
+    
+    double getDouble() {
+        double value = 0.0;
+        if (end_ - data_ >= static_cast<std::ptrdiff_t>(sizeof(double))) {
+            std::memcpy(&value, data_, sizeof(double));
+            data_ += sizeof(double);
+        }
+        return value;
+    }
+    
+    std::string getText() {
+        std::size_t size = static_cast<std::size_t>(getInt());
+        size = std::min(size, static_cast<std::size_t>(end_ - data_));
+        std::string value(data_, size);
+        data_ += size;
+        return value;
+    }
+    
+private:
+    const char* data_;
+    const char* end_;
+};
+
+// 查询结果缓存
+//
+// 以"语句SQL + 绑定参数"为键保存编码后的结果，容量按字节计，按分段LRU淘汰。
+// 每个条目记录填充时所属表的写入代数（MultiConnectionDatabaseManager::writeGeneration），
+// 查找时代数不一致即视为失效并删除，因此任何写入都会精确地使该表的所有结果失效，
+// 而无需逐条清理。命中只获取所在分段的互斥量，不涉及连接互斥量与SQLite。
+// 填充方必须在持有连接互斥量、执行查询之前读取代数，保证结果不会比代数更旧；
+// 连接上有未结束的事务时不得填充，其中的写入可能随后被回滚。
+class QueryResultCache {
+public:
+    explicit QueryResultCache(std::size_t capacity_bytes);
+    
+    // 查找代数仍为generation的结果，命中时写入value
+    bool lookup(const std::string& key, std::uint64_t generation, std::string& value);
+    void insert(const std::string& key, std::uint64_t generation, const std::string& value);
+    void clear();
+    
+    std::uint64_t hits() const {
+        return hits_.load();
+    }
+    
+    std::uint64_t misses() const {
+        return misses_.load();
+    }
+    
+    // 当前缓存的编码结果字节数（不含键）
+    std::size_t bytes() const;
+    
+private:
+    QueryResultCache(const QueryResultCache&) = delete;
+    QueryResultCache& operator=(const QueryResultCache&) = delete;
+    
+    static const std::size_t kSegmentCount = 16;
+    
+    struct Entry {
+        std::string key;
+        std::uint64_t generation;
+        std::string value;
+    };
+    
+    // 分段：各自独立的LRU链表与索引，降低并发查找时的锁竞争
+    struct Segment {
+        mutable std::mutex mutex;
+        std::list<Entry> entries;  // 表头为最近使用
+        std::unordered_map<std::string, std::list<Entry>::iterator> index;
+        std::size_t bytes = 0;
+    };
+    
+    Segment& segmentFor(const std::string& key);
+    static void erase(Segment& segment, std::list<Entry>::iterator it);
+    
+    std::size_t segment_capacity_;
+    Segment segments_[kSegmentCount];
+    std::atomic<std::uint64_t> hits_;
+    std::atomic<std::uint64_t> misses_;
+};
@@ -0,0 +1,72 @@
+#include "snapshot_reader.h"
+
+SnapshotReader::SnapshotReader(std::shared_ptr<sqlite3> connection, std::chrono::milliseconds max_staleness)
+    : connection_(std::move(connection)), max_staleness_(max_staleness),
+      in_snapshot_(false), snapshots_(0), memo_hits_(0) {
+}
+
+SnapshotReader::~SnapshotReader() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    endSnapshot();
+    for (auto& entry : statements_) {
+        sqlite3_finalize(entry.second);
+    }
+}
+
+SnapshotReader::Session::Session(SnapshotReader& reader)
+    : reader_(reader), lock_(reader.mutex_), valid_(true) {
+    if (!reader_.in_snapshot_ || reader_.stale()) {
+        reader_.endSnapshot();
+        valid_ = reader_.beginSnapshot();
+    }
+}
+
+sqlite3_stmt* SnapshotReader::Session::statement(const char* sql) {
+    sqlite3_stmt*& stmt = reader_.statements_[sql];
+    if (!stmt) {
+        sqlite3_prepare_v2(reader_.connection_.get(), sql, -1, &stmt, nullptr);
+    } else {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+    return stmt;
+}
+
+void SnapshotReader::expireIfStale() {
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (lock.owns_lock() && in_snapshot_ && stale()) {
+        endSnapshot();
+    }
+}
+
+bool SnapshotReader::stale() const {
+    return std::chrono::steady_clock::now() - snapshot_started_ >= max_staleness_;
+}
+
+bool SnapshotReader::beginSnapshot() {
+    sqlite3* db = connection_.get();
+    // BEGIN是延迟事务，第一次读取数据库时才固定快照，因此立即读一次文件头
+    if (sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    if (sqlite3_exec(db, "SELECT 1 FROM sqlite_master LIMIT 1;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    in_snapshot_ = true;
+    snapshot_started_ = std::chrono::steady_clock::now();
+    ++snapshots_;
+    return true;
+}
+
+void SnapshotReader::endSnapshot() {
+    memo_.clear();
+    if (!in_snapshot_) {
+        return;
+    }
+    for (auto& entry : statements_) {
+        sqlite3_reset(entry.second);
+    }
+    sqlite3_exec(connection_.get(), "COMMIT;", nullptr, nullptr, nullptr);
+    in_snapshot_ = false;
+}
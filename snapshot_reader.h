@@ -0,0 +1,120 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// 有界陈旧读的快照读者
+//
+// 在专用连接（与写入连接相互独立，WAL模式下读写互不阻塞）上保持一个读事务，
+// 同一快照上的重复查询直接返回记忆的结果。快照建立超过max_staleness后，
+// 下一次读取先结束旧读事务再开始新的；空闲的读者由数据库管理器的后台维护
+// 线程结束读事务，避免长期占住WAL使检查点无法推进。
+// 由MultiConnectionDatabaseManager::openSnapshotReader()创建。
+class SnapshotReader {
+public:
+    SnapshotReader(std::shared_ptr<sqlite3> connection, std::chrono::milliseconds max_staleness);
+    ~SnapshotReader();
+    
+    // 读会话：持有读者互斥量，保证快照已建立且未超过陈旧上限
+    class Session {
+    public:
+        explicit Session(SnapshotReader& reader);
+        
+        // 快照是否建立成功，失败时调用方应回退到写入连接
+        bool valid() const {
+            return valid_;
+        }
+        
+        // 读者连接上按SQL文本缓存的预编译语句，返回前已重置并清除绑定
+        sqlite3_stmt* statement(const char* sql);
+        
+        // 当前快照上记忆的结果，类型须与存入时一致
+        template <typename T>
+        const T* find(const std::string& key) const {
+            auto it = reader_.memo_.find(key);
+            if (it == reader_.memo_.end()) {
+                return nullptr;
+            }
+            ++reader_.memo_hits_;
+            return static_cast<const T*>(it->second.get());
+        }
+        
+        template <typename T>
+        void store(const std::string& key, const T& value) {
+            if (reader_.memo_.size() < kMaxMemoEntries) {
+                reader_.memo_[key] = std::make_shared<T>(value);
+            }
+        }
+        
+    private:
+        Session(const Session&) = delete;
+        Session& operator=(const Session&) = delete;
+        
+        SnapshotReader& reader_;
+        std::lock_guard<std::mutex> lock_;
+        bool valid_;
+    };
+    
+    // 在快照上执行查询并按key记忆结果；run以Session&为参数返回结果。
+    // 快照无法建立时返回false，result不变
+    template <typename Result, typename Run>
+    bool read(const std::string& key, Run run, Result& result) {
+        Session session(*this);
+        if (!session.valid()) {
+            return false;
+        }
+        if (const Result* cached = session.find<Result>(key)) {
+            result = *cached;
+            return true;
+        }
+        result = run(session);
+        session.store(key, result);
+        return true;
+    }
+    
+    // 快照已超过陈旧上限时结束读事务（读者正被使用时跳过），供后台维护调用
+    void expireIfStale();
+    
+    std::chrono::milliseconds maxStaleness() const {
+        return max_staleness_;
+    }
+    
+    // 累计建立的快照数与记忆命中数
+    std::uint64_t snapshots() const {
+        return snapshots_.load();
+    }
+    
+    std::uint64_t memoHits() const {
+        return memo_hits_.load();
+    }
+    
+private:
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+    
+    // 每个快照最多记忆的查询结果数，超出后的查询照常执行但不再记忆
+    static const std::size_t kMaxMemoEntries = 256;
+    
+    bool beginSnapshot();
+    void endSnapshot();
+    bool stale() const;
+    
+    std::shared_ptr<sqlite3> connection_;
+    std::chrono::milliseconds max_staleness_;
+    
+    // 以下成员受mutex_保护
+    std::mutex mutex_;
+    bool in_snapshot_;
+    std::chrono::steady_clock::time_point snapshot_started_;
+    std::unordered_map<std::string, sqlite3_stmt*> statements_;
+    std::unordered_map<std::string, std::shared_ptr<void>> memo_;
+    
+    std::atomic<std::uint64_t> snapshots_;
+    mutable std::atomic<std::uint64_t> memo_hits_;
+};
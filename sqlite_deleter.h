@@ -0,0 +1,12 @@
+#pragma once
+
+#include <sqlite3.h>
+
+// 自定义删除器用于sqlite3指针
+struct SQLiteDeleter {
+    void operator()(sqlite3* db) {
+        if (db) {
+            sqlite3_close_v2(db);
+        }
+    }
+};
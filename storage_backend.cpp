@@ -0,0 +1,207 @@
+#include "storage_backend.h"
+#include "user_manager.h"
+#include "order_manager.h"
+#include "product_manager.h"
+#include "multi_connection_user_manager.h"
+#include "multi_connection_order_manager.h"
+#include "multi_connection_product_manager.h"
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+
+// 两种布局的管理器API同名同参，以模板统一转发
+template <typename UserManagerType, typename OrderManagerType, typename ProductManagerType>
+class ManagerBackend : public StorageBackend {
+public:
+    explicit ManagerBackend(StorageLayout layout)
+        : layout_(layout), users_(UserManagerType::getInstance()),
+          orders_(OrderManagerType::getInstance()), products_(ProductManagerType::getInstance()) {}
+    
+    StorageLayout layout() const override {
+        return layout_;
+    }
+    
+    const char* name() const override {
+        return storageLayoutName(layout_);
+    }
+    
+    bool createUser(const std::string& username, const std::string& email) override {
+        return users_.createUser(username, email);
+    }
+    
+    std::vector<User> getAllUsers() override {
+        return users_.getAllUsers();
+    }
+    
+    User getUserById(int id) override {
+        return users_.getUserById(id);
+    }
+    
+    User getUserByUsername(const std::string& username) override {
+        return users_.getUserByUsername(username);
+    }
+    
+    bool updateUser(int id, const std::string& username, const std::string& email) override {
+        return users_.updateUser(id, username, email);
+    }
+    
+    bool deleteUser(int id) override {
+        return users_.deleteUser(id);
+    }
+    
+    bool createUsersTransaction(const std::vector<std::pair<std::string, std::string>>& users) override {
+        return users_.createUsersTransaction(users);
+    }
+    
+    bool createOrder(int user_id, double total_amount, const std::string& status) override {
+        return orders_.createOrder(user_id, total_amount, status);
+    }
+    
+    std::vector<Order> getAllOrders() override {
+        return orders_.getAllOrders();
+    }
+    
+    std::vector<Order> getOrdersByUserId(int user_id) override {
+        return orders_.getOrdersByUserId(user_id);
+    }
+    
+    std::vector<Order> getOrdersByStatus(const std::string& status) override {
+        return orders_.getOrdersByStatus(status);
+    }
+    
+    Order getOrderById(int id) override {
+        return orders_.getOrderById(id);
+    }
+    
+    bool updateOrderStatus(int id, const std::string& status) override {
+        return orders_.updateOrderStatus(id, status);
+    }
+    
+    bool updateOrderAmount(int id, double total_amount) override {
+        return orders_.updateOrderAmount(id, total_amount);
+    }
+    
+    bool deleteOrder(int id) override {
+        return orders_.deleteOrder(id);
+    }
+    
+    double getTotalAmountByUserId(int user_id) override {
+        return orders_.getTotalAmountByUserId(user_id);
+    }
+    
+    int getOrderCountByStatus(const std::string& status) override {
+        return orders_.getOrderCountByStatus(status);
+    }
+    
+    bool createOrdersTransaction(const std::vector<std::tuple<int, double, std::string>>& orders) override {
+        return orders_.createOrdersTransaction(orders);
+    }
+    
+    bool createProduct(const std::string& name, const std::string& description,
+                       double price, int stock_quantity) override {
+        return products_.createProduct(name, description, price, stock_quantity);
+    }
+    
+    std::vector<Product> getAllProducts() override {
+        return products_.getAllProducts();
+    }
+    
+    std::vector<Product> getProductsByPriceRange(double min_price, double max_price) override {
+        return products_.getProductsByPriceRange(min_price, max_price);
+    }
+    
+    std::vector<Product> getProductsInStock() override {
+        return products_.getProductsInStock();
+    }
+    
+    Product getProductById(int id) override {
+        return products_.getProductById(id);
+    }
+    
+    Product getProductByName(const std::string& name) override {
+        return products_.getProductByName(name);
+    }
+    
+    bool updateProduct(int id, const std::string& name, const std::string& description,
+                       double price, int stock_quantity) override {
+        return products_.updateProduct(id, name, description, price, stock_quantity);
+    }
+    
+    bool updateProductStock(int id, int stock_quantity) override {
+        return products_.updateProductStock(id, stock_quantity);
+    }
+    
+    bool updateProductPrice(int id, double price) override {
+        return products_.updateProductPrice(id, price);
+    }
+    
+    bool deleteProduct(int id) override {
+        return products_.deleteProduct(id);
+    }
+    
+    bool increaseStock(int id, int quantity) override {
+        return products_.increaseStock(id, quantity);
+    }
+    
+    bool decreaseStock(int id, int quantity) override {
+        return products_.decreaseStock(id, quantity);
+    }
+    
+    int getStockQuantity(int id) override {
+        return products_.getStockQuantity(id);
+    }
+    
+    bool createProductsTransaction(
+        const std::vector<std::tuple<std::string, std::string, double, int>>& products) override {
+        return products_.createProductsTransaction(products);
+    }
+    
+    bool updateStockTransaction(const std::vector<std::pair<int, int>>& stock_updates) override {
+        return products_.updateStockTransaction(stock_updates);
+    }
+    
+private:
+    StorageLayout layout_;
+    UserManagerType& users_;
+    OrderManagerType& orders_;
+    ProductManagerType& products_;
+};
+
+}  // namespace
+
+StorageLayout parseStorageLayout(const std::string& name) {
+    if (name == "single_file") {
+        return StorageLayout::SINGLE_FILE;
+    }
+    if (name == "per_table") {
+        return StorageLayout::PER_TABLE;
+    }
+    throw std::invalid_argument("未知的存储布局: " + name);
+}
+
+const char* storageLayoutName(StorageLayout layout) {
+    switch (layout) {
+        case StorageLayout::SINGLE_FILE: return "single_file";
+        case StorageLayout::PER_TABLE: return "per_table";
+    }
+    return "unknown";
+}
+
+StorageLayout configuredStorageLayout() {
+    const char* name = std::getenv("STORAGE_LAYOUT");
+    return name ? parseStorageLayout(name) : StorageLayout::PER_TABLE;
+}
+
+std::unique_ptr<StorageBackend> createStorageBackend(StorageLayout layout) {
+    switch (layout) {
+        case StorageLayout::SINGLE_FILE:
+            return std::unique_ptr<StorageBackend>(
+                new ManagerBackend<UserManager, OrderManager, ProductManager>(layout));
+        case StorageLayout::PER_TABLE:
+            return std::unique_ptr<StorageBackend>(
+                new ManagerBackend<MultiConnectionUserManager, MultiConnectionOrderManager,
+                                   MultiConnectionProductManager>(layout));
+    }
+    throw std::invalid_argument("未知的存储布局");
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "models.h"
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// 存储布局
+enum class StorageLayout {
+    SINGLE_FILE,  // 所有表位于app_database.db，共用一个连接（DatabaseManager）
+    PER_TABLE     // 每表一个数据库文件与写入连接（MultiConnectionDatabaseManager）
+};
+
+// 存储后端接口
+//
+// 以两种布局共有的管理器API为准，使同一份业务代码或工作负载可以在运行时
+// 切换布局。实现只是对应管理器单例的薄封装，管理器各自的可选模式
+// （结果缓存、软删除等）仍通过管理器本身配置。
+class StorageBackend {
+public:
+    virtual ~StorageBackend() {}
+    
+    virtual StorageLayout layout() const = 0;
+    virtual const char* name() const = 0;
+    
+    // 用户
+    virtual bool createUser(const std::string& username, const std::string& email) = 0;
+    virtual std::vector<User> getAllUsers() = 0;
+    virtual User getUserById(int id) = 0;
+    virtual User getUserByUsername(const std::string& username) = 0;
+    virtual bool updateUser(int id, const std::string& username, const std::string& email) = 0;
+    virtual bool deleteUser(int id) = 0;
+    virtual bool createUsersTransaction(const std::vector<std::pair<std::string, std::string>>& users) = 0;
+    
+    // 订单
+    virtual bool createOrder(int user_id, double total_amount, const std::string& status = "pending") = 0;
+    virtual std::vector<Order> getAllOrders() = 0;
+    virtual std::vector<Order> getOrdersByUserId(int user_id) = 0;
+    virtual std::vector<Order> getOrdersByStatus(const std::string& status) = 0;
+    virtual Order getOrderById(int id) = 0;
+    virtual bool updateOrderStatus(int id, const std::string& status) = 0;
+    virtual bool updateOrderAmount(int id, double total_amount) = 0;
+    virtual bool deleteOrder(int id) = 0;
+    virtual double getTotalAmountByUserId(int user_id) = 0;
+    virtual int getOrderCountByStatus(const std::string& status) = 0;
+    virtual bool createOrdersTransaction(const std::vector<std::tuple<int, double, std::string>>& orders) = 0;
+    
+    // 产品
+    virtual bool createProduct(const std::string& name, const std::string& description,
+                               double price, int stock_quantity = 0) = 0;
+    virtual std::vector<Product> getAllProducts() = 0;
+    virtual std::vector<Product> getProductsByPriceRange(double min_price, double max_price) = 0;
+    virtual std::vector<Product> getProductsInStock() = 0;
+    virtual Product getProductById(int id) = 0;
+    virtual Product getProductByName(const std::string& name) = 0;
+    virtual bool updateProduct(int id, const std::string& name, const std::string& description,
+                               double price, int stock_quantity) = 0;
+    virtual bool updateProductStock(int id, int stock_quantity) = 0;
+    virtual bool updateProductPrice(int id, double price) = 0;
+    virtual bool deleteProduct(int id) = 0;
+    virtual bool increaseStock(int id, int quantity) = 0;
+    virtual bool decreaseStock(int id, int quantity) = 0;
+    virtual int getStockQuantity(int id) = 0;
+    virtual bool createProductsTransaction(
+        const std::vector<std::tuple<std::string, std::string, double, int>>& products) = 0;
+    virtual bool updateStockTransaction(const std::vector<std::pair<int, int>>& stock_updates) = 0;
+};
+
+// 布局名称："single_file"或"per_table"，无法识别时抛出std::invalid_argument
+StorageLayout parseStorageLayout(const std::string& name);
+const char* storageLayoutName(StorageLayout layout);
+
+// 部署配置的布局：环境变量STORAGE_LAYOUT，未设置时为per_table
+StorageLayout configuredStorageLayout();
+
+// 创建指定布局的后端；首次使用时才打开该布局的数据库文件
+std::unique_ptr<StorageBackend> createStorageBackend(StorageLayout layout);
@@ -0,0 +1,143 @@
+#include "storage_backend.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 存储布局对比基准测试
+//
+// 对每个指定的布局运行完全相同的混合工作负载（随机数种子固定），
+// 用法: storage_benchmark [线程数] [每线程操作数] [布局...]
+// 未指定布局时依次测试single_file与per_table。
+
+namespace {
+
+struct Fixture {
+    std::vector<int> user_ids;
+    std::vector<int> product_ids;
+};
+
+// 准备固定数量的用户与产品，重复运行时复用已有数据
+Fixture prepare(StorageBackend& backend, int count) {
+    Fixture fixture;
+    std::vector<std::pair<std::string, std::string>> users;
+    std::vector<std::tuple<std::string, std::string, double, int>> products;
+    for (int i = 0; i < count; ++i) {
+        std::string username = "layout_user_" + std::to_string(i);
+        if (backend.getUserByUsername(username).id == 0) {
+            users.push_back(std::make_pair(username, username + "@example.com"));
+        }
+        std::string product = "layout_product_" + std::to_string(i);
+        if (backend.getProductByName(product).id == 0) {
+            products.push_back(std::make_tuple(product, std::string("布局对比产品"), 10.0 + i, 1000000));
+        }
+    }
+    if (!users.empty()) {
+        backend.createUsersTransaction(users);
+    }
+    if (!products.empty()) {
+        backend.createProductsTransaction(products);
+    }
+    for (int i = 0; i < count; ++i) {
+        fixture.user_ids.push_back(backend.getUserByUsername("layout_user_" + std::to_string(i)).id);
+        fixture.product_ids.push_back(backend.getProductByName("layout_product_" + std::to_string(i)).id);
+    }
+    return fixture;
+}
+
+// 一次混合操作：读多写少，涉及全部三张表
+bool runOperation(StorageBackend& backend, const Fixture& fixture, std::mt19937& gen) {
+    int user_id = fixture.user_ids[gen() % fixture.user_ids.size()];
+    int product_id = fixture.product_ids[gen() % fixture.product_ids.size()];
+    switch (gen() % 10) {
+        case 0:
+        case 1:
+        case 2:
+        case 3:
+            return backend.getProductById(product_id).id == product_id;
+        case 4:
+        case 5:
+            return backend.getUserById(user_id).id == user_id;
+        case 6:
+            backend.getOrdersByUserId(user_id);
+            return true;
+        case 7:
+        case 8:
+            return backend.createOrder(user_id, 19.9, "layout_bench");
+        default:
+            return backend.decreaseStock(product_id, 1);
+    }
+}
+
+void benchmarkLayout(StorageLayout layout, int thread_count, int operations_per_thread) {
+    std::unique_ptr<StorageBackend> backend = createStorageBackend(layout);
+    Fixture fixture = prepare(*backend, 100);
+    
+    std::atomic<int> succeeded(0);
+    std::atomic<int> failed(0);
+    std::vector<std::thread> threads;
+    auto start_time = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < thread_count; ++i) {
+        threads.emplace_back([&, i]() {
+            std::mt19937 gen(static_cast<unsigned>(i + 1));
+            for (int j = 0; j < operations_per_thread; ++j) {
+                if (runOperation(*backend, fixture, gen)) {
+                    ++succeeded;
+                } else {
+                    ++failed;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::high_resolution_clock::now() - start_time).count();
+    
+    int total = succeeded + failed;
+    std::cout << backend->name() << ": 成功 " << succeeded.load() << ", 失败 " << failed.load()
+              << ", 耗时 " << elapsed_ms << " 毫秒";
+    if (elapsed_ms > 0) {
+        std::cout << ", 吞吐量 " << (total * 1000.0 / elapsed_ms) << " 次/秒";
+    }
+    std::cout << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int thread_count = argc > 1 ? std::atoi(argv[1]) : 4;
+    int operations_per_thread = argc > 2 ? std::atoi(argv[2]) : 2000;
+    if (thread_count <= 0 || operations_per_thread <= 0) {
+        std::cerr << "用法: " << argv[0] << " [线程数] [每线程操作数] [single_file|per_table...]" << std::endl;
+        return 1;
+    }
+    
+    try {
+        std::vector<StorageLayout> layouts;
+        for (int i = 3; i < argc; ++i) {
+            layouts.push_back(parseStorageLayout(argv[i]));
+        }
+        if (layouts.empty()) {
+            layouts.push_back(StorageLayout::SINGLE_FILE);
+            layouts.push_back(StorageLayout::PER_TABLE);
+        }
+        
+        std::cout << "\n=== 存储布局对比基准测试 ===" << std::endl;
+        std::cout << "线程数: " << thread_count << ", 每线程操作数: " << operations_per_thread << std::endl;
+        for (StorageLayout layout : layouts) {
+            benchmarkLayout(layout, thread_count, operations_per_thread);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "基准测试出错: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,377 @@
+#include "transaction_intent_log.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+const std::size_t kFrameHeaderSize = 8;
+
+std::uint32_t checksum(const std::string& data) {
+    // FNV-1a 32位
+    std::uint32_t hash = 2166136261u;
+    for (unsigned char c : data) {
+        hash ^= c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void putU32(std::string& out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void putU64(std::string& out, std::uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+void putString(std::string& out, const std::string& value) {
+    putU32(out, static_cast<std::uint32_t>(value.size()));
+    out.append(value);
+}
+
+// 负载解析游标，越界时置位failed
+struct Reader {
+    const std::string& data;
+    std::size_t pos;
+    bool failed;
+    
+    explicit Reader(const std::string& d) : data(d), pos(0), failed(false) {}
+    
+    std::uint64_t readInt(int bytes) {
+        if (pos + bytes > data.size()) {
+            failed = true;
+            return 0;
+        }
+        std::uint64_t value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            value |= static_cast<std::uint64_t>(static_cast<unsigned char>(data[pos + i])) << (8 * i);
+        }
+        pos += bytes;
+        return value;
+    }
+    
+    std::string readString() {
+        std::uint32_t size = static_cast<std::uint32_t>(readInt(4));
+        if (failed || pos + size > data.size()) {
+            failed = true;
+            return std::string();
+        }
+        std::string value = data.substr(pos, size);
+        pos += size;
+        return value;
+    }
+};
+
+std::string preparePayload(std::uint64_t txid, const TransactionIntentLog::Prepare& prepare) {
+    std::string payload;
+    payload.push_back(static_cast<char>(TransactionIntentLog::RecordType::PREPARE));
+    putU64(payload, txid);
+    putString(payload, prepare.db_path);
+    putU32(payload, static_cast<std::uint32_t>(prepare.redo_statements.size()));
+    for (const auto& statement : prepare.redo_statements) {
+        putString(payload, statement);
+    }
+    return payload;
+}
+
+std::string simplePayload(TransactionIntentLog::RecordType type, std::uint64_t txid) {
+    std::string payload;
+    payload.push_back(static_cast<char>(type));
+    putU64(payload, txid);
+    return payload;
+}
+
+std::string frame(const std::string& payload) {
+    std::string framed;
+    putU32(framed, static_cast<std::uint32_t>(payload.size()));
+    putU32(framed, checksum(payload));
+    framed.append(payload);
+    return framed;
+}
+
+int syncFile(int fd) {
+#if defined(__linux__)
+    return ::fdatasync(fd);
+#else
+    return ::fsync(fd);
+#endif
+}
+
+// 同步文件所在目录，使改名后的目录项落盘
+bool syncDirectory(const std::string& path) {
+    std::string::size_type slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return false;
+    }
+    bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+}
+
+}  // namespace
+
+TransactionIntentLog::TransactionIntentLog(const std::string& path)
+    : path_(path), fd_(-1), base_size_(0), appended_lsn_(0), durable_lsn_(0), syncing_(false) {
+    openFile(false);
+}
+
+TransactionIntentLog::~TransactionIntentLog() {
+    // 刷出尚未写入的END/ABORT记录，析构时不抛出异常
+    try {
+        sync(appended_lsn_);
+    } catch (const std::exception&) {
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void TransactionIntentLog::openFile(bool truncate) {
+    int flags = O_RDWR | O_CREAT | O_APPEND;
+    if (truncate) {
+        flags |= O_TRUNC;
+    }
+    fd_ = ::open(path_.c_str(), flags, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("无法打开事务日志 " + path_ + ": " + std::strerror(errno));
+    }
+    off_t size = ::lseek(fd_, 0, SEEK_END);
+    if (size < 0) {
+        throw std::runtime_error("无法读取事务日志长度 " + path_ + ": " + std::strerror(errno));
+    }
+    base_size_ = static_cast<std::uint64_t>(size);
+}
+
+std::uint64_t TransactionIntentLog::appendRecord(const std::string& payload) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_.append(frame(payload));
+    appended_lsn_ += kFrameHeaderSize + payload.size();
+    return appended_lsn_;
+}
+
+std::uint64_t TransactionIntentLog::appendPrepare(std::uint64_t txid, const Prepare& prepare) {
+    return appendRecord(preparePayload(txid, prepare));
+}
+
+std::uint64_t TransactionIntentLog::appendDecision(std::uint64_t txid, bool commit) {
+    return appendRecord(simplePayload(commit ? RecordType::COMMIT : RecordType::ABORT, txid));
+}
+
+std::uint64_t TransactionIntentLog::appendEnd(std::uint64_t txid) {
+    return appendRecord(simplePayload(RecordType::END, txid));
+}
+
+void TransactionIntentLog::writeAll(int fd, const std::string& data) {
+    std::size_t written = 0;
+    while (written < data.size()) {
+        ssize_t result = ::write(fd, data.data() + written, data.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("写入事务日志失败: " + std::string(std::strerror(errno)));
+        }
+        written += static_cast<std::size_t>(result);
+    }
+}
+
+void TransactionIntentLog::sync(std::uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    
+    while (durable_lsn_ < lsn) {
+        if (!failure_.empty()) {
+            throw std::runtime_error(failure_);
+        }
+        if (syncing_) {
+            // 其他线程正在fsync，等待其完成后再检查是否已覆盖本记录
+            synced_cv_.wait(lock);
+            continue;
+        }
+        
+        // 成为本轮的领导者：取走缓冲区中所有记录，一次写入一次fsync
+        syncing_ = true;
+        std::string pending;
+        pending.swap(buffer_);
+        std::uint64_t target = appended_lsn_;
+        lock.unlock();
+        
+        bool ok = true;
+        std::string error;
+        try {
+            writeAll(fd_, pending);
+            if (syncFile(fd_) != 0) {
+                ok = false;
+                error = "同步事务日志失败: " + std::string(std::strerror(errno));
+            }
+        } catch (const std::exception& e) {
+            ok = false;
+            error = e.what();
+        }
+        
+        lock.lock();
+        if (ok) {
+            durable_lsn_ = target;
+        } else {
+            // 本轮记录（可能含提交决定）已部分或全部写入文件，fsync失败并不撤销它们，
+            // 重启后恢复流程会把调用方随即回滚的事务当作已提交补齐。截断回最后落盘的
+            // 长度并同步后才能报告失败；截断无法落盘时不能再回滚，只能终止进程
+            if (::ftruncate(fd_, static_cast<off_t>(base_size_ + durable_lsn_)) != 0 || syncFile(fd_) != 0) {
+                std::cerr << "事务日志写入失败后无法截断 " << path_ << ": " << std::strerror(errno) << "（" << error
+                          << "），终止进程" << std::endl;
+                std::abort();
+            }
+            // 缓冲区无法原样重试；此后不再确认任何记录
+            failure_ = error;
+        }
+        syncing_ = false;
+        synced_cv_.notify_all();
+        if (!ok) {
+            throw std::runtime_error(error);
+        }
+    }
+}
+
+std::vector<TransactionIntentLog::RecoveredTransaction> TransactionIntentLog::recover(std::uint64_t& max_txid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<RecoveredTransaction> transactions;
+    max_txid = 0;
+    
+    // 读取整个日志文件
+    std::string content;
+    if (::lseek(fd_, 0, SEEK_SET) < 0) {
+        throw std::runtime_error("读取事务日志失败: " + std::string(std::strerror(errno)));
+    }
+    char chunk[65536];
+    for (;;) {
+        ssize_t result = ::read(fd_, chunk, sizeof(chunk));
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("读取事务日志失败: " + std::string(std::strerror(errno)));
+        }
+        if (result == 0) {
+            break;
+        }
+        content.append(chunk, static_cast<std::size_t>(result));
+    }
+    
+    auto findTransaction = [&transactions](std::uint64_t txid) -> RecoveredTransaction& {
+        for (auto& transaction : transactions) {
+            if (transaction.txid == txid) {
+                return transaction;
+            }
+        }
+        RecoveredTransaction transaction = {txid, {}, false, false};
+        transactions.push_back(transaction);
+        return transactions.back();
+    };
+    
+    std::size_t pos = 0;
+    while (pos + kFrameHeaderSize <= content.size()) {
+        Reader header(content);
+        header.pos = pos;
+        std::uint32_t size = static_cast<std::uint32_t>(header.readInt(4));
+        std::uint32_t expected = static_cast<std::uint32_t>(header.readInt(4));
+        if (pos + kFrameHeaderSize + size > content.size()) {
+            break;  // 残缺尾部
+        }
+        std::string payload = content.substr(pos + kFrameHeaderSize, size);
+        if (checksum(payload) != expected) {
+            break;  // 校验失败，视为残缺尾部
+        }
+        pos += kFrameHeaderSize + size;
+        
+        Reader reader(payload);
+        RecordType type = static_cast<RecordType>(reader.readInt(1));
+        std::uint64_t txid = reader.readInt(8);
+        if (reader.failed) {
+            break;
+        }
+        if (txid > max_txid) {
+            max_txid = txid;
+        }
+        
+        switch (type) {
+            case RecordType::CHECKPOINT:
+                // 检查点记录的是下一个可用ID
+                if (txid > 0 && txid - 1 > max_txid) {
+                    max_txid = txid - 1;
+                }
+                break;
+            case RecordType::PREPARE: {
+                Prepare prepare;
+                prepare.db_path = reader.readString();
+                std::uint32_t count = static_cast<std::uint32_t>(reader.readInt(4));
+                for (std::uint32_t i = 0; i < count && !reader.failed; ++i) {
+                    prepare.redo_statements.push_back(reader.readString());
+                }
+                if (!reader.failed) {
+                    findTransaction(txid).participants.push_back(prepare);
+                }
+                break;
+            }
+            case RecordType::COMMIT:
+                findTransaction(txid).committed = true;
+                break;
+            case RecordType::ABORT:
+                findTransaction(txid).ended = true;
+                break;
+            case RecordType::END:
+                findTransaction(txid).ended = true;
+                break;
+        }
+    }
+    
+    return transactions;
+}
+
+void TransactionIntentLog::reset(std::uint64_t next_txid, const std::vector<RecoveredTransaction>& unresolved) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    // 先写临时文件再原子替换，避免截断过程中崩溃丢失未解决的事务
+    std::string content = frame(simplePayload(RecordType::CHECKPOINT, next_txid));
+    for (const auto& transaction : unresolved) {
+        for (const auto& prepare : transaction.participants) {
+            content.append(frame(preparePayload(transaction.txid, prepare)));
+        }
+        if (transaction.committed) {
+            content.append(frame(simplePayload(RecordType::COMMIT, transaction.txid)));
+        }
+    }
+    
+    std::string temp_path = path_ + ".tmp";
+    int temp_fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (temp_fd < 0) {
+        throw std::runtime_error("无法创建事务日志 " + temp_path + ": " + std::strerror(errno));
+    }
+    try {
+        writeAll(temp_fd, content);
+    } catch (...) {
+        ::close(temp_fd);
+        throw;
+    }
+    bool synced = syncFile(temp_fd) == 0;
+    ::close(temp_fd);
+    if (!synced || ::rename(temp_path.c_str(), path_.c_str()) != 0 || !syncDirectory(path_)) {
+        throw std::runtime_error("替换事务日志失败: " + std::string(std::strerror(errno)));
+    }
+    
+    ::close(fd_);
+    openFile(false);
+    buffer_.clear();
+    appended_lsn_ = 0;
+    durable_lsn_ = 0;
+    failure_.clear();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 分布式事务协调者日志：只追加写入，批量fsync（组提交）
+//
+// 记录格式：[u32 负载长度][u32 FNV-1a校验和][负载]
+// 崩溃造成的残缺尾部记录在恢复时通过长度与校验和识别并丢弃。
+class TransactionIntentLog {
+public:
+    enum class RecordType : std::uint8_t {
+        CHECKPOINT = 1,  // 日志重置后的起点，携带下一个可用的事务ID
+        PREPARE = 2,     // 参与者已完成所有写入，携带文件路径与重做语句
+        COMMIT = 3,      // 提交决定，持久化后各参与者才开始提交
+        ABORT = 4,       // 回滚决定（推定回滚，仅用于记录）
+        END = 5          // 所有参与者已提交，事务不再需要恢复
+    };
+    
+    // 参与者准备记录
+    struct Prepare {
+        std::string db_path;
+        std::vector<std::string> redo_statements;
+    };
+    
+    // 恢复阶段重建的事务状态
+    struct RecoveredTransaction {
+        std::uint64_t txid;
+        std::vector<Prepare> participants;
+        bool committed;
+        bool ended;
+    };
+    
+    explicit TransactionIntentLog(const std::string& path);
+    ~TransactionIntentLog();
+    
+    // 追加记录到内存缓冲区，返回该记录结束位置的日志序号
+    std::uint64_t appendPrepare(std::uint64_t txid, const Prepare& prepare);
+    std::uint64_t appendDecision(std::uint64_t txid, bool commit);
+    std::uint64_t appendEnd(std::uint64_t txid);
+    
+    // 组提交：等待直到lsn之前的记录落盘；同一时刻只有一个线程执行fsync，
+    // 其余线程等待并共享同一次fsync的结果。写入或fsync失败时先把文件截断回最后
+    // 落盘的长度并同步（无法做到时终止进程），未确认的记录因此不会在恢复时出现，
+    // 调用方可以安全回滚；之后日志进入失败状态，每次调用均抛出异常
+    void sync(std::uint64_t lsn);
+    
+    // 读取日志文件，返回所有出现过的事务以及日志中最大的事务ID
+    std::vector<RecoveredTransaction> recover(std::uint64_t& max_txid);
+    
+    // 恢复完成后截断日志，仅保留检查点与尚未解决的事务
+    void reset(std::uint64_t next_txid, const std::vector<RecoveredTransaction>& unresolved);
+    
+    const std::string& path() const {
+        return path_;
+    }
+    
+private:
+    TransactionIntentLog(const TransactionIntentLog&) = delete;
+    TransactionIntentLog& operator=(const TransactionIntentLog&) = delete;
+    
+    std::uint64_t appendRecord(const std::string& payload);
+    void writeAll(int fd, const std::string& data);
+    void openFile(bool truncate);
+    
+    std::string path_;
+    int fd_;
+    std::uint64_t base_size_;      // 打开时文件已有（已落盘）的字节数，日志序号从此处起算
+    
+    std::mutex mutex_;
+    std::condition_variable synced_cv_;
+    std::string buffer_;           // 尚未写入文件的记录
+    std::uint64_t appended_lsn_;   // 已追加（含缓冲区）的字节数
+    std::uint64_t durable_lsn_;    // 已fsync的字节数
+    bool syncing_;
+    std::string failure_;          // 首次写入失败的原因，非空时sync()一律失败
+};
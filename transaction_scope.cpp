@@ -0,0 +1,71 @@
+#include "transaction_scope.h"
+#include <atomic>
+
+namespace {
+
+// 保存点名称只需在同一连接的嵌套层级内唯一，全局计数器足够
+std::atomic<unsigned long> savepoint_counter(0);
+
+}  // namespace
+
+TransactionScope::TransactionScope(sqlite3* db)
+    : db_(db), active_(false) {
+    
+    if (sqlite3_get_autocommit(db_)) {
+        // 顶层：立即获取写锁，避免读锁升级时的SQLITE_BUSY
+        active_ = sqlite3_exec(db_, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) == SQLITE_OK;
+    } else {
+        // 嵌套：使用保存点
+        std::string name = "sp_" + std::to_string(savepoint_counter.fetch_add(1));
+        std::string sql = "SAVEPOINT " + name + ";";
+        if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, nullptr) == SQLITE_OK) {
+            savepoint_ = name;
+            active_ = true;
+        }
+    }
+}
+
+TransactionScope::~TransactionScope() {
+    if (active_) {
+        rollback();
+    }
+}
+
+bool TransactionScope::commit() {
+    if (!active_) {
+        return false;
+    }
+    active_ = false;
+    
+    if (nested()) {
+        // 释放保存点，变更并入外层事务
+        std::string sql = "RELEASE " + savepoint_ + ";";
+        if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+            std::string rollback_sql = "ROLLBACK TO " + savepoint_ + "; RELEASE " + savepoint_ + ";";
+            sqlite3_exec(db_, rollback_sql.c_str(), nullptr, nullptr, nullptr);
+            return false;
+        }
+        return true;
+    }
+    
+    if (sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    return true;
+}
+
+void TransactionScope::rollback() {
+    if (!active_) {
+        return;
+    }
+    active_ = false;
+    
+    if (nested()) {
+        // 只撤销本保存点之后的变更，外层事务保持不变
+        std::string sql = "ROLLBACK TO " + savepoint_ + "; RELEASE " + savepoint_ + ";";
+        sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, nullptr);
+    } else {
+        sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr);
+    }
+}
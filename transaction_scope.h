@@ -0,0 +1,36 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <string>
+
+// 事务作用域RAII管理器
+//
+// 连接处于自动提交模式时开始真正的事务（BEGIN IMMEDIATE），否则说明调用方
+// 已在事务中（例如DistributedTransaction或外层批量操作），改用SAVEPOINT，
+// 使多个批量操作可以组合进同一次提交、共享同一次fsync。
+// 调用方需在整个作用域内持有该连接的互斥量。
+class TransactionScope {
+public:
+    explicit TransactionScope(sqlite3* db);
+    ~TransactionScope();
+    
+    // 事务或保存点是否成功开始
+    bool active() const {
+        return active_;
+    }
+    
+    bool nested() const {
+        return !savepoint_.empty();
+    }
+    
+    bool commit();
+    void rollback();
+    
+private:
+    TransactionScope(const TransactionScope&) = delete;
+    TransactionScope& operator=(const TransactionScope&) = delete;
+    
+    sqlite3* db_;
+    std::string savepoint_;
+    bool active_;
+};
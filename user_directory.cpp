@@ -0,0 +1,265 @@
+#include "user_directory.h"
+#include "multi_connection_user_manager.h"
+#include "epoch_reclaimer.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <new>
+
+namespace {
+
+const std::size_t kBlockBytes = 64 * 1024;
+const std::size_t kMinCapacity = 64;
+
+// splitmix64终结函数，使相邻id分散到不同槽位
+std::uint64_t mix(std::uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+// 重建后负载率不超过35%，装载率上限为70%（含墓碑）
+std::size_t capacityFor(std::size_t users) {
+    std::size_t capacity = kMinCapacity;
+    while (capacity * 7 < users * 20) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+}  // namespace
+
+const UserDirectory::Record UserDirectory::tombstone_ = {0, 0, 0, {0, 0, 0, 0}};
+
+UserDirectory::Table::Table(std::size_t capacity)
+    : mask(capacity - 1), slots(new std::atomic<const Record*>[capacity]), live(0), used(0) {
+    for (std::size_t i = 0; i < capacity; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+UserDirectory::UserDirectory(std::size_t expected_users)
+    : by_id_(nullptr), by_username_(nullptr), block_cursor_(nullptr), block_remaining_(0),
+      users_(0), memory_bytes_(0), garbage_bytes_(0) {
+    by_id_.store(newTable(capacityFor(expected_users)), std::memory_order_release);
+    by_username_.store(newTable(capacityFor(expected_users)), std::memory_order_release);
+}
+
+UserDirectory::~UserDirectory() {
+    delete by_id_.load();
+    delete by_username_.load();
+}
+
+UserDirectory::Table* UserDirectory::newTable(std::size_t capacity) {
+    memory_bytes_ += capacity * sizeof(std::atomic<const Record*>);
+    return new Table(capacity);
+}
+
+std::uint64_t UserDirectory::idHash(int id) {
+    return mix(static_cast<std::uint32_t>(id));
+}
+
+std::uint64_t UserDirectory::usernameHash(const std::string& username) {
+    return mix(std::hash<std::string>()(username));
+}
+
+std::uint64_t UserDirectory::keyHash(Key key, const Record* record) {
+    return key == Key::ID ? idHash(record->id) : record->username_hash;
+}
+
+bool UserDirectory::sameKey(Key key, const Record* a, const Record* b) {
+    if (key == Key::ID) {
+        return a->id == b->id;
+    }
+    return a->username_hash == b->username_hash && a->text_sizes[0] == b->text_sizes[0] &&
+           std::memcmp(a->text(), b->text(), a->text_sizes[0]) == 0;
+}
+
+void UserDirectory::copyOut(const Record* record, User& user) {
+    const char* text = record->text();
+    user.id = record->id;
+    user.version = record->version;
+    user.username.assign(text, record->text_sizes[0]);
+    text += record->text_sizes[0];
+    user.email.assign(text, record->text_sizes[1]);
+    text += record->text_sizes[1];
+    user.created_at.assign(text, record->text_sizes[2]);
+    text += record->text_sizes[2];
+    user.updated_at.assign(text, record->text_sizes[3]);
+}
+
+std::size_t UserDirectory::recordBytes(const Record* record) {
+    std::size_t bytes = sizeof(Record);
+    for (std::uint32_t size : record->text_sizes) {
+        bytes += size;
+    }
+    return (bytes + alignof(Record) - 1) & ~(alignof(Record) - 1);
+}
+
+const UserDirectory::Record* UserDirectory::recordById(int id) const {
+    const Table* table = by_id_.load(std::memory_order_acquire);
+    for (std::size_t i = idHash(id) & table->mask;; i = (i + 1) & table->mask) {
+        const Record* record = table->slots[i].load(std::memory_order_acquire);
+        if (!record) {
+            return nullptr;
+        }
+        if (record != &tombstone_ && record->id == id) {
+            return record;
+        }
+    }
+}
+
+bool UserDirectory::findById(int id, User& user) const {
+    const Record* record = recordById(id);
+    if (!record) {
+        return false;
+    }
+    copyOut(record, user);
+    return true;
+}
+
+bool UserDirectory::findByUsername(const std::string& username, User& user) const {
+    std::uint64_t hash = usernameHash(username);
+    const Table* table = by_username_.load(std::memory_order_acquire);
+    for (std::size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        const Record* record = table->slots[i].load(std::memory_order_acquire);
+        if (!record) {
+            return false;
+        }
+        if (record != &tombstone_ && record->username_hash == hash && record->text_sizes[0] == username.size() &&
+            std::memcmp(record->text(), username.data(), username.size()) == 0) {
+            copyOut(record, user);
+            return true;
+        }
+    }
+}
+
+const UserDirectory::Record* UserDirectory::allocate(const User& user) {
+    const std::string* texts[4] = {&user.username, &user.email, &user.created_at, &user.updated_at};
+    std::size_t bytes = sizeof(Record);
+    for (const std::string* text : texts) {
+        bytes += text->size();
+    }
+    bytes = (bytes + alignof(Record) - 1) & ~(alignof(Record) - 1);
+    
+    // 超过块大小的记录独占一块
+    if (bytes > block_remaining_) {
+        std::size_t block = std::max(bytes, kBlockBytes);
+        blocks_.emplace_back(new char[block]);
+        block_cursor_ = blocks_.back().get();
+        block_remaining_ = block;
+        memory_bytes_ += block;
+    }
+    
+    Record* record = new (block_cursor_) Record;
+    record->id = user.id;
+    record->version = user.version;
+    record->username_hash = usernameHash(user.username);
+    char* text = block_cursor_ + sizeof(Record);
+    for (int i = 0; i < 4; ++i) {
+        record->text_sizes[i] = static_cast<std::uint32_t>(texts[i]->size());
+        std::memcpy(text, texts[i]->data(), texts[i]->size());
+        text += texts[i]->size();
+    }
+    block_cursor_ += bytes;
+    block_remaining_ -= bytes;
+    return record;
+}
+
+void UserDirectory::rebuild(Key key) {
+    Table* old_table = table(key).load(std::memory_order_relaxed);
+    Table* new_table = newTable(capacityFor(old_table->live + 1));
+    for (std::size_t i = 0; i <= old_table->mask; ++i) {
+        const Record* record = old_table->slots[i].load(std::memory_order_relaxed);
+        if (!record || record == &tombstone_) {
+            continue;
+        }
+        std::size_t slot = keyHash(key, record) & new_table->mask;
+        while (new_table->slots[slot].load(std::memory_order_relaxed)) {
+            slot = (slot + 1) & new_table->mask;
+        }
+        new_table->slots[slot].store(record, std::memory_order_relaxed);
+    }
+    new_table->live = old_table->live;
+    new_table->used = old_table->live;
+    // 发布后查询改用新表，仍在旧表上探测的查询结束后旧表才被释放
+    table(key).store(new_table, std::memory_order_release);
+    memory_bytes_ -= (old_table->mask + 1) * sizeof(std::atomic<const Record*>);
+    EpochReclaimer::getInstance().retire(old_table);
+}
+
+void UserDirectory::link(Key key, const Record* record) {
+    Table* current = table(key).load(std::memory_order_relaxed);
+    if ((current->used + 1) * 10 > (current->mask + 1) * 7) {
+        rebuild(key);
+        current = table(key).load(std::memory_order_relaxed);
+    }
+    
+    std::atomic<const Record*>* free_slot = nullptr;
+    for (std::size_t i = keyHash(key, record) & current->mask;; i = (i + 1) & current->mask) {
+        const Record* existing = current->slots[i].load(std::memory_order_relaxed);
+        if (!existing) {
+            // 优先复用探测链上的墓碑，否则占用空槽
+            if (!free_slot) {
+                free_slot = &current->slots[i];
+                ++current->used;
+            }
+            ++current->live;
+            free_slot->store(record, std::memory_order_release);
+            return;
+        }
+        if (existing == &tombstone_) {
+            if (!free_slot) {
+                free_slot = &current->slots[i];
+            }
+        } else if (sameKey(key, existing, record)) {
+            current->slots[i].store(record, std::memory_order_release);
+            return;
+        }
+    }
+}
+
+void UserDirectory::unlink(Key key, const Record* record) {
+    Table* current = table(key).load(std::memory_order_relaxed);
+    for (std::size_t i = keyHash(key, record) & current->mask;; i = (i + 1) & current->mask) {
+        const Record* existing = current->slots[i].load(std::memory_order_relaxed);
+        if (!existing) {
+            return;
+        }
+        if (existing == record) {
+            current->slots[i].store(&tombstone_, std::memory_order_release);
+            --current->live;
+            return;
+        }
+    }
+}
+
+void UserDirectory::put(const User& user) {
+    const Record* old_record = recordById(user.id);
+    const Record* record = allocate(user);
+    // 用户名变更时先移除旧名称；同名时由link原位替换
+    if (old_record && !sameKey(Key::USERNAME, old_record, record)) {
+        unlink(Key::USERNAME, old_record);
+    }
+    link(Key::USERNAME, record);
+    link(Key::ID, record);
+    if (old_record) {
+        garbage_bytes_ += recordBytes(old_record);
+    } else {
+        ++users_;
+    }
+}
+
+void UserDirectory::erase(int id) {
+    const Record* record = recordById(id);
+    if (!record) {
+        return;
+    }
+    unlink(Key::ID, record);
+    unlink(Key::USERNAME, record);
+    garbage_bytes_ += recordBytes(record);
+    --users_;
+}
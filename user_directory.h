@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct User;
+
+// 内存常驻用户目录
+//
+// 以id和用户名两张开放寻址哈希表（线性探测）索引全部用户，记录追加写入连续的
+// 内存块。记录发布后不再修改：更新写入一条新记录并替换槽位中的指针，删除把槽位
+// 置为墓碑。查询只做原子加载，不加锁，也不修改任何共享计数。
+// 查询须在EpochReclaimer::Guard内进行：扩容前的旧哈希表经EpochReclaimer退役；
+// 被替换的记录留在内存块中直到目录析构，garbageBytes()超出预期时由使用方整体
+// 重新加载并退役旧目录。
+// 写入（put/erase）需由调用方串行化，查询可与写入并发。
+class UserDirectory {
+public:
+    explicit UserDirectory(std::size_t expected_users);
+    ~UserDirectory();
+    
+    // 插入或整体替换同id的用户
+    void put(const User& user);
+    void erase(int id);
+    
+    // 找到时写入user并返回true
+    bool findById(int id, User& user) const;
+    bool findByUsername(const std::string& username, User& user) const;
+    
+    std::size_t size() const {
+        return users_.load(std::memory_order_relaxed);
+    }
+    
+    // 记录内存块与当前哈希表占用的字节数，含已被替换的记录
+    std::size_t memoryBytes() const {
+        return memory_bytes_.load(std::memory_order_relaxed);
+    }
+    
+    // 已被替换或删除、仍占用内存块的记录字节数
+    std::size_t garbageBytes() const {
+        return garbage_bytes_.load(std::memory_order_relaxed);
+    }
+    
+private:
+    UserDirectory(const UserDirectory&) = delete;
+    UserDirectory& operator=(const UserDirectory&) = delete;
+    
+    // 记录头，之后紧跟用户名、邮箱、创建时间、更新时间四段文本
+    struct Record {
+        int id;
+        int version;
+        std::uint64_t username_hash;
+        std::uint32_t text_sizes[4];
+        
+        const char* text() const {
+            return reinterpret_cast<const char*>(this + 1);
+        }
+    };
+    
+    // 开放寻址哈希表，槽位为空、墓碑或记录指针；live与used只由写入方访问
+    struct Table {
+        explicit Table(std::size_t capacity);
+        
+        std::size_t mask;
+        std::unique_ptr<std::atomic<const Record*>[]> slots;
+        std::size_t live;   // 有效记录数
+        std::size_t used;   // 有效记录与墓碑数，决定何时重建
+    };
+    
+    enum class Key { ID, USERNAME };
+    
+    static std::uint64_t idHash(int id);
+    static std::uint64_t usernameHash(const std::string& username);
+    static std::uint64_t keyHash(Key key, const Record* record);
+    static bool sameKey(Key key, const Record* a, const Record* b);
+    static void copyOut(const Record* record, User& user);
+    static std::size_t recordBytes(const Record* record);
+    
+    std::atomic<Table*>& table(Key key) {
+        return key == Key::ID ? by_id_ : by_username_;
+    }
+    
+    const Record* recordById(int id) const;
+    const Record* allocate(const User& user);
+    void link(Key key, const Record* record);
+    void unlink(Key key, const Record* record);
+    void rebuild(Key key);
+    Table* newTable(std::size_t capacity);
+    
+    static const Record tombstone_;
+    
+    std::atomic<Table*> by_id_;
+    std::atomic<Table*> by_username_;
+    
+    // 以下只由写入方访问
+    std::vector<std::unique_ptr<char[]>> blocks_;      // 记录内存块
+    char* block_cursor_;
+    std::size_t block_remaining_;
+    
+    std::atomic<std::size_t> users_;
+    std::atomic<std::size_t> memory_bytes_;
+    std::atomic<std::size_t> garbage_bytes_;
+};
@@ -0,0 +1,90 @@
+#include "user_id_set.h"
+#include "epoch_reclaimer.h"
+
+namespace {
+
+const std::size_t kMinWords = 64;
+
+}  // namespace
+
+UserIdSet::Bitmap::Bitmap(std::size_t word_count)
+    : words(word_count), bits(new std::atomic<std::uint64_t>[word_count]) {
+    for (std::size_t i = 0; i < word_count; ++i) {
+        bits[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+UserIdSet::UserIdSet(int max_id) : bitmap_(nullptr), size_(0), memory_bytes_(0) {
+    std::size_t words = kMinWords;
+    while (max_id > 0 && words * 64 <= static_cast<std::size_t>(max_id)) {
+        words <<= 1;
+    }
+    bitmap_.store(new Bitmap(words), std::memory_order_release);
+    memory_bytes_.store(words * sizeof(std::uint64_t));
+}
+
+UserIdSet::~UserIdSet() {
+    delete bitmap_.load();
+}
+
+void UserIdSet::grow(std::size_t min_words) {
+    Bitmap* old_bitmap = bitmap_.load(std::memory_order_relaxed);
+    std::size_t words = old_bitmap->words;
+    while (words < min_words) {
+        words <<= 1;
+    }
+    Bitmap* new_bitmap = new Bitmap(words);
+    for (std::size_t i = 0; i < old_bitmap->words; ++i) {
+        new_bitmap->bits[i].store(old_bitmap->bits[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+    // 发布后查询改用新位图，仍在读取旧位图的查询结束后旧位图才被释放
+    bitmap_.store(new_bitmap, std::memory_order_release);
+    memory_bytes_.store(words * sizeof(std::uint64_t));
+    EpochReclaimer::getInstance().retire(old_bitmap);
+}
+
+void UserIdSet::insert(int id) {
+    if (id <= 0) {
+        return;
+    }
+    std::size_t word = static_cast<std::size_t>(id) / 64;
+    if (word >= bitmap_.load(std::memory_order_relaxed)->words) {
+        grow(word + 1);
+    }
+    std::atomic<std::uint64_t>& bits = bitmap_.load(std::memory_order_relaxed)->bits[word];
+    std::uint64_t mask = std::uint64_t(1) << (id % 64);
+    std::uint64_t current = bits.load(std::memory_order_relaxed);
+    if (!(current & mask)) {
+        bits.store(current | mask, std::memory_order_release);
+        ++size_;
+    }
+}
+
+void UserIdSet::erase(int id) {
+    if (id <= 0) {
+        return;
+    }
+    std::size_t word = static_cast<std::size_t>(id) / 64;
+    Bitmap* bitmap = bitmap_.load(std::memory_order_relaxed);
+    if (word >= bitmap->words) {
+        return;
+    }
+    std::uint64_t mask = std::uint64_t(1) << (id % 64);
+    std::uint64_t current = bitmap->bits[word].load(std::memory_order_relaxed);
+    if (current & mask) {
+        bitmap->bits[word].store(current & ~mask, std::memory_order_release);
+        --size_;
+    }
+}
+
+bool UserIdSet::contains(int id) const {
+    if (id <= 0) {
+        return false;
+    }
+    std::size_t word = static_cast<std::size_t>(id) / 64;
+    const Bitmap* bitmap = bitmap_.load(std::memory_order_acquire);
+    if (word >= bitmap->words) {
+        return false;
+    }
+    return (bitmap->bits[word].load(std::memory_order_acquire) >> (id % 64)) & 1;
+}
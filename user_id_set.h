@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// 用户id集合
+//
+// 以位图记录存在的用户id，供跨库引用校验（订单的user_id）使用。用户id由
+// AUTOINCREMENT分配、基本连续，位图每个用户只占1比特；查询是一次原子加载，
+// O(1)、不加锁、不修改任何共享计数。容量不足时按倍数扩容，旧位图经
+// EpochReclaimer退役，因此查询须在EpochReclaimer::Guard内进行。
+// 写入（insert/erase）需由调用方串行化，查询可与写入并发。
+class UserIdSet {
+public:
+    // max_id为预计的最大用户id，决定初始容量
+    explicit UserIdSet(int max_id);
+    ~UserIdSet();
+    
+    // 非正数id被忽略
+    void insert(int id);
+    void erase(int id);
+    bool contains(int id) const;
+    
+    std::size_t size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+    
+    std::size_t memoryBytes() const {
+        return memory_bytes_.load(std::memory_order_relaxed);
+    }
+    
+private:
+    UserIdSet(const UserIdSet&) = delete;
+    UserIdSet& operator=(const UserIdSet&) = delete;
+    
+    struct Bitmap {
+        explicit Bitmap(std::size_t word_count);
+        
+        std::size_t words;
+        std::unique_ptr<std::atomic<std::uint64_t>[]> bits;
+    };
+    
+    void grow(std::size_t min_words);
+    
+    std::atomic<Bitmap*> bitmap_;
+    std::atomic<std::size_t> size_;
+    std::atomic<std::size_t> memory_bytes_;
+};
@@ -1,4 +1,5 @@
 #include "user_manager.h"
+#include "transaction_scope.h"
 #include <iostream>
 
 std::once_flag UserManager::initialized_;
@@ -12,7 +13,7 @@ UserManager& UserManager::getInstance() {
 }
 
 UserManager::UserManager() 
-    : db_connection_(DatabaseManager::getInstance().getConnection()),
+    : db_connection_(DatabaseManager::getInstance().borrowConnection()),
       insert_stmt_(nullptr), select_all_stmt_(nullptr), 
       select_by_id_stmt_(nullptr), select_by_username_stmt_(nullptr),
       update_stmt_(nullptr), delete_stmt_(nullptr) {
@@ -24,7 +25,7 @@ UserManager::~UserManager() {
 }
 
 void UserManager::prepareStatements() {
-    auto db = db_connection_.get();
+    auto db = db_connection_;
     
     // 准备插入语句
     const char* insert_sql = "INSERT INTO users (username, email) VALUES (?, ?)";
@@ -84,6 +85,7 @@ std::vector<User> UserManager::getAllUsers() {
         user.email = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 2));
         user.created_at = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 3));
         user.updated_at = reinterpret_cast<const char*>(sqlite3_column_text(select_all_stmt_, 4));
+        user.version = 0;
         users.push_back(user);
     }
     
@@ -92,7 +94,7 @@ std::vector<User> UserManager::getAllUsers() {
 
 User UserManager::getUserById(int id) {
     std::lock_guard<std::mutex> lock(operation_mutex_);
-    User user = {0, "", "", "", ""};
+    User user = {0, "", "", "", "", 0};
     
     sqlite3_reset(select_by_id_stmt_);
     sqlite3_bind_int(select_by_id_stmt_, 1, id);
@@ -110,7 +112,7 @@ User UserManager::getUserById(int id) {
 
 User UserManager::getUserByUsername(const std::string& username) {
     std::lock_guard<std::mutex> lock(operation_mutex_);
-    User user = {0, "", "", "", ""};
+    User user = {0, "", "", "", "", 0};
     
     sqlite3_reset(select_by_username_stmt_);
     sqlite3_bind_text(select_by_username_stmt_, 1, username.c_str(), -1, SQLITE_STATIC);
@@ -135,7 +137,7 @@ bool UserManager::updateUser(int id, const std::string& username, const std::str
     sqlite3_bind_int(update_stmt_, 3, id);
     
     int result = sqlite3_step(update_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool UserManager::deleteUser(int id) {
@@ -145,18 +147,15 @@ bool UserManager::deleteUser(int id) {
     sqlite3_bind_int(delete_stmt_, 1, id);
     
     int result = sqlite3_step(delete_stmt_);
-    return result == SQLITE_DONE && sqlite3_changes(db_connection_.get()) > 0;
+    return result == SQLITE_DONE && sqlite3_changes(db_connection_) > 0;
 }
 
 bool UserManager::createUsersTransaction(const std::vector<std::pair<std::string, std::string>>& users) {
     std::lock_guard<std::mutex> lock(operation_mutex_);
-    auto db = db_connection_.get();
     
-    // 开始事务
-    char* error_msg = nullptr;
-    int result = sqlite3_exec(db, "BEGIN TRANSACTION;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
+    // 开始事务（调用方已在事务中时使用保存点）
+    TransactionScope transaction(db_connection_);
+    if (!transaction.active()) {
         return false;
     }
     
@@ -167,18 +166,10 @@ bool UserManager::createUsersTransaction(const std::vector<std::pair<std::string
         sqlite3_bind_text(insert_stmt_, 2, user_pair.second.c_str(), -1, SQLITE_STATIC);
         
         if (sqlite3_step(insert_stmt_) != SQLITE_DONE) {
-            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-            return false;
+            return false; // 作用域析构时回滚
         }
     }
     
-    // 提交事务
-    result = sqlite3_exec(db, "COMMIT;", nullptr, nullptr, &error_msg);
-    if (result != SQLITE_OK) {
-        sqlite3_free(error_msg);
-        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
-        return false;
-    }
-    
-    return true;
+    // 提交事务（嵌套时释放保存点，由外层事务统一提交）
+    return transaction.commit();
 }
@@ -0,0 +1,326 @@
+#include "workload_capture.h"
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+const char kMagic[4] = {'M', 'C', 'W', 'L'};
+const std::uint32_t kFormatVersion = 1;
+const std::size_t kRecordHeaderSize = 1 + 4 + 8 + 4;
+const std::size_t kFlushThreshold = 1 << 20;
+// 后台线程写出跟不上时缓冲区的上限，超过后停止捕获而不是让调用线程等待
+const std::size_t kMaxBuffered = 64 << 20;
+// 未攒满一批时后台线程也按此间隔写出，进程异常退出时丢失的记录有限
+const int kFlushIntervalMs = 1000;
+
+// 线程序号：首次记录时分配，0表示尚未分配
+thread_local std::uint32_t thread_index = 0;
+
+template <typename T>
+void putRaw(std::string& out, T value) {
+    // 小端机器上直接按内存布局写入
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+std::int64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void writeAll(int fd, const std::string& data) {
+    std::size_t written = 0;
+    while (written < data.size()) {
+        ssize_t result = ::write(fd, data.data() + written, data.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("写入工作负载日志失败: " + std::string(std::strerror(errno)));
+        }
+        written += static_cast<std::size_t>(result);
+    }
+}
+
+}  // namespace
+
+std::atomic<bool> WorkloadCapture::enabled_(false);
+
+WorkloadCapture& WorkloadCapture::getInstance() {
+    // 函数内静态对象：其他单例析构时仍可能经由Call访问
+    static WorkloadCapture instance;
+    return instance;
+}
+
+WorkloadCapture::WorkloadCapture()
+    : fd_(-1), start_us_(0), next_thread_index_(1), stopping_(false), failed_(false) {}
+
+WorkloadCapture::~WorkloadCapture() {
+    stop();
+}
+
+int& WorkloadCapture::Call::depth() {
+    static thread_local int call_depth = 0;
+    return call_depth;
+}
+
+void WorkloadCapture::start(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ >= 0) {
+        throw std::runtime_error("工作负载捕获已在进行中");
+    }
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("无法创建工作负载日志 " + path);
+    }
+    buffer_.assign(kMagic, sizeof(kMagic));
+    putRaw(buffer_, kFormatVersion);
+    start_us_ = nowMicros();
+    stopping_ = false;
+    failed_ = false;
+    writer_ = std::thread(&WorkloadCapture::writerLoop, this);
+    enabled_.store(true);
+}
+
+void WorkloadCapture::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ < 0 || stopping_) {
+            return;
+        }
+        enabled_.store(false);
+        stopping_ = true;
+    }
+    // 后台线程写出剩余记录后退出
+    writer_cv_.notify_all();
+    writer_.join();
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    ::close(fd_);
+    fd_ = -1;
+    stopping_ = false;
+}
+
+void WorkloadCapture::append(WorkloadOp op, const std::string& args) {
+    std::int64_t timestamp = nowMicros();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (fd_ < 0 || failed_) {
+        return; // 记录前捕获已停止
+    }
+    if (thread_index == 0) {
+        thread_index = next_thread_index_++;
+    }
+    
+    buffer_.push_back(static_cast<char>(op));
+    putRaw(buffer_, thread_index);
+    putRaw(buffer_, static_cast<std::uint64_t>(timestamp > start_us_ ? timestamp - start_us_ : 0));
+    putRaw(buffer_, static_cast<std::uint32_t>(args.size()));
+    buffer_.append(args);
+    
+    if (buffer_.size() >= kMaxBuffered) {
+        abandonLocked("日志写出跟不上记录速度");
+    } else if (buffer_.size() >= kFlushThreshold) {
+        writer_cv_.notify_one();
+    }
+}
+
+void WorkloadCapture::abandon(const char* reason) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    abandonLocked(reason);
+}
+
+void WorkloadCapture::abandonLocked(const char* reason) {
+    if (failed_) {
+        return;
+    }
+    // 丢弃未写出的记录；文件中已有的记录都是完整的，仍可用于重放
+    failed_ = true;
+    enabled_.store(false);
+    buffer_.clear();
+    std::cerr << "工作负载捕获已停止: " << reason << std::endl;
+}
+
+void WorkloadCapture::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        writer_cv_.wait_for(lock, std::chrono::milliseconds(kFlushIntervalMs), [this]() {
+            return stopping_ || buffer_.size() >= kFlushThreshold;
+        });
+        bool last = stopping_;
+        std::string pending;
+        pending.swap(buffer_);
+        
+        // fd_只在没有后台线程时改变，写出期间不持有互斥量
+        if (!pending.empty() && !failed_) {
+            lock.unlock();
+            std::string error;
+            try {
+                writeAll(fd_, pending);
+            } catch (const std::exception& e) {
+                error = e.what();
+            }
+            lock.lock();
+            if (!error.empty()) {
+                abandonLocked(error.c_str());
+            }
+        }
+        if (last) {
+            return;
+        }
+    }
+}
+
+void WorkloadCapture::encode(std::string& out, std::int32_t value) {
+    putRaw(out, value);
+}
+
+void WorkloadCapture::encode(std::string& out, std::uint64_t value) {
+    putRaw(out, value);
+}
+
+void WorkloadCapture::encode(std::string& out, double value) {
+    putRaw(out, value);
+}
+
+void WorkloadCapture::encode(std::string& out, const std::string& value) {
+    putRaw(out, static_cast<std::uint32_t>(value.size()));
+    out.append(value);
+}
+
+bool WorkloadArgs::take(void* out, std::size_t size) {
+    if (failed_ || pos_ + size > data_.size()) {
+        failed_ = true;
+        std::memset(out, 0, size);
+        return false;
+    }
+    std::memcpy(out, data_.data() + pos_, size);
+    pos_ += size;
+    return true;
+}
+
+std::int32_t WorkloadArgs::readInt() {
+    std::int32_t value;
+    take(&value, sizeof(value));
+    return value;
+}
+
+std::uint64_t WorkloadArgs::readU64() {
+    std::uint64_t value;
+    take(&value, sizeof(value));
+    return value;
+}
+
+double WorkloadArgs::readDouble() {
+    double value;
+    take(&value, sizeof(value));
+    return value;
+}
+
+std::string WorkloadArgs::readString() {
+    std::uint32_t size;
+    if (!take(&size, sizeof(size)) || pos_ + size > data_.size()) {
+        failed_ = true;
+        return std::string();
+    }
+    std::string value = data_.substr(pos_, size);
+    pos_ += size;
+    return value;
+}
+
+std::vector<CapturedCall> readWorkload(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("无法打开工作负载日志 " + path);
+    }
+    std::string content;
+    char chunk[65536];
+    for (;;) {
+        ssize_t result = ::read(fd, chunk, sizeof(chunk));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            break;
+        }
+        content.append(chunk, static_cast<std::size_t>(result));
+    }
+    ::close(fd);
+    
+    std::uint32_t version = 0;
+    if (content.size() < sizeof(kMagic) + sizeof(version) ||
+        content.compare(0, sizeof(kMagic), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error("不是工作负载日志: " + path);
+    }
+    std::memcpy(&version, content.data() + sizeof(kMagic), sizeof(version));
+    if (version != kFormatVersion) {
+        throw std::runtime_error("不支持的工作负载日志版本: " + std::to_string(version));
+    }
+    
+    std::vector<CapturedCall> calls;
+    std::size_t pos = sizeof(kMagic) + sizeof(version);
+    while (pos + kRecordHeaderSize <= content.size()) {
+        CapturedCall call;
+        std::uint32_t args_size;
+        call.op = static_cast<WorkloadOp>(content[pos]);
+        std::memcpy(&call.thread, content.data() + pos + 1, sizeof(call.thread));
+        std::memcpy(&call.timestamp_us, content.data() + pos + 5, sizeof(call.timestamp_us));
+        std::memcpy(&args_size, content.data() + pos + 13, sizeof(args_size));
+        if (pos + kRecordHeaderSize + args_size > content.size()) {
+            break; // 残缺尾部
+        }
+        call.args = content.substr(pos + kRecordHeaderSize, args_size);
+        calls.push_back(call);
+        pos += kRecordHeaderSize + args_size;
+    }
+    return calls;
+}
+
+const char* workloadOpName(WorkloadOp op) {
+    switch (op) {
+        case WorkloadOp::CREATE_USER: return "createUser";
+        case WorkloadOp::GET_ALL_USERS: return "getAllUsers";
+        case WorkloadOp::GET_USER_BY_ID: return "getUserById";
+        case WorkloadOp::GET_USER_BY_USERNAME: return "getUserByUsername";
+        case WorkloadOp::UPDATE_USER: return "updateUser";
+        case WorkloadOp::UPDATE_USER_IF_VERSION: return "updateUserIfVersion";
+        case WorkloadOp::DELETE_USER: return "deleteUser";
+        case WorkloadOp::CREATE_USERS_TRANSACTION: return "createUsersTransaction";
+        case WorkloadOp::IMPORT_USERS: return "importUsers";
+        case WorkloadOp::IS_USERNAME_AVAILABLE: return "isUsernameAvailable";
+        case WorkloadOp::IS_EMAIL_AVAILABLE: return "isEmailAvailable";
+        case WorkloadOp::CREATE_ORDER: return "createOrder";
+        case WorkloadOp::GET_ALL_ORDERS: return "getAllOrders";
+        case WorkloadOp::GET_ORDERS_BY_USER_ID: return "getOrdersByUserId";
+        case WorkloadOp::GET_ORDERS_BY_STATUS: return "getOrdersByStatus";
+        case WorkloadOp::GET_ORDER_BY_ID: return "getOrderById";
+        case WorkloadOp::UPDATE_ORDER_STATUS: return "updateOrderStatus";
+        case WorkloadOp::UPDATE_ORDER_AMOUNT: return "updateOrderAmount";
+        case WorkloadOp::DELETE_ORDER: return "deleteOrder";
+        case WorkloadOp::GET_TOTAL_AMOUNT_BY_USER_ID: return "getTotalAmountByUserId";
+        case WorkloadOp::GET_ORDER_COUNT_BY_STATUS: return "getOrderCountByStatus";
+        case WorkloadOp::CREATE_ORDERS_TRANSACTION: return "createOrdersTransaction";
+        case WorkloadOp::IMPORT_ORDERS: return "importOrders";
+        case WorkloadOp::CREATE_PRODUCT: return "createProduct";
+        case WorkloadOp::GET_ALL_PRODUCTS: return "getAllProducts";
+        case WorkloadOp::GET_PRODUCTS_BY_PRICE_RANGE: return "getProductsByPriceRange";
+        case WorkloadOp::GET_PRODUCTS_IN_STOCK: return "getProductsInStock";
+        case WorkloadOp::GET_PRODUCT_BY_ID: return "getProductById";
+        case WorkloadOp::GET_PRODUCT_BY_NAME: return "getProductByName";
+        case WorkloadOp::UPDATE_PRODUCT: return "updateProduct";
+        case WorkloadOp::UPDATE_PRODUCT_IF_VERSION: return "updateProductIfVersion";
+        case WorkloadOp::UPDATE_PRODUCT_STOCK: return "updateProductStock";
+        case WorkloadOp::UPDATE_PRODUCT_PRICE: return "updateProductPrice";
+        case WorkloadOp::DELETE_PRODUCT: return "deleteProduct";
+        case WorkloadOp::INCREASE_STOCK: return "increaseStock";
+        case WorkloadOp::DECREASE_STOCK: return "decreaseStock";
+        case WorkloadOp::GET_STOCK_QUANTITY: return "getStockQuantity";
+        case WorkloadOp::CREATE_PRODUCTS_TRANSACTION: return "createProductsTransaction";
+        case WorkloadOp::IMPORT_PRODUCTS: return "importProducts";
+        case WorkloadOp::UPDATE_STOCK_TRANSACTION: return "updateStockTransaction";
+        case WorkloadOp::CHECKOUT: return "checkout";
+    }
+    return "unknown";
+}
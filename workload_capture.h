@@ -0,0 +1,224 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// 被捕获的管理器API
+enum class WorkloadOp : std::uint8_t {
+    // 用户
+    CREATE_USER = 1,
+    GET_ALL_USERS,
+    GET_USER_BY_ID,
+    GET_USER_BY_USERNAME,
+    UPDATE_USER,
+    UPDATE_USER_IF_VERSION,
+    DELETE_USER,
+    CREATE_USERS_TRANSACTION,
+    IMPORT_USERS,
+    IS_USERNAME_AVAILABLE,
+    IS_EMAIL_AVAILABLE,
+    
+    // 订单
+    CREATE_ORDER = 32,
+    GET_ALL_ORDERS,
+    GET_ORDERS_BY_USER_ID,
+    GET_ORDERS_BY_STATUS,
+    GET_ORDER_BY_ID,
+    UPDATE_ORDER_STATUS,
+    UPDATE_ORDER_AMOUNT,
+    DELETE_ORDER,
+    GET_TOTAL_AMOUNT_BY_USER_ID,
+    GET_ORDER_COUNT_BY_STATUS,
+    CREATE_ORDERS_TRANSACTION,
+    IMPORT_ORDERS,
+    
+    // 产品
+    CREATE_PRODUCT = 64,
+    GET_ALL_PRODUCTS,
+    GET_PRODUCTS_BY_PRICE_RANGE,
+    GET_PRODUCTS_IN_STOCK,
+    GET_PRODUCT_BY_ID,
+    GET_PRODUCT_BY_NAME,
+    UPDATE_PRODUCT,
+    UPDATE_PRODUCT_IF_VERSION,
+    UPDATE_PRODUCT_STOCK,
+    UPDATE_PRODUCT_PRICE,
+    DELETE_PRODUCT,
+    INCREASE_STOCK,
+    DECREASE_STOCK,
+    GET_STOCK_QUANTITY,
+    CREATE_PRODUCTS_TRANSACTION,
+    IMPORT_PRODUCTS,
+    UPDATE_STOCK_TRANSACTION,
+    
+    // 下单
+    CHECKOUT = 96
+};
+
+const char* workloadOpName(WorkloadOp op);
+
+// 工作负载捕获
+//
+// 启用后记录每次管理器API调用的操作、参数、线程与时间戳，写入紧凑的二进制
+// 日志，供workload_replay在数据库副本上重放。
+//
+// 文件格式：头部 "MCWL" + u32版本，之后为连续记录：
+//   [u8 操作][u32 线程序号][u64 相对开始时间(微秒)][u32 参数长度][参数]
+// 参数按调用顺序编码：整数为小端定长，double按位存储，字符串与数组带u32长度前缀。
+//
+// 只记录最外层调用：管理器内部互相调用（如合并写入时的getStockQuantity）
+// 不会重复记录。未启用时每次调用的开销为一次原子读取。
+//
+// 调用线程只把记录追加到内存缓冲区，由后台线程写出文件。捕获不会影响被记录的
+// 调用：编码或写出失败、缓冲区积压超过上限时输出一次原因并停止捕获，不向调用方
+// 抛出异常，已写出的日志保持完整可读。
+class WorkloadCapture {
+public:
+    static WorkloadCapture& getInstance();
+    ~WorkloadCapture();
+    
+    void start(const std::string& path);
+    void stop();
+    
+    static bool enabled() {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+    
+    // 调用作用域：构造时记录（仅最外层），析构时退出
+    class Call {
+    public:
+        template <typename... Args>
+        explicit Call(WorkloadOp op, const Args&... args) : outermost_(++depth() == 1) {
+            if (outermost_ && enabled()) {
+                try {
+                    std::string encoded;
+                    encodeAll(encoded, args...);
+                    getInstance().append(op, encoded);
+                } catch (const std::exception& e) {
+                    getInstance().abandon(e.what());
+                }
+            }
+        }
+        
+        ~Call() {
+            --depth();
+        }
+        
+    private:
+        Call(const Call&) = delete;
+        Call& operator=(const Call&) = delete;
+        
+        static int& depth();
+        bool outermost_;
+    };
+    
+    // 参数编码
+    static void encode(std::string& out, std::int32_t value);
+    static void encode(std::string& out, std::uint64_t value);
+    static void encode(std::string& out, double value);
+    static void encode(std::string& out, const std::string& value);
+    
+    template <typename A, typename B>
+    static void encode(std::string& out, const std::pair<A, B>& value) {
+        encode(out, value.first);
+        encode(out, value.second);
+    }
+    
+    template <typename... T>
+    static void encode(std::string& out, const std::tuple<T...>& value) {
+        TupleEncoder<0, sizeof...(T), T...>::apply(out, value);
+    }
+    
+    template <typename T>
+    static void encode(std::string& out, const std::vector<T>& values) {
+        encode(out, static_cast<std::int32_t>(values.size()));
+        for (const auto& value : values) {
+            encode(out, value);
+        }
+    }
+    
+private:
+    WorkloadCapture();
+    WorkloadCapture(const WorkloadCapture&) = delete;
+    WorkloadCapture& operator=(const WorkloadCapture&) = delete;
+    
+    template <std::size_t I, std::size_t N, typename... T>
+    struct TupleEncoder {
+        static void apply(std::string& out, const std::tuple<T...>& value) {
+            encode(out, std::get<I>(value));
+            TupleEncoder<I + 1, N, T...>::apply(out, value);
+        }
+    };
+    
+    template <std::size_t N, typename... T>
+    struct TupleEncoder<N, N, T...> {
+        static void apply(std::string&, const std::tuple<T...>&) {}
+    };
+    
+    static void encodeAll(std::string&) {}
+    
+    template <typename First, typename... Rest>
+    static void encodeAll(std::string& out, const First& first, const Rest&... rest) {
+        encode(out, first);
+        encodeAll(out, rest...);
+    }
+    
+    void append(WorkloadOp op, const std::string& args);
+    void abandon(const char* reason);
+    void abandonLocked(const char* reason);
+    void writerLoop();
+    
+    static std::atomic<bool> enabled_;
+    
+    std::mutex mutex_;
+    std::condition_variable writer_cv_;
+    std::thread writer_;
+    int fd_;
+    std::string buffer_;       // 尚未交给后台线程写出的记录
+    std::int64_t start_us_;
+    std::uint32_t next_thread_index_;
+    bool stopping_;
+    bool failed_;              // 本次捕获已因错误停止
+};
+
+// 捕获日志中的一条记录
+struct CapturedCall {
+    WorkloadOp op;
+    std::uint32_t thread;
+    std::uint64_t timestamp_us;
+    std::string args;
+};
+
+// 参数解码游标，越界时置位failed
+class WorkloadArgs {
+public:
+    explicit WorkloadArgs(const std::string& data) : data_(data), pos_(0), failed_(false) {}
+    
+    std::int32_t readInt();
+    std::uint64_t readU64();
+    double readDouble();
+    std::string readString();
+    
+    bool failed() const {
+        return failed_;
+    }
+    
+private:
+    bool take(void* out, std::size_t size);
+    
+    const std::string& data_;
+    std::size_t pos_;
+    bool failed_;
+};
+
+// 读取整个捕获日志；格式错误时抛出异常，残缺的尾部记录被忽略
+std::vector<CapturedCall> readWorkload(const std::string& path);
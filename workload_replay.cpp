@@ -0,0 +1,369 @@
+#include "multi_connection_database_manager.h"
+#include "multi_connection_user_manager.h"
+#include "multi_connection_order_manager.h"
+#include "multi_connection_product_manager.h"
+#include "multi_connection_checkout_manager.h"
+#include "workload_capture.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// 工作负载重放工具
+//
+// 用法: workload_replay <捕获日志> [--speed 倍速]
+// 在当前目录的数据库文件上重放（应先复制一份捕获开始时的数据库）。
+// 每个捕获线程对应一个重放线程，按原始时间间隔除以倍速发起调用；
+// 倍速为0时不等待，尽可能快地重放。
+
+namespace {
+
+typedef std::map<WorkloadOp, std::vector<long long>> LatencyTable;
+
+template <typename T>
+std::vector<T> readVector(WorkloadArgs& args, T (*read_element)(WorkloadArgs&)) {
+    std::vector<T> values;
+    std::int32_t count = args.readInt();
+    for (std::int32_t i = 0; i < count && !args.failed(); ++i) {
+        values.push_back(read_element(args));
+    }
+    return values;
+}
+
+std::pair<std::string, std::string> readUserRow(WorkloadArgs& args) {
+    std::string username = args.readString();
+    std::string email = args.readString();
+    return std::make_pair(username, email);
+}
+
+std::tuple<int, double, std::string> readOrderRow(WorkloadArgs& args) {
+    int user_id = args.readInt();
+    double total_amount = args.readDouble();
+    std::string status = args.readString();
+    return std::make_tuple(user_id, total_amount, status);
+}
+
+std::tuple<std::string, std::string, double, int> readProductRow(WorkloadArgs& args) {
+    std::string name = args.readString();
+    std::string description = args.readString();
+    double price = args.readDouble();
+    int stock_quantity = args.readInt();
+    return std::make_tuple(name, description, price, stock_quantity);
+}
+
+std::pair<int, int> readIntPair(WorkloadArgs& args) {
+    int first = args.readInt();
+    int second = args.readInt();
+    return std::make_pair(first, second);
+}
+
+// 执行一条捕获的调用；参数按捕获时的顺序解码
+bool execute(const CapturedCall& call) {
+    auto& users = MultiConnectionUserManager::getInstance();
+    auto& orders = MultiConnectionOrderManager::getInstance();
+    auto& products = MultiConnectionProductManager::getInstance();
+    WorkloadArgs args(call.args);
+    
+    // 函数参数的求值顺序未指定，因此先按顺序读出再调用
+    switch (call.op) {
+        case WorkloadOp::CREATE_USER: {
+            std::string username = args.readString();
+            std::string email = args.readString();
+            users.createUser(username, email);
+            break;
+        }
+        case WorkloadOp::GET_ALL_USERS:
+            users.getAllUsers();
+            break;
+        case WorkloadOp::GET_USER_BY_ID:
+            users.getUserById(args.readInt());
+            break;
+        case WorkloadOp::GET_USER_BY_USERNAME:
+            users.getUserByUsername(args.readString());
+            break;
+        case WorkloadOp::UPDATE_USER: {
+            int id = args.readInt();
+            std::string username = args.readString();
+            std::string email = args.readString();
+            users.updateUser(id, username, email);
+            break;
+        }
+        case WorkloadOp::UPDATE_USER_IF_VERSION: {
+            int id = args.readInt();
+            int version = args.readInt();
+            std::string username = args.readString();
+            std::string email = args.readString();
+            users.updateUserIfVersion(id, version, username, email);
+            break;
+        }
+        case WorkloadOp::DELETE_USER:
+            users.deleteUser(args.readInt());
+            break;
+        case WorkloadOp::CREATE_USERS_TRANSACTION:
+            users.createUsersTransaction(readVector(args, readUserRow));
+            break;
+        case WorkloadOp::IMPORT_USERS: {
+            auto rows = readVector(args, readUserRow);
+            users.importUsers(rows, static_cast<std::size_t>(args.readU64()));
+            break;
+        }
+        case WorkloadOp::IS_USERNAME_AVAILABLE:
+            users.isUsernameAvailable(args.readString());
+            break;
+        case WorkloadOp::IS_EMAIL_AVAILABLE:
+            users.isEmailAvailable(args.readString());
+            break;
+        
+        case WorkloadOp::CREATE_ORDER: {
+            int user_id = args.readInt();
+            double total_amount = args.readDouble();
+            std::string status = args.readString();
+            orders.createOrder(user_id, total_amount, status);
+            break;
+        }
+        case WorkloadOp::GET_ALL_ORDERS:
+            orders.getAllOrders();
+            break;
+        case WorkloadOp::GET_ORDERS_BY_USER_ID:
+            orders.getOrdersByUserId(args.readInt());
+            break;
+        case WorkloadOp::GET_ORDERS_BY_STATUS:
+            orders.getOrdersByStatus(args.readString());
+            break;
+        case WorkloadOp::GET_ORDER_BY_ID:
+            orders.getOrderById(args.readInt());
+            break;
+        case WorkloadOp::UPDATE_ORDER_STATUS: {
+            int id = args.readInt();
+            std::string status = args.readString();
+            orders.updateOrderStatus(id, status);
+            break;
+        }
+        case WorkloadOp::UPDATE_ORDER_AMOUNT: {
+            int id = args.readInt();
+            double total_amount = args.readDouble();
+            orders.updateOrderAmount(id, total_amount);
+            break;
+        }
+        case WorkloadOp::DELETE_ORDER:
+            orders.deleteOrder(args.readInt());
+            break;
+        case WorkloadOp::GET_TOTAL_AMOUNT_BY_USER_ID:
+            orders.getTotalAmountByUserId(args.readInt());
+            break;
+        case WorkloadOp::GET_ORDER_COUNT_BY_STATUS:
+            orders.getOrderCountByStatus(args.readString());
+            break;
+        case WorkloadOp::CREATE_ORDERS_TRANSACTION:
+            orders.createOrdersTransaction(readVector(args, readOrderRow));
+            break;
+        case WorkloadOp::IMPORT_ORDERS: {
+            auto rows = readVector(args, readOrderRow);
+            orders.importOrders(rows, static_cast<std::size_t>(args.readU64()));
+            break;
+        }
+        
+        case WorkloadOp::CREATE_PRODUCT: {
+            auto row = readProductRow(args);
+            products.createProduct(std::get<0>(row), std::get<1>(row), std::get<2>(row), std::get<3>(row));
+            break;
+        }
+        case WorkloadOp::GET_ALL_PRODUCTS:
+            products.getAllProducts();
+            break;
+        case WorkloadOp::GET_PRODUCTS_BY_PRICE_RANGE: {
+            double min_price = args.readDouble();
+            double max_price = args.readDouble();
+            products.getProductsByPriceRange(min_price, max_price);
+            break;
+        }
+        case WorkloadOp::GET_PRODUCTS_IN_STOCK:
+            products.getProductsInStock();
+            break;
+        case WorkloadOp::GET_PRODUCT_BY_ID:
+            products.getProductById(args.readInt());
+            break;
+        case WorkloadOp::GET_PRODUCT_BY_NAME:
+            products.getProductByName(args.readString());
+            break;
+        case WorkloadOp::UPDATE_PRODUCT: {
+            int id = args.readInt();
+            auto row = readProductRow(args);
+            products.updateProduct(id, std::get<0>(row), std::get<1>(row), std::get<2>(row), std::get<3>(row));
+            break;
+        }
+        case WorkloadOp::UPDATE_PRODUCT_IF_VERSION: {
+            int id = args.readInt();
+            int version = args.readInt();
+            auto row = readProductRow(args);
+            products.updateProductIfVersion(id, version, std::get<0>(row), std::get<1>(row),
+                                            std::get<2>(row), std::get<3>(row));
+            break;
+        }
+        case WorkloadOp::UPDATE_PRODUCT_STOCK: {
+            auto values = readIntPair(args);
+            products.updateProductStock(values.first, values.second);
+            break;
+        }
+        case WorkloadOp::UPDATE_PRODUCT_PRICE: {
+            int id = args.readInt();
+            double price = args.readDouble();
+            products.updateProductPrice(id, price);
+            break;
+        }
+        case WorkloadOp::DELETE_PRODUCT:
+            products.deleteProduct(args.readInt());
+            break;
+        case WorkloadOp::INCREASE_STOCK: {
+            auto values = readIntPair(args);
+            products.increaseStock(values.first, values.second);
+            break;
+        }
+        case WorkloadOp::DECREASE_STOCK: {
+            auto values = readIntPair(args);
+            products.decreaseStock(values.first, values.second);
+            break;
+        }
+        case WorkloadOp::GET_STOCK_QUANTITY:
+            products.getStockQuantity(args.readInt());
+            break;
+        case WorkloadOp::CREATE_PRODUCTS_TRANSACTION:
+            products.createProductsTransaction(readVector(args, readProductRow));
+            break;
+        case WorkloadOp::IMPORT_PRODUCTS: {
+            auto rows = readVector(args, readProductRow);
+            products.importProducts(rows, static_cast<std::size_t>(args.readU64()));
+            break;
+        }
+        case WorkloadOp::UPDATE_STOCK_TRANSACTION:
+            products.updateStockTransaction(readVector(args, readIntPair));
+            break;
+        
+        case WorkloadOp::CHECKOUT: {
+            int user_id = args.readInt();
+            std::vector<CheckoutItem> items;
+            for (const auto& item : readVector(args, readIntPair)) {
+                items.push_back({item.first, item.second});
+            }
+            MultiConnectionCheckoutManager::getInstance().checkout(user_id, items);
+            break;
+        }
+        
+        default:
+            return false;
+    }
+    return !args.failed();
+}
+
+void printReport(const LatencyTable& latencies, long long elapsed_ms) {
+    std::size_t total = 0;
+    std::cout << std::left << std::setw(28) << "操作" << std::right
+              << std::setw(10) << "次数" << std::setw(12) << "平均(us)"
+              << std::setw(12) << "p50(us)" << std::setw(12) << "p99(us)" << std::setw(12) << "最大(us)" << std::endl;
+    for (const auto& entry : latencies) {
+        std::vector<long long> samples = entry.second;
+        std::sort(samples.begin(), samples.end());
+        long long sum = 0;
+        for (long long sample : samples) {
+            sum += sample;
+        }
+        total += samples.size();
+        std::cout << std::left << std::setw(28) << workloadOpName(entry.first) << std::right
+                  << std::setw(10) << samples.size()
+                  << std::setw(12) << sum / static_cast<long long>(samples.size())
+                  << std::setw(12) << samples[samples.size() / 2]
+                  << std::setw(12) << samples[samples.size() * 99 / 100]
+                  << std::setw(12) << samples.back() << std::endl;
+    }
+    std::cout << "共重放 " << total << " 次调用，耗时 " << elapsed_ms << " 毫秒" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <捕获日志> [--speed 倍速]" << std::endl;
+        return 1;
+    }
+    std::string log_path = argv[1];
+    double speed = 1.0;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--speed") == 0) {
+            speed = std::atof(argv[i + 1]);
+        }
+    }
+    
+    try {
+        std::vector<CapturedCall> calls = readWorkload(log_path);
+        std::cout << "读取捕获调用 " << calls.size() << " 次" << std::endl;
+        
+        // 按捕获线程分组，保持每个线程内的调用顺序
+        std::map<std::uint32_t, std::vector<const CapturedCall*>> by_thread;
+        for (const auto& call : calls) {
+            by_thread[call.thread].push_back(&call);
+        }
+        
+        MultiConnectionDatabaseManager::getInstance();
+        
+        LatencyTable latencies;
+        std::mutex latencies_mutex;
+        std::size_t unknown = 0;
+        std::vector<std::thread> threads;
+        auto replay_start = std::chrono::steady_clock::now();
+        
+        for (const auto& thread_calls : by_thread) {
+            const std::vector<const CapturedCall*>* sequence = &thread_calls.second;
+            threads.emplace_back([sequence, speed, replay_start, &latencies, &latencies_mutex, &unknown]() {
+                LatencyTable local;
+                std::size_t local_unknown = 0;
+                for (const CapturedCall* call : *sequence) {
+                    if (speed > 0) {
+                        auto offset = std::chrono::microseconds(static_cast<long long>(call->timestamp_us / speed));
+                        std::this_thread::sleep_until(replay_start + offset);
+                    }
+                    auto start = std::chrono::steady_clock::now();
+                    bool ok = execute(*call);
+                    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - start).count();
+                    if (ok) {
+                        local[call->op].push_back(latency);
+                    } else {
+                        ++local_unknown;
+                    }
+                }
+                
+                std::lock_guard<std::mutex> lock(latencies_mutex);
+                for (auto& entry : local) {
+                    auto& samples = latencies[entry.first];
+                    samples.insert(samples.end(), entry.second.begin(), entry.second.end());
+                }
+                unknown += local_unknown;
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - replay_start).count();
+        std::cout << "\n=== 重放结果（" << by_thread.size() << " 个线程，倍速 " << speed << "）===" << std::endl;
+        printReport(latencies, elapsed);
+        if (unknown > 0) {
+            std::cout << "无法解析的调用: " << unknown << std::endl;
+        }
+        
+    } catch (const std::exception& e) {
+        std::cerr << "重放出错: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}